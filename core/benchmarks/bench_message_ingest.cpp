@@ -0,0 +1,219 @@
+// Measures how many incoming messages per second reach the message cache and
+// SQLite, comparing the per-message path (one cache insert and one DB task
+// per message) with MessageIngestor.
+//
+//   anychat_bench_message_ingest [messages] [conversations]
+//
+// Each path runs twice: one message per call, as pushes arrive, and 100 per
+// call, as offline and sync pages do. A last run delivers every message
+// three times, as push, offline page and sync page, and reports how many
+// copies the recent-id filter dropped. The database is a file in the temp
+// directory, so the numbers include real commits.
+
+#include "message_ingestor.h"
+
+#include "cache/conversation_cache.h"
+#include "cache/message_cache.h"
+#include "db/database.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using anychat::IngestSource;
+using anychat::Message;
+using anychat::MessageIngestor;
+
+constexpr const char* kUpsertMessageSql =
+    "INSERT INTO messages (message_id, local_id, conv_id, sender_id, content_type, content, seq, reply_to, "
+    "status, send_state, is_read, timestamp_ms) "
+    "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?) "
+    "ON CONFLICT(message_id) DO UPDATE SET "
+    "local_id=excluded.local_id, conv_id=excluded.conv_id, sender_id=excluded.sender_id, "
+    "content_type=excluded.content_type, content=excluded.content, seq=excluded.seq, reply_to=excluded.reply_to, "
+    "status=excluded.status, send_state=excluded.send_state, is_read=excluded.is_read, "
+    "timestamp_ms=excluded.timestamp_ms";
+
+std::vector<Message> makeMessages(int count, int conversations) {
+    std::vector<Message> messages;
+    messages.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        Message m;
+        m.message_id = "msg-" + std::to_string(i);
+        m.conv_id = "conv-" + std::to_string(i % conversations);
+        m.sender_id = "user-" + std::to_string(i % 7);
+        m.content_type = 1;
+        m.content = "benchmark message body number " + std::to_string(i);
+        m.seq = i / conversations + 1;
+        m.timestamp_ms = 1'700'000'000'000 + i;
+        m.send_state = 1;
+        messages.push_back(std::move(m));
+    }
+    return messages;
+}
+
+// A fresh database with the conversations the messages refer to.
+std::unique_ptr<anychat::db::Database> openDb(const std::filesystem::path& path, int conversations) {
+    std::filesystem::remove(path);
+    std::filesystem::remove(path.string() + "-wal");
+    std::filesystem::remove(path.string() + "-shm");
+    auto db = std::make_unique<anychat::db::Database>(path.string());
+    if (!db->open()) {
+        return nullptr;
+    }
+    db->transactionSync([conversations](anychat::db::Database::TxScope& tx) {
+        for (int i = 0; i < conversations; ++i) {
+            tx.execDirect(
+                "INSERT INTO conversations (conv_id, conv_type, local_seq) VALUES (?, 'private', 0)",
+                { "conv-" + std::to_string(i) }
+            );
+        }
+        return true;
+    });
+    return db;
+}
+
+// The path MessageManagerImpl took before the ingestor.
+void perMessage(anychat::db::Database& db, anychat::cache::MessageCache& cache, const std::vector<Message>& batch) {
+    for (const auto& msg : batch) {
+        cache.insert(msg);
+        db.exec(
+            kUpsertMessageSql,
+            { msg.message_id,
+              nullptr,
+              msg.conv_id,
+              msg.sender_id,
+              static_cast<int64_t>(msg.content_type),
+              msg.content,
+              msg.seq,
+              msg.reply_to,
+              static_cast<int64_t>(msg.status),
+              static_cast<int64_t>(msg.send_state),
+              static_cast<int64_t>(msg.is_read ? 1 : 0),
+              msg.timestamp_ms }
+        );
+    }
+}
+
+void run(
+    const char* name,
+    size_t batch_size,
+    const std::vector<Message>& messages,
+    int conversations,
+    const std::filesystem::path& path,
+    bool use_ingestor
+) {
+    auto db = openDb(path, conversations);
+    if (!db) {
+        std::fprintf(stderr, "cannot open %s\n", path.string().c_str());
+        std::exit(1);
+    }
+    anychat::cache::MessageCache msg_cache;
+    anychat::cache::ConversationCache conv_cache;
+    MessageIngestor ingestor(db.get(), &msg_cache, &conv_cache);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < messages.size(); i += batch_size) {
+        const auto end = messages.begin() + static_cast<std::ptrdiff_t>(std::min(messages.size(), i + batch_size));
+        std::vector<Message> batch(messages.begin() + static_cast<std::ptrdiff_t>(i), end);
+        if (use_ingestor) {
+            ingestor.ingest(std::move(batch), IngestSource::Push);
+        } else {
+            perMessage(*db, msg_cache, batch);
+        }
+    }
+    ingestor.flush();
+    db->querySync("SELECT 1"); // the per-message tasks are done
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const size_t stored = db->querySync("SELECT message_id FROM messages").size();
+    std::printf(
+        "%-12s batch %-4zu %8zu msgs %9.1f ms %12.0f msgs/s  (stored %zu, transactions %llu)\n",
+        name,
+        batch_size,
+        messages.size(),
+        seconds * 1000,
+        static_cast<double>(messages.size()) / seconds,
+        stored,
+        static_cast<unsigned long long>(ingestor.stats().transactions)
+    );
+    db->close();
+}
+
+// Each message pushed, then fetched and synced again in pages of 100, one
+// reconnect's worth (1000 messages) at a time.
+void redelivery(const std::vector<Message>& messages, int conversations, const std::filesystem::path& path) {
+    auto db = openDb(path, conversations);
+    if (!db) {
+        std::fprintf(stderr, "cannot open %s\n", path.string().c_str());
+        std::exit(1);
+    }
+    anychat::cache::MessageCache msg_cache;
+    anychat::cache::ConversationCache conv_cache;
+    MessageIngestor ingestor(db.get(), &msg_cache, &conv_cache);
+
+    const auto page = [&](size_t begin, size_t size) {
+        const auto first = messages.begin() + static_cast<std::ptrdiff_t>(begin);
+        const auto count = static_cast<std::ptrdiff_t>(std::min(messages.size() - begin, size));
+        return std::vector<Message>(first, first + count);
+    };
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t chunk = 0; chunk < messages.size(); chunk += 1000) {
+        const size_t chunk_end = std::min(messages.size(), chunk + 1000);
+        for (size_t i = chunk; i < chunk_end; ++i) {
+            ingestor.ingest({ messages[i] }, IngestSource::Push);
+        }
+        for (IngestSource source : { IngestSource::Fetch, IngestSource::Sync }) {
+            for (size_t i = chunk; i < chunk_end; i += 100) {
+                ingestor.ingest(page(i, std::min<size_t>(100, chunk_end - i)), source);
+            }
+        }
+    }
+    ingestor.flush();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const auto stats = ingestor.stats();
+    std::printf(
+        "%-12s x3         %8zu msgs %9.1f ms %12.0f msgs/s  (persisted %llu, dropped %llu + %llu)\n",
+        "redelivery",
+        messages.size(),
+        seconds * 1000,
+        static_cast<double>(messages.size() * 3) / seconds,
+        static_cast<unsigned long long>(stats.persisted),
+        static_cast<unsigned long long>(stats.seen_recently),
+        static_cast<unsigned long long>(stats.below_watermark)
+    );
+    db->close();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int count = argc > 1 ? std::atoi(argv[1]) : 20'000;
+    const int conversations = argc > 2 ? std::atoi(argv[2]) : 50;
+    if (count <= 0 || conversations <= 0) {
+        std::fprintf(stderr, "usage: %s [messages] [conversations]\n", argv[0]);
+        return 2;
+    }
+
+    const auto path = std::filesystem::temp_directory_path() / "anychat_bench_message_ingest.db";
+    const std::vector<Message> messages = makeMessages(count, conversations);
+
+    for (size_t batch_size : { size_t{ 1 }, size_t{ 100 } }) {
+        run("per-message", batch_size, messages, conversations, path, false);
+        run("ingestor", batch_size, messages, conversations, path, true);
+    }
+    redelivery(messages, conversations, path);
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(path.string() + "-wal");
+    std::filesystem::remove(path.string() + "-shm");
+    return 0;
+}
@@ -16,6 +16,16 @@ typedef struct {
     int connect_timeout_ms; /* default: 10000 */
     int max_reconnect_attempts; /* default: 5 */
     int auto_reconnect; /* 1 = enabled (default), 0 = disabled */
+    const char* media_cache_dir; /* downloaded media cache directory; NULL or "" disables it */
+    int64_t media_cache_max_bytes; /* default: 512 MiB */
+    int compress_request_bodies; /* 1 = gzip large /sync request bodies, 0 = off (default) */
+    int ws_permessage_deflate; /* 1 = offer WebSocket permessage-deflate, 0 = off (default) */
+    int ws_deflate_window_bits; /* 9..15, default: 15 */
+    int ws_deflate_no_context_takeover; /* 1 = reset the deflate dictionary per message, 0 = keep (default) */
+    int ws_binary_frames; /* 1 = offer binary (BEVE) frames, 0 = JSON only (default) */
+    int dispatch_threads; /* callback threads; 0 = default (2), negative = run on the WebSocket thread */
+    int dispatch_queue_limit; /* events waiting for a callback thread; 0 = default (10000) */
+    int listener_batch_window_ms; /* > 0: deliver listener events in batches per window, e.g. 16; 0 = off (default) */
 } AnyChatClientConfig_C;
 
 /* Connection state change callback.
@@ -29,7 +39,8 @@ typedef void (*AnyChatConnectionStateCallback)(void* userdata, int state);
 ANYCHAT_C_API AnyChatClientHandle anychat_client_create(const AnyChatClientConfig_C* config);
 
 /* Destroy the client and release all resources.
- * Must not be called while callbacks are in flight on other threads. */
+ * Must not be called while callbacks are in flight on other threads, nor
+ * from a callback. */
 ANYCHAT_C_API void anychat_client_destroy(AnyChatClientHandle handle);
 
 /* ---- Authentication & Connection ---- */
@@ -67,6 +78,30 @@ ANYCHAT_C_API void anychat_client_set_connection_callback(
     AnyChatConnectionStateCallback callback
 );
 
+/* ---- Diagnostics ---- */
+
+/* HTTP statistics as a JSON object: "totals" (request, retry and byte
+ * counters) and "routes", one entry per route template such as
+ * "GET /conversations/{id}" with status code counts, wire bytes and latency
+ * summaries (count, mean, p50/p90/p99, max in ms, bucket counts) for dns,
+ * connect, tls, ttfb and total. Returns NULL on failure; free the result with
+ * anychat_free_string(). */
+ANYCHAT_C_API char* anychat_client_get_http_stats_json(AnyChatClientHandle handle);
+
+/* Clear the per-route statistics, e.g. after uploading a report. */
+ANYCHAT_C_API void anychat_client_reset_http_stats(AnyChatClientHandle handle);
+
+/* WebSocket statistics of the current connection as a JSON object:
+ * "counters" (messages, uncompressed payload bytes, whether permessage-deflate
+ * is active, deflate/inflate byte counts, pings and pongs), the tx/rx
+ * compression ratios (compressed / uncompressed), "rtt" (samples, last, min,
+ * smoothed RTT, jitter and retransmission timeout in ms, measured by the
+ * heartbeat), "heartbeat_interval_ms", "resume" (session resume outcomes) and
+ * "dispatch" (callback tasks posted and executed, producer waits on a full
+ * queue, current and peak queue length). Returns NULL before login or on
+ * failure; free the result with anychat_free_string(). */
+ANYCHAT_C_API char* anychat_client_get_ws_stats_json(AnyChatClientHandle handle);
+
 /* ---- Sub-module accessors ----
  * The returned handles are owned by the client; do NOT destroy them separately. */
 ANYCHAT_C_API AnyChatAuthHandle anychat_client_get_auth(AnyChatClientHandle handle);
@@ -70,9 +70,15 @@ typedef struct {
 /* Fired when any conversation is created or updated. */
 typedef void (*AnyChatConvUpdatedCallback)(void* userdata, const AnyChatConversation_C* conversation);
 
+/* Batched form, used when listener_batch_window_ms is set in the client
+ * config; each conversation appears once, in its latest state. */
+typedef void (*AnyChatConvsUpdatedCallback)(void* userdata, const AnyChatConversationList_C* conversations);
+
 typedef struct {
     void* userdata;
     AnyChatConvUpdatedCallback on_conversation_updated;
+    /* When NULL, batches go to on_conversation_updated one by one. */
+    AnyChatConvsUpdatedCallback on_conversations_updated;
 } AnyChatConvListener_C;
 
 /* ---- Conversation operations ---- */
@@ -11,6 +11,7 @@ extern "C" {
 typedef void (*AnyChatFileInfoSuccessCallback)(void* userdata, const AnyChatFileInfo_C* info);
 typedef void (*AnyChatDownloadUrlSuccessCallback)(void* userdata, const char* url);
 typedef void (*AnyChatFileListSuccessCallback)(void* userdata, const AnyChatFileList_C* list);
+typedef void (*AnyChatDownloadSuccessCallback)(void* userdata, const char* local_path);
 
 typedef struct {
     void* userdata;
@@ -33,12 +34,53 @@ typedef struct {
     AnyChatErrorCallback on_error;
 } AnyChatDownloadUrlCallback_C;
 
+/* Progress during download: total is 0 until the size is known. */
+typedef void (*AnyChatDownloadProgressCallback)(void* userdata, int64_t downloaded, int64_t total);
+
+typedef struct {
+    void* userdata;
+    AnyChatDownloadSuccessCallback on_success;
+    AnyChatErrorCallback on_error;
+} AnyChatDownloadCallback_C;
+
 typedef struct {
     void* userdata;
     AnyChatFileListSuccessCallback on_success;
     AnyChatErrorCallback on_error;
 } AnyChatFileListCallback_C;
 
+/* Aggregate progress of the upload queue's current batch (every job queued
+ * since the queue was last idle). */
+typedef struct {
+    int64_t uploaded_bytes;
+    int64_t total_bytes;
+    int queued;
+    int running;
+    int succeeded;
+    int failed;
+} AnyChatUploadQueueProgress_C;
+
+typedef void (*AnyChatUploadQueueProgressCallback)(void* userdata, const AnyChatUploadQueueProgress_C* progress);
+
+/* Fired for every finished queued upload, including jobs restored from a
+ * previous run. code is 0 on success; info is NULL on failure. */
+typedef void (*AnyChatUploadJobDoneCallback)(
+    void* userdata,
+    int64_t job_id,
+    int code,
+    const char* error,
+    const AnyChatFileInfo_C* info
+);
+
+typedef struct {
+    void* userdata;
+    AnyChatUploadQueueProgressCallback on_progress;
+    AnyChatUploadJobDoneCallback on_job_done;
+} AnyChatUploadQueueListener_C;
+
+/* Read-only memory mapping of a cached media file. */
+typedef void* AnyChatMappedFileHandle;
+
 /* ---- File operations ---- */
 
 /* Upload a local file.
@@ -53,6 +95,56 @@ ANYCHAT_C_API int anychat_file_upload(
     const AnyChatFileInfoCallback_C* on_done
 );
 
+/* Upload a large local file in parts, several at a time.
+ * part_size: bytes per part; <= 0 uses the SDK default (8 MiB).
+ * parallelism: concurrent part uploads; <= 0 uses the SDK default (3).
+ * Completed parts are remembered in the local database: calling this again
+ * for the same unmodified file after a failure resumes where it stopped. */
+ANYCHAT_C_API int anychat_file_upload_multipart(
+    AnyChatFileHandle handle,
+    const char* local_path,
+    int32_t file_type,
+    int64_t part_size,
+    int parallelism,
+    AnyChatUploadProgressCallback on_progress,
+    const AnyChatFileInfoCallback_C* on_done
+);
+
+/* ---- Upload queue ----
+ * Queued uploads run at most max_concurrent at a time (default 2), highest
+ * priority first, under an optional aggregate bandwidth limit. Queued jobs are
+ * kept in the local database; after a restart they are restored with the
+ * queue paused, and report only through the queue listener once
+ * anychat_file_queue_resume() is called. */
+
+/* Queue a local file for upload. Stores the job id in out_job_id (may be
+ * NULL). on_done fires when this job finishes, fails or is cancelled. */
+ANYCHAT_C_API int anychat_file_queue_upload(
+    AnyChatFileHandle handle,
+    const char* local_path,
+    int32_t file_type,
+    int32_t priority,
+    const AnyChatFileInfoCallback_C* on_done,
+    int64_t* out_job_id
+);
+
+/* Cancel a job that has not started yet.
+ * Returns ANYCHAT_ERROR_NOT_FOUND if it is unknown or already running. */
+ANYCHAT_C_API int anychat_file_queue_cancel(AnyChatFileHandle handle, int64_t job_id);
+
+/* Stop starting queued jobs; running uploads finish normally. */
+ANYCHAT_C_API int anychat_file_queue_pause(AnyChatFileHandle handle);
+
+ANYCHAT_C_API int anychat_file_queue_resume(AnyChatFileHandle handle);
+
+/* max_concurrent: clamped to [1, 8].
+ * max_bytes_per_sec: aggregate upload bandwidth, 0 = unlimited. The limit
+ * applies to uploads started after the call. */
+ANYCHAT_C_API int anychat_file_queue_configure(AnyChatFileHandle handle, int max_concurrent, int64_t max_bytes_per_sec);
+
+/* listener == NULL clears the current listener. */
+ANYCHAT_C_API int anychat_file_queue_set_listener(AnyChatFileHandle handle, const AnyChatUploadQueueListener_C* listener);
+
 /* Retrieve a presigned download URL for a file. */
 ANYCHAT_C_API int anychat_file_get_download_url(
     AnyChatFileHandle handle,
@@ -60,6 +152,55 @@ ANYCHAT_C_API int anychat_file_get_download_url(
     const AnyChatDownloadUrlCallback_C* callback
 );
 
+/* Download a file to dest_path.
+ * Large files are fetched as parallel byte ranges into "<dest_path>.part",
+ * which is renamed to dest_path once its size has been verified. Finished
+ * ranges are remembered, so retrying after a failure resumes the download.
+ * Concurrent calls for the same file_id share one transfer; on_success then
+ * receives the path the file was actually written to.
+ * on_progress: may be NULL. */
+ANYCHAT_C_API int anychat_file_download(
+    AnyChatFileHandle handle,
+    const char* file_id,
+    const char* dest_path,
+    AnyChatDownloadProgressCallback on_progress,
+    const AnyChatDownloadCallback_C* callback
+);
+
+/* Return the local path of a media file, downloading it into the media cache
+ * on a miss. Cache hits call on_success synchronously without any network
+ * request. Fails when the client has no media_cache_dir configured.
+ * on_progress: may be NULL. */
+ANYCHAT_C_API int anychat_file_fetch_media(
+    AnyChatFileHandle handle,
+    const char* file_id,
+    AnyChatDownloadProgressCallback on_progress,
+    const AnyChatDownloadCallback_C* callback
+);
+
+/* Look up a file in the media cache without touching the network.
+ * Copies the cached path into out_path and returns ANYCHAT_OK, or
+ * ANYCHAT_ERROR_NOT_FOUND on a miss. */
+ANYCHAT_C_API int anychat_file_cache_lookup(
+    AnyChatFileHandle handle,
+    const char* file_id,
+    char* out_path,
+    int out_path_size
+);
+
+/* Map a cached media file read-only for zero-copy access. On a hit, stores the
+ * data pointer and size and returns a handle that must be released with
+ * anychat_file_cache_unmap(); returns NULL on a miss. The data stays valid
+ * until unmapped, even if the file is evicted meanwhile (POSIX). */
+ANYCHAT_C_API AnyChatMappedFileHandle anychat_file_cache_map(
+    AnyChatFileHandle handle,
+    const char* file_id,
+    const uint8_t** out_data,
+    int64_t* out_size
+);
+
+ANYCHAT_C_API void anychat_file_cache_unmap(AnyChatMappedFileHandle mapped);
+
 /* Retrieve metadata for a single file. */
 ANYCHAT_C_API int anychat_file_get_info(
     AnyChatFileHandle handle,
@@ -48,6 +48,16 @@ typedef void (*AnyChatMessageReceivedCallback)(void* userdata, const AnyChatMess
 typedef void (*AnyChatMessageReadReceiptCallback)(void* userdata, const AnyChatMessageReadReceiptEvent_C* event);
 typedef void (*AnyChatMessageTypingCallback)(void* userdata, const AnyChatMessageTypingEvent_C* event);
 
+/* Batched forms, used when listener_batch_window_ms is set in the client
+ * config. Arrays are only valid during the callback. */
+typedef void (*AnyChatMessagesReceivedCallback)(void* userdata, const AnyChatMessageList_C* messages);
+typedef void (*AnyChatMessageReadReceiptsCallback)(
+    void* userdata,
+    const AnyChatMessageReadReceiptEvent_C* events,
+    int count
+);
+typedef void (*AnyChatMessageTypingsCallback)(void* userdata, const AnyChatMessageTypingEvent_C* events, int count);
+
 typedef struct {
     void* userdata;
     AnyChatMessageReceivedCallback on_message_received;
@@ -57,6 +67,11 @@ typedef struct {
     AnyChatMessageReceivedCallback on_message_edited;
     AnyChatMessageTypingCallback on_message_typing;
     AnyChatMessageReceivedCallback on_message_mentioned;
+    /* Batched delivery; when NULL, each event of the batch goes to the
+     * matching single-event callback above. */
+    AnyChatMessagesReceivedCallback on_messages_received;
+    AnyChatMessageReadReceiptsCallback on_message_read_receipts;
+    AnyChatMessageTypingsCallback on_message_typings;
 } AnyChatMessageListener_C;
 
 /* ---- Message operations ---- */
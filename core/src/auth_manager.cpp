@@ -141,7 +141,7 @@ AuthManagerImpl::AuthManagerImpl(
     }
 
     if (notif_mgr) {
-        notif_mgr->addNotificationHandler([this](const NotificationEvent& event) {
+        notif_mgr->subscribe("auth.force_logout", [this](const NotificationEvent& event) {
             handleAuthNotification(event);
         });
     }
@@ -556,10 +556,6 @@ void AuthManagerImpl::handleAuthResponse(network::HttpResponse resp, const AnyCh
     }
 }
 void AuthManagerImpl::handleAuthNotification(const NotificationEvent& event) {
-    if (event.notification_type != "auth.force_logout") {
-        return;
-    }
-
     std::string target_device_id;
     ForceLogoutPayload payload{};
     std::string err;
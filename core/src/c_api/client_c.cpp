@@ -3,6 +3,7 @@
 
 #include "anychat/client.h"
 
+#include <algorithm>
 #include <exception>
 #include <string>
 
@@ -100,6 +101,26 @@ AnyChatClientHandle anychat_client_create(const AnyChatClientConfig_C* config) {
             cpp_config.max_reconnect_attempts = config->max_reconnect_attempts;
         }
         cpp_config.auto_reconnect = config->auto_reconnect != 0;
+        if (config->media_cache_dir) {
+            cpp_config.media_cache_dir = config->media_cache_dir;
+        }
+        if (config->media_cache_max_bytes > 0) {
+            cpp_config.media_cache_max_bytes = config->media_cache_max_bytes;
+        }
+        cpp_config.compress_request_bodies = config->compress_request_bodies != 0;
+        cpp_config.ws_permessage_deflate = config->ws_permessage_deflate != 0;
+        if (config->ws_deflate_window_bits > 0) {
+            cpp_config.ws_deflate_window_bits = config->ws_deflate_window_bits;
+        }
+        cpp_config.ws_deflate_no_context_takeover = config->ws_deflate_no_context_takeover != 0;
+        cpp_config.ws_binary_frames = config->ws_binary_frames != 0;
+        if (config->dispatch_threads != 0) {
+            cpp_config.dispatch_threads = std::max(config->dispatch_threads, 0);
+        }
+        if (config->dispatch_queue_limit > 0) {
+            cpp_config.dispatch_queue_limit = static_cast<size_t>(config->dispatch_queue_limit);
+        }
+        cpp_config.listener_batch_window_ms = std::max(config->listener_batch_window_ms, 0);
 
         auto* client = new anychat::AnyChatClient(cpp_config);
         return static_cast<AnyChatClientHandle>(client);
@@ -229,6 +250,42 @@ void anychat_client_set_connection_callback(
     }
 }
 
+char* anychat_client_get_http_stats_json(AnyChatClientHandle handle) {
+    auto* client = static_cast<anychat::AnyChatClient*>(handle);
+    if (!client) {
+        return nullptr;
+    }
+
+    try {
+        const std::string json = client->httpStatsJson();
+        return json.empty() ? nullptr : anychat_strdup(json.c_str());
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+void anychat_client_reset_http_stats(AnyChatClientHandle handle) {
+    auto* client = static_cast<anychat::AnyChatClient*>(handle);
+    if (!client) {
+        return;
+    }
+    client->resetHttpStats();
+}
+
+char* anychat_client_get_ws_stats_json(AnyChatClientHandle handle) {
+    auto* client = static_cast<anychat::AnyChatClient*>(handle);
+    if (!client) {
+        return nullptr;
+    }
+
+    try {
+        const std::string json = client->webSocketStatsJson();
+        return json.empty() ? nullptr : anychat_strdup(json.c_str());
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
 AnyChatAuthHandle anychat_client_get_auth(AnyChatClientHandle handle) {
     auto* client = static_cast<anychat::AnyChatClient*>(handle);
     if (!client) {
@@ -47,6 +47,19 @@ public:
         listener_.on_conversation_updated(listener_.userdata, &c_conv);
     }
 
+    void onConversationsUpdated(const std::vector<anychat::Conversation>& convs) override {
+        if (!listener_.on_conversations_updated) {
+            ConversationListener::onConversationsUpdated(convs);
+            return;
+        }
+        std::vector<AnyChatConversation_C> c_convs(convs.size());
+        for (size_t i = 0; i < convs.size(); ++i) {
+            convToCStruct(convs[i], &c_convs[i]);
+        }
+        const AnyChatConversationList_C c_list{ c_convs.data(), static_cast<int>(c_convs.size()) };
+        listener_.on_conversations_updated(listener_.userdata, &c_list);
+    }
+
 private:
     AnyChatConvListener_C listener_{};
 };
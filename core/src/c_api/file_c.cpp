@@ -107,6 +107,184 @@ int anychat_file_upload(
     return ANYCHAT_OK;
 }
 
+int anychat_file_upload_multipart(
+    AnyChatFileHandle handle,
+    const char* local_path,
+    int32_t file_type,
+    int64_t part_size,
+    int parallelism,
+    AnyChatUploadProgressCallback on_progress,
+    const AnyChatFileInfoCallback_C* on_done
+) {
+    auto* impl = static_cast<anychat::FileManagerImpl*>(handle);
+    if (!impl || !local_path) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+    if (!validateCallbackStruct(on_done)) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+
+    anychat::MultipartUploadOptions options;
+    if (part_size > 0) {
+        options.part_size = part_size;
+    }
+    if (parallelism > 0) {
+        options.parallelism = parallelism;
+    }
+
+    const AnyChatFileInfoCallback_C callback_copy = copyCallbackStruct(on_done);
+
+    impl->uploadMultipart(
+        local_path,
+        file_type,
+        options,
+        [userdata = callback_copy.userdata, on_progress](int64_t uploaded, int64_t total) {
+            if (on_progress)
+                on_progress(userdata, uploaded, total);
+        },
+        anychat::AnyChatValueCallback<anychat::FileInfo>{
+            .on_success =
+                [callback_copy](const anychat::FileInfo& info) {
+                    if (!callback_copy.on_success) {
+                        return;
+                    }
+                    AnyChatFileInfo_C c_info{};
+                    fileInfoToC(info, &c_info);
+                    callback_copy.on_success(callback_copy.userdata, &c_info);
+                },
+            .on_error =
+                [callback_copy](int code, const std::string& error) {
+                    invokeFileError(callback_copy, code, error);
+                },
+        }
+    );
+
+    return ANYCHAT_OK;
+}
+
+int anychat_file_queue_upload(
+    AnyChatFileHandle handle,
+    const char* local_path,
+    int32_t file_type,
+    int32_t priority,
+    const AnyChatFileInfoCallback_C* on_done,
+    int64_t* out_job_id
+) {
+    auto* impl = static_cast<anychat::FileManagerImpl*>(handle);
+    if (!impl || !local_path) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+    if (!validateCallbackStruct(on_done)) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+
+    const AnyChatFileInfoCallback_C callback_copy = copyCallbackStruct(on_done);
+    const int64_t job_id = impl->uploadScheduler().enqueue(
+        local_path,
+        file_type,
+        priority,
+        anychat::AnyChatValueCallback<anychat::FileInfo>{
+            .on_success =
+                [callback_copy](const anychat::FileInfo& info) {
+                    if (callback_copy.on_success) {
+                        AnyChatFileInfo_C c_info{};
+                        fileInfoToC(info, &c_info);
+                        callback_copy.on_success(callback_copy.userdata, &c_info);
+                    }
+                },
+            .on_error =
+                [callback_copy](int code, const std::string& error) {
+                    invokeFileError(callback_copy, code, error);
+                },
+        }
+    );
+    if (out_job_id) {
+        *out_job_id = job_id;
+    }
+    return ANYCHAT_OK;
+}
+
+int anychat_file_queue_cancel(AnyChatFileHandle handle, int64_t job_id) {
+    auto* impl = static_cast<anychat::FileManagerImpl*>(handle);
+    if (!impl) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+    return impl->uploadScheduler().cancel(job_id) ? ANYCHAT_OK : ANYCHAT_ERROR_NOT_FOUND;
+}
+
+int anychat_file_queue_pause(AnyChatFileHandle handle) {
+    auto* impl = static_cast<anychat::FileManagerImpl*>(handle);
+    if (!impl) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+    impl->uploadScheduler().pause();
+    return ANYCHAT_OK;
+}
+
+int anychat_file_queue_resume(AnyChatFileHandle handle) {
+    auto* impl = static_cast<anychat::FileManagerImpl*>(handle);
+    if (!impl) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+    impl->uploadScheduler().resume();
+    return ANYCHAT_OK;
+}
+
+int anychat_file_queue_configure(AnyChatFileHandle handle, int max_concurrent, int64_t max_bytes_per_sec) {
+    auto* impl = static_cast<anychat::FileManagerImpl*>(handle);
+    if (!impl || max_bytes_per_sec < 0) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+    impl->uploadScheduler().setConfig(
+        anychat::UploadSchedulerConfig{ .max_concurrent = max_concurrent, .max_bytes_per_sec = max_bytes_per_sec }
+    );
+    return ANYCHAT_OK;
+}
+
+int anychat_file_queue_set_listener(AnyChatFileHandle handle, const AnyChatUploadQueueListener_C* listener) {
+    auto* impl = static_cast<anychat::FileManagerImpl*>(handle);
+    if (!impl) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+    anychat::UploadScheduler& scheduler = impl->uploadScheduler();
+    if (!listener) {
+        scheduler.setQueueProgressListener(nullptr);
+        scheduler.setJobListener(nullptr);
+        return ANYCHAT_OK;
+    }
+
+    const AnyChatUploadQueueListener_C copied = *listener;
+    scheduler.setQueueProgressListener([copied](const anychat::UploadQueueProgress& progress) {
+        if (!copied.on_progress) {
+            return;
+        }
+        AnyChatUploadQueueProgress_C c_progress{
+            .uploaded_bytes = progress.uploaded_bytes,
+            .total_bytes = progress.total_bytes,
+            .queued = progress.queued,
+            .running = progress.running,
+            .succeeded = progress.succeeded,
+            .failed = progress.failed,
+        };
+        copied.on_progress(copied.userdata, &c_progress);
+    });
+    scheduler.setJobListener(
+        [copied](int64_t job_id, int code, const std::string& error, const anychat::FileInfo& info) {
+            if (!copied.on_job_done) {
+                return;
+            }
+            if (code != 0) {
+                copied.on_job_done(copied.userdata, job_id, code, error.empty() ? nullptr : error.c_str(), nullptr);
+                return;
+            }
+            AnyChatFileInfo_C c_info{};
+            fileInfoToC(info, &c_info);
+            copied.on_job_done(copied.userdata, job_id, 0, nullptr, &c_info);
+        }
+    );
+    return ANYCHAT_OK;
+}
+
 int anychat_file_get_download_url(
     AnyChatFileHandle handle,
     const char* file_id,
@@ -139,6 +317,129 @@ int anychat_file_get_download_url(
     return ANYCHAT_OK;
 }
 
+int anychat_file_download(
+    AnyChatFileHandle handle,
+    const char* file_id,
+    const char* dest_path,
+    AnyChatDownloadProgressCallback on_progress,
+    const AnyChatDownloadCallback_C* callback
+) {
+    auto* impl = static_cast<anychat::FileManagerImpl*>(handle);
+    if (!impl || !file_id || !dest_path) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+    if (!validateCallbackStruct(callback)) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+
+    const AnyChatDownloadCallback_C callback_copy = copyCallbackStruct(callback);
+    impl->download(
+        file_id,
+        dest_path,
+        [userdata = callback_copy.userdata, on_progress](int64_t downloaded, int64_t total) {
+            if (on_progress)
+                on_progress(userdata, downloaded, total);
+        },
+        anychat::AnyChatValueCallback<std::string>{
+            .on_success =
+                [callback_copy](const std::string& local_path) {
+                    if (callback_copy.on_success) {
+                        callback_copy.on_success(callback_copy.userdata, local_path.c_str());
+                    }
+                },
+            .on_error =
+                [callback_copy](int code, const std::string& error) {
+                    invokeFileError(callback_copy, code, error);
+                },
+        }
+    );
+    return ANYCHAT_OK;
+}
+
+int anychat_file_fetch_media(
+    AnyChatFileHandle handle,
+    const char* file_id,
+    AnyChatDownloadProgressCallback on_progress,
+    const AnyChatDownloadCallback_C* callback
+) {
+    auto* impl = static_cast<anychat::FileManagerImpl*>(handle);
+    if (!impl || !file_id) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+    if (!validateCallbackStruct(callback)) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+
+    const AnyChatDownloadCallback_C callback_copy = copyCallbackStruct(callback);
+    impl->fetchMedia(
+        file_id,
+        [userdata = callback_copy.userdata, on_progress](int64_t downloaded, int64_t total) {
+            if (on_progress)
+                on_progress(userdata, downloaded, total);
+        },
+        anychat::AnyChatValueCallback<std::string>{
+            .on_success =
+                [callback_copy](const std::string& local_path) {
+                    if (callback_copy.on_success) {
+                        callback_copy.on_success(callback_copy.userdata, local_path.c_str());
+                    }
+                },
+            .on_error =
+                [callback_copy](int code, const std::string& error) {
+                    invokeFileError(callback_copy, code, error);
+                },
+        }
+    );
+    return ANYCHAT_OK;
+}
+
+int anychat_file_cache_lookup(AnyChatFileHandle handle, const char* file_id, char* out_path, int out_path_size) {
+    auto* impl = static_cast<anychat::FileManagerImpl*>(handle);
+    if (!impl || !file_id || !out_path || out_path_size <= 0) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+    anychat::cache::MediaCache* media_cache = impl->mediaCache();
+    if (!media_cache) {
+        return ANYCHAT_ERROR_NOT_FOUND;
+    }
+
+    auto path = media_cache->lookup(file_id);
+    if (!path) {
+        return ANYCHAT_ERROR_NOT_FOUND;
+    }
+    if (path->size() >= static_cast<size_t>(out_path_size)) {
+        return ANYCHAT_ERROR_INVALID_PARAM;
+    }
+    anychat_strlcpy(out_path, path->c_str(), static_cast<size_t>(out_path_size));
+    return ANYCHAT_OK;
+}
+
+AnyChatMappedFileHandle anychat_file_cache_map(
+    AnyChatFileHandle handle,
+    const char* file_id,
+    const uint8_t** out_data,
+    int64_t* out_size
+) {
+    auto* impl = static_cast<anychat::FileManagerImpl*>(handle);
+    if (!impl || !file_id || !out_data || !out_size || !impl->mediaCache()) {
+        return nullptr;
+    }
+
+    anychat::cache::MappedFile mapped = impl->mediaCache()->map(file_id);
+    if (!mapped.valid()) {
+        return nullptr;
+    }
+
+    auto* owned = new anychat::cache::MappedFile(std::move(mapped));
+    *out_data = owned->data();
+    *out_size = owned->size();
+    return static_cast<AnyChatMappedFileHandle>(owned);
+}
+
+void anychat_file_cache_unmap(AnyChatMappedFileHandle mapped) {
+    delete static_cast<anychat::cache::MappedFile*>(mapped);
+}
+
 int anychat_file_get_info(AnyChatFileHandle handle, const char* file_id, const AnyChatFileInfoCallback_C* callback) {
     auto* impl = static_cast<anychat::FileManagerImpl*>(handle);
     if (!impl || !file_id) {
@@ -149,6 +149,41 @@ public:
         std::free(c_msg.content);
     }
 
+    void onMessagesReceived(const std::vector<anychat::Message>& messages) override {
+        if (!listener_.on_messages_received) {
+            MessageListener::onMessagesReceived(messages);
+            return;
+        }
+        AnyChatMessageList_C c_list{};
+        fillMessageArray(messages, &c_list.items, &c_list.count);
+        listener_.on_messages_received(listener_.userdata, &c_list);
+        anychat_free_message_list(&c_list);
+    }
+
+    void onMessageReadReceipts(const std::vector<anychat::MessageReadReceiptEvent>& events) override {
+        if (!listener_.on_message_read_receipts) {
+            MessageListener::onMessageReadReceipts(events);
+            return;
+        }
+        std::vector<AnyChatMessageReadReceiptEvent_C> c_events(events.size());
+        for (size_t i = 0; i < events.size(); ++i) {
+            readReceiptToCStruct(events[i], &c_events[i]);
+        }
+        listener_.on_message_read_receipts(listener_.userdata, c_events.data(), static_cast<int>(c_events.size()));
+    }
+
+    void onMessageTypings(const std::vector<anychat::MessageTypingEvent>& events) override {
+        if (!listener_.on_message_typings) {
+            MessageListener::onMessageTypings(events);
+            return;
+        }
+        std::vector<AnyChatMessageTypingEvent_C> c_events(events.size());
+        for (size_t i = 0; i < events.size(); ++i) {
+            typingToCStruct(events[i], &c_events[i]);
+        }
+        listener_.on_message_typings(listener_.userdata, c_events.data(), static_cast<int>(c_events.size()));
+    }
+
 private:
     AnyChatMessageListener_C listener_{};
 };
@@ -118,6 +118,39 @@ public:
         }
     }
 
+    // Move the summary of a cached conversation forward to `msg`: the last
+    // message only if `msg` is not older than it, and local_seq only up to
+    // `local_seq` (0 leaves it alone).  Never moves either backwards.
+    void advanceSummary(const std::string& conv_id, const Message& msg, int64_t local_seq) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        for (auto& c : convs_) {
+            if (c.conv_id == conv_id) {
+                if (local_seq > c.local_seq)
+                    c.local_seq = local_seq;
+                if (msg.timestamp_ms >= c.last_msg_time_ms) {
+                    c.last_msg_id = msg.message_id;
+                    c.last_msg_text = msg.content;
+                    c.last_msg_time_ms = msg.timestamp_ms;
+                    sort();
+                }
+                return;
+            }
+        }
+    }
+
+    // Move the local_seq of a cached conversation up to `local_seq`; never
+    // backwards.
+    void advanceLocalSeq(const std::string& conv_id, int64_t local_seq) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        for (auto& c : convs_) {
+            if (c.conv_id == conv_id) {
+                if (local_seq > c.local_seq)
+                    c.local_seq = local_seq;
+                return;
+            }
+        }
+    }
+
     void clear() {
         std::lock_guard<std::mutex> lk(mutex_);
         convs_.clear();
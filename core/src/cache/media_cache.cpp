@@ -0,0 +1,320 @@
+#include "media_cache.h"
+
+#include "json_common.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace anychat {
+namespace cache {
+
+namespace fs = std::filesystem;
+
+using db::rowInt64;
+using db::rowText;
+using json_common::nowMs;
+
+namespace {
+
+int64_t fileSize(const std::string& path) {
+    std::error_code ec;
+    const auto size = fs::file_size(fs::path(path), ec);
+    return ec ? -1 : static_cast<int64_t>(size);
+}
+
+// Moves |from| to |to|, falling back to copy + delete across file systems.
+bool moveFile(const std::string& from, const std::string& to) {
+    std::error_code ec;
+    fs::rename(fs::path(from), fs::path(to), ec);
+    if (!ec)
+        return true;
+    fs::copy_file(fs::path(from), fs::path(to), fs::copy_options::overwrite_existing, ec);
+    if (ec)
+        return false;
+    fs::remove(fs::path(from), ec);
+    return true;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// MappedFile
+// ---------------------------------------------------------------------------
+
+MappedFile::~MappedFile() {
+    reset();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr))
+    , size_(std::exchange(other.size_, 0))
+#ifdef _WIN32
+    , mapping_(std::exchange(other.mapping_, nullptr))
+#endif
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        reset();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+        mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+    }
+    return *this;
+}
+
+void MappedFile::reset() {
+    if (!data_)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle(static_cast<HANDLE>(mapping_));
+    mapping_ = nullptr;
+#else
+    ::munmap(const_cast<uint8_t*>(data_), static_cast<size_t>(size_));
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+MappedFile MappedFile::open(const std::string& path) {
+    MappedFile mapped;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE)
+        return mapped;
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return mapped;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file); // the mapping keeps the file open
+    if (!mapping)
+        return mapped;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return mapped;
+    }
+    mapped.data_ = static_cast<const uint8_t*>(view);
+    mapped.size_ = static_cast<int64_t>(size.QuadPart);
+    mapped.mapping_ = mapping;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return mapped;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return mapped;
+    }
+    void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping stays valid after close
+    if (addr == MAP_FAILED)
+        return mapped;
+    mapped.data_ = static_cast<const uint8_t*>(addr);
+    mapped.size_ = static_cast<int64_t>(st.st_size);
+#endif
+    return mapped;
+}
+
+// ---------------------------------------------------------------------------
+// MediaCache
+// ---------------------------------------------------------------------------
+
+MediaCache::MediaCache(std::string directory, int64_t max_bytes, db::Database* db)
+    : directory_(std::move(directory))
+    , db_(db)
+    , max_bytes_(max_bytes > 0 ? max_bytes : kDefaultMediaCacheBytes) {
+    std::error_code ec;
+    fs::create_directories(fs::path(directory_), ec);
+    loadIndex();
+}
+
+void MediaCache::loadIndex() {
+    if (!db_ || !db_->isOpen())
+        return;
+
+    const db::Rows rows =
+        db_->querySync("SELECT file_id, path, size, last_access FROM media_cache ORDER BY last_access DESC");
+
+    std::lock_guard<std::mutex> lk(mutex_);
+    for (const auto& row : rows) {
+        MediaCacheEntry entry{
+            .file_id = rowText(row, "file_id"),
+            .path = rowText(row, "path"),
+            .size = rowInt64(row, "size"),
+            .last_access_ms = rowInt64(row, "last_access"),
+        };
+        // Files removed behind our back (e.g. by the OS clearing caches).
+        if (entry.file_id.empty() || fileSize(entry.path) != entry.size) {
+            db_->exec("DELETE FROM media_cache WHERE file_id = ?", { entry.file_id });
+            continue;
+        }
+        total_bytes_ += entry.size;
+        lru_.push_back(std::move(entry));
+        index_[lru_.back().file_id] = std::prev(lru_.end());
+    }
+    evictLocked();
+}
+
+std::optional<std::string> MediaCache::lookup(const std::string& file_id) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = index_.find(file_id);
+    if (it == index_.end()) {
+        ++misses_;
+        return std::nullopt;
+    }
+    if (fileSize(it->second->path) != it->second->size) {
+        eraseLocked(it->second, false);
+        ++misses_;
+        return std::nullopt;
+    }
+    ++hits_;
+    touchLocked(it->second);
+    return lru_.front().path;
+}
+
+std::string MediaCache::pathFor(const std::string& file_id) const {
+    // file_ids are server-generated but still must not escape the directory.
+    std::string name;
+    bool changed = false;
+    for (char c : file_id) {
+        const bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-'
+                          || c == '_';
+        name += safe ? c : '_';
+        changed = changed || !safe;
+    }
+    if (name.empty() || changed) {
+        std::ostringstream suffix;
+        suffix << std::hex << std::hash<std::string>{}(file_id);
+        name += "_" + suffix.str();
+    }
+    return (fs::path(directory_) / name).string();
+}
+
+std::optional<std::string> MediaCache::insert(const std::string& file_id, const std::string& path) {
+    const std::string target = pathFor(file_id);
+    if (fs::path(path).lexically_normal() != fs::path(target).lexically_normal() && !moveFile(path, target))
+        return std::nullopt;
+
+    const int64_t size = fileSize(target);
+    if (size < 0)
+        return std::nullopt;
+
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = index_.find(file_id);
+    if (it != index_.end()) {
+        // Same target path: the file on disk is the new content already.
+        eraseLocked(it->second, false);
+    }
+
+    lru_.push_front(MediaCacheEntry{ .file_id = file_id, .path = target, .size = size, .last_access_ms = nowMs() });
+    index_[file_id] = lru_.begin();
+    total_bytes_ += size;
+
+    if (db_ && db_->isOpen()) {
+        db_->exec(
+            "INSERT OR REPLACE INTO media_cache (file_id, path, size, last_access) VALUES (?, ?, ?, ?)",
+            { file_id, target, size, lru_.front().last_access_ms }
+        );
+    }
+
+    evictLocked();
+    return target;
+}
+
+MappedFile MediaCache::map(const std::string& file_id) {
+    auto path = lookup(file_id);
+    if (!path)
+        return {};
+    return MappedFile::open(*path);
+}
+
+void MediaCache::remove(const std::string& file_id) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = index_.find(file_id);
+    if (it != index_.end())
+        eraseLocked(it->second, true);
+}
+
+void MediaCache::clear() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    while (!lru_.empty())
+        eraseLocked(std::prev(lru_.end()), true);
+}
+
+void MediaCache::setMaxBytes(int64_t max_bytes) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    max_bytes_ = max_bytes > 0 ? max_bytes : kDefaultMediaCacheBytes;
+    evictLocked();
+}
+
+MediaCacheStats MediaCache::stats() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return MediaCacheStats{
+        .hits = hits_,
+        .misses = misses_,
+        .evictions = evictions_,
+        .total_bytes = total_bytes_,
+        .entries = lru_.size(),
+    };
+}
+
+void MediaCache::touchLocked(EntryList::iterator it) {
+    it->last_access_ms = nowMs();
+    lru_.splice(lru_.begin(), lru_, it);
+    if (db_ && db_->isOpen()) {
+        db_->exec("UPDATE media_cache SET last_access = ? WHERE file_id = ?", { it->last_access_ms, it->file_id });
+    }
+}
+
+void MediaCache::eraseLocked(EntryList::iterator it, bool delete_file) {
+    if (delete_file) {
+        std::error_code ec;
+        fs::remove(fs::path(it->path), ec);
+    }
+    if (db_ && db_->isOpen()) {
+        db_->exec("DELETE FROM media_cache WHERE file_id = ?", { it->file_id });
+    }
+    total_bytes_ -= it->size;
+    index_.erase(it->file_id);
+    lru_.erase(it);
+}
+
+void MediaCache::evictLocked() {
+    while (total_bytes_ > max_bytes_ && lru_.size() > 1) {
+        eraseLocked(std::prev(lru_.end()), true);
+        ++evictions_;
+    }
+}
+
+} // namespace cache
+} // namespace anychat
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "db/database.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace anychat {
+namespace cache {
+
+// Read-only memory mapping of a whole file. Move-only; unmapped on
+// destruction. An invalid mapping has data() == nullptr.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps |path|; returns an invalid mapping for missing or empty files.
+    static MappedFile open(const std::string& path);
+
+    const uint8_t* data() const {
+        return data_;
+    }
+    int64_t size() const {
+        return size_;
+    }
+    bool valid() const {
+        return data_ != nullptr;
+    }
+
+private:
+    void reset();
+
+    const uint8_t* data_ = nullptr;
+    int64_t size_ = 0;
+#ifdef _WIN32
+    void* mapping_ = nullptr; // HANDLE of the file mapping object
+#endif
+};
+
+struct MediaCacheEntry {
+    std::string file_id;
+    std::string path;
+    int64_t size = 0;
+    int64_t last_access_ms = 0;
+};
+
+struct MediaCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    int64_t total_bytes = 0;
+    size_t entries = 0;
+};
+
+static constexpr int64_t kDefaultMediaCacheBytes = 512LL * 1024 * 1024;
+
+// Size-bounded on-disk cache of downloaded media, keyed by file_id.
+//
+// Files live in |directory|; the index (file_id, path, size, last access) is
+// kept in memory as an LRU list and mirrored to the media_cache table so it
+// survives restarts. Whenever the total size exceeds the byte budget the
+// least recently used files are deleted, except the newest entry, which is
+// always kept so that a single oversized file can still be served.
+//
+// All public methods are thread-safe.
+class MediaCache {
+public:
+    // |db| is optional; without an open database the index starts empty on
+    // every launch.
+    MediaCache(std::string directory, int64_t max_bytes = kDefaultMediaCacheBytes, db::Database* db = nullptr);
+
+    // Path of the cached file, promoted to most recently used. Entries whose
+    // file has disappeared from disk are dropped and reported as a miss.
+    std::optional<std::string> lookup(const std::string& file_id);
+
+    // Where a download of |file_id| should be written so that insert() does
+    // not have to move it.
+    std::string pathFor(const std::string& file_id) const;
+
+    // Adds or replaces |file_id|. A file outside the cache directory is moved
+    // in. Returns the cached path, or nullopt if the file is missing or cannot
+    // be moved.
+    std::optional<std::string> insert(const std::string& file_id, const std::string& path);
+
+    // Maps the cached file for zero-copy reads; counts as an access.
+    MappedFile map(const std::string& file_id);
+
+    void remove(const std::string& file_id);
+    void clear();
+
+    void setMaxBytes(int64_t max_bytes);
+
+    MediaCacheStats stats() const;
+
+    const std::string& directory() const {
+        return directory_;
+    }
+
+private:
+    using EntryList = std::list<MediaCacheEntry>;
+
+    void loadIndex();
+    void touchLocked(EntryList::iterator it);
+    void eraseLocked(EntryList::iterator it, bool delete_file);
+    void evictLocked();
+
+    const std::string directory_;
+    db::Database* db_;
+
+    mutable std::mutex mutex_;
+    int64_t max_bytes_;
+    int64_t total_bytes_ = 0;
+    EntryList lru_; // front = most recently used
+    std::unordered_map<std::string, EntryList::iterator> index_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+};
+
+} // namespace cache
+} // namespace anychat
@@ -7,6 +7,7 @@
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace anychat {
@@ -54,6 +55,54 @@ public:
         }
     }
 
+    // Add several messages under one lock.  Each touched bucket is merged
+    // once rather than re-sorted per message, then trimmed to capacity.
+    // Returns, per message, whether it was added; false for a message_id
+    // that was already cached or appears earlier in `msgs`.
+    std::vector<bool> insertBatch(const std::vector<Message>& msgs) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        std::vector<bool> added(msgs.size(), false);
+
+        // Touched bucket → its size before this batch.
+        std::vector<std::pair<std::vector<Message>*, size_t>> touched;
+        for (size_t i = 0; i < msgs.size(); ++i) {
+            const Message& msg = msgs[i];
+            auto& bucket = buckets_[msg.conv_id];
+            auto t = std::find_if(touched.begin(), touched.end(), [&](const auto& entry) {
+                return entry.first == &bucket;
+            });
+            if (t == touched.end()) {
+                t = touched.insert(touched.end(), { &bucket, bucket.size() });
+            }
+
+            const bool dup = std::any_of(bucket.begin(), bucket.end(), [&](const Message& m) {
+                return m.message_id == msg.message_id;
+            });
+            if (dup)
+                continue;
+            bucket.push_back(msg);
+            added[i] = true;
+        }
+
+        for (auto& [bucket, old_size] : touched) {
+            // The old part is sorted already; sort the new tail and merge.
+            const auto mid = bucket->begin() + static_cast<std::ptrdiff_t>(old_size);
+            const auto by_seq = [](const Message& a, const Message& b) {
+                return a.seq < b.seq;
+            };
+            std::stable_sort(mid, bucket->end(), by_seq);
+            std::inplace_merge(bucket->begin(), mid, bucket->end(), by_seq);
+
+            if (bucket->size() > bucket_size_) {
+                bucket->erase(
+                    bucket->begin(),
+                    bucket->begin() + static_cast<std::ptrdiff_t>(bucket->size() - bucket_size_)
+                );
+            }
+        }
+        return added;
+    }
+
     // Return a sorted-by-seq-ascending copy of all cached messages for a
     // conversation.  Returns an empty vector if the conv is unknown.
     std::vector<Message> get(const std::string& conv_id) const {
@@ -207,9 +207,24 @@ using namespace call_detail;
 CallManagerImpl::CallManagerImpl(std::shared_ptr<network::HttpClient> http, NotificationManager* notif_mgr)
     : http_(std::move(http)) {
     if (notif_mgr) {
-        notif_mgr->addNotificationHandler([this](const NotificationEvent& ev) {
-            handleCallNotification(ev);
-        });
+        notif_mgr->subscribe<CallSessionPayload>(
+            "livekit.call_invite",
+            [this](const NotificationEvent&, const CallSessionPayload& payload) {
+                handleCallInvite(payload);
+            }
+        );
+        notif_mgr->subscribe<CallStatusNotificationPayload>(
+            "livekit.call_status",
+            [this](const NotificationEvent&, const CallStatusNotificationPayload& payload) {
+                handleCallStatus(payload, false);
+            }
+        );
+        notif_mgr->subscribe<CallStatusNotificationPayload>(
+            "livekit.call_rejected",
+            [this](const NotificationEvent&, const CallStatusNotificationPayload& payload) {
+                handleCallStatus(payload, true);
+            }
+        );
     }
 }
 
@@ -502,52 +517,33 @@ void CallManagerImpl::setListener(std::shared_ptr<CallListener> listener) {
     listener_ = std::move(listener);
 }
 
-void CallManagerImpl::handleCallNotification(const NotificationEvent& event) {
-    const auto& nt = event.notification_type;
-
-    if (nt == "livekit.call_invite") {
-        std::shared_ptr<CallListener> listener;
-        {
-            std::lock_guard<std::mutex> lk(handler_mutex_);
-            listener = listener_;
-        }
-        if (listener) {
-            try {
-                CallSessionPayload payload{};
-                std::string err;
-                if (!parseJsonObject(event.data, payload, err)) {
-                    return;
-                }
-                listener->onIncomingCall(parseCallSessionPayload(payload));
-            } catch (...) {
-            }
-        }
-        return;
+void CallManagerImpl::handleCallInvite(const CallSessionPayload& payload) {
+    std::shared_ptr<CallListener> listener;
+    {
+        std::lock_guard<std::mutex> lk(handler_mutex_);
+        listener = listener_;
     }
-
-    if (nt == "livekit.call_status" || nt == "livekit.call_rejected") {
-        std::shared_ptr<CallListener> listener;
-        {
-            std::lock_guard<std::mutex> lk(handler_mutex_);
-            listener = listener_;
+    if (listener) {
+        try {
+            listener->onIncomingCall(parseCallSessionPayload(payload));
+        } catch (...) {
         }
-        if (listener) {
-            try {
-                CallStatusNotificationPayload payload{};
-                std::string err;
-                if (!parseJsonObject(event.data, payload, err)) {
-                    return;
-                }
+    }
+}
 
-                const CallStatus status =
-                    (nt == "livekit.call_rejected")
-                        ? CallStatus::Rejected
-                        : parseCallStatusValue(payload.status, CallStatus::Ringing);
-                listener->onCallStatusChanged(payload.call_id, status);
-            } catch (...) {
-            }
+void CallManagerImpl::handleCallStatus(const CallStatusNotificationPayload& payload, bool rejected) {
+    std::shared_ptr<CallListener> listener;
+    {
+        std::lock_guard<std::mutex> lk(handler_mutex_);
+        listener = listener_;
+    }
+    if (listener) {
+        try {
+            const CallStatus status =
+                rejected ? CallStatus::Rejected : parseCallStatusValue(payload.status, CallStatus::Ringing);
+            listener->onCallStatusChanged(payload.call_id, status);
+        } catch (...) {
         }
-        return;
     }
 }
 
@@ -26,6 +26,11 @@ public:
     }
 };
 
+namespace call_detail {
+struct CallSessionPayload;
+struct CallStatusNotificationPayload;
+} // namespace call_detail
+
 class CallManagerImpl {
 public:
     CallManagerImpl(std::shared_ptr<network::HttpClient> http, NotificationManager* notif_mgr);
@@ -75,7 +80,9 @@ public:
     void setListener(std::shared_ptr<CallListener> listener);
 
 private:
-    void handleCallNotification(const NotificationEvent& event);
+    void handleCallInvite(const call_detail::CallSessionPayload& payload);
+    // |rejected|: livekit.call_rejected, whose payload carries no status.
+    void handleCallStatus(const call_detail::CallStatusNotificationPayload& payload, bool rejected);
 
     std::shared_ptr<network::HttpClient> http_;
 
@@ -7,9 +7,11 @@
 #include "file_manager.h"
 #include "friend_manager.h"
 #include "group_manager.h"
+#include "message_ingestor.h"
 #include "message_manager.h"
 #include "notification_manager.h"
 #include "outbound_queue.h"
+#include "session_resumer.h"
 #include "sync_engine.h"
 #include "user_manager.h"
 #include "version_manager.h"
@@ -17,17 +19,107 @@
 #include "cache/conversation_cache.h"
 #include "cache/message_cache.h"
 #include "db/database.h"
+#include "frame_codec.h"
+#include "json_common.h"
 #include "network/http_client.h"
+#include "network/rtt_estimator.h"
 #include "network/websocket_client.h"
+#include "util/dispatch_executor.h"
+#include "util/timer_wheel.h"
 
+#include <chrono>
+#include <map>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
+
+namespace anychat::client_impl_detail {
+
+struct LatencySummaryPayload {
+    uint64_t count = 0;
+    double mean_ms = 0;
+    double p50_ms = 0;
+    double p90_ms = 0;
+    double p99_ms = 0;
+    double max_ms = 0;
+    std::vector<uint64_t> buckets{};
+};
+
+struct RouteStatsPayload {
+    std::string route{};
+    uint64_t attempts = 0;
+    uint64_t new_connections = 0;
+    std::map<std::string, uint64_t> status_codes{};
+    uint64_t bytes_sent = 0;
+    uint64_t bytes_received = 0;
+    LatencySummaryPayload dns{};
+    LatencySummaryPayload connect{};
+    LatencySummaryPayload tls{};
+    LatencySummaryPayload ttfb{};
+    LatencySummaryPayload total{};
+};
+
+struct WebSocketStatsPayload {
+    network::WebSocketStats counters{};
+    network::RttStats rtt{};
+    int heartbeat_interval_ms = 0;
+    SessionResumeStats resume{};
+    util::DispatchExecutorStats dispatch{};
+    MessageIngestorStats ingest{};
+    double tx_compression_ratio = 0; // compressed / uncompressed, 0 without data
+    double rx_compression_ratio = 0;
+};
+
+struct HttpStatsPayload {
+    network::HttpStats totals{};
+    std::vector<int64_t> bucket_bounds_ms{};
+    std::vector<RouteStatsPayload> routes{};
+};
+
+LatencySummaryPayload toLatencySummary(const network::LatencyHistogram& histogram) {
+    return LatencySummaryPayload{
+        .count = histogram.count,
+        .mean_ms = histogram.meanMs(),
+        .p50_ms = histogram.quantileMs(0.5),
+        .p90_ms = histogram.quantileMs(0.9),
+        .p99_ms = histogram.quantileMs(0.99),
+        .max_ms = static_cast<double>(histogram.max_us) / 1000.0,
+        .buckets = { histogram.buckets.begin(), histogram.buckets.end() },
+    };
+}
+
+double compressionRatio(uint64_t compressed, uint64_t uncompressed) {
+    return uncompressed == 0 ? 0.0 : static_cast<double>(compressed) / static_cast<double>(uncompressed);
+}
+
+RouteStatsPayload toRouteStatsPayload(const network::HttpRouteStats& stats) {
+    RouteStatsPayload payload{
+        .route = stats.route,
+        .attempts = stats.attempts,
+        .new_connections = stats.new_connections,
+        .bytes_sent = stats.bytes_sent,
+        .bytes_received = stats.bytes_received,
+        .dns = toLatencySummary(stats.dns),
+        .connect = toLatencySummary(stats.connect),
+        .tls = toLatencySummary(stats.tls),
+        .ttfb = toLatencySummary(stats.ttfb),
+        .total = toLatencySummary(stats.total),
+    };
+    for (const auto& [code, count] : stats.status_codes)
+        payload.status_codes[std::to_string(code)] = count;
+    return payload;
+}
+
+} // namespace anychat::client_impl_detail
 
 namespace anychat {
+using namespace client_impl_detail;
 
 AnyChatClient::AnyChatClient(const ClientConfig& config)
-    : http_(std::make_shared<network::HttpClient>(config.api_base_url))
+    : timers_(std::make_shared<util::TimerScheduler>())
+    , rtt_(std::make_shared<network::RttEstimator>())
+    , http_(std::make_shared<network::HttpClient>(config.api_base_url))
     , gateway_url_(config.gateway_url)
     , config_(config) {
     if (config.gateway_url.empty()) {
@@ -40,6 +132,9 @@ AnyChatClient::AnyChatClient(const ClientConfig& config)
         throw std::invalid_argument("ClientConfig::device_id must not be empty");
     }
 
+    http_->setCompression(network::HttpCompressionOptions{ .enabled = config.compress_request_bodies });
+    http_->setRttEstimator(rtt_);
+
     db_ = std::make_unique<db::Database>(config.db_path);
     if (!config.db_path.empty()) {
         db_->open();
@@ -47,19 +142,40 @@ AnyChatClient::AnyChatClient(const ClientConfig& config)
 
     conv_cache_ = std::make_unique<cache::ConversationCache>();
     msg_cache_ = std::make_unique<cache::MessageCache>();
-    notif_mgr_ = std::make_unique<NotificationManager>();
+    if (!config.media_cache_dir.empty()) {
+        media_cache_ =
+            std::make_unique<cache::MediaCache>(config.media_cache_dir, config.media_cache_max_bytes, db_.get());
+    }
+    if (config.dispatch_threads > 0) {
+        dispatcher_ = std::make_shared<util::DispatchExecutor>(util::DispatchExecutorOptions{
+            .threads = config.dispatch_threads,
+            .max_queued = config.dispatch_queue_limit,
+        });
+    }
+    notif_mgr_ = std::make_unique<NotificationManager>(dispatcher_);
 
     auth_mgr_ = std::make_unique<AuthManagerImpl>(http_, config.device_id, db_.get(), notif_mgr_.get());
     outbound_q_ = std::make_unique<OutboundQueue>(db_.get());
-    sync_engine_ = std::make_unique<SyncEngine>(db_.get(), conv_cache_.get(), msg_cache_.get(), http_);
+    ingestor_ = std::make_unique<MessageIngestor>(db_.get(), msg_cache_.get(), conv_cache_.get());
+    sync_engine_ = std::make_unique<SyncEngine>(db_.get(), conv_cache_.get(), ingestor_.get(), http_);
+    resumer_ = std::make_unique<SessionResumer>(timers_, [this]() {
+        sync_engine_->sync();
+    });
 
     notif_mgr_->setOnMessageSent([this](const MsgSentAck& ack) {
         outbound_q_->onMessageSentAck(ack);
     });
+    notif_mgr_->setOnResume([this](const ResumeResult& result) {
+        resumer_->onResumeResult(result);
+    });
+    notif_mgr_->setOnSequence([this](int64_t seq) {
+        resumer_->onSequence(seq);
+    });
 
     msg_mgr_ = std::make_unique<MessageManagerImpl>(
         db_.get(),
         msg_cache_.get(),
+        ingestor_.get(),
         outbound_q_.get(),
         notif_mgr_.get(),
         http_,
@@ -68,16 +184,27 @@ AnyChatClient::AnyChatClient(const ClientConfig& config)
     conv_mgr_ = std::make_unique<ConversationManagerImpl>(db_.get(), conv_cache_.get(), notif_mgr_.get(), http_);
     friend_mgr_ = std::make_unique<FriendManagerImpl>(db_.get(), notif_mgr_.get(), http_);
     group_mgr_ = std::make_unique<GroupManagerImpl>(db_.get(), notif_mgr_.get(), http_);
-    file_mgr_ = std::make_unique<FileManagerImpl>(http_);
+    file_mgr_ = std::make_unique<FileManagerImpl>(http_, db_.get(), media_cache_.get());
     user_mgr_ = std::make_unique<UserManagerImpl>(http_, notif_mgr_.get(), config.device_id);
     call_mgr_ = std::make_unique<CallManagerImpl>(http_, notif_mgr_.get());
     version_mgr_ = std::make_unique<VersionManagerImpl>(http_);
+
+    if (config.listener_batch_window_ms > 0) {
+        const std::chrono::milliseconds window(config.listener_batch_window_ms);
+        msg_mgr_->setListenerBatching(timers_, dispatcher_, window);
+        conv_mgr_->setListenerBatching(timers_, dispatcher_, window);
+    }
 }
 
 AnyChatClient::~AnyChatClient() {
     if (conn_mgr_) {
         conn_mgr_->disconnect();
     }
+    // Queued handlers reference the managers: finish the running ones and
+    // drop the rest before anything is destroyed.
+    if (dispatcher_) {
+        dispatcher_->shutdown();
+    }
 }
 
 void AnyChatClient::login(
@@ -96,6 +223,7 @@ void AnyChatClient::login(
         AnyChatValueCallback<AuthToken>{
             .on_success =
                 [this, cb_ptr](const AuthToken& token) {
+                    resumer_->reset(); // a new login starts with a full sync
                     initializeWebSocket(token.access_token);
                     conn_mgr_->connect();
                     if (cb_ptr->on_success) {
@@ -141,6 +269,51 @@ void AnyChatClient::setOnConnectionStateChanged(ConnectionStateCallback callback
     state_cb_ = std::move(callback);
 }
 
+std::string AnyChatClient::httpStatsJson() const {
+    const auto& bounds = network::LatencyHistogram::kBoundsMs;
+    HttpStatsPayload payload{
+        .totals = http_->stats(),
+        .bucket_bounds_ms = { bounds.begin(), bounds.end() },
+    };
+    for (const auto& route : http_->routeStats())
+        payload.routes.push_back(toRouteStatsPayload(route));
+
+    std::string json;
+    std::string err;
+    if (!json_common::writeJson(payload, json, err)) {
+        return {};
+    }
+    return json;
+}
+
+void AnyChatClient::resetHttpStats() {
+    http_->resetRouteStats();
+}
+
+std::string AnyChatClient::webSocketStatsJson() const {
+    if (!ws_) {
+        return {};
+    }
+    const network::WebSocketStats stats = ws_->stats();
+    const WebSocketStatsPayload payload{
+        .counters = stats,
+        .rtt = rtt_->stats(),
+        .heartbeat_interval_ms = conn_mgr_ ? conn_mgr_->heartbeatIntervalMs() : 0,
+        .resume = resumer_->stats(),
+        .dispatch = dispatcher_ ? dispatcher_->stats() : util::DispatchExecutorStats{},
+        .ingest = ingestor_->stats(),
+        .tx_compression_ratio = compressionRatio(stats.deflate_out_bytes, stats.deflate_in_bytes),
+        .rx_compression_ratio = compressionRatio(stats.inflate_in_bytes, stats.inflate_out_bytes),
+    };
+
+    std::string json;
+    std::string err;
+    if (!json_common::writeJson(payload, json, err)) {
+        return {};
+    }
+    return json;
+}
+
 AuthManagerImpl& AnyChatClient::authMgr() {
     return *auth_mgr_;
 }
@@ -193,8 +366,38 @@ void AnyChatClient::initializeWebSocket(const std::string& access_token) {
     const std::string ws_url = buildWsUrl(gateway_url_, access_token);
 
     ws_ = std::make_shared<network::WebSocketClient>(ws_url);
-    ws_->setOnMessage([this](const std::string& raw) {
-        notif_mgr_->handleRaw(raw);
+    ws_->setCompression(network::WebSocketCompressionOptions{
+        .enabled = config_.ws_permessage_deflate,
+        .client_max_window_bits = config_.ws_deflate_window_bits,
+        .server_max_window_bits = config_.ws_deflate_window_bits,
+        .client_no_context_takeover = config_.ws_deflate_no_context_takeover,
+        .server_no_context_takeover = config_.ws_deflate_no_context_takeover,
+    });
+    if (config_.ws_binary_frames) {
+        ws_->setSubprotocols({ kBeveSubprotocol, kJsonSubprotocol });
+    }
+    // Backpressure from the dispatch pool: reading pauses while it is full
+    // and resumes once it is down to half, without parking the WebSocket
+    // thread. The re-check covers a space handler that ran before the pause.
+    network::WebSocketClient* ws = ws_.get();
+    ws_->setOnMessage([this, ws](std::string_view raw, bool binary) {
+        notif_mgr_->handleRaw(raw, binary ? FrameEncoding::Beve : FrameEncoding::Json);
+        if (dispatcher_ && dispatcher_->full()) {
+            ws->setReceivePaused(true);
+            if (!dispatcher_->full()) {
+                ws->setReceivePaused(false);
+            }
+        }
+    });
+    if (dispatcher_) {
+        dispatcher_->setOnSpace([weak_ws = std::weak_ptr<network::WebSocketClient>(ws_)] {
+            if (auto ws = weak_ws.lock()) {
+                ws->setReceivePaused(false);
+            }
+        });
+    }
+    ws_->setOnDrained([this]() {
+        outbound_q_->onDrained();
     });
 
     conn_mgr_ = std::make_unique<ConnectionManager>(
@@ -206,7 +409,9 @@ void AnyChatClient::initializeWebSocket(const std::string& access_token) {
         },
         [this]() {
             onReady();
-        }
+        },
+        timers_,
+        rtt_
     );
 
     notif_mgr_->setOnPong([this]() {
@@ -217,6 +422,10 @@ void AnyChatClient::initializeWebSocket(const std::string& access_token) {
 }
 
 void AnyChatClient::onStateChanged(ConnectionState state) {
+    if (state == ConnectionState::Disconnected || state == ConnectionState::Reconnecting) {
+        resumer_->onDisconnected();
+    }
+
     ConnectionStateCallback callback;
     {
         std::lock_guard<std::mutex> lock(cb_mutex_);
@@ -228,12 +437,22 @@ void AnyChatClient::onStateChanged(ConnectionState state) {
 }
 
 void AnyChatClient::onReady() {
-    if (ws_) {
-        outbound_q_->onConnected([this](const std::string& json) {
-            ws_->send(json);
-        });
+    if (!ws_) {
+        sync_engine_->sync();
+        return;
     }
-    sync_engine_->sync();
+    const FrameCodec codec = FrameCodec::forSubprotocol(ws_->subprotocol());
+    // Ahead of the outbound flush: a resume request travels as a control frame.
+    resumer_->onConnected(codec, [this, binary = codec.binary()](const std::string& frame) {
+        const auto priority = network::SendPriority::Control;
+        return binary ? ws_->sendBinary(frame, priority) : ws_->send(frame, priority);
+    });
+    outbound_q_->onConnected(
+        [this, binary = codec.binary()](const std::string& frame, network::SendPriority priority) {
+            return binary ? ws_->sendBinary(frame, priority) : ws_->send(frame, priority);
+        },
+        codec
+    );
 }
 
 } // namespace anychat
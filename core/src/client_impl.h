@@ -31,18 +31,37 @@ class Database;
 
 namespace network {
 class HttpClient;
+class RttEstimator;
 class WebSocketClient;
 } // namespace network
 
+namespace util {
+class DispatchExecutor;
+class TimerScheduler;
+} // namespace util
+
 class ConnectionManager;
 class NotificationManager;
 class OutboundQueue;
+class SessionResumer;
 class SyncEngine;
 
 struct ClientConfig {
     // ---- Network ------------------------------------------------------------
     std::string gateway_url; // WebSocket gateway, e.g. "wss://api.anychat.io"
     std::string api_base_url; // HTTP API base path, e.g. "https://api.anychat.io/api/v1"
+    // gzip large JSON request bodies on routes that opt in (/sync); the server
+    // must accept Content-Encoding: gzip. Responses are always negotiated.
+    bool compress_request_bodies = false;
+    // Offer permessage-deflate on the WebSocket. Servers that do not support
+    // it get a plain connection. Fewer window bits (9..15) and no context
+    // takeover cut per-connection memory at the cost of compression ratio.
+    bool ws_permessage_deflate = false;
+    int ws_deflate_window_bits = 15;
+    bool ws_deflate_no_context_takeover = false;
+    // Offer binary (BEVE) WebSocket frames. Used only if the server selects
+    // the "anychat.beve" subprotocol; JSON text frames otherwise.
+    bool ws_binary_frames = false;
 
     // ---- Device -------------------------------------------------------------
     std::string device_id; // Unique device identifier, generated and persisted by platform binding
@@ -56,6 +75,12 @@ struct ClientConfig {
         // iOS: <ApplicationSupport>/anychat.db
         // Web: leave empty (Web SDK uses IndexedDB, not through C++ Core)
 
+    // ---- Media Cache --------------------------------------------------------
+    // Directory for downloaded media managed by the SDK; empty disables the
+    // cache. Oldest files are evicted once media_cache_max_bytes is exceeded.
+    std::string media_cache_dir;
+    int64_t media_cache_max_bytes = 512LL * 1024 * 1024;
+
     // ---- Network Monitor -----------------------------------------------------
     // Optional. Platform-implemented NetworkMonitor; when nullptr, SDK always considers network available.
     std::shared_ptr<NetworkMonitor> network_monitor;
@@ -64,6 +89,19 @@ struct ClientConfig {
     int connect_timeout_ms = 10'000;
     int max_reconnect_attempts = 5; // WebSocket inner layer max retry attempts
     bool auto_reconnect = true; // Whether to auto-reconnect after disconnection
+
+    // ---- Dispatch ------------------------------------------------------------
+    // Threads running notification handlers and listener callbacks, so that
+    // slow callbacks do not stall the WebSocket. Events of one conversation
+    // stay in order. 0 runs them on the WebSocket thread.
+    int dispatch_threads = 2;
+    // Events waiting for a dispatch thread; beyond it the WebSocket stops
+    // reading until the callbacks catch up.
+    size_t dispatch_queue_limit = 10'000;
+    // Deliver received messages, read receipts, typing and conversation
+    // updates to the listeners in batches, one per window (16 ms is about a
+    // display frame), with repeats collapsed. 0 delivers every event alone.
+    int listener_batch_window_ms = 0;
 };
 
 using ConnectionStateCallback = std::function<void(ConnectionState state)>;
@@ -94,6 +132,17 @@ public:
     ConnectionState connectionState() const;
     void setOnConnectionStateChanged(ConnectionStateCallback callback);
 
+    // ---- Diagnostics -------------------------------------------------------
+    // HTTP totals and per-route timings as JSON; empty on serialization error.
+    std::string httpStatsJson() const;
+    void resetHttpStats();
+
+    // WebSocket message and compression counters of the current connection,
+    // the heartbeat RTT estimate and interval, the session resume and the
+    // event dispatch counters as JSON; empty before login or on
+    // serialization error.
+    std::string webSocketStatsJson() const;
+
     // ---- Sub-modules -------------------------------------------------------
     AuthManagerImpl& authMgr();
     MessageManagerImpl& messageMgr();
@@ -111,8 +160,13 @@ private:
     void onStateChanged(ConnectionState state);
     void onReady();
 
+    // Shared by every component that needs timers; outlives them.
+    std::shared_ptr<util::TimerScheduler> timers_;
+    std::shared_ptr<network::RttEstimator> rtt_; // fed by the WebSocket heartbeat
     std::shared_ptr<network::HttpClient> http_;
     std::shared_ptr<network::WebSocketClient> ws_;
+    // Runs notification handlers; null when they run on the WebSocket thread.
+    std::shared_ptr<util::DispatchExecutor> dispatcher_;
 
     std::string gateway_url_;
     ClientConfig config_;
@@ -120,6 +174,9 @@ private:
     std::unique_ptr<db::Database> db_;
     std::unique_ptr<cache::ConversationCache> conv_cache_;
     std::unique_ptr<cache::MessageCache> msg_cache_;
+    std::unique_ptr<cache::MediaCache> media_cache_;
+    // Shared by the message manager and sync; outlives both.
+    std::unique_ptr<MessageIngestor> ingestor_;
 
     std::unique_ptr<AuthManagerImpl> auth_mgr_;
     std::unique_ptr<MessageManagerImpl> msg_mgr_;
@@ -128,6 +185,7 @@ private:
     std::unique_ptr<NotificationManager> notif_mgr_;
     std::unique_ptr<OutboundQueue> outbound_q_;
     std::unique_ptr<SyncEngine> sync_engine_;
+    std::unique_ptr<SessionResumer> resumer_; // resume on reconnect, /sync as fallback
 
     std::unique_ptr<ConversationManagerImpl> conv_mgr_;
     std::unique_ptr<FriendManagerImpl> friend_mgr_;
@@ -2,6 +2,8 @@
 
 #include <algorithm>
 #include <chrono>
+#include <string>
+#include <utility>
 
 namespace anychat {
 
@@ -27,13 +29,19 @@ ConnectionManager::ConnectionManager(
     std::shared_ptr<NetworkMonitor> monitor,
     std::shared_ptr<network::IWebSocketClient> ws,
     std::function<void(ConnectionState)> on_state_changed,
-    std::function<void()> on_ready
+    std::function<void()> on_ready,
+    std::shared_ptr<util::TimerScheduler> timers,
+    std::shared_ptr<network::RttEstimator> rtt,
+    network::HeartbeatOptions heartbeat
 )
     : ws_url_(std::move(ws_url))
     , monitor_(std::move(monitor))
     , ws_(std::move(ws))
     , on_state_changed_(std::move(on_state_changed))
-    , on_ready_(std::move(on_ready)) {
+    , on_ready_(std::move(on_ready))
+    , timers_(timers ? std::move(timers) : std::make_shared<util::TimerScheduler>())
+    , rtt_(rtt ? std::move(rtt) : std::make_shared<network::RttEstimator>())
+    , heartbeat_interval_(heartbeat) {
     // Subscribe to WebSocket events
     ws_->setOnConnected([this]() {
         onWsConnected();
@@ -44,69 +52,33 @@ ConnectionManager::ConnectionManager(
     ws_->setOnError([this](const std::string& e) {
         onWsError(e);
     });
+    ws_->setOnPong([this](std::string_view payload) {
+        onWsPong(payload);
+    });
 
     // Initialize network status
     if (monitor_) {
+        network_path_ = monitor_->currentStatus();
         network_ok_ = isReachable(monitor_->currentStatus());
         monitor_->setOnStatusChanged([this](NetworkStatus s) {
             onNetworkChanged(s);
         });
     }
-
-    // Start reconnect timer thread (resident, waiting to be woken)
-    reconnect_thread_ = std::thread([this]() {
-        while (true) {
-            std::unique_lock<std::mutex> lock(reconnect_mutex_);
-            // Wait until there's pending reconnect or stop signal
-            reconnect_cv_.wait(lock, [this]() {
-                return reconnect_pending_ || stopping_;
-            });
-            if (stopping_)
-                break;
-
-            // Extract delay time, unlock then sleep
-            reconnect_cancel_ = false;
-            lock.unlock();
-
-            // Use condition_variable for interruptible wait
-            // Delay time already set in reconnect_delay_ms_ by scheduleReconnect
-            {
-                std::unique_lock<std::mutex> delay_lock(reconnect_mutex_);
-                reconnect_cv_.wait_for(delay_lock, std::chrono::milliseconds(reconnect_delay_ms_), [this]() {
-                    return reconnect_cancel_ || stopping_;
-                });
-
-                reconnect_pending_ = false;
-                if (reconnect_cancel_ || stopping_)
-                    continue;
-            }
-
-            // Timer expired and not cancelled — execute connection
-            if (want_connected_ && network_ok_) {
-                doConnect();
-            }
-        }
-    });
 }
 
 ConnectionManager::~ConnectionManager() {
-    // Stop the heartbeat thread before joining the reconnect thread so we
-    // don't call onWsDisconnected() after teardown.
+    // Cancelling waits for a running timer callback, so none can touch this
+    // object after teardown (the scheduler may outlive it).
     stopHeartbeat();
-
-    {
-        std::lock_guard<std::mutex> lock(reconnect_mutex_);
-        stopping_ = true;
-        reconnect_cancel_ = true;
-        reconnect_pending_ = true; // wake up thread
-    }
-    reconnect_cv_.notify_all();
-    if (reconnect_thread_.joinable())
-        reconnect_thread_.join();
+    cancelReconnect();
 
     if (monitor_)
         monitor_->stop();
     ws_->disconnect();
+
+    // The WebSocket thread may have re-armed either timer before it stopped.
+    stopHeartbeat();
+    cancelReconnect();
 }
 
 // ---------------------------------------------------------------------------
@@ -143,7 +115,16 @@ ConnectionState ConnectionManager::state() const {
 }
 
 void ConnectionManager::onPongReceived() {
-    last_pong_ms_.store(currentMs(), std::memory_order_relaxed);
+    onPingAnswered(-1);
+}
+
+network::RttStats ConnectionManager::rtt() const {
+    return rtt_->stats();
+}
+
+int ConnectionManager::heartbeatIntervalMs() const {
+    std::lock_guard<std::mutex> lock(timer_mutex_);
+    return heartbeat_interval_.intervalMs();
 }
 
 // ---------------------------------------------------------------------------
@@ -152,6 +133,11 @@ void ConnectionManager::onPongReceived() {
 
 void ConnectionManager::onNetworkChanged(NetworkStatus status) {
     bool reachable = isReachable(status);
+    if (reachable && network_path_.exchange(status) != status) {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        heartbeat_interval_.reset();
+        rtt_->reset();
+    }
     bool was_ok = network_ok_.exchange(reachable);
 
     if (reachable == was_ok)
@@ -177,6 +163,8 @@ void ConnectionManager::onNetworkChanged(NetworkStatus status) {
 
 void ConnectionManager::onWsConnected() {
     super_retry_count_ = 0;
+    // The WebSocket recovered on its own; an outer-layer retry is moot.
+    cancelReconnect();
     setState(ConnectionState::Connected);
 
     // Start heartbeat now that the connection is live.
@@ -193,6 +181,14 @@ void ConnectionManager::onWsConnected() {
 }
 
 void ConnectionManager::onWsDisconnected() {
+    {
+        // Dropped right after a ping: most likely the NAT had already
+        // forgotten the connection.  Deliberate disconnects stop the
+        // heartbeat first and do not count.
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        if (heartbeat_running_ && ping_outstanding_)
+            heartbeat_interval_.onLost();
+    }
     // Stop heartbeat — the connection is gone.
     stopHeartbeat();
 
@@ -220,6 +216,18 @@ void ConnectionManager::onWsError(const std::string& /*error*/) {
         setState(ConnectionState::Reconnecting);
 }
 
+void ConnectionManager::onWsPong(std::string_view payload) {
+    int64_t rtt_ms = 0;
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        // Unsolicited pongs and answers to earlier pings are ignored.
+        if (!ping_outstanding_ || payload != std::to_string(ping_seq_))
+            return;
+        rtt_ms = currentMs() - ping_sent_ms_;
+    }
+    onPingAnswered(rtt_ms);
+}
+
 // ---------------------------------------------------------------------------
 // Actions
 // ---------------------------------------------------------------------------
@@ -235,18 +243,33 @@ void ConnectionManager::doDisconnect() {
 }
 
 void ConnectionManager::scheduleReconnect(int delay_ms) {
-    std::lock_guard<std::mutex> lock(reconnect_mutex_);
-    reconnect_delay_ms_ = delay_ms;
-    reconnect_cancel_ = false;
-    reconnect_pending_ = true;
-    reconnect_cv_.notify_one();
+    cancelReconnect();
+    std::lock_guard<std::mutex> lock(timer_mutex_);
+    reconnect_timer_ = timers_->schedule(std::chrono::milliseconds(delay_ms), [this]() {
+        onReconnectTimer();
+    });
 }
 
 void ConnectionManager::cancelReconnect() {
-    std::lock_guard<std::mutex> lock(reconnect_mutex_);
-    reconnect_cancel_ = true;
-    reconnect_pending_ = false;
-    reconnect_cv_.notify_one();
+    util::TimerId id = 0;
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        id = std::exchange(reconnect_timer_, 0);
+    }
+    timers_->cancel(id);
+}
+
+void ConnectionManager::onReconnectTimer() {
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        if (reconnect_timer_ == 0)
+            return; // cancelled while firing
+        reconnect_timer_ = 0;
+    }
+    // Timer expired and not cancelled — execute connection
+    if (want_connected_ && network_ok_) {
+        doConnect();
+    }
 }
 
 void ConnectionManager::setState(ConnectionState s) {
@@ -268,67 +291,83 @@ void ConnectionManager::setState(ConnectionState s) {
 // ---------------------------------------------------------------------------
 
 void ConnectionManager::startHeartbeat() {
-    // Guard against double-start: stop any existing thread first.
+    // Guard against double-start: stop any existing timer first.
     stopHeartbeat();
 
+    std::lock_guard<std::mutex> lock(timer_mutex_);
+    heartbeat_running_ = true;
+    armHeartbeatLocked(heartbeat_interval_.intervalMs());
+}
+
+void ConnectionManager::stopHeartbeat() {
+    util::TimerId id = 0;
     {
-        std::lock_guard<std::mutex> lock(heartbeat_mutex_);
-        heartbeat_stopping_ = false;
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        heartbeat_running_ = false;
+        ping_outstanding_ = false;
+        ++heartbeat_generation_;
+        id = std::exchange(heartbeat_timer_, 0);
     }
+    timers_->cancel(id);
+}
 
-    // Initialise last_pong_ms_ to "now" so the very first interval is clean.
-    last_pong_ms_.store(currentMs(), std::memory_order_relaxed);
-
-    heartbeat_thread_ = std::thread([this]() {
-        while (true) {
-            // Sleep for the ping interval, but wake early if stopHeartbeat()
-            // is called.
-            {
-                std::unique_lock<std::mutex> lock(heartbeat_mutex_);
-                heartbeat_cv_.wait_for(lock, std::chrono::milliseconds(kHeartbeatIntervalMs), [this]() {
-                    return heartbeat_stopping_;
-                });
-
-                if (heartbeat_stopping_)
-                    break;
-            }
-
-            // Only send pings (and check for pong timeout) while connected.
-            if (state_.load() != ConnectionState::Connected)
-                continue;
-
-            // Check whether the server has been silent for too long.
-            int64_t elapsed = currentMs() - last_pong_ms_.load(std::memory_order_relaxed);
-            if (elapsed > kPongTimeoutMs) {
-                // Two consecutive pongs missed — treat as a dead connection.
-                onWsDisconnected();
-                break; // stopHeartbeat() will be called by onWsDisconnected
-            }
-
-            // Send the ping frame.
-            sendPing();
-        }
-    });
+util::TimerId ConnectionManager::armHeartbeatLocked(int delay_ms) {
+    const uint64_t generation = ++heartbeat_generation_;
+    return std::exchange(
+        heartbeat_timer_,
+        timers_->schedule(std::chrono::milliseconds(delay_ms), [this, generation]() {
+            onHeartbeatTimer(generation);
+        })
+    );
 }
 
-void ConnectionManager::stopHeartbeat() {
+void ConnectionManager::onHeartbeatTimer(uint64_t generation) {
+    std::string ping;
     {
-        std::lock_guard<std::mutex> lock(heartbeat_mutex_);
-        heartbeat_stopping_ = true;
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        if (!heartbeat_running_ || generation != heartbeat_generation_)
+            return; // stopped or superseded while firing
+        heartbeat_timer_ = 0;
+
+        if (ping_outstanding_) {
+            // Pong deadline passed.
+            ping_outstanding_ = false;
+            heartbeat_interval_.onLost();
+        } else if (state_.load() != ConnectionState::Connected) {
+            // Only ping while connected; look again after the interval.
+            armHeartbeatLocked(heartbeat_interval_.intervalMs());
+            return;
+        } else {
+            ping = std::to_string(++ping_seq_);
+            ping_outstanding_ = true;
+            ping_sent_ms_ = currentMs();
+            armHeartbeatLocked(heartbeat_interval_.pongTimeoutMs(rtt_->stats()));
+        }
     }
-    heartbeat_cv_.notify_all();
 
-    if (heartbeat_thread_.joinable())
-        heartbeat_thread_.join();
+    if (ping.empty()) {
+        // Treat as a dead connection.
+        onWsDisconnected(); // stops the heartbeat
+        return;
+    }
+    // Best-effort: if the socket is already gone, the deadline catches it.
+    ws_->sendPing(ping);
 }
 
-void ConnectionManager::sendPing() {
-    // Best-effort: ignore errors (the pong timeout will catch dead connections).
-    try {
-        ws_->send("{\"type\":\"ping\"}");
-    } catch (...) {
-        // Swallow — connection may have already closed.
+void ConnectionManager::onPingAnswered(int64_t rtt_ms) {
+    util::TimerId deadline = 0;
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        if (!heartbeat_running_ || !ping_outstanding_)
+            return;
+        ping_outstanding_ = false;
+        if (rtt_ms >= 0)
+            rtt_->addSample(rtt_ms);
+        heartbeat_interval_.onAnswered();
+        deadline = armHeartbeatLocked(heartbeat_interval_.intervalMs());
     }
+    // Superseded by the generation already; cancelling frees the slot.
+    timers_->cancel(deadline);
 }
 
 } // namespace anychat
@@ -3,16 +3,18 @@
 #include "network_monitor.h"
 #include "sdk_types.h"
 
+#include "network/heartbeat_interval.h"
 #include "network/iwebsocket_client.h"
+#include "network/rtt_estimator.h"
+#include "util/timer_wheel.h"
 
 #include <atomic>
-#include <condition_variable>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
-#include <thread>
+#include <string_view>
 
 namespace anychat {
 
@@ -23,12 +25,20 @@ namespace anychat {
 //   2. Maintain externally visible ConnectionState and trigger callbacks on state changes.
 //   3. Perform longer-interval outer-layer reconnection after WebSocket internal retries exhausted (up to kMaxSuperRetries times).
 //   4. Trigger on_ready hook after WebSocket connection established (for SyncEngine to perform incremental sync).
-//   5. Send ping heartbeat every 30 s during connection; reconnect if no pong received within 60 s.
+//   5. Own the connection's only heartbeat: WebSocket ping control frames, spaced by an interval that adapts
+//      to the NAT idle timeout (network::HeartbeatInterval). Each pong is an RTT sample; a ping left
+//      unanswered past the RTO-based deadline marks the connection dead.
 //
 // Division with WebSocketClient:
 //   WebSocketClient  — handles connection-level retries (fast, up to 5 times, exponential backoff to ~16 s)
 //   ConnectionManager — handles network-level retries (slow, up to 5 times, backoff starts at 30 s)
 //                       and network reachability-induced pause/resume
+//
+// The heartbeat and the outer-layer reconnect are timers on a shared
+// util::TimerScheduler; ConnectionManager owns no threads.
+//
+// The RTT estimate it feeds is shared, so that other transports (HttpClient)
+// can size their timeouts from it.
 class ConnectionManager {
 public:
     // |ws_url|    : full WebSocket URL, token maintained by HttpClient, appended as query.
@@ -36,12 +46,18 @@ public:
     // |ws|        : constructed WebSocket client.
     // |on_state_changed| : notifies caller when ConnectionState changes.
     // |on_ready|  : called after WebSocket successfully established (for post-connect actions like incremental sync).
+    // |timers|    : scheduler for the heartbeat and reconnect timers; nullptr creates a private one.
+    // |rtt|       : estimate fed by the heartbeat; nullptr creates a private one.
+    // |heartbeat| : bounds of the adaptive heartbeat interval.
     ConnectionManager(
         std::string ws_url,
         std::shared_ptr<NetworkMonitor> monitor,
         std::shared_ptr<network::IWebSocketClient> ws,
         std::function<void(ConnectionState)> on_state_changed,
-        std::function<void()> on_ready
+        std::function<void()> on_ready,
+        std::shared_ptr<util::TimerScheduler> timers = nullptr,
+        std::shared_ptr<network::RttEstimator> rtt = nullptr,
+        network::HeartbeatOptions heartbeat = {}
     );
 
     ~ConnectionManager();
@@ -59,11 +75,17 @@ public:
 
     ConnectionState state() const;
 
-    // Called by the notification layer (e.g. NotificationManager) when a
-    // "pong" frame is received from the server.  Updates last_pong_ms_ so the
-    // heartbeat watchdog knows the connection is still alive.
+    // Called by the notification layer (e.g. NotificationManager) when an
+    // application-level {"type":"pong"} arrives.  Proves the connection alive
+    // and answers the outstanding ping, but gives no RTT sample since it
+    // cannot be matched to a ping.
     void onPongReceived();
 
+    network::RttStats rtt() const;
+
+    // Current idle time between pings.
+    int heartbeatIntervalMs() const;
+
 private:
     // ---- Internal Event Handling --------------------------------------------
 
@@ -71,6 +93,7 @@ private:
     void onWsConnected();
     void onWsDisconnected();
     void onWsError(const std::string& error);
+    void onWsPong(std::string_view payload);
 
     // ---- Actions ------------------------------------------------------------
 
@@ -83,23 +106,37 @@ private:
     // Schedule an outer-layer reconnection (calls doConnect after delay_ms milliseconds).
     void scheduleReconnect(int delay_ms);
 
-    // Wake up reconnect thread, cancel pending reconnection plans.
+    // Cancel the pending reconnection, if any.
     void cancelReconnect();
 
+    void onReconnectTimer();
+
     // Thread-safe update of state_ and trigger callback.
     void setState(ConnectionState s);
 
     // ---- Heartbeat -----------------------------------------------------------
+    // One timer alternates between two roles: while no ping is outstanding it
+    // fires after the idle interval and sends one; while a ping is
+    // outstanding it is the pong deadline.  A pong re-arms it for the next
+    // interval, so the interval is idle time as the NAT sees it.
 
-    // Start the heartbeat loop thread.  Called from onWsConnected().
+    // Start the heartbeat timer.  Called from onWsConnected().
     void startHeartbeat();
 
-    // Signal the heartbeat thread to stop and join it.  Called from
-    // onWsDisconnected() and doDisconnect().
+    // Cancel the heartbeat timer; waits if its callback is running on the
+    // scheduler thread.  Called from onWsDisconnected() and doDisconnect().
     void stopHeartbeat();
 
-    // Send a ping frame to the server.
-    void sendPing();
+    // Arm the heartbeat timer |delay_ms| from now; timer_mutex_ must be held.
+    // Returns the id it replaces, for the caller to cancel after unlocking.
+    util::TimerId armHeartbeatLocked(int delay_ms);
+
+    // Interval elapsed: send a ping.  Deadline passed: declare the
+    // connection dead.  Ignored unless |generation| is still current.
+    void onHeartbeatTimer(uint64_t generation);
+
+    // The outstanding ping was answered, |rtt_ms| < 0 if not measurable.
+    void onPingAnswered(int64_t rtt_ms);
 
     // ---- Reconnect Parameters -----------------------------------------------
 
@@ -107,10 +144,6 @@ private:
     static constexpr int kSuperBaseDelayMs = 30'000;
     static constexpr int kMaxSuperRetries = 5;
 
-    // Heartbeat parameters.
-    static constexpr int kHeartbeatIntervalMs = 30'000; // send ping every 30 s
-    static constexpr int kPongTimeoutMs = 60'000; // 2 missed pongs = 60 s
-
     // ---- Members --------------------------------------------------------------
 
     std::string ws_url_;
@@ -118,34 +151,38 @@ private:
     std::shared_ptr<network::IWebSocketClient> ws_;
     std::function<void(ConnectionState)> on_state_changed_;
     std::function<void()> on_ready_;
+    std::shared_ptr<util::TimerScheduler> timers_;
+    std::shared_ptr<network::RttEstimator> rtt_;
 
     std::atomic<ConnectionState> state_{ ConnectionState::Disconnected };
     std::atomic<bool> want_connected_{ false }; // user intent
     std::atomic<bool> network_ok_{ true }; // current network reachability
+    // Last reachable status; another one means another NAT and path, so the
+    // heartbeat interval and RTT estimate start over.
+    std::atomic<NetworkStatus> network_path_{ NetworkStatus::Unknown };
     std::atomic<int> super_retry_count_{ 0 }; // outer-layer retry count
 
     // callback protection
     std::mutex cb_mutex_;
 
-    // outer-layer reconnect timer (separate thread + condition_variable for cancellable sleep)
-    std::thread reconnect_thread_;
-    std::mutex reconnect_mutex_;
-    std::condition_variable reconnect_cv_;
-    bool reconnect_pending_ = false;
-    bool reconnect_cancel_ = false;
-    bool stopping_ = false;
-    int reconnect_delay_ms_ = 0;
-
-    // ---- Heartbeat Thread Members ----------------------------------------
-
-    std::thread heartbeat_thread_;
-    std::mutex heartbeat_mutex_;
-    std::condition_variable heartbeat_cv_;
-    bool heartbeat_stopping_ = false;
-
-    // Unix timestamp (ms) of the last received pong.  Initialised to "now"
-    // when the heartbeat starts so the first 30 s window is clean.
-    std::atomic<int64_t> last_pong_ms_{ 0 };
+    // ---- Timers ---------------------------------------------------------------
+    // Pending timer ids, 0 when not armed.  The reconnect callback only acts
+    // while its id is still set, so clearing the id under timer_mutex_ and
+    // then cancelling it stops the timer for good.  Heartbeat callbacks carry
+    // the generation they were armed in instead, as a pong replaces the
+    // timer from another thread; stopping bumps the generation.
+
+    mutable std::mutex timer_mutex_;
+    util::TimerId reconnect_timer_ = 0;
+    util::TimerId heartbeat_timer_ = 0;
+
+    // Heartbeat state, guarded by timer_mutex_.
+    bool heartbeat_running_ = false;
+    uint64_t heartbeat_generation_ = 0;
+    network::HeartbeatInterval heartbeat_interval_;
+    uint64_t ping_seq_ = 0; // payload of the last ping, in decimal
+    bool ping_outstanding_ = false;
+    int64_t ping_sent_ms_ = 0;
 };
 
 } // namespace anychat
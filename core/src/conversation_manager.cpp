@@ -240,12 +240,10 @@ void applyNotificationPatch(const NotificationConversationPayload& payload, Conv
     }
 }
 
-bool isConversationNotification(const std::string& notification_type) {
-    return notification_type == "conversation.unread_updated" || notification_type == "conversation.pin_updated"
-           || notification_type == "conversation.mute_updated" || notification_type == "conversation.deleted"
-           || notification_type == "conversation.burn_updated"
-           || notification_type == "conversation.auto_delete_updated";
-}
+constexpr const char* kConversationNotificationTypes[] = {
+    "conversation.unread_updated", "conversation.pin_updated",  "conversation.mute_updated",
+    "conversation.deleted",        "conversation.burn_updated", "conversation.auto_delete_updated",
+};
 
 } // namespace anychat::conversation_manager_detail
 
@@ -345,11 +343,18 @@ ConversationManagerImpl::ConversationManagerImpl(
     , conv_cache_(conv_cache)
     , notif_mgr_(notif_mgr)
     , http_(std::move(http)) {
-    notif_mgr_->addNotificationHandler([this](const NotificationEvent& event) {
-        if (isConversationNotification(event.notification_type)) {
-            handleConversationNotification(event);
-        }
-    });
+    for (const char* type : kConversationNotificationTypes) {
+        notif_mgr_->subscribe<NotificationConversationPayload>(
+            type,
+            [this](const NotificationEvent& event, const NotificationConversationPayload& payload) {
+                handleConversationNotification(event, payload);
+            },
+            // Same key as the message events of the conversation.
+            [](const NotificationConversationPayload& payload) -> std::string_view {
+                return payload.conversation_id ? std::string_view(*payload.conversation_id) : std::string_view{};
+            }
+        );
+    }
 }
 
 void ConversationManagerImpl::getConversationList(AnyChatValueCallback<std::vector<Conversation>> cb) {
@@ -805,14 +810,34 @@ void ConversationManagerImpl::setListener(std::shared_ptr<ConversationListener>
     listener_ = std::move(listener);
 }
 
-void ConversationManagerImpl::handleConversationNotification(const NotificationEvent& event) {
-    try {
-        NotificationConversationPayload payload{};
-        std::string err;
-        if (!parseJsonObject(event.data, payload, err)) {
-            return;
+void ConversationManagerImpl::setListenerBatching(
+    std::shared_ptr<util::TimerScheduler> timers,
+    std::shared_ptr<util::DispatchExecutor> executor,
+    std::chrono::milliseconds window
+) {
+    updated_batch_ = std::make_unique<util::EventBatcher<Conversation>>(
+        std::move(timers),
+        std::move(executor),
+        "listener.conversation.updated",
+        window,
+        [this](std::vector<Conversation>&& batch) {
+            std::shared_ptr<ConversationListener> listener;
+            {
+                std::lock_guard<std::mutex> lk(handler_mutex_);
+                listener = listener_;
+            }
+            if (listener) {
+                listener->onConversationsUpdated(batch);
+            }
         }
+    );
+}
 
+void ConversationManagerImpl::handleConversationNotification(
+    const NotificationEvent& event,
+    const NotificationConversationPayload& payload
+) {
+    try {
         const std::string conv_id = notificationConversationId(payload);
         if (conv_id.empty()) {
             return;
@@ -829,14 +854,7 @@ void ConversationManagerImpl::handleConversationNotification(const NotificationE
             conv_cache_->remove(conv_id);
             db_->exec("DELETE FROM conversations WHERE conv_id=?", { conv_id });
 
-            std::shared_ptr<ConversationListener> listener;
-            {
-                std::lock_guard<std::mutex> lk(handler_mutex_);
-                listener = listener_;
-            }
-            if (listener) {
-                listener->onConversationUpdated(removed);
-            }
+            notifyUpdated(std::move(removed));
             return;
         }
 
@@ -863,16 +881,26 @@ void ConversationManagerImpl::handleConversationNotification(const NotificationE
         conv_cache_->upsert(conv);
         upsertDb(conv);
 
-        std::shared_ptr<ConversationListener> listener;
-        {
-            std::lock_guard<std::mutex> lk(handler_mutex_);
-            listener = listener_;
-        }
-        if (listener) {
-            listener->onConversationUpdated(conv);
-        }
+        notifyUpdated(std::move(conv));
     } catch (const std::exception&) {
     }
 }
 
+void ConversationManagerImpl::notifyUpdated(Conversation conv) {
+    if (updated_batch_) {
+        const std::string key = conv.conv_id;
+        updated_batch_->add(std::move(conv), key);
+        return;
+    }
+
+    std::shared_ptr<ConversationListener> listener;
+    {
+        std::lock_guard<std::mutex> lk(handler_mutex_);
+        listener = listener_;
+    }
+    if (listener) {
+        listener->onConversationUpdated(conv);
+    }
+}
+
 } // namespace anychat
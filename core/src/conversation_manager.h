@@ -7,7 +7,9 @@
 #include "cache/conversation_cache.h"
 #include "db/database.h"
 #include "network/http_client.h"
+#include "util/event_batcher.h"
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -22,8 +24,20 @@ public:
     virtual void onConversationUpdated(const Conversation& conv) {
         (void) conv;
     }
+
+    // Batched form, called instead when listener batching is on (see
+    // setListenerBatching()). By default it forwards each conversation.
+    virtual void onConversationsUpdated(const std::vector<Conversation>& convs) {
+        for (const auto& conv : convs) {
+            onConversationUpdated(conv);
+        }
+    }
 };
 
+namespace conversation_manager_detail {
+struct NotificationConversationPayload;
+} // namespace conversation_manager_detail
+
 class ConversationManagerImpl {
 public:
     ConversationManagerImpl(
@@ -84,6 +98,16 @@ public:
     // Listener fired whenever a conversation is updated (new message, read, etc.)
     void setListener(std::shared_ptr<ConversationListener> listener);
 
+    // Delivers updates to the listener in batches, one per |window|, with
+    // each conversation reported once per batch in its latest state (a
+    // burst of unread count changes becomes one update). Call before
+    // notifications flow.
+    void setListenerBatching(
+        std::shared_ptr<util::TimerScheduler> timers,
+        std::shared_ptr<util::DispatchExecutor> executor,
+        std::chrono::milliseconds window
+    );
+
 private:
     // Persist a conversation to the DB (upsert).
     void upsertDb(const Conversation& conv);
@@ -92,7 +116,11 @@ private:
     static Conversation rowToConversation(const db::Row& row);
 
     // Notification handler for conversation-related events.
-    void handleConversationNotification(const NotificationEvent& event);
+    void handleConversationNotification(
+        const NotificationEvent& event,
+        const conversation_manager_detail::NotificationConversationPayload& payload
+    );
+    void notifyUpdated(Conversation conv);
 
     db::Database* db_;
     cache::ConversationCache* conv_cache_;
@@ -101,6 +129,9 @@ private:
 
     mutable std::mutex handler_mutex_;
     std::shared_ptr<ConversationListener> listener_;
+
+    // Set once by setListenerBatching(); null for per-event delivery.
+    std::unique_ptr<util::EventBatcher<Conversation>> updated_batch_;
 };
 
 } // namespace anychat
@@ -218,6 +218,10 @@ void Database::close() {
     impl_->open_ = false;
 }
 
+bool Database::isOpen() const {
+    return impl_ && impl_->open_;
+}
+
 // ---------------------------------------------------------------------------
 // Async variants
 // ---------------------------------------------------------------------------
@@ -281,7 +285,7 @@ void Database::setMeta(const std::string& key, const std::string& value) {
 }
 
 // ---------------------------------------------------------------------------
-// TxScope — direct (non-queued) DB operations used inside transactionSync
+// TxScope — direct (non-queued) DB operations used inside transactions
 // ---------------------------------------------------------------------------
 
 bool Database::TxScope::execDirect(const std::string& sql, const Params& params) {
@@ -295,36 +299,74 @@ Rows Database::TxScope::queryDirect(const std::string& sql, const Params& params
     return rows;
 }
 
+size_t Database::TxScope::execBatch(const std::string& sql, const std::vector<Params>& rows, std::vector<bool>* done) {
+    if (done) {
+        done->assign(rows.size(), false);
+    }
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        return 0;
+    }
+    size_t succeeded = 0;
+    Rows ignored;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (bindParams(stmt, rows[i]) && stepAll(stmt, ignored).empty()) {
+            ++succeeded;
+            if (done) {
+                (*done)[i] = true;
+            }
+        }
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+    sqlite3_finalize(stmt);
+    return succeeded;
+}
+
 // ---------------------------------------------------------------------------
-// transactionSync
+// transactionSync / transaction
 // ---------------------------------------------------------------------------
 
-bool Database::transactionSync(std::function<bool(TxScope&)> fn) {
-    return impl_->postSync([this, fn = std::move(fn)]() -> bool {
-        if (execOrQuery(impl_->raw_db, "BEGIN", {}, nullptr) != "")
-            return false;
+// Runs fn between BEGIN and COMMIT on the DB thread; rolls back when fn
+// returns false or throws, or when COMMIT fails.
+static bool runTransaction(sqlite3* db, const std::function<bool(Database::TxScope&)>& fn) {
+    if (execOrQuery(db, "BEGIN", {}, nullptr) != "")
+        return false;
 
-        TxScope scope;
-        scope.db = impl_->raw_db;
+    Database::TxScope scope;
+    scope.db = db;
 
-        bool ok = false;
-        try {
-            ok = fn(scope);
-        } catch (...) {
-            ok = false;
-        }
+    bool ok = false;
+    try {
+        ok = fn(scope);
+    } catch (...) {
+        ok = false;
+    }
 
-        if (ok) {
-            std::string err = execOrQuery(impl_->raw_db, "COMMIT", {}, nullptr);
-            if (!err.empty()) {
-                execOrQuery(impl_->raw_db, "ROLLBACK", {}, nullptr);
-                return false;
-            }
-            return true;
-        } else {
-            execOrQuery(impl_->raw_db, "ROLLBACK", {}, nullptr);
+    if (ok) {
+        std::string err = execOrQuery(db, "COMMIT", {}, nullptr);
+        if (!err.empty()) {
+            execOrQuery(db, "ROLLBACK", {}, nullptr);
             return false;
         }
+        return true;
+    } else {
+        execOrQuery(db, "ROLLBACK", {}, nullptr);
+        return false;
+    }
+}
+
+bool Database::transactionSync(std::function<bool(TxScope&)> fn) {
+    return impl_->postSync([this, fn = std::move(fn)]() -> bool {
+        return runTransaction(impl_->raw_db, fn);
+    });
+}
+
+void Database::transaction(std::function<bool(TxScope&)> fn, ExecCallback cb) {
+    impl_->post([this, fn = std::move(fn), cb = std::move(cb)]() mutable {
+        const bool ok = runTransaction(impl_->raw_db, fn);
+        if (cb)
+            cb(ok, ok ? std::string{} : std::string("transaction rolled back"));
     });
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
 #include <memory>
 #include <string>
@@ -18,6 +20,17 @@ using Params = std::vector<DbValue>;
 using Row = std::unordered_map<std::string, std::string>;
 using Rows = std::vector<Row>;
 
+// Column accessors for query results; a missing column reads as 0 / "".
+inline int64_t rowInt64(const Row& row, const std::string& column) {
+    auto it = row.find(column);
+    return it == row.end() ? 0 : std::strtoll(it->second.c_str(), nullptr, 10);
+}
+
+inline std::string rowText(const Row& row, const std::string& column) {
+    auto it = row.find(column);
+    return it == row.end() ? std::string{} : it->second;
+}
+
 using ExecCallback = std::function<void(bool ok, std::string err)>;
 using QueryCallback = std::function<void(Rows rows, std::string err)>;
 
@@ -36,6 +49,10 @@ public:
     // Drains the task queue and closes the SQLite file.
     void close();
 
+    // True between a successful open() and close(). Callers with optional
+    // persistence (e.g. resumable uploads) check this before queuing work.
+    bool isOpen() const;
+
     // -------------------------------------------------------------------------
     // Async variants — callback is invoked on the DB worker thread.
     // -------------------------------------------------------------------------
@@ -68,6 +85,11 @@ public:
         // Execute a query and return all result rows.
         Rows queryDirect(const std::string& sql, const Params& params = {});
 
+        // Execute one statement once per parameter set, preparing it only
+        // once. A failing row does not stop the others; returns how many
+        // succeeded, and sets (*done)[i] for each row that did.
+        size_t execBatch(const std::string& sql, const std::vector<Params>& rows, std::vector<bool>* done = nullptr);
+
         // Raw SQLite handle — for internal use by execDirect/queryDirect.
         struct sqlite3* db = nullptr;
     };
@@ -76,6 +98,10 @@ public:
     // COMMIT themselves failed.
     bool transactionSync(std::function<bool(TxScope&)> fn);
 
+    // Async variant of transactionSync(); cb (if any) is invoked on the DB
+    // worker thread with ok == false when the transaction was rolled back.
+    void transaction(std::function<bool(TxScope&)> fn, ExecCallback cb = nullptr);
+
 private:
     struct Impl;
     std::unique_ptr<Impl> impl_;
@@ -138,6 +138,181 @@ static bool migrateToV1(sqlite3* db) {
     return true;
 }
 
+// Version 2: resumable multipart uploads.
+static constexpr const char* kSchemav2 = R"sql(
+CREATE TABLE IF NOT EXISTS upload_sessions (
+    local_path   TEXT PRIMARY KEY,
+    file_size    INTEGER,
+    file_mtime   INTEGER,
+    file_type    INTEGER,
+    file_id      TEXT,
+    upload_id    TEXT,
+    part_size    INTEGER,
+    part_count   INTEGER,
+    created_at   INTEGER
+);
+
+CREATE TABLE IF NOT EXISTS upload_parts (
+    file_id      TEXT NOT NULL,
+    part_number  INTEGER NOT NULL,
+    etag         TEXT,
+    PRIMARY KEY (file_id, part_number)
+);
+)sql";
+
+// Apply migration to version 2.
+static bool migrateToV2(sqlite3* db) {
+    if (!execRaw(db, "BEGIN"))
+        return false;
+    if (!execRaw(db, kSchemav2)) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    if (!execRaw(db, "PRAGMA user_version = 2")) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    if (!execRaw(db, "COMMIT")) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    return true;
+}
+
+// Version 3: resumable downloads. Only fully written segments are recorded.
+static constexpr const char* kSchemav3 = R"sql(
+CREATE TABLE IF NOT EXISTS download_tasks (
+    file_id      TEXT PRIMARY KEY,
+    dest_path    TEXT,
+    total_size   INTEGER,
+    etag         TEXT,
+    segment_size INTEGER,
+    created_at   INTEGER
+);
+
+CREATE TABLE IF NOT EXISTS download_segments (
+    file_id       TEXT NOT NULL,
+    segment_index INTEGER NOT NULL,
+    PRIMARY KEY (file_id, segment_index)
+);
+)sql";
+
+// Apply migration to version 3.
+static bool migrateToV3(sqlite3* db) {
+    if (!execRaw(db, "BEGIN"))
+        return false;
+    if (!execRaw(db, kSchemav3)) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    if (!execRaw(db, "PRAGMA user_version = 3")) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    if (!execRaw(db, "COMMIT")) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    return true;
+}
+
+// Version 4: on-disk media cache index.
+static constexpr const char* kSchemav4 = R"sql(
+CREATE TABLE IF NOT EXISTS media_cache (
+    file_id      TEXT PRIMARY KEY,
+    path         TEXT NOT NULL,
+    size         INTEGER NOT NULL,
+    last_access  INTEGER NOT NULL
+);
+
+CREATE INDEX IF NOT EXISTS idx_media_cache_access ON media_cache(last_access);
+)sql";
+
+// Apply migration to version 4.
+static bool migrateToV4(sqlite3* db) {
+    if (!execRaw(db, "BEGIN"))
+        return false;
+    if (!execRaw(db, kSchemav4)) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    if (!execRaw(db, "PRAGMA user_version = 4")) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    if (!execRaw(db, "COMMIT")) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    return true;
+}
+
+// Version 5: content hash -> file_id index for upload deduplication.
+static constexpr const char* kSchemav5 = R"sql(
+CREATE TABLE IF NOT EXISTS file_hashes (
+    sha256       TEXT NOT NULL,
+    file_size    INTEGER NOT NULL,
+    file_type    INTEGER NOT NULL,
+    file_id      TEXT NOT NULL,
+    file_name    TEXT,
+    mime_type    TEXT,
+    created_at   INTEGER,
+    PRIMARY KEY (sha256, file_type)
+);
+
+CREATE INDEX IF NOT EXISTS idx_file_hashes_file ON file_hashes(file_id);
+)sql";
+
+// Apply migration to version 5.
+static bool migrateToV5(sqlite3* db) {
+    if (!execRaw(db, "BEGIN"))
+        return false;
+    if (!execRaw(db, kSchemav5)) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    if (!execRaw(db, "PRAGMA user_version = 5")) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    if (!execRaw(db, "COMMIT")) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    return true;
+}
+
+// Version 6: queued uploads of the UploadScheduler, restored after a restart.
+static constexpr const char* kSchemav6 = R"sql(
+CREATE TABLE IF NOT EXISTS upload_jobs (
+    job_id       INTEGER PRIMARY KEY,
+    local_path   TEXT NOT NULL,
+    file_type    INTEGER NOT NULL,
+    priority     INTEGER NOT NULL DEFAULT 0,
+    file_size    INTEGER NOT NULL DEFAULT 0,
+    created_at   INTEGER NOT NULL
+);
+)sql";
+
+// Apply migration to version 6.
+static bool migrateToV6(sqlite3* db) {
+    if (!execRaw(db, "BEGIN"))
+        return false;
+    if (!execRaw(db, kSchemav6)) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    if (!execRaw(db, "PRAGMA user_version = 6")) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    if (!execRaw(db, "COMMIT")) {
+        execRaw(db, "ROLLBACK");
+        return false;
+    }
+    return true;
+}
+
 } // anonymous namespace
 
 bool runMigrations(sqlite3* db) {
@@ -151,6 +326,36 @@ bool runMigrations(sqlite3* db) {
         ver = 1;
     }
 
+    if (ver < 2) {
+        if (!migrateToV2(db))
+            return false;
+        ver = 2;
+    }
+
+    if (ver < 3) {
+        if (!migrateToV3(db))
+            return false;
+        ver = 3;
+    }
+
+    if (ver < 4) {
+        if (!migrateToV4(db))
+            return false;
+        ver = 4;
+    }
+
+    if (ver < 5) {
+        if (!migrateToV5(db))
+            return false;
+        ver = 5;
+    }
+
+    if (ver < 6) {
+        if (!migrateToV6(db))
+            return false;
+        ver = 6;
+    }
+
     (void) ver;
     return true;
 }
@@ -8,7 +8,7 @@ namespace db {
 
 // The current schema version.  Increment this (and add a migration block in
 // migrations.cpp) whenever the schema changes.
-static constexpr int kCurrentSchemaVersion = 1;
+static constexpr int kCurrentSchemaVersion = 6;
 
 // Apply all pending schema migrations to `db`.
 // Returns true on success, false on any error.
@@ -0,0 +1,619 @@
+#include "download_manager.h"
+
+#include "json_common.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace anychat::download_manager_detail {
+
+using db::rowInt64;
+using db::rowText;
+using json_common::nowMs;
+
+constexpr int kMaxDownloadParallelism = 8;
+
+struct DownloadWaiter {
+    DownloadProgressCallback on_progress;
+    AnyChatValueCallback<std::string> on_done;
+};
+
+// Shared by the callbacks of one download. Segment callbacks arrive on the
+// HTTP worker thread.
+struct DownloadTask {
+    std::mutex mutex;
+
+    std::string file_id;
+    std::string dest_path;
+    std::string part_path;
+    std::string url;
+    std::string etag;
+    int64_t total_size = -1; // unknown until the first reply
+    int64_t segment_size = 0;
+    int32_t segment_count = 0;
+    int parallelism = 1;
+    bool resuming = false;
+
+    std::deque<int32_t> queued; // segment indexes, 0-based
+    std::set<int32_t> done;
+    std::map<int32_t, int64_t> in_flight; // segment index -> bytes received so far
+    int64_t completed_bytes = 0;
+    bool failed = false;
+    bool changed = false; // failed because a segment came from another version
+    bool restarted = false; // already started over once for a change
+    bool finished = false;
+    std::string error;
+
+    std::vector<DownloadWaiter> waiters;
+
+    int64_t segmentOffset(int32_t index) const {
+        return static_cast<int64_t>(index) * segment_size;
+    }
+
+    int64_t segmentLength(int32_t index) const {
+        return std::min(segment_size, total_size - segmentOffset(index));
+    }
+
+    int64_t downloadedLocked() const {
+        int64_t downloaded = completed_bytes;
+        for (const auto& [index, received] : in_flight)
+            downloaded += received;
+        return downloaded;
+    }
+
+    void resetSegmentsLocked() {
+        queued.clear();
+        done.clear();
+        in_flight.clear();
+        completed_bytes = 0;
+        total_size = -1;
+        segment_count = 0;
+        etag.clear();
+    }
+};
+
+int64_t localFileSize(const std::string& path) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(std::filesystem::path(path), ec);
+    return ec ? -1 : static_cast<int64_t>(size);
+}
+
+// Parses "bytes <first>-<last>/<total>"; total is -1 for "*".
+bool parseContentRange(const std::string& value, int64_t& first, int64_t& last, int64_t& total) {
+    constexpr const char* kPrefix = "bytes ";
+    if (value.compare(0, 6, kPrefix) != 0)
+        return false;
+
+    const size_t dash = value.find('-', 6);
+    const size_t slash = value.find('/', 6);
+    if (dash == std::string::npos || slash == std::string::npos || dash > slash)
+        return false;
+
+    char* end = nullptr;
+    first = std::strtoll(value.c_str() + 6, &end, 10);
+    if (end != value.c_str() + dash)
+        return false;
+    last = std::strtoll(value.c_str() + dash + 1, &end, 10);
+    if (end != value.c_str() + slash || last < first)
+        return false;
+
+    const std::string total_str = value.substr(slash + 1);
+    if (total_str == "*") {
+        total = -1;
+        return true;
+    }
+    total = std::strtoll(total_str.c_str(), &end, 10);
+    return *end == '\0' && total > last;
+}
+
+std::string rangeHeader(int64_t first, int64_t last) {
+    return "Range: bytes=" + std::to_string(first) + "-" + std::to_string(last);
+}
+
+// Large bodies can take longer than the default total timeout, so only the
+// connect and low-speed limits apply.
+network::HttpRequest makeRangeRequest(const std::string& url, int64_t first, int64_t last) {
+    network::HttpRequest req;
+    req.method = network::HttpMethod::Get;
+    req.path = url;
+    req.timeouts = network::HttpTimeouts{ .total_timeout_ms = 0 };
+    req.headers.push_back(rangeHeader(first, last));
+    return req;
+}
+
+std::string httpFailure(const network::HttpResponse& resp, const std::string& what) {
+    if (!resp.error.empty())
+        return resp.error;
+    return what + " failed: HTTP " + std::to_string(resp.status_code);
+}
+
+} // namespace anychat::download_manager_detail
+
+namespace anychat {
+using namespace download_manager_detail;
+
+DownloadManager::DownloadManager(
+    std::shared_ptr<network::HttpClient> http,
+    db::Database* db,
+    UrlResolver resolve_url,
+    DownloadOptions options
+)
+    : http_(std::move(http))
+    , db_(db)
+    , resolve_url_(std::move(resolve_url))
+    , options_(options) {
+    if (options_.segment_size <= 0)
+        options_.segment_size = DownloadOptions{}.segment_size;
+    options_.parallelism = std::clamp(options_.parallelism, 1, kMaxDownloadParallelism);
+}
+
+void DownloadManager::download(
+    const std::string& file_id,
+    const std::string& dest_path,
+    DownloadProgressCallback on_progress,
+    AnyChatValueCallback<std::string> on_done
+) {
+    if (file_id.empty() || dest_path.empty()) {
+        if (on_done.on_error) {
+            on_done.on_error(-1, "file_id and dest_path are required");
+        }
+        return;
+    }
+
+    TaskPtr task;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = active_.find(file_id);
+        if (it != active_.end()) {
+            // Join the running transfer; finish() takes the waiter list only
+            // after the task has left active_, so this waiter is never missed.
+            std::lock_guard<std::mutex> task_lock(it->second->mutex);
+            it->second->waiters.push_back(DownloadWaiter{ std::move(on_progress), std::move(on_done) });
+            return;
+        }
+
+        task = std::make_shared<DownloadTask>();
+        task->file_id = file_id;
+        task->dest_path = dest_path;
+        task->part_path = dest_path + ".part";
+        task->segment_size = options_.segment_size;
+        task->parallelism = options_.parallelism;
+        task->waiters.push_back(DownloadWaiter{ std::move(on_progress), std::move(on_done) });
+        active_[file_id] = task;
+    }
+
+    // Pick up the segments of an earlier, interrupted download of this file.
+    if (db_ && db_->isOpen()) {
+        const db::Rows rows = db_->querySync(
+            "SELECT dest_path, total_size, etag, segment_size FROM download_tasks WHERE file_id = ?",
+            { file_id }
+        );
+        if (!rows.empty()) {
+            const db::Row& row = rows.front();
+            const int64_t total_size = rowInt64(row, "total_size");
+            const int64_t segment_size = rowInt64(row, "segment_size");
+            const bool usable = rowText(row, "dest_path") == dest_path && total_size > 0 && segment_size > 0
+                                && localFileSize(task->part_path) == total_size;
+            if (!usable) {
+                dropDownloadState(file_id);
+            } else {
+                task->resuming = true;
+                task->total_size = total_size;
+                task->segment_size = segment_size;
+                task->segment_count = static_cast<int32_t>((total_size + segment_size - 1) / segment_size);
+                task->etag = rowText(row, "etag");
+
+                const db::Rows segments =
+                    db_->querySync("SELECT segment_index FROM download_segments WHERE file_id = ?", { file_id });
+                for (const auto& segment : segments) {
+                    const auto index = static_cast<int32_t>(rowInt64(segment, "segment_index"));
+                    if (index < 0 || index >= task->segment_count || !task->done.insert(index).second)
+                        continue;
+                    task->completed_bytes += task->segmentLength(index);
+                }
+            }
+        }
+    }
+
+    // Presigned URLs expire, so they are resolved again on every attempt.
+    AnyChatValueCallback<std::string> resolved;
+    resolved.on_success = [this, task](const std::string& url) {
+        {
+            std::lock_guard<std::mutex> lock(task->mutex);
+            task->url = url;
+        }
+        start(task);
+    };
+    resolved.on_error = [this, task](int code, const std::string& error) {
+        finish(task, code, error);
+    };
+    resolve_url_(file_id, std::move(resolved));
+}
+
+void DownloadManager::start(const TaskPtr& task) {
+    bool resuming = false;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        resuming = task->resuming;
+    }
+    if (resuming) {
+        validateResume(task);
+    } else {
+        startFresh(task);
+    }
+}
+
+void DownloadManager::startFresh(const TaskPtr& task) {
+    dropDownloadState(task->file_id);
+
+    {
+        std::ofstream part(task->part_path, std::ios::binary | std::ios::trunc);
+        if (!part) {
+            finish(task, -1, "cannot create file: " + task->part_path);
+            return;
+        }
+    }
+
+    std::string url;
+    int64_t segment_size = 0;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->resuming = false;
+        task->resetSegmentsLocked();
+        task->failed = false;
+        task->changed = false;
+        task->error.clear();
+        task->in_flight[0] = 0;
+        url = task->url;
+        segment_size = task->segment_size;
+    }
+
+    // The first segment doubles as the size / Range-support probe. A server
+    // that ignores Range answers 200 and streams the whole file here.
+    network::HttpRequest req = makeRangeRequest(url, 0, segment_size - 1);
+    req.file_sink = network::HttpFileSink{ .path = task->part_path, .offset = 0 };
+    req.on_progress = [this, task](int64_t received, int64_t /*total*/) {
+        {
+            std::lock_guard<std::mutex> lock(task->mutex);
+            auto it = task->in_flight.find(0);
+            if (it == task->in_flight.end())
+                return;
+            it->second = received;
+        }
+        reportProgress(task);
+    };
+
+    http_->send(std::move(req), [this, task](network::HttpResponse resp) {
+        onFirstSegment(task, std::move(resp));
+    });
+}
+
+void DownloadManager::validateResume(const TaskPtr& task) {
+    std::string url;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        url = task->url;
+    }
+
+    // A one-byte Range request confirms the object is still the one the
+    // recorded segments belong to.
+    http_->send(makeRangeRequest(url, 0, 0), [this, task](network::HttpResponse resp) {
+        if (!resp.error.empty()) {
+            finish(task, -1, resp.error);
+            return;
+        }
+
+        int64_t first = 0;
+        int64_t last = 0;
+        int64_t total = -1;
+        bool unchanged = false;
+        {
+            std::lock_guard<std::mutex> lock(task->mutex);
+            unchanged = resp.status_code == 206 && parseContentRange(resp.header("content-range"), first, last, total)
+                        && total == task->total_size && resp.header("etag") == task->etag;
+            if (unchanged) {
+                for (int32_t index = 0; index < task->segment_count; ++index) {
+                    if (task->done.count(index) == 0)
+                        task->queued.push_back(index);
+                }
+            }
+        }
+
+        if (!unchanged) {
+            startFresh(task);
+            return;
+        }
+
+        reportProgress(task);
+        pumpSegments(task);
+    });
+}
+
+void DownloadManager::onFirstSegment(const TaskPtr& task, network::HttpResponse resp) {
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->in_flight.erase(0);
+    }
+
+    if (!resp.error.empty() || (resp.status_code != 200 && resp.status_code != 206)) {
+        finish(task, -1, httpFailure(resp, "download"));
+        return;
+    }
+
+    const int64_t written = localFileSize(task->part_path);
+
+    if (resp.status_code == 200) {
+        // No Range support: the whole body has been streamed already.
+        const std::string content_length = resp.header("content-length");
+        if (!content_length.empty() && std::strtoll(content_length.c_str(), nullptr, 10) != written) {
+            finish(task, -1, "download size mismatch");
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(task->mutex);
+            task->total_size = written;
+            task->completed_bytes = written;
+        }
+        finalize(task);
+        return;
+    }
+
+    int64_t first = 0;
+    int64_t last = 0;
+    int64_t total = -1;
+    if (!parseContentRange(resp.header("content-range"), first, last, total) || first != 0 || total < 0) {
+        finish(task, -1, "download failed: unusable Content-Range");
+        return;
+    }
+    if (written != last + 1) {
+        finish(task, -1, "download size mismatch");
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->total_size = total;
+        task->etag = resp.header("etag");
+        // Servers may cap the length of a range; follow their segment size.
+        task->segment_size = written;
+        task->segment_count = static_cast<int32_t>((total + written - 1) / written);
+        task->done.insert(0);
+        task->completed_bytes = written;
+        for (int32_t index = 1; index < task->segment_count; ++index)
+            task->queued.push_back(index);
+    }
+
+    if (written == total) {
+        finalize(task);
+        return;
+    }
+
+    // Pre-size the part file so every segment can be written at its offset.
+    std::error_code ec;
+    std::filesystem::resize_file(std::filesystem::path(task->part_path), static_cast<uintmax_t>(total), ec);
+    if (ec) {
+        finish(task, -1, "cannot allocate file: " + task->part_path);
+        return;
+    }
+
+    if (db_ && db_->isOpen()) {
+        db_->exec(
+            "INSERT OR REPLACE INTO download_tasks "
+            "(file_id, dest_path, total_size, etag, segment_size, created_at) VALUES (?, ?, ?, ?, ?, ?)",
+            { task->file_id, task->dest_path, total, task->etag, written, nowMs() }
+        );
+        db_->exec(
+            "INSERT OR REPLACE INTO download_segments (file_id, segment_index) VALUES (?, ?)",
+            { task->file_id, static_cast<int64_t>(0) }
+        );
+    }
+
+    reportProgress(task);
+    pumpSegments(task);
+}
+
+void DownloadManager::pumpSegments(const TaskPtr& task) {
+    std::vector<int32_t> to_start;
+    std::string url;
+    bool all_done = false;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        while (!task->failed && static_cast<int>(task->in_flight.size()) < task->parallelism
+               && !task->queued.empty()) {
+            const int32_t index = task->queued.front();
+            task->queued.pop_front();
+            task->in_flight[index] = 0;
+            to_start.push_back(index);
+        }
+        url = task->url;
+        all_done = !task->failed && task->queued.empty() && task->in_flight.empty();
+    }
+
+    if (all_done) {
+        finalize(task);
+        return;
+    }
+
+    for (const int32_t index : to_start) {
+        const int64_t offset = task->segmentOffset(index);
+        const int64_t length = task->segmentLength(index);
+
+        network::HttpRequest req = makeRangeRequest(url, offset, offset + length - 1);
+        req.file_sink = network::HttpFileSink{ .path = task->part_path, .offset = offset, .max_bytes = length };
+        req.on_progress = [this, task, index](int64_t received, int64_t /*total*/) {
+            {
+                std::lock_guard<std::mutex> lock(task->mutex);
+                auto it = task->in_flight.find(index);
+                if (it == task->in_flight.end())
+                    return;
+                it->second = received;
+            }
+            reportProgress(task);
+        };
+
+        http_->send(std::move(req), [this, task, index](network::HttpResponse resp) {
+            onSegmentDone(task, index, std::move(resp));
+        });
+    }
+}
+
+void DownloadManager::onSegmentDone(const TaskPtr& task, int32_t index, network::HttpResponse resp) {
+    const int64_t offset = task->segmentOffset(index);
+    const int64_t length = task->segmentLength(index);
+
+    int64_t first = 0;
+    int64_t last = 0;
+    int64_t total = -1;
+    const bool ranged = resp.error.empty() && resp.status_code == 206
+                        && parseContentRange(resp.header("content-range"), first, last, total);
+
+    bool ok = false;
+    bool report_failure = false;
+    bool restart = false;
+    bool all_done = false;
+    std::string error;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->in_flight.erase(index);
+        // Same check as validateResume(): bytes of another version of the
+        // object must not be spliced into the part file.
+        const bool changed = ranged && (total != task->total_size || resp.header("etag") != task->etag);
+        ok = ranged && !changed && first == offset && last == offset + length - 1;
+        if (ok) {
+            task->done.insert(index);
+            task->completed_bytes += length;
+        } else if (!task->failed) {
+            task->failed = true;
+            task->changed = changed;
+            task->error = changed ? "download failed: file changed during download"
+                                  : httpFailure(resp, "segment " + std::to_string(index) + " download");
+        }
+
+        if (task->failed) {
+            // Act once all in-flight segments have settled, so that every
+            // segment that did make it is recorded for the next attempt.
+            // A changed object starts over once; if it changes again the
+            // failure is reported.
+            if (task->in_flight.empty()) {
+                restart = task->changed && !task->restarted;
+                report_failure = !restart;
+                task->restarted = task->restarted || restart;
+            }
+            error = task->error;
+        } else {
+            all_done = task->queued.empty() && task->in_flight.empty();
+        }
+    }
+
+    if (ok && db_ && db_->isOpen()) {
+        db_->exec(
+            "INSERT OR REPLACE INTO download_segments (file_id, segment_index) VALUES (?, ?)",
+            { task->file_id, static_cast<int64_t>(index) }
+        );
+    }
+
+    if (restart) {
+        startFresh(task);
+        return;
+    }
+    if (report_failure) {
+        finish(task, -1, error);
+        return;
+    }
+
+    if (all_done) {
+        finalize(task);
+    } else {
+        pumpSegments(task);
+    }
+}
+
+void DownloadManager::finalize(const TaskPtr& task) {
+    int64_t total_size = 0;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        total_size = task->total_size;
+    }
+
+    if (localFileSize(task->part_path) != total_size) {
+        dropDownloadState(task->file_id);
+        std::error_code ec;
+        std::filesystem::remove(std::filesystem::path(task->part_path), ec);
+        finish(task, -1, "download size mismatch");
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(std::filesystem::path(task->part_path), std::filesystem::path(task->dest_path), ec);
+    if (ec) {
+        finish(task, -1, "cannot move download to " + task->dest_path + ": " + ec.message());
+        return;
+    }
+
+    dropDownloadState(task->file_id);
+    reportProgress(task);
+    finish(task, 0, {});
+}
+
+void DownloadManager::finish(const TaskPtr& task, int code, const std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = active_.find(task->file_id);
+        if (it != active_.end() && it->second == task)
+            active_.erase(it);
+    }
+
+    std::vector<DownloadWaiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        if (task->finished)
+            return;
+        task->finished = true;
+        task->failed = !error.empty();
+        waiters = std::move(task->waiters);
+    }
+
+    for (const auto& waiter : waiters) {
+        if (error.empty()) {
+            if (waiter.on_done.on_success) {
+                waiter.on_done.on_success(task->dest_path);
+            }
+        } else if (waiter.on_done.on_error) {
+            waiter.on_done.on_error(code, error);
+        }
+    }
+}
+
+void DownloadManager::reportProgress(const TaskPtr& task) {
+    std::vector<DownloadProgressCallback> callbacks;
+    int64_t downloaded = 0;
+    int64_t total = 0;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        downloaded = task->downloadedLocked();
+        total = std::max<int64_t>(task->total_size, 0);
+        for (const auto& waiter : task->waiters) {
+            if (waiter.on_progress)
+                callbacks.push_back(waiter.on_progress);
+        }
+    }
+    for (const auto& cb : callbacks)
+        cb(downloaded, total);
+}
+
+void DownloadManager::dropDownloadState(const std::string& file_id) {
+    if (!db_ || !db_->isOpen())
+        return;
+    db_->exec("DELETE FROM download_segments WHERE file_id = ?", { file_id });
+    db_->exec("DELETE FROM download_tasks WHERE file_id = ?", { file_id });
+}
+
+} // namespace anychat
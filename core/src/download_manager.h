@@ -0,0 +1,88 @@
+#pragma once
+
+#include "sdk_callbacks.h"
+
+#include "db/database.h"
+#include "network/http_client.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace anychat {
+
+using DownloadProgressCallback = std::function<void(int64_t downloaded, int64_t total)>;
+
+struct DownloadOptions {
+    int64_t segment_size = 4 * 1024 * 1024; // bytes per Range request
+    int parallelism = 4; // concurrent Range requests, clamped to [1, 8]
+};
+
+namespace download_manager_detail {
+struct DownloadTask;
+} // namespace download_manager_detail
+
+// Streams files from presigned storage URLs to disk.
+//
+// The first request asks for the first segment with a Range header. A 206
+// reply reveals the total size, and the remaining segments are then fetched
+// in parallel into "<dest_path>.part" at their offsets. A server that ignores
+// Range simply streams the whole body in that first request. The part file is
+// size-checked and renamed onto |dest_path| once complete.
+//
+// Finished segments are recorded in the database, so a download that failed
+// (or was interrupted by a restart) resumes with the missing segments as long
+// as the remote object's size and ETag are unchanged. Every segment reply is
+// held to the same size and ETag; if the object changes mid-download, the
+// download starts over once.
+//
+// Concurrent download() calls for the same file_id share one transfer; every
+// caller is notified and receives the path the file was written to.
+class DownloadManager {
+public:
+    // Resolves a file_id to a (presigned) download URL.
+    using UrlResolver = std::function<void(const std::string& file_id, AnyChatValueCallback<std::string> cb)>;
+
+    // |db| is optional; without an open database downloads cannot resume
+    // across restarts.
+    DownloadManager(
+        std::shared_ptr<network::HttpClient> http,
+        db::Database* db,
+        UrlResolver resolve_url,
+        DownloadOptions options = {}
+    );
+
+    // on_done receives the local path of the downloaded file.
+    void download(
+        const std::string& file_id,
+        const std::string& dest_path,
+        DownloadProgressCallback on_progress,
+        AnyChatValueCallback<std::string> on_done
+    );
+
+private:
+    using TaskPtr = std::shared_ptr<download_manager_detail::DownloadTask>;
+
+    void start(const TaskPtr& task);
+    void startFresh(const TaskPtr& task);
+    void validateResume(const TaskPtr& task);
+    void onFirstSegment(const TaskPtr& task, network::HttpResponse resp);
+    void pumpSegments(const TaskPtr& task);
+    void onSegmentDone(const TaskPtr& task, int32_t index, network::HttpResponse resp);
+    void finalize(const TaskPtr& task);
+    void finish(const TaskPtr& task, int code, const std::string& error);
+    void reportProgress(const TaskPtr& task);
+    void dropDownloadState(const std::string& file_id);
+
+    std::shared_ptr<network::HttpClient> http_;
+    db::Database* db_;
+    UrlResolver resolve_url_;
+    DownloadOptions options_;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, TaskPtr> active_; // file_id -> running task
+};
+
+} // namespace anychat
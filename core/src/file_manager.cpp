@@ -1,9 +1,14 @@
 #include "file_manager.h"
 
 #include "json_common.h"
-
-#include <fstream>
-#include <iterator>
+#include "util/sha256.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <utility>
@@ -12,7 +17,10 @@
 
 namespace anychat::file_manager_detail {
 
+using db::rowInt64;
+using db::rowText;
 using json_common::ApiEnvelope;
+using json_common::nowMs;
 using json_common::parseApiEnvelopeResponse;
 using json_common::parseBoolValue;
 using json_common::parseInt32Value;
@@ -30,6 +38,7 @@ struct UploadTokenRequest {
     int32_t file_type = 0;
     int64_t file_size = 0;
     std::string mime_type{};
+    std::string sha256{};
 };
 
 struct UploadClientLogInitRequest {
@@ -63,6 +72,18 @@ struct FileInfoPayload {
 
 using FileInfoDataValue = std::variant<std::monostate, FileInfoPayload>;
 
+struct HashCheckRequest {
+    std::string sha256{};
+    int64_t file_size = 0;
+    int32_t file_type = 0;
+    std::string file_name{};
+};
+
+struct HashCheckPayload {
+    OptionalBooleanValue exists{};
+    std::optional<FileInfoPayload> file{};
+};
+
 struct FileListDataPayload {
     std::optional<std::vector<FileInfoPayload>> files{};
     OptionalIntegerValue total{};
@@ -72,6 +93,93 @@ struct DeleteFilePayload {
     OptionalBooleanValue success{};
 };
 
+struct MultipartInitRequest {
+    std::string file_name{};
+    int32_t file_type = 0;
+    int64_t file_size = 0;
+    std::string mime_type{};
+    int64_t part_size = 0;
+    std::string sha256{};
+};
+
+struct MultipartInitPayload {
+    std::string file_id{};
+    std::string upload_id{};
+    OptionalIntegerValue part_size{};
+};
+
+struct PartUrlsRequest {
+    std::string upload_id{};
+    std::vector<int32_t> part_numbers{};
+};
+
+struct PartUrlPayload {
+    OptionalIntegerValue part_number{};
+    std::string upload_url{};
+};
+
+struct PartUrlsPayload {
+    std::optional<std::vector<PartUrlPayload>> parts{};
+};
+
+struct CompletedPart {
+    int32_t part_number = 0;
+    std::string etag{};
+};
+
+struct MultipartCompleteRequest {
+    std::string upload_id{};
+    std::vector<CompletedPart> parts{};
+};
+
+constexpr int kMaxMultipartParallelism = 8;
+
+// Shared by the callbacks of one multipart upload. Part callbacks arrive on
+// the HTTP worker thread; the mutex also covers the initial setup.
+struct MultipartUploadState {
+    std::mutex mutex;
+
+    std::string local_path;
+    std::string file_name;
+    int32_t file_type = 0;
+    int64_t file_size = 0;
+    int64_t file_mtime = 0;
+    std::string sha256;
+    int64_t part_size = 0;
+    int32_t part_count = 0;
+    int parallelism = 1;
+    int64_t max_bytes_per_sec = 0; // whole upload, split across parallel parts
+    std::string file_id;
+    std::string upload_id;
+
+    std::deque<std::pair<int32_t, std::string>> queued; // part number, upload url
+    std::map<int32_t, std::string> etags; // completed parts
+    std::map<int32_t, int64_t> in_flight; // part number -> bytes sent so far
+    int64_t completed_bytes = 0;
+    bool restarted = false; // the server forgot the upload once already
+    bool failed = false;
+    bool finished = false;
+    std::string error;
+
+    UploadProgressCallback on_progress;
+    AnyChatValueCallback<FileInfo> on_done;
+
+    int64_t partOffset(int32_t part_number) const {
+        return static_cast<int64_t>(part_number - 1) * part_size;
+    }
+
+    int64_t partLength(int32_t part_number) const {
+        return std::min(part_size, file_size - partOffset(part_number));
+    }
+
+    int64_t uploadedLocked() const {
+        int64_t uploaded = completed_bytes;
+        for (const auto& [part_number, sent] : in_flight)
+            uploaded += sent;
+        return uploaded;
+    }
+};
+
 constexpr int32_t kFileTypeUnspecified = 0;
 constexpr int32_t kFileTypeImage = 1;
 constexpr int32_t kFileTypeVideo = 2;
@@ -107,29 +215,54 @@ std::string extractFileName(const std::string& local_path) {
     return file_name;
 }
 
-bool readFileBytes(const std::string& local_path, std::string& file_name, std::string& file_bytes, std::string& err) {
+// Validates |local_path| for upload without reading it; the body is streamed
+// from disk by the HTTP client.
+bool statUploadFile(const std::string& local_path, std::string& file_name, int64_t& file_size, std::string& err) {
     file_name = extractFileName(local_path);
 
-    std::ifstream ifs(local_path, std::ios::binary);
-    if (!ifs.is_open()) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(std::filesystem::path(local_path), ec);
+    if (ec) {
         err = "cannot open file: " + local_path;
         return false;
     }
 
-    file_bytes.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
-    if (ifs.bad()) {
-        err = "read file failed: " + local_path;
-        return false;
-    }
-
-    if (file_bytes.empty()) {
+    if (size == 0) {
         err = "file is empty: " + local_path;
         return false;
     }
 
+    file_size = static_cast<int64_t>(size);
     return true;
 }
 
+int64_t fileMtime(const std::string& local_path) {
+    std::error_code ec;
+    const auto mtime = std::filesystem::last_write_time(std::filesystem::path(local_path), ec);
+    return ec ? 0 : static_cast<int64_t>(mtime.time_since_epoch().count());
+}
+
+// PUT of (a range of) a local file to a presigned storage URL. Large bodies can
+// take longer than the default total timeout, so only the connect and
+// low-speed limits apply.
+network::HttpRequest makeFilePutRequest(
+    const std::string& upload_url,
+    const std::string& local_path,
+    int64_t offset,
+    int64_t length,
+    const UploadProgressCallback& on_progress,
+    int64_t max_bytes_per_sec = 0
+) {
+    network::HttpRequest req;
+    req.method = network::HttpMethod::Put;
+    req.path = upload_url;
+    req.timeouts = network::HttpTimeouts{ .total_timeout_ms = 0 };
+    req.file_body = network::HttpFileBody{ .path = local_path, .offset = offset, .length = length };
+    req.on_progress = on_progress;
+    req.max_send_bytes_per_sec = max_bytes_per_sec;
+    return req;
+}
+
 template <typename T>
 bool parseTypedDataResponse(
     const network::HttpResponse& resp,
@@ -167,30 +300,165 @@ const std::vector<FileInfoPayload>* toFileInfoPayloadList(const FileListDataPayl
 namespace anychat {
 using namespace file_manager_detail;
 
-FileManagerImpl::FileManagerImpl(std::shared_ptr<network::HttpClient> http)
-    : http_(std::move(http)) {}
+FileManagerImpl::FileManagerImpl(
+    std::shared_ptr<network::HttpClient> http,
+    db::Database* db,
+    cache::MediaCache* media_cache
+)
+    : http_(std::move(http))
+    , db_(db)
+    , media_cache_(media_cache)
+    , downloads_(std::make_unique<DownloadManager>(
+          http_,
+          db_,
+          [this](const std::string& file_id, AnyChatValueCallback<std::string> cb) {
+              getDownloadUrl(file_id, std::move(cb));
+          }
+      ))
+    , scheduler_(std::make_unique<UploadScheduler>(
+          [this](
+              const UploadJobInfo& job,
+              int64_t max_bytes_per_sec,
+              UploadProgressCallback on_progress,
+              AnyChatValueCallback<FileInfo> on_done
+          ) {
+              if (job.file_size >= kScheduledMultipartThreshold) {
+                  uploadMultipart(
+                      job.local_path,
+                      job.file_type,
+                      MultipartUploadOptions{ .max_bytes_per_sec = max_bytes_per_sec },
+                      std::move(on_progress),
+                      std::move(on_done)
+                  );
+              } else {
+                  uploadSingle(
+                      job.local_path,
+                      job.file_type,
+                      max_bytes_per_sec,
+                      std::move(on_progress),
+                      std::move(on_done)
+                  );
+              }
+          },
+          db_
+      ))
+    , hasher_(std::make_unique<util::DispatchExecutor>(util::DispatchExecutorOptions{ .threads = 1 })) {}
+
+FileManagerImpl::~FileManagerImpl() {
+    // A hash that finishes now may still report to the scheduler; a job the
+    // scheduler starts afterwards finds hasher_ shut down and is dropped, to
+    // be restored from upload_jobs on the next start.
+    hasher_->shutdown();
+}
 
 void FileManagerImpl::upload(
     const std::string& local_path,
     int32_t file_type,
     UploadProgressCallback on_progress,
     AnyChatValueCallback<FileInfo> on_done
+) {
+    uploadSingle(local_path, file_type, 0, std::move(on_progress), std::move(on_done));
+}
+
+void FileManagerImpl::uploadSingle(
+    const std::string& local_path,
+    int32_t file_type,
+    int64_t max_bytes_per_sec,
+    UploadProgressCallback on_progress,
+    AnyChatValueCallback<FileInfo> on_done
 ) {
     std::string file_name;
-    auto file_bytes = std::make_shared<std::string>();
-    std::string read_err;
-    if (!readFileBytes(local_path, file_name, *file_bytes, read_err)) {
+    int64_t file_size = 0;
+    std::string stat_err;
+    if (!statUploadFile(local_path, file_name, file_size, stat_err)) {
         if (on_done.on_error) {
-            on_done.on_error(-1, read_err);
+            on_done.on_error(-1, stat_err);
         }
         return;
     }
 
+    const int32_t normalized_type = normalizeFileType(file_type);
+    hashForDedupe(
+        local_path,
+        [this, local_path, file_name, file_size, normalized_type, max_bytes_per_sec, on_progress, on_done](
+            bool ok,
+            const std::string& sha256,
+            const std::string& hash_err
+        ) {
+            if (!ok) {
+                if (on_done.on_error) {
+                    on_done.on_error(-1, hash_err);
+                }
+                return;
+            }
+            if (sha256.empty()) {
+                startUpload(
+                    local_path,
+                    file_name,
+                    file_size,
+                    normalized_type,
+                    {},
+                    max_bytes_per_sec,
+                    on_progress,
+                    on_done
+                );
+                return;
+            }
+
+            lookupUploadedHash(
+                sha256,
+                file_size,
+                normalized_type,
+                file_name,
+                [file_size, on_progress, on_done](const FileInfo& info) {
+                    if (on_progress) {
+                        on_progress(file_size, file_size);
+                    }
+                    if (on_done.on_success) {
+                        on_done.on_success(info);
+                    }
+                },
+                [this,
+                 local_path,
+                 file_name,
+                 file_size,
+                 normalized_type,
+                 sha256,
+                 max_bytes_per_sec,
+                 on_progress,
+                 on_done] {
+                    startUpload(
+                        local_path,
+                        file_name,
+                        file_size,
+                        normalized_type,
+                        sha256,
+                        max_bytes_per_sec,
+                        on_progress,
+                        rememberHashOnSuccess(sha256, file_size, normalized_type, on_done)
+                    );
+                }
+            );
+        }
+    );
+}
+
+void FileManagerImpl::startUpload(
+    const std::string& local_path,
+    const std::string& file_name,
+    int64_t file_size,
+    int32_t file_type,
+    const std::string& sha256,
+    int64_t max_bytes_per_sec,
+    UploadProgressCallback on_progress,
+    AnyChatValueCallback<FileInfo> on_done
+) {
     UploadTokenRequest req_body{
         .file_name = file_name,
-        .file_type = normalizeFileType(file_type),
-        .file_size = static_cast<int64_t>(file_bytes->size()),
+        .file_type = file_type,
+        .file_size = file_size,
         .mime_type = "application/octet-stream",
+        .sha256 = sha256,
     };
 
     std::string req_json;
@@ -205,7 +473,7 @@ void FileManagerImpl::upload(
     http_->post(
         "/files/upload-token",
         req_json,
-        [this, file_bytes, on_progress, on_done](network::HttpResponse resp) {
+        [this, local_path, file_size, max_bytes_per_sec, on_progress, on_done](network::HttpResponse resp) {
             ApiEnvelope<UploadTokenPayload> root{};
             if (!parseTypedDataResponse(resp, root, "upload-token failed")) {
                 if (on_done.on_error) {
@@ -223,13 +491,12 @@ void FileManagerImpl::upload(
             }
 
             if (on_progress) {
-                on_progress(0, static_cast<int64_t>(file_bytes->size()));
+                on_progress(0, file_size);
             }
 
-            http_->put(
-                token.upload_url,
-                *file_bytes,
-                [this, file_id = token.file_id, file_bytes, on_progress, on_done](network::HttpResponse put_resp) {
+            http_->send(
+                makeFilePutRequest(token.upload_url, local_path, 0, file_size, on_progress, max_bytes_per_sec),
+                [this, file_id = token.file_id, on_done](network::HttpResponse put_resp) {
                     if (!put_resp.error.empty()) {
                         if (on_done.on_error) {
                             on_done.on_error(-1, put_resp.error);
@@ -244,11 +511,6 @@ void FileManagerImpl::upload(
                         return;
                     }
 
-                    if (on_progress) {
-                        const auto uploaded = static_cast<int64_t>(file_bytes->size());
-                        on_progress(uploaded, uploaded);
-                    }
-
                     http_->post("/files/" + file_id + "/complete", "{}", [file_id, on_done](network::HttpResponse complete_resp) {
                         ApiEnvelope<FileInfoDataValue> complete_root{};
                         if (!parseTypedDataResponse(complete_resp, complete_root, "complete failed")) {
@@ -273,6 +535,541 @@ void FileManagerImpl::upload(
     );
 }
 
+void FileManagerImpl::uploadMultipart(
+    const std::string& local_path,
+    int32_t file_type,
+    MultipartUploadOptions options,
+    UploadProgressCallback on_progress,
+    AnyChatValueCallback<FileInfo> on_done
+) {
+    auto state = std::make_shared<MultipartUploadState>();
+    std::string stat_err;
+    if (!statUploadFile(local_path, state->file_name, state->file_size, stat_err)) {
+        if (on_done.on_error) {
+            on_done.on_error(-1, stat_err);
+        }
+        return;
+    }
+
+    state->local_path = local_path;
+    state->file_type = normalizeFileType(file_type);
+    state->file_mtime = fileMtime(local_path);
+    state->part_size = options.part_size > 0 ? options.part_size : MultipartUploadOptions{}.part_size;
+    state->parallelism = std::clamp(options.parallelism, 1, kMaxMultipartParallelism);
+    state->max_bytes_per_sec = std::max<int64_t>(options.max_bytes_per_sec, 0);
+
+    state->on_progress = std::move(on_progress);
+    state->on_done = std::move(on_done);
+    hashForDedupe(local_path, [this, state](bool ok, const std::string& sha256, const std::string& hash_err) {
+        if (!ok) {
+            if (state->on_done.on_error) {
+                state->on_done.on_error(-1, hash_err);
+            }
+            return;
+        }
+        if (sha256.empty()) {
+            beginMultipart(state);
+            return;
+        }
+        state->sha256 = sha256;
+        state->on_done = rememberHashOnSuccess(sha256, state->file_size, state->file_type, std::move(state->on_done));
+
+        lookupUploadedHash(
+            state->sha256,
+            state->file_size,
+            state->file_type,
+            state->file_name,
+            [state](const FileInfo& info) {
+                if (state->on_progress) {
+                    state->on_progress(state->file_size, state->file_size);
+                }
+                if (state->on_done.on_success) {
+                    state->on_done.on_success(info);
+                }
+            },
+            [this, state]() {
+                beginMultipart(state);
+            }
+        );
+    });
+}
+
+void FileManagerImpl::beginMultipart(const MultipartStatePtr& state) {
+    const std::string& local_path = state->local_path;
+
+    // Resume a previous session for the same, unmodified file.
+    if (db_ && db_->isOpen()) {
+        const db::Rows sessions = db_->querySync(
+            "SELECT file_size, file_mtime, file_type, file_id, upload_id, part_size, part_count "
+            "FROM upload_sessions WHERE local_path = ?",
+            { local_path }
+        );
+        if (!sessions.empty()) {
+            const db::Row& session = sessions.front();
+            const bool same_file = rowInt64(session, "file_size") == state->file_size
+                                   && rowInt64(session, "file_mtime") == state->file_mtime
+                                   && rowInt64(session, "file_type") == state->file_type
+                                   && rowInt64(session, "part_size") > 0 && !rowText(session, "file_id").empty();
+            if (!same_file) {
+                dropUploadSession(local_path, rowText(session, "file_id"));
+            } else {
+                state->file_id = rowText(session, "file_id");
+                state->upload_id = rowText(session, "upload_id");
+                state->part_size = rowInt64(session, "part_size");
+                state->part_count = static_cast<int32_t>(rowInt64(session, "part_count"));
+
+                const db::Rows parts =
+                    db_->querySync("SELECT part_number, etag FROM upload_parts WHERE file_id = ?", { state->file_id });
+                for (const auto& part : parts) {
+                    const auto part_number = static_cast<int32_t>(rowInt64(part, "part_number"));
+                    if (part_number < 1 || part_number > state->part_count)
+                        continue;
+                    state->etags[part_number] = rowText(part, "etag");
+                    state->completed_bytes += state->partLength(part_number);
+                }
+                requestPartUrls(state);
+                return;
+            }
+        }
+    }
+
+    initMultipart(state);
+}
+
+void FileManagerImpl::initMultipart(const MultipartStatePtr& state) {
+    MultipartInitRequest req_body{
+        .file_name = state->file_name,
+        .file_type = state->file_type,
+        .file_size = state->file_size,
+        .mime_type = "application/octet-stream",
+        .part_size = state->part_size,
+        .sha256 = state->sha256,
+    };
+
+    std::string req_json;
+    std::string req_err;
+    if (!writeJson(req_body, req_json, req_err)) {
+        failMultipart(state, -1, req_err);
+        return;
+    }
+
+    http_->post("/files/multipart/init", req_json, [this, state](network::HttpResponse resp) {
+        ApiEnvelope<MultipartInitPayload> root{};
+        if (!parseTypedDataResponse(resp, root, "multipart init failed")) {
+            failMultipart(state, root.code, root.message);
+            return;
+        }
+        if (root.data.file_id.empty()) {
+            failMultipart(state, -1, "multipart init response missing file id");
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->file_id = root.data.file_id;
+            state->upload_id = root.data.upload_id;
+            const int64_t server_part_size = parseInt64Value(root.data.part_size, 0);
+            if (server_part_size > 0) {
+                state->part_size = server_part_size;
+            }
+            state->part_count = static_cast<int32_t>((state->file_size + state->part_size - 1) / state->part_size);
+        }
+
+        if (db_ && db_->isOpen()) {
+            db_->exec(
+                "INSERT OR REPLACE INTO upload_sessions "
+                "(local_path, file_size, file_mtime, file_type, file_id, upload_id, part_size, part_count, created_at) "
+                "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)",
+                { state->local_path,
+                  state->file_size,
+                  state->file_mtime,
+                  static_cast<int64_t>(state->file_type),
+                  state->file_id,
+                  state->upload_id,
+                  state->part_size,
+                  static_cast<int64_t>(state->part_count),
+                  nowMs() }
+            );
+        }
+
+        requestPartUrls(state);
+    });
+}
+
+void FileManagerImpl::requestPartUrls(const MultipartStatePtr& state) {
+    PartUrlsRequest req_body;
+    int64_t uploaded = 0;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        req_body.upload_id = state->upload_id;
+        for (int32_t part_number = 1; part_number <= state->part_count; ++part_number) {
+            if (state->etags.find(part_number) == state->etags.end()) {
+                req_body.part_numbers.push_back(part_number);
+            }
+        }
+        uploaded = state->completed_bytes;
+    }
+
+    if (state->on_progress) {
+        state->on_progress(uploaded, state->file_size);
+    }
+
+    if (req_body.part_numbers.empty()) {
+        completeMultipart(state);
+        return;
+    }
+
+    std::string req_json;
+    std::string req_err;
+    if (!writeJson(req_body, req_json, req_err)) {
+        failMultipart(state, -1, req_err);
+        return;
+    }
+
+    const size_t expected = req_body.part_numbers.size();
+    http_->post("/files/" + state->file_id + "/parts", req_json, [this, state, expected](network::HttpResponse resp) {
+        // The server no longer knows this upload (expired or aborted): start
+        // over, once. A server that forgets the new upload too will not do
+        // better on a third try.
+        if (resp.error.empty() && (resp.status_code == 404 || resp.status_code == 410)) {
+            dropUploadSession(state->local_path, state->file_id);
+            bool restart = false;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                restart = !state->restarted;
+                state->restarted = true;
+                state->etags.clear();
+                state->completed_bytes = 0;
+            }
+            if (!restart) {
+                failMultipart(state, resp.status_code, "multipart upload no longer known to the server");
+                return;
+            }
+            initMultipart(state);
+            return;
+        }
+
+        ApiEnvelope<PartUrlsPayload> root{};
+        if (!parseTypedDataResponse(resp, root, "get part urls failed")) {
+            failMultipart(state, root.code, root.message);
+            return;
+        }
+
+        size_t queued = 0;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (root.data.parts.has_value()) {
+                for (const auto& part : *root.data.parts) {
+                    const int32_t part_number = parseInt32Value(part.part_number, 0);
+                    if (part_number < 1 || part_number > state->part_count || part.upload_url.empty()
+                        || state->etags.count(part_number) != 0) {
+                        continue;
+                    }
+                    state->queued.emplace_back(part_number, part.upload_url);
+                }
+            }
+            queued = state->queued.size();
+        }
+
+        if (queued != expected) {
+            failMultipart(state, -1, "part urls response incomplete");
+            return;
+        }
+        pumpParts(state);
+    });
+}
+
+void FileManagerImpl::pumpParts(const MultipartStatePtr& state) {
+    std::vector<std::pair<int32_t, std::string>> to_start;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        while (!state->failed && static_cast<int>(state->in_flight.size()) < state->parallelism
+               && !state->queued.empty()) {
+            auto next = std::move(state->queued.front());
+            state->queued.pop_front();
+            state->in_flight[next.first] = 0;
+            to_start.push_back(std::move(next));
+        }
+    }
+
+    for (auto& [part_number, upload_url] : to_start) {
+        auto on_part_progress = [state, part_number](int64_t sent, int64_t /*total*/) {
+            int64_t uploaded = 0;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                auto it = state->in_flight.find(part_number);
+                if (it == state->in_flight.end())
+                    return;
+                it->second = sent;
+                uploaded = state->uploadedLocked();
+            }
+            if (state->on_progress) {
+                state->on_progress(uploaded, state->file_size);
+            }
+        };
+
+        http_->send(
+            makeFilePutRequest(
+                upload_url,
+                state->local_path,
+                state->partOffset(part_number),
+                state->partLength(part_number),
+                on_part_progress,
+                state->max_bytes_per_sec > 0 ? std::max<int64_t>(state->max_bytes_per_sec / state->parallelism, 1) : 0
+            ),
+            [this, state, part_number](network::HttpResponse resp) {
+                onPartDone(state, part_number, std::move(resp));
+            }
+        );
+    }
+}
+
+void FileManagerImpl::onPartDone(const MultipartStatePtr& state, int32_t part_number, network::HttpResponse resp) {
+    const bool ok = resp.error.empty() && resp.status_code >= 200 && resp.status_code < 300;
+    const std::string etag = resp.header("etag");
+
+    bool report_failure = false;
+    bool all_done = false;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->in_flight.erase(part_number);
+        if (ok) {
+            state->etags[part_number] = etag;
+            state->completed_bytes += state->partLength(part_number);
+        } else if (!state->failed) {
+            state->failed = true;
+            state->error = !resp.error.empty()
+                               ? resp.error
+                               : "part " + std::to_string(part_number) + " upload failed: HTTP "
+                                     + std::to_string(resp.status_code);
+        }
+
+        if (state->failed) {
+            // Report once all in-flight parts have settled, so that every
+            // part that did make it is recorded for the next attempt.
+            report_failure = state->in_flight.empty() && !state->finished;
+            if (report_failure)
+                state->finished = true;
+        } else {
+            all_done = state->queued.empty() && state->in_flight.empty();
+        }
+    }
+
+    if (ok && db_ && db_->isOpen()) {
+        db_->exec(
+            "INSERT OR REPLACE INTO upload_parts (file_id, part_number, etag) VALUES (?, ?, ?)",
+            { state->file_id, static_cast<int64_t>(part_number), etag }
+        );
+    }
+
+    if (report_failure) {
+        if (state->on_done.on_error) {
+            state->on_done.on_error(-1, state->error);
+        }
+        return;
+    }
+
+    if (all_done) {
+        completeMultipart(state);
+    } else {
+        pumpParts(state);
+    }
+}
+
+void FileManagerImpl::completeMultipart(const MultipartStatePtr& state) {
+    MultipartCompleteRequest req_body;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        req_body.upload_id = state->upload_id;
+        req_body.parts.reserve(state->etags.size());
+        for (const auto& [part_number, etag] : state->etags) {
+            req_body.parts.push_back(CompletedPart{ .part_number = part_number, .etag = etag });
+        }
+    }
+
+    std::string req_json;
+    std::string req_err;
+    if (!writeJson(req_body, req_json, req_err)) {
+        failMultipart(state, -1, req_err);
+        return;
+    }
+
+    http_->post("/files/" + state->file_id + "/complete", req_json, [this, state](network::HttpResponse resp) {
+        ApiEnvelope<FileInfoDataValue> root{};
+        if (!parseTypedDataResponse(resp, root, "complete failed")) {
+            // Parts stay recorded; the next call only repeats this step.
+            failMultipart(state, root.code, root.message);
+            return;
+        }
+
+        dropUploadSession(state->local_path, state->file_id);
+
+        FileInfo info = parseFileInfoData(root.data);
+        if (info.file_id.empty()) {
+            info.file_id = state->file_id;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->finished = true;
+        }
+        if (state->on_done.on_success) {
+            state->on_done.on_success(info);
+        }
+    });
+}
+
+void FileManagerImpl::failMultipart(const MultipartStatePtr& state, int code, const std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->finished)
+            return;
+        state->failed = true;
+        state->finished = true;
+    }
+    if (state->on_done.on_error) {
+        state->on_done.on_error(code, error);
+    }
+}
+
+void FileManagerImpl::dropUploadSession(const std::string& local_path, const std::string& file_id) {
+    if (!db_ || !db_->isOpen())
+        return;
+    if (!file_id.empty()) {
+        db_->exec("DELETE FROM upload_parts WHERE file_id = ?", { file_id });
+    }
+    db_->exec("DELETE FROM upload_sessions WHERE local_path = ?", { local_path });
+}
+
+void FileManagerImpl::setServerHashCheck(bool enabled) {
+    server_hash_check_ = enabled;
+}
+
+void FileManagerImpl::hashForDedupe(const std::string& local_path, HashCallback done) {
+    // Without a local index or the server endpoint a hash could not be used.
+    if (!server_hash_check_ && !(db_ && db_->isOpen())) {
+        done(true, {}, {});
+        return;
+    }
+    // Reading a multi-GB file takes seconds: keep it off the caller's thread,
+    // which may be the UI or the HTTP worker.
+    hasher_->post(local_path, [local_path, done = std::move(done)] {
+        std::string sha256;
+        std::string err;
+        const bool ok = util::sha256File(local_path, sha256, err);
+        done(ok, sha256, err);
+    });
+}
+
+void FileManagerImpl::lookupUploadedHash(
+    const std::string& sha256,
+    int64_t file_size,
+    int32_t file_type,
+    const std::string& file_name,
+    std::function<void(const FileInfo&)> on_hit,
+    std::function<void()> on_miss
+) {
+    if (db_ && db_->isOpen()) {
+        const db::Rows rows = db_->querySync(
+            "SELECT file_id, file_name, mime_type FROM file_hashes "
+            "WHERE sha256 = ? AND file_type = ? AND file_size = ?",
+            { sha256, static_cast<int64_t>(file_type), file_size }
+        );
+        if (!rows.empty() && !rowText(rows.front(), "file_id").empty()) {
+            FileInfo info;
+            info.file_id = rowText(rows.front(), "file_id");
+            info.file_name = rowText(rows.front(), "file_name");
+            info.file_type = file_type;
+            info.file_size_bytes = file_size;
+            info.mime_type = rowText(rows.front(), "mime_type");
+            on_hit(info);
+            return;
+        }
+    }
+
+    if (!server_hash_check_) {
+        on_miss();
+        return;
+    }
+
+    HashCheckRequest req_body{
+        .sha256 = sha256,
+        .file_size = file_size,
+        .file_type = file_type,
+        .file_name = file_name,
+    };
+    std::string req_json;
+    std::string req_err;
+    if (!writeJson(req_body, req_json, req_err)) {
+        on_miss();
+        return;
+    }
+
+    // Any failure here (including servers without the endpoint) just means
+    // the bytes are uploaded as usual.
+    http_->post(
+        "/files/hash-check",
+        req_json,
+        [this, sha256, file_size, file_type, on_hit, on_miss](network::HttpResponse resp) {
+            ApiEnvelope<HashCheckPayload> root{};
+            if (!parseTypedDataResponse(resp, root, "hash-check failed") || !parseBoolValue(root.data.exists, false)
+                || !root.data.file.has_value() || root.data.file->file_id.empty()) {
+                on_miss();
+                return;
+            }
+
+            FileInfo info = parseFileInfoPayload(*root.data.file);
+            if (info.file_type == kFileTypeUnspecified) {
+                info.file_type = file_type;
+            }
+            if (info.file_size_bytes == 0) {
+                info.file_size_bytes = file_size;
+            }
+            rememberUploadedHash(sha256, file_size, file_type, info);
+            on_hit(info);
+        }
+    );
+}
+
+AnyChatValueCallback<FileInfo> FileManagerImpl::rememberHashOnSuccess(
+    const std::string& sha256,
+    int64_t file_size,
+    int32_t file_type,
+    AnyChatValueCallback<FileInfo> on_done
+) {
+    AnyChatValueCallback<FileInfo> wrapped;
+    wrapped.on_error = on_done.on_error;
+    auto on_success = std::move(on_done.on_success);
+    wrapped.on_success = [this, sha256, file_size, file_type, on_success](const FileInfo& info) {
+        rememberUploadedHash(sha256, file_size, file_type, info);
+        if (on_success) {
+            on_success(info);
+        }
+    };
+    return wrapped;
+}
+
+void FileManagerImpl::rememberUploadedHash(
+    const std::string& sha256,
+    int64_t file_size,
+    int32_t file_type,
+    const FileInfo& info
+) {
+    if (!db_ || !db_->isOpen() || sha256.empty() || info.file_id.empty())
+        return;
+    db_->exec(
+        "INSERT OR REPLACE INTO file_hashes "
+        "(sha256, file_size, file_type, file_id, file_name, mime_type, created_at) VALUES (?, ?, ?, ?, ?, ?, ?)",
+        { sha256,
+          file_size,
+          static_cast<int64_t>(file_type),
+          info.file_id,
+          info.file_name,
+          info.mime_type,
+          nowMs() }
+    );
+}
+
 void FileManagerImpl::getDownloadUrl(
     const std::string& file_id,
     AnyChatValueCallback<std::string> cb
@@ -300,6 +1097,58 @@ void FileManagerImpl::getDownloadUrl(
     });
 }
 
+void FileManagerImpl::download(
+    const std::string& file_id,
+    const std::string& dest_path,
+    DownloadProgressCallback on_progress,
+    AnyChatValueCallback<std::string> on_done
+) {
+    downloads_->download(file_id, dest_path, std::move(on_progress), std::move(on_done));
+}
+
+void FileManagerImpl::fetchMedia(
+    const std::string& file_id,
+    DownloadProgressCallback on_progress,
+    AnyChatValueCallback<std::string> on_done
+) {
+    if (!media_cache_) {
+        if (on_done.on_error) {
+            on_done.on_error(-1, "media cache is not configured");
+        }
+        return;
+    }
+
+    if (auto cached = media_cache_->lookup(file_id)) {
+        if (on_done.on_success) {
+            on_done.on_success(*cached);
+        }
+        return;
+    }
+
+    cache::MediaCache* media_cache = media_cache_;
+    downloads_->download(
+        file_id,
+        media_cache->pathFor(file_id),
+        std::move(on_progress),
+        AnyChatValueCallback<std::string>{
+            .on_success =
+                [media_cache, file_id, on_done](const std::string& path) {
+                    auto cached = media_cache->insert(file_id, path);
+                    if (!cached) {
+                        if (on_done.on_error) {
+                            on_done.on_error(-1, "cannot add download to media cache: " + path);
+                        }
+                        return;
+                    }
+                    if (on_done.on_success) {
+                        on_done.on_success(*cached);
+                    }
+                },
+            .on_error = on_done.on_error,
+        }
+    );
+}
+
 void FileManagerImpl::getFileInfo(const std::string& file_id, AnyChatValueCallback<FileInfo> cb) {
     http_->get("/files/" + file_id, [cb, file_id](network::HttpResponse resp) {
         ApiEnvelope<FileInfoDataValue> root{};
@@ -375,18 +1224,18 @@ void FileManagerImpl::uploadClientLog(
     int32_t expires_hours
 ) {
     std::string file_name;
-    auto file_bytes = std::make_shared<std::string>();
-    std::string read_err;
-    if (!readFileBytes(local_path, file_name, *file_bytes, read_err)) {
+    int64_t file_size = 0;
+    std::string stat_err;
+    if (!statUploadFile(local_path, file_name, file_size, stat_err)) {
         if (on_done.on_error) {
-            on_done.on_error(-1, read_err);
+            on_done.on_error(-1, stat_err);
         }
         return;
     }
 
     UploadClientLogInitRequest req_body{
         .file_name = file_name,
-        .file_size = static_cast<int64_t>(file_bytes->size()),
+        .file_size = file_size,
         .expires_hours = expires_hours < 0 ? 0 : expires_hours,
     };
 
@@ -402,7 +1251,7 @@ void FileManagerImpl::uploadClientLog(
     http_->post(
         "/logs/upload",
         req_json,
-        [this, file_bytes, on_progress, on_done](network::HttpResponse resp) {
+        [this, local_path, file_size, on_progress, on_done](network::HttpResponse resp) {
             ApiEnvelope<UploadTokenPayload> root{};
             if (!parseTypedDataResponse(resp, root, "log upload init failed")) {
                 if (on_done.on_error) {
@@ -420,13 +1269,12 @@ void FileManagerImpl::uploadClientLog(
             }
 
             if (on_progress) {
-                on_progress(0, static_cast<int64_t>(file_bytes->size()));
+                on_progress(0, file_size);
             }
 
-            http_->put(
-                init.upload_url,
-                *file_bytes,
-                [this, file_id = init.file_id, file_bytes, on_progress, on_done](network::HttpResponse put_resp) {
+            http_->send(
+                makeFilePutRequest(init.upload_url, local_path, 0, file_size, on_progress),
+                [this, file_id = init.file_id, on_done](network::HttpResponse put_resp) {
                     if (!put_resp.error.empty()) {
                         if (on_done.on_error) {
                             on_done.on_error(-1, put_resp.error);
@@ -441,11 +1289,6 @@ void FileManagerImpl::uploadClientLog(
                         return;
                     }
 
-                    if (on_progress) {
-                        const auto uploaded = static_cast<int64_t>(file_bytes->size());
-                        on_progress(uploaded, uploaded);
-                    }
-
                     const UploadLogCompleteRequest complete_body{.file_id = file_id};
                     std::string complete_body_json;
                     std::string complete_body_err;
@@ -484,7 +1327,7 @@ void FileManagerImpl::uploadClientLog(
 }
 
 void FileManagerImpl::deleteFile(const std::string& file_id, AnyChatCallback cb) {
-    http_->del("/files/" + file_id, [cb](network::HttpResponse resp) {
+    http_->del("/files/" + file_id, [this, file_id, cb](network::HttpResponse resp) {
         ApiEnvelope<DeleteFilePayload> root{};
         if (!parseTypedDataResponse(resp, root, "deleteFile failed")) {
             if (cb.on_error) {
@@ -500,6 +1343,11 @@ void FileManagerImpl::deleteFile(const std::string& file_id, AnyChatCallback cb)
             return;
         }
 
+        // A deleted file must not be handed out again for identical content.
+        if (db_ && db_->isOpen()) {
+            db_->exec("DELETE FROM file_hashes WHERE file_id = ?", { file_id });
+        }
+
         if (cb.on_success) {
             cb.on_success();
         }
@@ -3,21 +3,52 @@
 #include "sdk_callbacks.h"
 #include "sdk_types.h"
 
+#include "download_manager.h"
+#include "upload_scheduler.h"
+
+#include "cache/media_cache.h"
+#include "db/database.h"
 #include "network/http_client.h"
+#include "util/dispatch_executor.h"
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <string>
 
 namespace anychat {
 
-using UploadProgressCallback = std::function<void(int64_t uploaded, int64_t total)>;
+struct MultipartUploadOptions {
+    int64_t part_size = 8 * 1024 * 1024; // the server may override it at init
+    int parallelism = 3; // concurrent part PUTs, clamped to [1, 8]
+    int64_t max_bytes_per_sec = 0; // whole upload, 0 = unlimited
+};
+
+// Scheduled uploads of at least this size go through uploadMultipart().
+constexpr int64_t kScheduledMultipartThreshold = 32 * 1024 * 1024;
+
+namespace file_manager_detail {
+struct MultipartUploadState;
+} // namespace file_manager_detail
 
 class FileManagerImpl {
 public:
-    explicit FileManagerImpl(std::shared_ptr<network::HttpClient> http);
+    // |db| is optional; without an open database multipart uploads still work
+    // but cannot resume across restarts. |media_cache| is optional as well;
+    // without it fetchMedia() always fails.
+    explicit FileManagerImpl(
+        std::shared_ptr<network::HttpClient> http,
+        db::Database* db = nullptr,
+        cache::MediaCache* media_cache = nullptr
+    );
+    // Stops hashing before the upload scheduler goes, since either may call
+    // into the other.
+    ~FileManagerImpl();
 
     // Three-step upload: get-token -> PUT -> complete
+    // When content deduplication is possible (open database or server hash
+    // check enabled) the file is SHA-256 hashed first, on a background
+    // thread; content that was uploaded before completes without any upload.
     // local_path: absolute path to the file to upload
     // on_progress: called periodically with bytes uploaded / total
     // on_done: called with the file_id and download_url on success
@@ -28,9 +59,58 @@ public:
         AnyChatValueCallback<FileInfo> on_done
     );
 
+    // Chunked upload for large files:
+    //   POST /files/multipart/init -> POST /files/{id}/parts (presigned part URLs)
+    //   -> parallel PUT per part -> POST /files/{id}/complete
+    // Completed parts are persisted, so calling this again for the same,
+    // unmodified file after a failure or restart only uploads missing parts.
+    // Deduplicated by content hash like upload().
+    void uploadMultipart(
+        const std::string& local_path,
+        int32_t file_type, // ANYCHAT_FILE_TYPE_*
+        MultipartUploadOptions options,
+        UploadProgressCallback on_progress,
+        AnyChatValueCallback<FileInfo> on_done
+    );
+
+    // Global upload queue with concurrency, priority and bandwidth limits.
+    // Queued jobs survive restarts when the client has a database; see
+    // UploadScheduler for how restored jobs are reported.
+    UploadScheduler& uploadScheduler() {
+        return *scheduler_;
+    }
+
+    // Also ask POST /files/hash-check when the local hash index has no entry.
+    // Off by default; servers without the endpoint simply cause a normal upload.
+    void setServerHashCheck(bool enabled);
+
     // GET /files/{fileId}/download -> presigned URL
     void getDownloadUrl(const std::string& file_id, AnyChatValueCallback<std::string> cb);
 
+    // Downloads a file to |dest_path| through the DownloadManager (ranged,
+    // parallel, resumable). on_done receives the local path; concurrent calls
+    // for the same file_id share one transfer and its destination.
+    void download(
+        const std::string& file_id,
+        const std::string& dest_path,
+        DownloadProgressCallback on_progress,
+        AnyChatValueCallback<std::string> on_done
+    );
+
+    // Returns the local path of |file_id| from the media cache, downloading it
+    // into the cache first on a miss. Cache hits complete synchronously
+    // without any network request.
+    void fetchMedia(
+        const std::string& file_id,
+        DownloadProgressCallback on_progress,
+        AnyChatValueCallback<std::string> on_done
+    );
+
+    // nullptr when the client was created without a media cache directory.
+    cache::MediaCache* mediaCache() {
+        return media_cache_;
+    }
+
     // GET /files/{fileId}
     void getFileInfo(const std::string& file_id, AnyChatValueCallback<FileInfo> cb);
 
@@ -50,7 +130,63 @@ public:
     void deleteFile(const std::string& file_id, AnyChatCallback cb);
 
 private:
+    using MultipartStatePtr = std::shared_ptr<file_manager_detail::MultipartUploadState>;
+
+    void uploadSingle(
+        const std::string& local_path,
+        int32_t file_type,
+        int64_t max_bytes_per_sec,
+        UploadProgressCallback on_progress,
+        AnyChatValueCallback<FileInfo> on_done
+    );
+    void startUpload(
+        const std::string& local_path,
+        const std::string& file_name,
+        int64_t file_size,
+        int32_t file_type,
+        const std::string& sha256,
+        int64_t max_bytes_per_sec,
+        UploadProgressCallback on_progress,
+        AnyChatValueCallback<FileInfo> on_done
+    );
+
+    // Content-hash deduplication. Hashes on hasher_ and calls |done| there,
+    // or inline with an empty |sha256| when deduplication is not possible.
+    using HashCallback = std::function<void(bool ok, const std::string& sha256, const std::string& err)>;
+    void hashForDedupe(const std::string& local_path, HashCallback done);
+    void lookupUploadedHash(
+        const std::string& sha256,
+        int64_t file_size,
+        int32_t file_type,
+        const std::string& file_name,
+        std::function<void(const FileInfo&)> on_hit,
+        std::function<void()> on_miss
+    );
+    AnyChatValueCallback<FileInfo> rememberHashOnSuccess(
+        const std::string& sha256,
+        int64_t file_size,
+        int32_t file_type,
+        AnyChatValueCallback<FileInfo> on_done
+    );
+    void rememberUploadedHash(const std::string& sha256, int64_t file_size, int32_t file_type, const FileInfo& info);
+
+    void beginMultipart(const MultipartStatePtr& state);
+    void initMultipart(const MultipartStatePtr& state);
+    void requestPartUrls(const MultipartStatePtr& state);
+    void pumpParts(const MultipartStatePtr& state);
+    void onPartDone(const MultipartStatePtr& state, int32_t part_number, network::HttpResponse resp);
+    void completeMultipart(const MultipartStatePtr& state);
+    void failMultipart(const MultipartStatePtr& state, int code, const std::string& error);
+    void dropUploadSession(const std::string& local_path, const std::string& file_id);
+
     std::shared_ptr<network::HttpClient> http_;
+    db::Database* db_;
+    cache::MediaCache* media_cache_;
+    std::unique_ptr<DownloadManager> downloads_;
+    std::unique_ptr<UploadScheduler> scheduler_;
+    std::atomic<bool> server_hash_check_{ false };
+    // Last, so it is joined before the members its tasks use go away.
+    std::unique_ptr<util::DispatchExecutor> hasher_;
 };
 
 } // namespace anychat
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "json_common.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+
+namespace anychat {
+
+// Wire encoding of WebSocket frames. JSON travels in text frames, BEVE
+// (glaze's binary format) in binary frames. The opcode of each frame names
+// its encoding, so a connection that negotiated BEVE may still carry JSON
+// text frames such as heartbeats.
+enum class FrameEncoding {
+    Json,
+    Beve,
+};
+
+// WebSocket subprotocols. Offering kBeveSubprotocol first lets the server
+// pick binary frames; servers that do not know it select kJsonSubprotocol
+// (or none) and the connection stays on JSON.
+inline constexpr const char* kJsonSubprotocol = "anychat";
+inline constexpr const char* kBeveSubprotocol = "anychat.beve";
+
+namespace frame_codec_detail {
+
+struct BareFrame {
+    std::string type{};
+};
+
+template<typename T>
+struct PayloadFrame {
+    std::string type{};
+    T payload{};
+};
+
+// In BEVE frames the payload is embedded as an opaque byte string, the
+// counterpart of a raw JSON member: the envelope decodes without touching
+// it, and the payload then decodes straight into its own struct.
+struct BeveFrame {
+    std::string type{};
+    std::string payload{};
+};
+
+// Envelopes as decoded. Pushes from a server that supports session resume
+// carry a sequence number next to the type (see SessionResumer). The
+// payload is skipped over and kept as a view into the frame, not copied.
+struct JsonEnvelope {
+    std::string type{};
+    std::optional<glz::raw_json_view> payload{};
+    std::optional<std::variant<int64_t, double, std::string>> seq{};
+};
+
+struct BeveEnvelope {
+    std::string type{};
+    std::string_view payload{};
+    int64_t seq = 0;
+};
+
+} // namespace frame_codec_detail
+
+// A decoded frame envelope; |payload| is still encoded (JSON text or BEVE
+// bytes), views the decoded frame and is empty when the frame has none.
+// |seq| is 0 when absent.
+struct FrameEnvelope {
+    std::string type;
+    std::string_view payload;
+    int64_t seq = 0;
+};
+
+// Encodes and decodes {"type", "payload"} frames with the same glaze payload
+// structs in either encoding. Cheap to copy.
+class FrameCodec {
+public:
+    FrameCodec() = default;
+    explicit FrameCodec(FrameEncoding encoding)
+        : encoding_(encoding) {}
+
+    // Codec for the subprotocol the server selected ("" if none).
+    static FrameCodec forSubprotocol(std::string_view subprotocol) {
+        return FrameCodec(subprotocol == kBeveSubprotocol ? FrameEncoding::Beve : FrameEncoding::Json);
+    }
+
+    FrameEncoding encoding() const {
+        return encoding_;
+    }
+
+    // Frames of this codec go out as binary WebSocket frames.
+    bool binary() const {
+        return encoding_ == FrameEncoding::Beve;
+    }
+
+    template<typename T>
+    bool encodePayload(const T& value, std::string& out, std::string& err) const {
+        if (encoding_ == FrameEncoding::Json) {
+            return json_common::writeJson(value, out, err);
+        }
+        auto written = glz::write_beve(value);
+        if (!written) {
+            err = std::string("serialize error: ") + glz::format_error(written);
+            return false;
+        }
+        out = std::move(*written);
+        return true;
+    }
+
+    template<typename T>
+    bool encodeFrame(std::string_view type, const T& payload, std::string& out, std::string& err) const {
+        using namespace frame_codec_detail;
+        if (encoding_ == FrameEncoding::Json) {
+            return json_common::writeJson(PayloadFrame<T>{ std::string(type), payload }, out, err);
+        }
+        BeveFrame frame{ .type = std::string(type) };
+        return encodePayload(payload, frame.payload, err) && encodePayload(frame, out, err);
+    }
+
+    // A frame without payload, e.g. {"type":"ping"}.
+    bool encodeFrame(std::string_view type, std::string& out, std::string& err) const {
+        return encodePayload(frame_codec_detail::BareFrame{ std::string(type) }, out, err);
+    }
+
+    // JSON input must be NUL-terminated past its end (see readJsonRelaxed).
+    // |out| views |data|, which must outlive it.
+    bool decodeEnvelope(std::string_view data, FrameEnvelope& out, std::string& err) const {
+        using namespace frame_codec_detail;
+        if (encoding_ == FrameEncoding::Json) {
+            JsonEnvelope envelope{};
+            if (!json_common::readJsonRelaxed(data, envelope, err)) {
+                return false;
+            }
+            out.type = std::move(envelope.type);
+            out.payload = envelope.payload.has_value() ? envelope.payload->str : std::string_view();
+            out.seq = json_common::parseInt64Value(envelope.seq, 0);
+            return true;
+        }
+        BeveEnvelope frame{};
+        if (!readBeve(data, frame, err)) {
+            return false;
+        }
+        out.type = std::move(frame.type);
+        out.payload = frame.payload;
+        out.seq = frame.seq;
+        return true;
+    }
+
+    // Also takes payloads viewed inside a larger frame.
+    template<typename T>
+    bool decodePayload(std::string_view data, T& out, std::string& err) const {
+        if (data.empty()) {
+            err = "parse error: empty payload";
+            return false;
+        }
+        if (encoding_ == FrameEncoding::Json) {
+            return json_common::readJsonView(data, out, err);
+        }
+        return readBeve(data, out, err);
+    }
+
+    // Re-encodes a payload as JSON text for consumers that only take JSON.
+    bool payloadToJson(std::string_view payload, std::string& json, std::string& err) const {
+        if (encoding_ == FrameEncoding::Json) {
+            json = payload;
+            return true;
+        }
+        json.clear();
+        if (const auto ec = glz::beve_to_json(payload, json)) {
+            err = std::string("transcode error: ") + glz::format_error(ec);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    template<typename T>
+    static bool readBeve(std::string_view data, T& out, std::string& err) {
+        glz::context ctx{};
+        const auto ec = glz::read<glz::opts{ .format = glz::BEVE, .error_on_unknown_keys = false }>(out, data, ctx);
+        if (ec) {
+            err = std::string("parse error: ") + glz::format_error(ec);
+            return false;
+        }
+        return true;
+    }
+
+    FrameEncoding encoding_ = FrameEncoding::Json;
+};
+
+} // namespace anychat
@@ -320,9 +320,12 @@ FriendManagerImpl::FriendManagerImpl(
     , notif_mgr_(notif_mgr)
     , http_(std::move(http)) {
     if (notif_mgr_) {
-        notif_mgr_->addNotificationHandler([this](const NotificationEvent& ev) {
-            handleFriendNotification(ev);
-        });
+        notif_mgr_->subscribe<NotificationFriendEventPayload>(
+            "friend.*",
+            [this](const NotificationEvent& ev, const NotificationFriendEventPayload& payload) {
+                handleFriendNotification(ev, payload);
+            }
+        );
     }
 }
 
@@ -539,11 +542,11 @@ void FriendManagerImpl::setListener(std::shared_ptr<FriendListener> listener) {
     listener_ = std::move(listener);
 }
 
-void FriendManagerImpl::handleFriendNotification(const NotificationEvent& event) {
+void FriendManagerImpl::handleFriendNotification(
+    const NotificationEvent& event,
+    const NotificationFriendEventPayload& payload
+) {
     const std::string& type = event.notification_type;
-    if (type.rfind("friend.", 0) != 0) {
-        return;
-    }
 
     std::shared_ptr<FriendListener> listener;
     {
@@ -555,12 +558,6 @@ void FriendManagerImpl::handleFriendNotification(const NotificationEvent& event)
     }
 
     try {
-        NotificationFriendEventPayload payload{};
-        std::string err;
-        if (!parseJsonObject(event.data, payload, err)) {
-            return;
-        }
-
         if (type == "friend.added") {
             listener->onFriendAdded(parseNotificationFriend(payload));
             return;
@@ -29,6 +29,10 @@ public:
     virtual void onFriendRequestRejected(const FriendRequest& req) = 0;
 };
 
+namespace friend_manager_detail {
+struct NotificationFriendEventPayload;
+} // namespace friend_manager_detail
+
 class FriendManagerImpl {
 public:
     FriendManagerImpl(db::Database* db, NotificationManager* notif_mgr, std::shared_ptr<network::HttpClient> http);
@@ -61,7 +65,10 @@ public:
     void setListener(std::shared_ptr<FriendListener> listener);
 
 private:
-    void handleFriendNotification(const NotificationEvent& event);
+    void handleFriendNotification(
+        const NotificationEvent& event,
+        const friend_manager_detail::NotificationFriendEventPayload& payload
+    );
 
     db::Database* db_;
     NotificationManager* notif_mgr_;
@@ -434,9 +434,12 @@ GroupManagerImpl::GroupManagerImpl(
     , notif_mgr_(notif_mgr)
     , http_(std::move(http)) {
     if (notif_mgr_) {
-        notif_mgr_->addNotificationHandler([this](const NotificationEvent& ev) {
-            handleGroupNotification(ev);
-        });
+        notif_mgr_->subscribe<NotificationGroupEventPayload>(
+            "group.*",
+            [this](const NotificationEvent& ev, const NotificationGroupEventPayload& payload) {
+                handleGroupNotification(ev, payload);
+            }
+        );
     }
 }
 
@@ -846,17 +849,11 @@ void GroupManagerImpl::setListener(std::shared_ptr<GroupListener> listener) {
     listener_ = std::move(listener);
 }
 
-void GroupManagerImpl::handleGroupNotification(const NotificationEvent& event) {
+void GroupManagerImpl::handleGroupNotification(
+    const NotificationEvent& event,
+    const NotificationGroupEventPayload& payload
+) {
     const std::string& type = event.notification_type;
-    if (type.rfind("group.", 0) != 0) {
-        return;
-    }
-
-    NotificationGroupEventPayload payload{};
-    std::string err;
-    if (!parseJsonObject(event.data, payload, err)) {
-        return;
-    }
 
     const auto parseEventGroup = [&payload]() {
         Group g = parseNotificationGroup(toGroupPayload(payload));
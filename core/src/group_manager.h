@@ -28,6 +28,10 @@ public:
     }
 };
 
+namespace group_manager_detail {
+struct NotificationGroupEventPayload;
+} // namespace group_manager_detail
+
 class GroupManagerImpl {
 public:
     GroupManagerImpl(db::Database* db, NotificationManager* notif_mgr, std::shared_ptr<network::HttpClient> http);
@@ -81,7 +85,10 @@ public:
     void setListener(std::shared_ptr<GroupListener> listener);
 
 private:
-    void handleGroupNotification(const NotificationEvent& event);
+    void handleGroupNotification(
+        const NotificationEvent& event,
+        const group_manager_detail::NotificationGroupEventPayload& payload
+    );
 
     db::Database* db_;
     NotificationManager* notif_mgr_;
@@ -1,13 +1,16 @@
 #pragma once
 
 #include "network/http_client.h"
+#include "network/json_stream.h"
 
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 
@@ -351,8 +354,10 @@ inline const std::vector<T>* pickList(const std::optional<std::vector<T>>& first
     }
 }
 
+// |json| must be NUL-terminated just past its end, as the contents of a
+// std::string are; glaze relies on that sentinel.
 template<typename T>
-inline bool readJsonRelaxed(const std::string& json, T& out, std::string& err) {
+inline bool readJsonRelaxed(std::string_view json, T& out, std::string& err) {
     glz::context ctx{};
     const auto ec = glz::read<glz::opts{ .error_on_unknown_keys = false }>(out, json, ctx);
     if (ec) {
@@ -362,6 +367,19 @@ inline bool readJsonRelaxed(const std::string& json, T& out, std::string& err) {
     return true;
 }
 
+// For |json| that is a slice of a larger buffer, such as a glz::raw_json_view
+// member, and so has no NUL sentinel after it.
+template<typename T>
+inline bool readJsonView(std::string_view json, T& out, std::string& err) {
+    glz::context ctx{};
+    const auto ec = glz::read<glz::opts{ .null_terminated = false, .error_on_unknown_keys = false }>(out, json, ctx);
+    if (ec) {
+        err = std::string("parse error: ") + glz::format_error(ec, json);
+        return false;
+    }
+    return true;
+}
+
 template<typename T>
 inline bool parseApiEnvelopeResponse(
     const network::HttpResponse& resp,
@@ -409,6 +427,29 @@ inline bool parseApiEnvelopeResponse(
     return true;
 }
 
+// Feeds the 2xx response body of |req| to |streamer| as it arrives instead of
+// collecting it in HttpResponse::body.
+inline void streamJsonBody(network::HttpRequest& req, std::shared_ptr<network::JsonArrayStreamer> streamer) {
+    req.on_body_data = [streamer = std::move(streamer)](std::string_view chunk) {
+        return streamer->feed(chunk);
+    };
+}
+
+// Puts the streamer's skeleton in place of the streamed body, so the envelope
+// can be checked with parseApiEnvelopeResponse() as usual.
+inline void finishStreamedBody(network::HttpResponse& resp, network::JsonArrayStreamer& streamer) {
+    if (resp.status_code < 200 || resp.status_code >= 300) {
+        return;
+    }
+    if (streamer.failed() || (resp.error.empty() && !streamer.finish())) {
+        resp.error = "malformed response: " + streamer.error();
+        return;
+    }
+    if (resp.error.empty()) {
+        resp.body = streamer.takeSkeleton();
+    }
+}
+
 template<typename T>
 inline bool writeJson(const T& value, std::string& json, std::string& err) {
     const auto written = glz::write_json(value);
@@ -0,0 +1,407 @@
+#include "message_ingestor.h"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace anychat {
+
+namespace {
+
+// The server copy wins: it carries recalls, edits and read state.
+constexpr const char* kUpsertMessageSql =
+    "INSERT INTO messages (message_id, local_id, conv_id, sender_id, content_type, content, seq, reply_to, "
+    "status, send_state, is_read, timestamp_ms) "
+    "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?) "
+    "ON CONFLICT(message_id) DO UPDATE SET "
+    "local_id=excluded.local_id, conv_id=excluded.conv_id, sender_id=excluded.sender_id, "
+    "content_type=excluded.content_type, content=excluded.content, seq=excluded.seq, reply_to=excluded.reply_to, "
+    "status=excluded.status, send_state=excluded.send_state, is_read=excluded.is_read, "
+    "timestamp_ms=excluded.timestamp_ms";
+
+// Sync merges are idempotent and keep what is stored locally.
+constexpr const char* kInsertMessageSql =
+    "INSERT OR IGNORE INTO messages (message_id, local_id, conv_id, sender_id, content_type, content, seq, reply_to, "
+    "status, send_state, is_read, timestamp_ms) "
+    "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+constexpr const char* kLastMessageSql =
+    "UPDATE conversations SET last_msg_id = ?, last_msg_text = ?, last_msg_time_ms = ? "
+    "WHERE conv_id = ? AND COALESCE(last_msg_time_ms, 0) <= ?";
+
+constexpr const char* kLocalSeqSql = "UPDATE conversations SET local_seq = MAX(local_seq, ?) WHERE conv_id = ?";
+
+db::Params messageParams(const Message& msg) {
+    // local_id is UNIQUE: store "none" as NULL, or every message received
+    // without one would collide with the first.
+    return { msg.message_id,
+             msg.local_id.empty() ? db::DbValue(nullptr) : db::DbValue(msg.local_id),
+             msg.conv_id,
+             msg.sender_id,
+             static_cast<int64_t>(msg.content_type),
+             msg.content,
+             msg.seq,
+             msg.reply_to,
+             static_cast<int64_t>(msg.status),
+             static_cast<int64_t>(msg.send_state),
+             static_cast<int64_t>(msg.is_read ? 1 : 0),
+             msg.timestamp_ms };
+}
+
+uint64_t mix(uint64_t hash, int64_t value) {
+    return util::fnv1a64(std::string_view(reinterpret_cast<const char*>(&value), sizeof(value)), hash);
+}
+
+uint64_t mix(uint64_t hash, std::string_view value) {
+    return util::fnv1a64(value, mix(hash, static_cast<int64_t>(value.size())));
+}
+
+// Stands for "stored, contents unknown": sync rows are INSERT OR IGNORE, so
+// what they record may not be what the table holds.
+constexpr uint64_t kUnknownVersion = 0;
+
+// A hash of every column messageParams() binds besides the message_id; never
+// kUnknownVersion.
+uint64_t versionOf(const Message& msg) {
+    uint64_t hash = mix(util::fnv1a64({}), msg.local_id);
+    hash = mix(hash, msg.conv_id);
+    hash = mix(hash, msg.sender_id);
+    hash = mix(hash, static_cast<int64_t>(msg.content_type));
+    hash = mix(hash, msg.content);
+    hash = mix(hash, msg.seq);
+    hash = mix(hash, msg.reply_to);
+    hash = mix(hash, static_cast<int64_t>(msg.status));
+    hash = mix(hash, static_cast<int64_t>(msg.send_state));
+    hash = mix(hash, static_cast<int64_t>(msg.is_read ? 1 : 0));
+    hash = mix(hash, msg.timestamp_ms);
+    return hash | 1;
+}
+
+bool isNewer(const Message& a, const Message& b) {
+    if (a.timestamp_ms != b.timestamp_ms) {
+        return a.timestamp_ms > b.timestamp_ms;
+    }
+    return a.seq > b.seq;
+}
+
+} // namespace
+
+MessageIngestor::MessageIngestor(
+    db::Database* db,
+    cache::MessageCache* msg_cache,
+    cache::ConversationCache* conv_cache,
+    MessageIngestorOptions options
+)
+    : db_(db)
+    , msg_cache_(msg_cache)
+    , conv_cache_(conv_cache)
+    , max_pending_(std::max<size_t>(options.max_pending, 1))
+    , recent_(options.recent_window) {}
+
+MessageIngestor::~MessageIngestor() {
+    flush();
+}
+
+std::vector<Message> MessageIngestor::ingest(std::vector<Message> messages, IngestSource source) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.ingested += messages.size();
+    }
+
+    std::vector<Message> accepted = dedup(std::move(messages));
+    if (accepted.empty()) {
+        return accepted;
+    }
+
+    // Before the filter and the cache stage: a sync batch the push already
+    // delivered must still move local_seq forward.
+    std::vector<Summary> summaries = summarize(accepted, source);
+
+    // Without a database nothing is stored, so nothing is a repeat of a
+    // stored message either.
+    const bool store = db_ != nullptr && db_->isOpen();
+    std::vector<RecentKey> keys;
+    if (store) {
+        keys = filterStored(accepted, source, summaries);
+    }
+
+    msg_cache_->insertBatch(accepted);
+    for (const auto& summary : summaries) {
+        // A stored batch moves the cached local_seq once it committed, so
+        // the next sync asks again for rows that failed.
+        conv_cache_->advanceSummary(summary.latest.conv_id, summary.latest, store ? 0 : summary.local_seq);
+    }
+    if (!store) {
+        return accepted;
+    }
+
+    // Cached is not stored: a row that failed to commit stays cached, and
+    // the recent-id filter already dropped what is stored.
+    std::vector<Row> rows;
+    rows.reserve(accepted.size());
+    for (size_t i = 0; i < accepted.size(); ++i) {
+        rows.push_back(Row{ accepted[i], source, keys[i] });
+    }
+
+    enqueue(std::move(rows), std::move(summaries));
+    return accepted;
+}
+
+std::vector<Message> MessageIngestor::dedup(std::vector<Message> messages) {
+    std::vector<Message> out;
+    out.reserve(messages.size());
+    // message_id -> position in out; a repeat replaces the earlier copy.
+    std::unordered_map<std::string, size_t> seen;
+    seen.reserve(messages.size());
+    uint64_t dropped = 0;
+    for (auto& msg : messages) {
+        if (msg.message_id.empty() || msg.conv_id.empty()) {
+            continue;
+        }
+        auto [it, inserted] = seen.try_emplace(msg.message_id, out.size());
+        if (!inserted) {
+            out[it->second] = std::move(msg);
+            ++dropped;
+            continue;
+        }
+        out.push_back(std::move(msg));
+    }
+
+    if (dropped > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.duplicates += dropped;
+    }
+    return out;
+}
+
+std::vector<MessageIngestor::Summary>
+MessageIngestor::summarize(const std::vector<Message>& messages, IngestSource source) const {
+    std::vector<Summary> summaries;
+    std::unordered_map<std::string_view, size_t> by_conv;
+    for (const auto& msg : messages) {
+        auto [it, inserted] = by_conv.try_emplace(msg.conv_id, summaries.size());
+        if (inserted) {
+            summaries.push_back(Summary{ .latest = msg });
+        } else if (isNewer(msg, summaries[it->second].latest)) {
+            summaries[it->second].latest = msg;
+        }
+        if (source == IngestSource::Sync) {
+            Summary& summary = summaries[it->second];
+            summary.local_seq = std::max(summary.local_seq, msg.seq);
+        }
+    }
+    return summaries;
+}
+
+std::vector<MessageIngestor::RecentKey>
+MessageIngestor::filterStored(std::vector<Message>& messages, IngestSource source, std::vector<Summary>& summaries) {
+    std::vector<RecentKey> keys;
+    keys.reserve(messages.size());
+    std::unordered_set<std::string> dropped;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto watermark = [this](const std::string& conv_id) -> int64_t {
+        auto it = watermarks_.find(conv_id);
+        return it == watermarks_.end() ? 0 : it->second;
+    };
+
+    size_t kept = 0;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        Message& msg = messages[i];
+        RecentKey key{ util::fnv1a64(msg.message_id), versionOf(msg) };
+        const std::optional<uint64_t> stored = recent_.find(key.id_hash);
+        if (source == IngestSource::Sync) {
+            // INSERT OR IGNORE leaves any stored row as it is.
+            if (stored.has_value()) {
+                ++stats_.seen_recently;
+                dropped.insert(std::move(msg.message_id));
+                continue;
+            }
+            if (msg.seq > 0 && msg.seq <= watermark(msg.conv_id)) {
+                ++stats_.below_watermark;
+                dropped.insert(std::move(msg.message_id));
+                continue;
+            }
+            key.version = kUnknownVersion;
+        } else if (stored == key.version) {
+            // The upsert would write back the columns already there.
+            ++stats_.seen_recently;
+            dropped.insert(std::move(msg.message_id));
+            continue;
+        }
+
+        recent_.record(key.id_hash, key.version);
+        keys.push_back(key);
+        if (kept != i) {
+            messages[kept] = std::move(msg);
+        }
+        ++kept;
+    }
+    messages.resize(kept);
+
+    if (!dropped.empty()) {
+        // A dropped message moved the summary when it was first stored;
+        // only a sync batch's local_seq may still have to move.
+        std::erase_if(summaries, [&](const Summary& summary) {
+            return dropped.contains(summary.latest.message_id)
+                   && summary.local_seq <= watermark(summary.latest.conv_id);
+        });
+    }
+    return keys;
+}
+
+void MessageIngestor::enqueue(std::vector<Row> rows, std::vector<Summary> summaries) {
+    if (rows.empty() && summaries.empty()) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stats_.pending >= max_pending_) {
+        ++stats_.producer_waits;
+        space_cv_.wait(lock, [this] {
+            return stats_.pending < max_pending_;
+        });
+    }
+
+    stats_.pending += rows.size();
+    rows_.insert(rows_.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+    summaries_.insert(
+        summaries_.end(),
+        std::make_move_iterator(summaries.begin()),
+        std::make_move_iterator(summaries.end())
+    );
+    stats_.peak_pending = std::max(stats_.peak_pending, stats_.pending);
+
+    if (scheduled_) {
+        return; // joins the queued task
+    }
+    // Queued under the lock, so a caller whose rows joined the task cannot
+    // queue later DB work ahead of it.
+    scheduled_ = true;
+    ++in_flight_;
+    persist();
+}
+
+void MessageIngestor::persist() {
+    // Shared by the transaction and its callback, both on the DB worker.
+    struct Batch {
+        bool taken = false; // false if BEGIN failed and fn never ran
+        std::vector<RecentKey> keys; // per row taken
+        std::vector<bool> written; // per row taken
+        std::vector<std::pair<std::string, int64_t>> watermarks; // valid once committed
+    };
+    auto batch = std::make_shared<Batch>();
+
+    db_->transaction(
+        [this, batch](db::Database::TxScope& tx) {
+            std::vector<Row> rows;
+            std::vector<Summary> summaries;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                rows.swap(rows_);
+                summaries.swap(summaries_);
+                scheduled_ = false;
+            }
+            batch->taken = true;
+            batch->written.reserve(rows.size());
+
+            // Runs of the same source keep the rows in arrival order.
+            std::unordered_set<std::string_view> failed_sync; // conv_ids
+            for (size_t begin = 0; begin < rows.size();) {
+                const bool sync = rows[begin].source == IngestSource::Sync;
+                std::vector<db::Params> params;
+                size_t end = begin;
+                for (; end < rows.size() && (rows[end].source == IngestSource::Sync) == sync; ++end) {
+                    params.push_back(messageParams(rows[end].msg));
+                }
+                std::vector<bool> done;
+                tx.execBatch(sync ? kInsertMessageSql : kUpsertMessageSql, params, &done);
+                for (size_t i = begin; i < end; ++i) {
+                    batch->keys.push_back(rows[i].key);
+                    batch->written.push_back(done[i - begin]);
+                    if (sync && !done[i - begin]) {
+                        failed_sync.insert(rows[i].msg.conv_id);
+                    }
+                }
+                begin = end;
+            }
+
+            std::vector<db::Params> last_message;
+            std::vector<db::Params> local_seq;
+            for (const auto& summary : summaries) {
+                const Message& msg = summary.latest;
+                last_message.push_back(
+                    { msg.message_id, msg.content, msg.timestamp_ms, msg.conv_id, msg.timestamp_ms }
+                );
+                // Everything up to local_seq is stored unless a row of this
+                // batch failed; then local_seq stays for the next sync.
+                if (summary.local_seq > 0 && !failed_sync.contains(msg.conv_id)) {
+                    local_seq.push_back({ summary.local_seq, msg.conv_id });
+                    batch->watermarks.emplace_back(msg.conv_id, summary.local_seq);
+                }
+            }
+            tx.execBatch(kLastMessageSql, last_message);
+            tx.execBatch(kLocalSeqSql, local_seq);
+            return true;
+        },
+        [this, batch](bool ok, const std::string&) {
+            if (ok) {
+                for (const auto& [conv_id, seq] : batch->watermarks) {
+                    conv_cache_->advanceLocalSeq(conv_id, seq);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!batch->taken) {
+                for (const auto& row : rows_) {
+                    batch->keys.push_back(row.key);
+                }
+                batch->written.assign(rows_.size(), false);
+                rows_.clear();
+                summaries_.clear();
+                scheduled_ = false;
+            }
+
+            size_t written = 0;
+            for (size_t i = 0; i < batch->keys.size(); ++i) {
+                if (ok && batch->written[i]) {
+                    ++written;
+                } else {
+                    // Not stored after all: let the next copy through.
+                    recent_.forget(batch->keys[i].id_hash, batch->keys[i].version);
+                }
+            }
+            if (ok) {
+                for (const auto& [conv_id, seq] : batch->watermarks) {
+                    int64_t& watermark = watermarks_[conv_id];
+                    watermark = std::max(watermark, seq);
+                }
+            }
+
+            ++stats_.transactions;
+            stats_.persisted += written;
+            stats_.failed += batch->keys.size() - written;
+            stats_.pending -= batch->keys.size();
+            --in_flight_;
+            space_cv_.notify_all();
+        }
+    );
+}
+
+void MessageIngestor::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    space_cv_.wait(lock, [this] {
+        return in_flight_ == 0;
+    });
+}
+
+MessageIngestorStats MessageIngestor::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace anychat
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "sdk_types.h"
+
+#include "cache/conversation_cache.h"
+#include "cache/message_cache.h"
+#include "db/database.h"
+#include "util/recent_id_window.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace anychat {
+
+// Where a batch of messages came from; decides how it is stored.
+enum class IngestSource {
+    Push, // message.new / message.mentioned notifications
+    Fetch, // offline, history and search responses
+    Sync, // per-conversation deltas of /sync
+};
+
+struct MessageIngestorOptions {
+    size_t max_pending = 5'000; // rows not yet committed; ingest() blocks beyond it
+    size_t recent_window = 10'000; // message ids remembered as stored, see MessageIngestor
+};
+
+struct MessageIngestorStats {
+    uint64_t ingested = 0; // messages handed to ingest()
+    uint64_t duplicates = 0; // repeated within one ingest() call
+    uint64_t seen_recently = 0; // dropped: stored recently with the same contents
+    uint64_t below_watermark = 0; // dropped: sync rows at or below the stored seq
+    uint64_t persisted = 0; // rows written by committed transactions
+    uint64_t failed = 0; // rows not written, e.g. for a conversation not stored yet
+    uint64_t transactions = 0;
+    uint64_t producer_waits = 0; // ingest() calls that blocked on a full queue
+    size_t pending = 0; // rows queued or being written
+    size_t peak_pending = 0;
+};
+
+// The path every server-sent message takes into local storage, whether it
+// arrived as a push, in an offline/history fetch or in a sync delta:
+//
+//   dedup → recent-id filter → message cache → conversation summary → DB
+//
+// The in-memory stages run on the calling thread and take each lock once
+// per batch. The DB stage is a bounded queue in front of the DB worker: rows
+// are written in one transaction per DB task, and rows queued while a task
+// waits to start join it, so a burst of pushes costs a few transactions
+// rather than one statement each. The task is queued at once, so the rows
+// still reach SQLite before any DB work the caller queues afterwards.
+// Once |max_pending| rows are uncommitted, ingest() blocks until the worker
+// catches up. Listener fan-out is left to the caller, using the returned
+// messages.
+//
+// Sync rows never overwrite a stored message (INSERT OR IGNORE) and advance
+// the conversation's local_seq, stored and cached, once they committed; if
+// one of them failed, local_seq stays and the next sync asks for them again.
+// Pushes and fetches overwrite the stored row (the server copy is newer) and
+// leave local_seq to sync, since they may skip over a gap.
+//
+// The same message usually arrives more than once: pushed, then again in the
+// offline fetch and the next sync. The recent-id filter drops a copy only
+// when writing it would change nothing: a push or fetch identical in every
+// stored column to the copy stored last, or a sync row whose message_id is
+// stored already or whose seq is at or below the conversation's watermark
+// (the local_seq of its last committed sync). It remembers the last
+// |recent_window| message ids as 64-bit hashes; a row that fails to commit
+// is forgotten again. Dropped copies are not returned, so listeners see a
+// message once.
+//
+// All public methods are thread-safe.
+class MessageIngestor {
+public:
+    MessageIngestor(
+        db::Database* db,
+        cache::MessageCache* msg_cache,
+        cache::ConversationCache* conv_cache,
+        MessageIngestorOptions options = {}
+    );
+    ~MessageIngestor(); // flush()
+
+    MessageIngestor(const MessageIngestor&) = delete;
+    MessageIngestor& operator=(const MessageIngestor&) = delete;
+
+    // Runs |messages| through the pipeline and returns the ones that passed
+    // dedup and the recent-id filter, in their original order. Messages
+    // without a message_id or conv_id are dropped.
+    std::vector<Message> ingest(std::vector<Message> messages, IngestSource source);
+
+    // Blocks until every queued row has been written (or failed). Must not
+    // be called on the DB worker thread.
+    void flush();
+
+    MessageIngestorStats stats() const;
+
+private:
+    // A message's entry in recent_.
+    struct RecentKey {
+        uint64_t id_hash = 0;
+        uint64_t version = 0;
+    };
+
+    struct Row {
+        Message msg;
+        IngestSource source;
+        RecentKey key;
+    };
+
+    // The newest message of a conversation within one batch.
+    struct Summary {
+        Message latest;
+        int64_t local_seq = 0; // 0 = leave local_seq alone
+    };
+
+    std::vector<Message> dedup(std::vector<Message> messages);
+    std::vector<Summary> summarize(const std::vector<Message>& messages, IngestSource source) const;
+    // Drops the messages already stored, and the summaries they made redundant.
+    // Returns the recent_ entries of the messages kept.
+    std::vector<RecentKey>
+    filterStored(std::vector<Message>& messages, IngestSource source, std::vector<Summary>& summaries);
+    void enqueue(std::vector<Row> rows, std::vector<Summary> summaries);
+    void persist(); // queues the DB task; mutex_ held
+
+    db::Database* db_;
+    cache::MessageCache* msg_cache_;
+    cache::ConversationCache* conv_cache_;
+    const size_t max_pending_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable space_cv_; // a DB task finished
+    std::vector<Row> rows_; // waiting for the next DB task
+    std::vector<Summary> summaries_; // applied after rows_, in the same transaction
+    bool scheduled_ = false; // a DB task is queued and has not taken rows_ yet
+    size_t in_flight_ = 0; // DB tasks queued or running
+    util::RecentIdWindow recent_; // message_id hash -> version stored or queued
+    std::unordered_map<std::string, int64_t> watermarks_; // conv_id -> committed local_seq
+    MessageIngestorStats stats_;
+};
+
+} // namespace anychat
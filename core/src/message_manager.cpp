@@ -6,6 +6,7 @@
 #include <cmath>
 #include <iomanip>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <string>
@@ -13,12 +14,15 @@
 
 namespace anychat::message_manager_detail {
 using json_common::ApiEnvelope;
+using json_common::finishStreamedBody;
 using json_common::parseApiEnvelopeResponse;
 using json_common::parseBoolValue;
 using json_common::parseInt32Value;
 using json_common::parseInt64Value;
 using json_common::parseJsonObject;
 using json_common::parseTimestampMs;
+using json_common::readJsonRelaxed;
+using json_common::streamJsonBody;
 using json_common::toLower;
 using json_common::writeJson;
 
@@ -189,6 +193,36 @@ const std::vector<MessagePayload>* toMessagePayloadList(const MessageListDataPay
     return data.messages.has_value() ? &(*data.messages) : nullptr;
 }
 
+// Messages of a history or search response, decoded one "data.messages"
+// element at a time while the body arrives.
+struct StreamedMessageList {
+    std::shared_ptr<network::JsonArrayStreamer> streamer;
+    std::shared_ptr<std::vector<Message>> messages;
+};
+
+StreamedMessageList streamMessageList(network::HttpRequest& req, const std::string& default_conv_id = "") {
+    StreamedMessageList list{
+        .streamer = std::make_shared<network::JsonArrayStreamer>(),
+        .messages = std::make_shared<std::vector<Message>>(),
+    };
+    list.streamer->onArray(
+        { "data", "messages" },
+        [messages = list.messages, default_conv_id](const std::string& element) {
+            MessagePayload payload{};
+            std::string parse_err;
+            if (readJsonRelaxed(element, payload, parse_err)) {
+                Message msg = parseMessagePayload(payload, default_conv_id);
+                if (!msg.message_id.empty()) {
+                    messages->push_back(std::move(msg));
+                }
+            }
+            return true;
+        }
+    );
+    streamJsonBody(req, list.streamer);
+    return list;
+}
+
 GroupMessageReadState parseGroupMessageReadState(const GroupReadStatePayload& payload) {
     GroupMessageReadState state;
     state.read_count = parseInt64Value(payload.read_count, 0);
@@ -244,12 +278,6 @@ struct MessageTypingPayload {
     std::optional<int32_t> ttl_seconds{};
 };
 
-template <typename T>
-struct TransientFrame {
-    std::string type{};
-    T payload{};
-};
-
 Message parseMessageFromNotification(const NotificationMessagePayload& payload, const std::string& default_conv_id = "") {
     Message msg;
     msg.message_id = payload.message_id;
@@ -310,6 +338,7 @@ using namespace message_manager_detail;
 MessageManagerImpl::MessageManagerImpl(
     db::Database* db,
     cache::MessageCache* msg_cache,
+    MessageIngestor* ingestor,
     OutboundQueue* outbound_q,
     NotificationManager* notif_mgr,
     std::shared_ptr<network::HttpClient> http,
@@ -317,28 +346,34 @@ MessageManagerImpl::MessageManagerImpl(
 )
     : db_(db)
     , msg_cache_(msg_cache)
+    , ingestor_(ingestor)
     , outbound_q_(outbound_q)
     , notif_mgr_(notif_mgr)
     , http_(std::move(http))
     , current_user_id_(current_user_id) {
-    notif_mgr_->addNotificationHandler([this](const NotificationEvent& event) {
-        const std::string& type = event.notification_type;
-        if (type == "message.new") {
-            handleIncomingMessage(event);
-        } else if (type == "message.read_receipt") {
-            handleReadReceipt(event);
-        } else if (type == "message.recalled") {
-            handleMessageRecalled(event);
-        } else if (type == "message.deleted") {
-            handleMessageDeleted(event);
-        } else if (type == "message.edited") {
-            handleMessageEdited(event);
-        } else if (type == "message.typing") {
-            handleTyping(event);
-        } else if (type == "message.mentioned") {
-            handleMentioned(event);
-        }
-    });
+    // Each handler gets its payload decoded into the struct it takes, and
+    // runs in order with the other events of its conversation.
+    const auto route = [this]<typename Payload>(
+                           const char* type,
+                           void (MessageManagerImpl::*handler)(const NotificationEvent&, const Payload&)
+                       ) {
+        notif_mgr_->subscribe<Payload>(
+            type,
+            [this, handler](const NotificationEvent& event, const Payload& payload) {
+                (this->*handler)(event, payload);
+            },
+            [](const Payload& payload) -> std::string_view {
+                return payload.conversation_id;
+            }
+        );
+    };
+    route("message.new", &MessageManagerImpl::handleIncomingMessage);
+    route("message.read_receipt", &MessageManagerImpl::handleReadReceipt);
+    route("message.recalled", &MessageManagerImpl::handleMessageRecalled);
+    route("message.deleted", &MessageManagerImpl::handleMessageDeleted);
+    route("message.edited", &MessageManagerImpl::handleMessageEdited);
+    route("message.typing", &MessageManagerImpl::handleTyping);
+    route("message.mentioned", &MessageManagerImpl::handleMentioned);
 }
 
 // ---------------------------------------------------------------------------
@@ -377,7 +412,8 @@ void MessageManagerImpl::getHistory(
                                 : "")
         + "&direction=backward";
 
-    auto parse_and_return = [this, conv_id, cb = std::move(callback)](network::HttpResponse resp) {
+    auto parse_and_return = [this, cb = std::move(callback)](network::HttpResponse resp, StreamedMessageList list) {
+        finishStreamedBody(resp, *list.streamer);
         ApiEnvelope<MessageListDataPayload> root;
         if (!parseApiEnvelopeResponse(resp, root, "get history failed", true)) {
             if (cb.on_error) {
@@ -386,39 +422,40 @@ void MessageManagerImpl::getHistory(
             return;
         }
 
-        std::vector<Message> messages;
-        const auto* payloads = toMessagePayloadList(root.data);
-        if (payloads != nullptr) {
-            messages.reserve(payloads->size());
-            for (const auto& item : *payloads) {
-                Message msg = parseMessagePayload(item, conv_id);
-                if (msg.message_id.empty()) {
-                    continue;
-                }
-                upsertMessageDb(msg);
-                msg_cache_->insert(msg);
-                messages.push_back(std::move(msg));
-            }
-        }
+        // Persist only once the envelope confirmed success.
+        std::vector<Message>& messages = *list.messages;
+        ingestor_->ingest(messages, IngestSource::Fetch);
         if (cb.on_success) {
             cb.on_success(messages);
         }
     };
 
-    http_->get(primary_path, [this,
-                              conv_id,
-                              before_timestamp,
-                              limit,
-                              parse_and_return = std::move(parse_and_return)](network::HttpResponse resp) mutable {
+    network::HttpRequest req;
+    req.path = primary_path;
+    StreamedMessageList primary = streamMessageList(req, conv_id);
+
+    http_->send(std::move(req), [this,
+                                 conv_id,
+                                 before_timestamp,
+                                 limit,
+                                 primary,
+                                 parse_and_return = std::move(parse_and_return)](network::HttpResponse resp) mutable {
         if (resp.status_code == 404 || resp.status_code == 405) {
-            std::string fallback = "/conversations/" + conv_id + "/messages?limit=" + std::to_string(limit);
+            network::HttpRequest fallback;
+            fallback.path = "/conversations/" + conv_id + "/messages?limit=" + std::to_string(limit);
             if (before_timestamp > 0) {
-                fallback += "&before=" + std::to_string(before_timestamp);
+                fallback.path += "&before=" + std::to_string(before_timestamp);
             }
-            http_->get(fallback, std::move(parse_and_return));
+            StreamedMessageList list = streamMessageList(fallback, conv_id);
+            http_->send(
+                std::move(fallback),
+                [list, parse_and_return = std::move(parse_and_return)](network::HttpResponse fallback_resp) mutable {
+                    parse_and_return(std::move(fallback_resp), list);
+                }
+            );
             return;
         }
-        parse_and_return(std::move(resp));
+        parse_and_return(std::move(resp), primary);
     });
 }
 
@@ -459,10 +496,9 @@ void MessageManagerImpl::getOfflineMessages(
                 if (msg.message_id.empty()) {
                     continue;
                 }
-                upsertMessageDb(msg);
-                msg_cache_->insert(msg);
                 result.messages.push_back(std::move(msg));
             }
+            ingestor_->ingest(result.messages, IngestSource::Fetch);
         }
         result.has_more = parseBoolValue(root.data.has_more, false);
         result.next_seq = parseInt64Value(root.data.next_seq, 0);
@@ -633,7 +669,12 @@ void MessageManagerImpl::searchMessages(
         path += "&offset=" + std::to_string(offset);
     }
 
-    http_->get(path, [this, cb = std::move(callback)](network::HttpResponse resp) {
+    network::HttpRequest req;
+    req.path = std::move(path);
+    StreamedMessageList list = streamMessageList(req);
+
+    http_->send(std::move(req), [this, list, cb = std::move(callback)](network::HttpResponse resp) {
+        finishStreamedBody(resp, *list.streamer);
         ApiEnvelope<MessageListDataPayload> root;
         if (!parseApiEnvelopeResponse(resp, root, "search messages failed", true)) {
             if (cb.on_error) {
@@ -643,17 +684,8 @@ void MessageManagerImpl::searchMessages(
         }
 
         MessageSearchResult result;
-        if (const auto* payloads = toMessagePayloadList(root.data); payloads != nullptr) {
-            for (const auto& item : *payloads) {
-                Message msg = parseMessagePayload(item);
-                if (msg.message_id.empty()) {
-                    continue;
-                }
-                upsertMessageDb(msg);
-                msg_cache_->insert(msg);
-                result.messages.push_back(std::move(msg));
-            }
-        }
+        result.messages = std::move(*list.messages);
+        ingestor_->ingest(result.messages, IngestSource::Fetch);
         result.total = parseInt64Value(root.data.total, static_cast<int64_t>(result.messages.size()));
 
         if (cb.on_success) {
@@ -696,29 +728,18 @@ void MessageManagerImpl::recallMessage(const std::string& message_id, AnyChatCal
         }
 
         if ((resp.status_code == 404 || resp.status_code == 405)) {
-            const TransientFrame<MessageRecallPayload> frame{
-                .type = "message.recall",
-                .payload =
-                    MessageRecallPayload{
-                        .message_id = message_id,
-                    },
+            const MessageRecallPayload payload{
+                .message_id = message_id,
             };
-            std::string frame_json;
             std::string err;
-            if (!writeJson(frame, frame_json, err)) {
-                if (cb.on_error) {
-                    cb.on_error(-1, err);
-                }
-                return;
-            }
-            if (outbound_q_->sendTransient(frame_json)) {
+            if (outbound_q_->sendTransient("message.recall", payload, err)) {
                 if (cb.on_success) {
                     cb.on_success();
                 }
                 return;
             }
             if (cb.on_error) {
-                cb.on_error(-1, "websocket not connected");
+                cb.on_error(-1, err);
             }
             return;
         }
@@ -751,29 +772,18 @@ void MessageManagerImpl::deleteMessage(const std::string& message_id, AnyChatCal
         }
 
         if ((resp.status_code == 404 || resp.status_code == 405)) {
-            const TransientFrame<MessageDeletePayload> frame{
-                .type = "message.delete",
-                .payload =
-                    MessageDeletePayload{
-                        .message_id = message_id,
-                    },
+            const MessageDeletePayload payload{
+                .message_id = message_id,
             };
-            std::string frame_json;
             std::string err;
-            if (!writeJson(frame, frame_json, err)) {
-                if (cb.on_error) {
-                    cb.on_error(-1, err);
-                }
-                return;
-            }
-            if (outbound_q_->sendTransient(frame_json)) {
+            if (outbound_q_->sendTransient("message.delete", payload, err)) {
                 if (cb.on_success) {
                     cb.on_success();
                 }
                 return;
             }
             if (cb.on_error) {
-                cb.on_error(-1, "websocket not connected");
+                cb.on_error(-1, err);
             }
             return;
         }
@@ -838,30 +848,19 @@ void MessageManagerImpl::editMessage(const std::string& message_id, const std::s
         }
 
         if ((resp.status_code == 404 || resp.status_code == 405)) {
-            const TransientFrame<MessageEditPayload> frame{
-                .type = "message.edit",
-                .payload =
-                    MessageEditPayload{
-                        .message_id = message_id,
-                        .content = content,
-                    },
+            const MessageEditPayload payload{
+                .message_id = message_id,
+                .content = content,
             };
-            std::string frame_json;
             std::string err;
-            if (!writeJson(frame, frame_json, err)) {
-                if (cb.on_error) {
-                    cb.on_error(-1, err);
-                }
-                return;
-            }
-            if (outbound_q_->sendTransient(frame_json)) {
+            if (outbound_q_->sendTransient("message.edit", payload, err)) {
                 if (cb.on_success) {
                     cb.on_success();
                 }
                 return;
             }
             if (cb.on_error) {
-                cb.on_error(-1, "websocket not connected");
+                cb.on_error(-1, err);
             }
             return;
         }
@@ -885,34 +884,21 @@ void MessageManagerImpl::sendTyping(
         return;
     }
 
-    const TransientFrame<MessageTypingPayload> frame{
-        .type = "message.typing",
-        .payload =
-            MessageTypingPayload{
-                .conversation_id = conversation_id,
-                .typing = typing,
-                .ttl_seconds = ttl_seconds > 0 ? std::optional<int32_t>{ ttl_seconds } : std::nullopt,
-            },
+    const MessageTypingPayload payload{
+        .conversation_id = conversation_id,
+        .typing = typing,
+        .ttl_seconds = ttl_seconds > 0 ? std::optional<int32_t>{ ttl_seconds } : std::nullopt,
     };
-
-    std::string frame_json;
+    // A newer typing state supersedes this one, so it may be dropped.
     std::string err;
-    if (!writeJson(frame, frame_json, err)) {
-        if (callback.on_error) {
-            callback.on_error(-1, err);
-        }
-        return;
-    }
-
-    const bool sent = outbound_q_->sendTransient(frame_json);
-    if (sent) {
+    if (outbound_q_->sendTransient("message.typing", payload, err, network::SendPriority::Transient)) {
         if (callback.on_success) {
             callback.on_success();
         }
         return;
     }
     if (callback.on_error) {
-        callback.on_error(-1, "websocket not connected");
+        callback.on_error(-1, err);
     }
 }
 
@@ -921,6 +907,57 @@ void MessageManagerImpl::setListener(std::shared_ptr<MessageListener> listener)
     listener_ = std::move(listener);
 }
 
+void MessageManagerImpl::setListenerBatching(
+    std::shared_ptr<util::TimerScheduler> timers,
+    std::shared_ptr<util::DispatchExecutor> executor,
+    std::chrono::milliseconds window
+) {
+    received_batch_ = std::make_unique<util::EventBatcher<Message>>(
+        timers,
+        executor,
+        "listener.message.received",
+        window,
+        [this](std::vector<Message>&& batch) {
+            if (auto listener = currentListener()) {
+                listener->onMessagesReceived(batch);
+            }
+        }
+    );
+    receipt_batch_ = std::make_unique<util::EventBatcher<MessageReadReceiptEvent>>(
+        timers,
+        executor,
+        "listener.message.read_receipt",
+        window,
+        [this](std::vector<MessageReadReceiptEvent>&& batch) {
+            if (auto listener = currentListener()) {
+                listener->onMessageReadReceipts(batch);
+            }
+        }
+    );
+    typing_batch_ = std::make_unique<util::EventBatcher<MessageTypingEvent>>(
+        std::move(timers),
+        std::move(executor),
+        "listener.message.typing",
+        window,
+        [this](std::vector<MessageTypingEvent>&& batch) {
+            if (auto listener = currentListener()) {
+                listener->onMessageTypings(batch);
+            }
+        }
+    );
+}
+
+std::shared_ptr<MessageListener> MessageManagerImpl::currentListener() const {
+    std::lock_guard<std::mutex> lk(handler_mutex_);
+    return listener_;
+}
+
+void MessageManagerImpl::flushReceivedBatch() {
+    if (received_batch_) {
+        received_batch_->flush();
+    }
+}
+
 void MessageManagerImpl::setCurrentUserId(const std::string& uid) {
     std::lock_guard<std::mutex> lk(uid_mutex_);
     current_user_id_ = uid;
@@ -930,14 +967,11 @@ void MessageManagerImpl::setCurrentUserId(const std::string& uid) {
 // Notification handling
 // ---------------------------------------------------------------------------
 
-void MessageManagerImpl::handleIncomingMessage(const NotificationEvent& event) {
+void MessageManagerImpl::handleIncomingMessage(
+    const NotificationEvent& event,
+    const NotificationMessagePayload& payload
+) {
     try {
-        NotificationMessagePayload payload{};
-        std::string err;
-        if (!parseJsonObject(event.data, payload, err)) {
-            return;
-        }
-
         Message msg = parseMessageFromNotification(payload);
         if (msg.message_id.empty()) {
             return;
@@ -946,34 +980,45 @@ void MessageManagerImpl::handleIncomingMessage(const NotificationEvent& event) {
             msg.timestamp_ms = normalizeEpochMs(event.timestamp);
         }
 
-        msg_cache_->insert(msg);
-        upsertMessageDb(msg);
+        std::vector<Message> batch;
+        batch.push_back(std::move(msg));
+        for (auto& received : ingestor_->ingest(std::move(batch), IngestSource::Push)) {
+            if (received_batch_) {
+                const std::string key = received.message_id; // a redelivered message is reported once
+                received_batch_->add(std::move(received), key);
+                continue;
+            }
 
-        std::shared_ptr<MessageListener> listener;
-        {
-            std::lock_guard<std::mutex> lk(handler_mutex_);
-            listener = listener_;
-        }
-        if (listener) {
-            listener->onMessageReceived(msg);
+            std::shared_ptr<MessageListener> listener;
+            {
+                std::lock_guard<std::mutex> lk(handler_mutex_);
+                listener = listener_;
+            }
+            if (listener) {
+                listener->onMessageReceived(received);
+            }
         }
     } catch (const std::exception&) {
         // Ignore malformed notification payload.
     }
 }
 
-void MessageManagerImpl::handleReadReceipt(const NotificationEvent& event) {
-    NotificationReadReceiptPayload payload{};
-    std::string err;
-    if (!parseJsonObject(event.data, payload, err)) {
-        return;
-    }
-
+void MessageManagerImpl::handleReadReceipt(
+    const NotificationEvent& event,
+    const NotificationReadReceiptPayload& payload
+) {
     MessageReadReceiptEvent receipt = parseReadReceiptFromNotification(payload);
     if (receipt.read_at_ms == 0) {
         receipt.read_at_ms = normalizeEpochMs(event.timestamp);
     }
 
+    if (receipt_batch_) {
+        // Only the reader's latest position in the conversation matters.
+        const std::string key = receipt.conversation_id + '\n' + receipt.from_user_id;
+        receipt_batch_->add(std::move(receipt), key);
+        return;
+    }
+
     std::shared_ptr<MessageListener> listener;
     {
         std::lock_guard<std::mutex> lk(handler_mutex_);
@@ -984,13 +1029,10 @@ void MessageManagerImpl::handleReadReceipt(const NotificationEvent& event) {
     }
 }
 
-void MessageManagerImpl::handleMessageRecalled(const NotificationEvent& event) {
-    NotificationMessagePayload payload{};
-    std::string err;
-    if (!parseJsonObject(event.data, payload, err)) {
-        return;
-    }
-
+void MessageManagerImpl::handleMessageRecalled(
+    const NotificationEvent& event,
+    const NotificationMessagePayload& payload
+) {
     Message msg = parseMessageFromNotification(payload);
     if (msg.message_id.empty()) {
         return;
@@ -1019,6 +1061,8 @@ void MessageManagerImpl::handleMessageRecalled(const NotificationEvent& event) {
     const std::string* content = msg.content.empty() ? nullptr : &msg.content;
     updateMessageDbStatusAndContent(msg.message_id, 1, content);
 
+    flushReceivedBatch();
+
     std::shared_ptr<MessageListener> listener;
     {
         std::lock_guard<std::mutex> lk(handler_mutex_);
@@ -1029,13 +1073,10 @@ void MessageManagerImpl::handleMessageRecalled(const NotificationEvent& event) {
     }
 }
 
-void MessageManagerImpl::handleMessageDeleted(const NotificationEvent& event) {
-    NotificationMessagePayload payload{};
-    std::string err;
-    if (!parseJsonObject(event.data, payload, err)) {
-        return;
-    }
-
+void MessageManagerImpl::handleMessageDeleted(
+    const NotificationEvent& event,
+    const NotificationMessagePayload& payload
+) {
     Message msg = parseMessageFromNotification(payload);
     if (msg.message_id.empty()) {
         return;
@@ -1060,6 +1101,8 @@ void MessageManagerImpl::handleMessageDeleted(const NotificationEvent& event) {
 
     updateMessageDbStatusAndContent(msg.message_id, 2, nullptr);
 
+    flushReceivedBatch();
+
     std::shared_ptr<MessageListener> listener;
     {
         std::lock_guard<std::mutex> lk(handler_mutex_);
@@ -1070,13 +1113,10 @@ void MessageManagerImpl::handleMessageDeleted(const NotificationEvent& event) {
     }
 }
 
-void MessageManagerImpl::handleMessageEdited(const NotificationEvent& event) {
-    NotificationMessagePayload payload{};
-    std::string err;
-    if (!parseJsonObject(event.data, payload, err)) {
-        return;
-    }
-
+void MessageManagerImpl::handleMessageEdited(
+    const NotificationEvent& event,
+    const NotificationMessagePayload& payload
+) {
     Message msg = parseMessageFromNotification(payload);
     if (msg.message_id.empty()) {
         return;
@@ -1101,6 +1141,8 @@ void MessageManagerImpl::handleMessageEdited(const NotificationEvent& event) {
     const std::string* content = msg.content.empty() ? nullptr : &msg.content;
     updateMessageDbStatusAndContent(msg.message_id, msg.status, content);
 
+    flushReceivedBatch();
+
     std::shared_ptr<MessageListener> listener;
     {
         std::lock_guard<std::mutex> lk(handler_mutex_);
@@ -1111,18 +1153,18 @@ void MessageManagerImpl::handleMessageEdited(const NotificationEvent& event) {
     }
 }
 
-void MessageManagerImpl::handleTyping(const NotificationEvent& event) {
-    NotificationTypingPayload payload{};
-    std::string err;
-    if (!parseJsonObject(event.data, payload, err)) {
-        return;
-    }
-
+void MessageManagerImpl::handleTyping(const NotificationEvent& event, const NotificationTypingPayload& payload) {
     MessageTypingEvent typing = parseTypingFromNotification(payload);
     if (typing.expire_at_ms == 0 && event.timestamp > 0) {
         typing.expire_at_ms = normalizeEpochMs(event.timestamp);
     }
 
+    if (typing_batch_) {
+        const std::string key = typing.conversation_id + '\n' + typing.from_user_id;
+        typing_batch_->add(std::move(typing), key);
+        return;
+    }
+
     std::shared_ptr<MessageListener> listener;
     {
         std::lock_guard<std::mutex> lk(handler_mutex_);
@@ -1133,13 +1175,7 @@ void MessageManagerImpl::handleTyping(const NotificationEvent& event) {
     }
 }
 
-void MessageManagerImpl::handleMentioned(const NotificationEvent& event) {
-    NotificationMessagePayload payload{};
-    std::string err;
-    if (!parseJsonObject(event.data, payload, err)) {
-        return;
-    }
-
+void MessageManagerImpl::handleMentioned(const NotificationEvent& event, const NotificationMessagePayload& payload) {
     Message msg = parseMessageFromNotification(payload);
     if (msg.message_id.empty()) {
         return;
@@ -1148,8 +1184,9 @@ void MessageManagerImpl::handleMentioned(const NotificationEvent& event) {
         msg.timestamp_ms = normalizeEpochMs(event.timestamp);
     }
 
-    msg_cache_->insert(msg);
-    upsertMessageDb(msg);
+    ingestor_->ingest({ msg }, IngestSource::Push);
+
+    flushReceivedBatch();
 
     std::shared_ptr<MessageListener> listener;
     {
@@ -1189,35 +1226,6 @@ int64_t MessageManagerImpl::normalizeEpochMs(int64_t raw) {
     return std::llabs(raw) >= 100000000000LL ? raw : raw * 1000;
 }
 
-void MessageManagerImpl::upsertMessageDb(const Message& msg) {
-    if (msg.message_id.empty() || msg.conv_id.empty()) {
-        return;
-    }
-
-    db_->exec(
-        "INSERT INTO messages (message_id, local_id, conv_id, sender_id, content_type, content, seq, reply_to, "
-        "status, send_state, is_read, timestamp_ms) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?) "
-        "ON CONFLICT(message_id) DO UPDATE SET "
-        "local_id=excluded.local_id, conv_id=excluded.conv_id, sender_id=excluded.sender_id, "
-        "content_type=excluded.content_type, content=excluded.content, seq=excluded.seq, reply_to=excluded.reply_to, "
-        "status=excluded.status, send_state=excluded.send_state, is_read=excluded.is_read, "
-        "timestamp_ms=excluded.timestamp_ms",
-        { msg.message_id,
-          msg.local_id,
-          msg.conv_id,
-          msg.sender_id,
-          static_cast<int64_t>(msg.content_type),
-          msg.content,
-          msg.seq,
-          msg.reply_to,
-          static_cast<int64_t>(msg.status),
-          static_cast<int64_t>(msg.send_state),
-          static_cast<int64_t>(msg.is_read ? 1 : 0),
-          msg.timestamp_ms }
-    );
-}
-
 void MessageManagerImpl::updateMessageDbStatusAndContent(
     const std::string& message_id,
     int status,
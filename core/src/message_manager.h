@@ -1,5 +1,6 @@
 #pragma once
 
+#include "message_ingestor.h"
 #include "notification_manager.h"
 #include "outbound_queue.h"
 #include "sdk_callbacks.h"
@@ -8,7 +9,9 @@
 #include "cache/message_cache.h"
 #include "db/database.h"
 #include "network/http_client.h"
+#include "util/event_batcher.h"
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -47,13 +50,40 @@ public:
     virtual void onMessageMentioned(const Message& message) {
         (void) message;
     }
+
+    // Batched forms, called instead of the ones above when listener batching
+    // is on (see setListenerBatching()). By default they forward each event.
+    virtual void onMessagesReceived(const std::vector<Message>& messages) {
+        for (const auto& message : messages) {
+            onMessageReceived(message);
+        }
+    }
+
+    virtual void onMessageReadReceipts(const std::vector<MessageReadReceiptEvent>& events) {
+        for (const auto& event : events) {
+            onMessageReadReceipt(event);
+        }
+    }
+
+    virtual void onMessageTypings(const std::vector<MessageTypingEvent>& events) {
+        for (const auto& event : events) {
+            onMessageTyping(event);
+        }
+    }
 };
 
+namespace message_manager_detail {
+struct NotificationMessagePayload;
+struct NotificationReadReceiptPayload;
+struct NotificationTypingPayload;
+} // namespace message_manager_detail
+
 class MessageManagerImpl {
 public:
     MessageManagerImpl(
         db::Database* db,
         cache::MessageCache* msg_cache,
+        MessageIngestor* ingestor,
         OutboundQueue* outbound_q,
         NotificationManager* notif_mgr,
         std::shared_ptr<network::HttpClient> http,
@@ -92,26 +122,58 @@ public:
 
     void setListener(std::shared_ptr<MessageListener> listener);
 
+    // Delivers received messages, read receipts and typing events to the
+    // listener in batches, one per |window|: the same message, or the same
+    // user's receipt or typing state in a conversation, is reported once
+    // per batch. Recalls, deletions, edits and mentions are not batched but
+    // flush the pending messages first, so they never overtake them. Call
+    // before notifications flow.
+    void setListenerBatching(
+        std::shared_ptr<util::TimerScheduler> timers,
+        std::shared_ptr<util::DispatchExecutor> executor,
+        std::chrono::milliseconds window
+    );
+
     // Called by AnyChatClientImpl when current_user_id becomes known after login.
     void setCurrentUserId(const std::string& uid);
 
 private:
     static std::string urlEncode(const std::string& input);
     static int64_t normalizeEpochMs(int64_t raw);
-    void upsertMessageDb(const Message& msg);
     void updateMessageDbStatusAndContent(const std::string& message_id, int status, const std::string* content);
 
-    void handleIncomingMessage(const NotificationEvent& event);
-    void handleReadReceipt(const NotificationEvent& event);
-    void handleMessageRecalled(const NotificationEvent& event);
-    void handleMessageDeleted(const NotificationEvent& event);
-    void handleMessageEdited(const NotificationEvent& event);
-    void handleTyping(const NotificationEvent& event);
-    void handleMentioned(const NotificationEvent& event);
+    void handleIncomingMessage(
+        const NotificationEvent& event,
+        const message_manager_detail::NotificationMessagePayload& payload
+    );
+    void handleReadReceipt(
+        const NotificationEvent& event,
+        const message_manager_detail::NotificationReadReceiptPayload& payload
+    );
+    void handleMessageRecalled(
+        const NotificationEvent& event,
+        const message_manager_detail::NotificationMessagePayload& payload
+    );
+    void handleMessageDeleted(
+        const NotificationEvent& event,
+        const message_manager_detail::NotificationMessagePayload& payload
+    );
+    void handleMessageEdited(
+        const NotificationEvent& event,
+        const message_manager_detail::NotificationMessagePayload& payload
+    );
+    void handleTyping(const NotificationEvent& event, const message_manager_detail::NotificationTypingPayload& payload);
+    void handleMentioned(
+        const NotificationEvent& event,
+        const message_manager_detail::NotificationMessagePayload& payload
+    );
+    std::shared_ptr<MessageListener> currentListener() const;
+    void flushReceivedBatch();
     static std::string generateLocalId();
 
     db::Database* db_;
     cache::MessageCache* msg_cache_;
+    MessageIngestor* ingestor_; // stores every message the server sends
     OutboundQueue* outbound_q_;
     NotificationManager* notif_mgr_;
     std::shared_ptr<network::HttpClient> http_;
@@ -119,6 +181,11 @@ private:
     mutable std::mutex handler_mutex_;
     std::shared_ptr<MessageListener> listener_;
 
+    // Set once by setListenerBatching(); null for per-event delivery.
+    std::unique_ptr<util::EventBatcher<Message>> received_batch_;
+    std::unique_ptr<util::EventBatcher<MessageReadReceiptEvent>> receipt_batch_;
+    std::unique_ptr<util::EventBatcher<MessageTypingEvent>> typing_batch_;
+
     std::mutex uid_mutex_;
     std::string current_user_id_;
 };
@@ -0,0 +1,46 @@
+#include "heartbeat_interval.h"
+
+#include <algorithm>
+
+namespace anychat::network {
+
+HeartbeatInterval::HeartbeatInterval(HeartbeatOptions options)
+    : options_(options)
+    , interval_ms_(options.min_interval_ms) {}
+
+void HeartbeatInterval::onAnswered() {
+    confirmed_ms_ = std::max(confirmed_ms_, interval_ms_);
+    if (settled_ || interval_ms_ >= options_.max_interval_ms)
+        return;
+    if (++answered_in_row_ < options_.probe_after)
+        return;
+    answered_in_row_ = 0;
+    interval_ms_ = std::min(interval_ms_ + options_.step_ms, options_.max_interval_ms);
+}
+
+void HeartbeatInterval::onLost() {
+    answered_in_row_ = 0;
+    settled_ = true;
+    if (interval_ms_ > confirmed_ms_) {
+        // Probing past the NAT timeout: fall back to what worked.
+        interval_ms_ = std::max(confirmed_ms_, options_.min_interval_ms);
+    } else {
+        // Lost at a proven interval: the path got worse, or it was not the
+        // NAT at all. Step down once; repeated losses keep stepping.
+        interval_ms_ = std::max(interval_ms_ - options_.step_ms, options_.min_interval_ms);
+    }
+    confirmed_ms_ = interval_ms_;
+}
+
+void HeartbeatInterval::reset() {
+    interval_ms_ = options_.min_interval_ms;
+    confirmed_ms_ = 0;
+    answered_in_row_ = 0;
+    settled_ = false;
+}
+
+int HeartbeatInterval::pongTimeoutMs(const RttStats& rtt) const {
+    return std::clamp(rtt.rto_ms, options_.min_pong_timeout_ms, options_.max_pong_timeout_ms);
+}
+
+} // namespace anychat::network
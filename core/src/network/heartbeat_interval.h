@@ -0,0 +1,63 @@
+#pragma once
+
+#include "rtt_estimator.h"
+
+namespace anychat {
+namespace network {
+
+struct HeartbeatOptions {
+    int min_interval_ms = 30'000; // starting interval and floor
+    int max_interval_ms = 270'000; // stays under the common 5 min NAT timeout
+    int step_ms = 30'000;
+    int probe_after = 3; // answered pings in a row before the interval grows
+    int min_pong_timeout_ms = 10'000;
+    int max_pong_timeout_ms = 60'000;
+};
+
+// Idle time between heartbeats, adapted to the NAT in front of the device.
+//
+// A NAT drops a TCP mapping that has been idle for longer than its timeout,
+// silently, so pinging more often than needed costs radio wake-ups and
+// pinging less often costs the connection. Starting from the floor, the
+// interval grows one step after every |probe_after| answered pings. When a
+// ping goes unanswered at an interval longer than any that worked, that
+// interval is past the timeout: the largest one that worked is kept from
+// then on. A loss at an interval that had worked steps down once. reset()
+// starts over, e.g. on a network change, which means another NAT.
+//
+// Not thread-safe.
+class HeartbeatInterval {
+public:
+    explicit HeartbeatInterval(HeartbeatOptions options = {});
+
+    int intervalMs() const {
+        return interval_ms_;
+    }
+
+    // True once a loss has fixed the interval.
+    bool settled() const {
+        return settled_;
+    }
+
+    // The ping sent after intervalMs() of idle time was answered.
+    void onAnswered();
+
+    // The connection died while a ping was unanswered.
+    void onLost();
+
+    void reset();
+
+    // How long to wait for a pong: the RTO, clamped to the configured
+    // bounds (the lower bound alone before the first RTT sample).
+    int pongTimeoutMs(const RttStats& rtt) const;
+
+private:
+    HeartbeatOptions options_;
+    int interval_ms_;
+    int confirmed_ms_ = 0; // largest interval that was answered, 0 if none
+    int answered_in_row_ = 0;
+    bool settled_ = false;
+};
+
+} // namespace network
+} // namespace anychat
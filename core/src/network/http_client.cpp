@@ -1,47 +1,329 @@
 #include "http_client.h"
 
+#include <algorithm>
 #include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
 #include <mutex>
 #include <queue>
+#include <string_view>
+#include <random>
 #include <thread>
+#include <unordered_set>
 
 #include <curl/curl.h>
 
+#ifdef ANYCHAT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 namespace anychat::network {
 
 // ── internal helpers ─────────────────────────────────────────────────────────
 
 namespace {
 
+using Clock = std::chrono::steady_clock;
+
+constexpr int kMaxIdleWaitMs = 20;
+constexpr int64_t kProgressStepBytes = 64 * 1024;
+
 size_t write_cb(char* ptr, size_t size, size_t nmemb, void* userdata) {
     auto* buf = static_cast<std::string*>(userdata);
     buf->append(ptr, size * nmemb);
     return size * nmemb;
 }
 
-enum class Method
-{
-    GET,
-    POST,
-    PUT,
-    PATCH,
-    DEL
-};
+// Collects "Name: value" lines of the final response; a new status line
+// (redirect, 100 Continue) starts over.
+size_t header_cb(char* buffer, size_t size, size_t nitems, void* userdata) {
+    auto* headers = static_cast<std::unordered_map<std::string, std::string>*>(userdata);
+    const size_t len = size * nitems;
+    std::string_view line(buffer, len);
+    if (line.rfind("HTTP/", 0) == 0) {
+        headers->clear();
+        return len;
+    }
+
+    const size_t colon = line.find(':');
+    if (colon == std::string_view::npos)
+        return len;
+
+    std::string name(line.substr(0, colon));
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    std::string_view value = line.substr(colon + 1);
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        value.remove_prefix(1);
+    while (!value.empty() && (value.back() == '\r' || value.back() == '\n' || value.back() == ' '))
+        value.remove_suffix(1);
+    (*headers)[std::move(name)] = std::string(value);
+    return len;
+}
+
+#ifdef ANYCHAT_HAVE_ZLIB
+// One-shot gzip of a request body held in memory.
+bool gzipCompress(const std::string& in, std::string& out) {
+    z_stream zs{};
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+    out.resize(deflateBound(&zs, static_cast<uLong>(in.size())));
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = static_cast<uInt>(out.size());
+    const int rc = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return rc == Z_STREAM_END;
+}
+#endif
+
+// "/sync" matches "/sync", "/sync/..." and "/sync?..." but not "/syncs".
+bool routeMatches(const std::string& path, const std::string& route) {
+    if (route.empty() || path.compare(0, route.size(), route) != 0)
+        return false;
+    return path.size() == route.size() || path[route.size()] == '/' || path[route.size()] == '?';
+}
+
+bool seekFile(std::FILE* file, int64_t pos, int origin = SEEK_SET) {
+#ifdef _WIN32
+    return _fseeki64(file, pos, origin) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(pos), origin) == 0;
+#endif
+}
+
+int64_t tellFile(std::FILE* file) {
+#ifdef _WIN32
+    return _ftelli64(file);
+#else
+    return static_cast<int64_t>(ftello(file));
+#endif
+}
 
 struct RequestCtx {
     CURL* easy = nullptr;
     curl_slist* headers = nullptr;
+    HttpMethod method = HttpMethod::Get;
     std::string body; // kept alive for the lifetime of the easy handle
+    int64_t body_bytes = 0; // request body size before compression
     std::string response_body;
+    std::unordered_map<std::string, std::string> response_headers;
     HttpCallback callback;
+    std::string setup_error; // reported instead of starting the transfer
+
+    // Streamed request body (HttpRequest::file_body)
+    std::FILE* file = nullptr;
+    int64_t file_offset = 0;
+    int64_t file_length = 0;
+    int64_t file_read = 0;
+
+    // Streamed response body (HttpRequest::file_sink)
+    std::FILE* sink = nullptr;
+    int64_t sink_offset = 0;
+    int64_t sink_max = -1;
+    int64_t sink_written = 0;
+
+    // Streamed response body (HttpRequest::on_body_data)
+    HttpBodyDataCallback on_body_data;
+    int64_t streamed = 0;
+
+    HttpProgressCallback on_progress;
+    int64_t last_progress = -1;
+
+    std::string route; // metrics key, "METHOD /template"
+
+    RetryPolicy retry;
+    HttpTimeouts timeouts;
+    int attempt = 0; // attempts started so far
+    bool has_deadline = false;
+    Clock::time_point deadline{};
+    Clock::time_point due{}; // earliest start of the next attempt
 };
 
+const char* methodName(HttpMethod method) {
+    switch (method) {
+        case HttpMethod::Get:
+            return "GET";
+        case HttpMethod::Post:
+            return "POST";
+        case HttpMethod::Put:
+            return "PUT";
+        case HttpMethod::Patch:
+            return "PATCH";
+        case HttpMethod::Delete:
+            return "DELETE";
+    }
+    return "GET";
+}
+
 bool isAbsoluteUrl(const std::string& path) {
     return path.rfind("http://", 0) == 0 || path.rfind("https://", 0) == 0;
 }
 
+// The request never reached the server, so even a POST can be sent again.
+bool isConnectFailure(CURLcode rc) {
+    return rc == CURLE_COULDNT_RESOLVE_HOST || rc == CURLE_COULDNT_RESOLVE_PROXY || rc == CURLE_COULDNT_CONNECT;
+}
+
+bool isTransientTransportError(CURLcode rc) {
+    switch (rc) {
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_PARTIAL_FILE:
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_HTTP2:
+        case CURLE_HTTP2_STREAM:
+            return true;
+        default:
+            return isConnectFailure(rc);
+    }
+}
+
+size_t read_cb(char* buffer, size_t size, size_t nitems, void* userdata) {
+    auto* ctx = static_cast<RequestCtx*>(userdata);
+    const int64_t remaining = ctx->file_length - ctx->file_read;
+    if (remaining <= 0)
+        return 0;
+
+    const size_t want = static_cast<size_t>(std::min<int64_t>(static_cast<int64_t>(size * nitems), remaining));
+    const size_t n = std::fread(buffer, 1, want, ctx->file);
+    if (n == 0 && std::ferror(ctx->file))
+        return CURL_READFUNC_ABORT;
+    ctx->file_read += static_cast<int64_t>(n);
+    return n;
+}
+
+size_t sink_write_cb(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    auto* ctx = static_cast<RequestCtx*>(userdata);
+    const size_t len = size * nmemb;
+
+    // Error bodies are kept in memory for diagnostics, never written to disk.
+    long code = 0;
+    curl_easy_getinfo(ctx->easy, CURLINFO_RESPONSE_CODE, &code);
+    if (code < 200 || code >= 300) {
+        ctx->response_body.append(ptr, len);
+        return len;
+    }
+
+    if (ctx->sink_max >= 0 && ctx->sink_written + static_cast<int64_t>(len) > ctx->sink_max)
+        return 0; // aborts with CURLE_WRITE_ERROR
+    if (std::fwrite(ptr, 1, len, ctx->sink) != len)
+        return 0;
+    ctx->sink_written += static_cast<int64_t>(len);
+    return len;
+}
+
+size_t stream_write_cb(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    auto* ctx = static_cast<RequestCtx*>(userdata);
+    const size_t len = size * nmemb;
+
+    long code = 0;
+    curl_easy_getinfo(ctx->easy, CURLINFO_RESPONSE_CODE, &code);
+    if (code < 200 || code >= 300) {
+        ctx->response_body.append(ptr, len);
+        return len;
+    }
+
+    ctx->streamed += static_cast<int64_t>(len);
+    return ctx->on_body_data(std::string_view(ptr, len)) ? len : 0;
+}
+
+// libcurl rewinds the body on redirects and re-authentication.
+int seek_cb(void* userdata, curl_off_t offset, int origin) {
+    auto* ctx = static_cast<RequestCtx*>(userdata);
+    if (origin != SEEK_SET)
+        return CURL_SEEKFUNC_CANTSEEK;
+    if (offset < 0 || offset > ctx->file_length || !seekFile(ctx->file, ctx->file_offset + offset))
+        return CURL_SEEKFUNC_FAIL;
+    ctx->file_read = static_cast<int64_t>(offset);
+    return CURL_SEEKFUNC_OK;
+}
+
+void reportProgress(RequestCtx* ctx, int64_t done, int64_t total) {
+    if (done == ctx->last_progress)
+        return;
+    if (done != total && ctx->last_progress >= 0 && done - ctx->last_progress < kProgressStepBytes)
+        return;
+    ctx->last_progress = done;
+    ctx->on_progress(done, total);
+}
+
+int xferinfo_cb(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t /*ultotal*/, curl_off_t ulnow) {
+    auto* ctx = static_cast<RequestCtx*>(userdata);
+    if (ctx->file)
+        reportProgress(ctx, static_cast<int64_t>(ulnow), ctx->file_length);
+    else if (dlnow > 0)
+        reportProgress(ctx, static_cast<int64_t>(dlnow), static_cast<int64_t>(dltotal));
+    return 0;
+}
+
+void releaseCtx(RequestCtx* ctx) {
+    if (ctx->file)
+        std::fclose(ctx->file);
+    if (ctx->sink)
+        std::fclose(ctx->sink);
+    if (ctx->headers)
+        curl_slist_free_all(ctx->headers);
+    curl_easy_cleanup(ctx->easy);
+    delete ctx;
+}
+
+struct DueLater {
+    bool operator()(const RequestCtx* a, const RequestCtx* b) const {
+        return a->due > b->due;
+    }
+};
+
 } // namespace
 
+// ── retry policy ─────────────────────────────────────────────────────────────
+
+int computeBackoffMs(const RetryPolicy& policy, int retry, double random01) {
+    const int base = std::max(policy.base_backoff_ms, 0);
+    const int cap = std::max(policy.max_backoff_ms, base);
+    const int shift = std::clamp(retry - 1, 0, 30);
+
+    double delay = std::min(static_cast<double>(base) * static_cast<double>(1LL << shift), static_cast<double>(cap));
+    const double jitter = std::clamp(policy.jitter, 0.0, 1.0);
+    delay = delay * (1.0 - jitter) + delay * jitter * std::clamp(random01, 0.0, 1.0);
+    return static_cast<int>(delay);
+}
+
+bool isRetryableStatus(const RetryPolicy& policy, int status_code) {
+    return std::find(policy.retryable_status.begin(), policy.retryable_status.end(), status_code)
+           != policy.retryable_status.end();
+}
+
+bool isIdempotent(HttpMethod method, const RetryPolicy& policy) {
+    if (policy.idempotent.has_value())
+        return *policy.idempotent;
+    return method == HttpMethod::Get || method == HttpMethod::Put || method == HttpMethod::Delete;
+}
+
+HttpTimeouts adaptTimeouts(HttpTimeouts timeouts, const RttStats& rtt) {
+    if (rtt.samples == 0 || timeouts.connect_timeout_ms <= 0)
+        return timeouts;
+    const int connect = std::max(timeouts.connect_timeout_ms, kConnectRoundTrips * rtt.rto_ms);
+    if (timeouts.total_timeout_ms > 0)
+        timeouts.total_timeout_ms += connect - timeouts.connect_timeout_ms;
+    timeouts.connect_timeout_ms = connect;
+    return timeouts;
+}
+
+RetryPolicy adaptRetryPolicy(RetryPolicy policy, const RttStats& rtt) {
+    if (rtt.samples == 0)
+        return policy;
+    policy.base_backoff_ms = std::max(policy.base_backoff_ms, rtt.srtt_ms);
+    policy.max_backoff_ms = std::max(policy.max_backoff_ms, policy.base_backoff_ms);
+    return policy;
+}
+
 // ── Impl ──────────────────────────────────────────────────────────────────────
 
 struct HttpClient::Impl {
@@ -49,6 +331,12 @@ struct HttpClient::Impl {
     std::string auth_token;
     std::mutex token_mutex;
 
+    std::mutex defaults_mutex;
+    RetryPolicy default_retry;
+    HttpTimeouts default_timeouts;
+    HttpCompressionOptions compression;
+    std::shared_ptr<const RttEstimator> rtt;
+
     CURLM* multi = nullptr;
     std::thread worker;
     std::atomic<bool> running{ false };
@@ -56,6 +344,24 @@ struct HttpClient::Impl {
     std::mutex queue_mutex;
     std::queue<RequestCtx*> pending;
 
+    // Worker-thread only.
+    std::vector<RequestCtx*> delayed; // min-heap on due
+    std::unordered_set<RequestCtx*> in_flight;
+    std::mt19937 rng{ std::random_device{}() };
+
+    std::atomic<uint64_t> stat_requests{ 0 };
+    std::atomic<uint64_t> stat_attempts{ 0 };
+    std::atomic<uint64_t> stat_retries{ 0 };
+    std::atomic<uint64_t> stat_timeouts{ 0 };
+    std::atomic<uint64_t> stat_deadline_exceeded{ 0 };
+    std::atomic<uint64_t> stat_failed{ 0 };
+    std::atomic<uint64_t> stat_request_body_bytes{ 0 };
+    std::atomic<uint64_t> stat_request_wire_bytes{ 0 };
+    std::atomic<uint64_t> stat_response_body_bytes{ 0 };
+    std::atomic<uint64_t> stat_response_wire_bytes{ 0 };
+    std::atomic<uint64_t> stat_compressed_requests{ 0 };
+    HttpRouteMetrics route_metrics;
+
     explicit Impl(std::string url)
         : base_url(std::move(url)) {
         curl_global_init(CURL_GLOBAL_DEFAULT);
@@ -68,6 +374,18 @@ struct HttpClient::Impl {
         running = false;
         if (worker.joinable())
             worker.join();
+
+        // Requests still outstanding at shutdown are dropped without callbacks.
+        while (!pending.empty()) {
+            releaseCtx(pending.front());
+            pending.pop();
+        }
+        for (RequestCtx* ctx : delayed)
+            releaseCtx(ctx);
+        for (RequestCtx* ctx : in_flight) {
+            curl_multi_remove_handle(multi, ctx->easy);
+            releaseCtx(ctx);
+        }
         curl_multi_cleanup(multi);
         curl_global_cleanup();
     }
@@ -75,17 +393,39 @@ struct HttpClient::Impl {
     void loop() {
         while (running) {
             // Enqueue pending requests
+            std::vector<RequestCtx*> setup_failed;
             {
                 std::lock_guard<std::mutex> lk(queue_mutex);
                 while (!pending.empty()) {
-                    curl_multi_add_handle(multi, pending.front()->easy);
+                    RequestCtx* ctx = pending.front();
                     pending.pop();
+                    if (ctx->setup_error.empty()) {
+                        startAttempt(ctx);
+                        continue;
+                    }
+                    setup_failed.push_back(ctx);
                 }
             }
+            // Outside the lock: a callback may issue another request.
+            for (RequestCtx* ctx : setup_failed) {
+                ++stat_failed;
+                if (ctx->callback)
+                    ctx->callback(HttpResponse{ .error = ctx->setup_error });
+                releaseCtx(ctx);
+            }
+
+            // Re-issue retries whose back-off has elapsed
+            const auto now = Clock::now();
+            while (!delayed.empty() && delayed.front()->due <= now) {
+                std::pop_heap(delayed.begin(), delayed.end(), DueLater{});
+                RequestCtx* ctx = delayed.back();
+                delayed.pop_back();
+                startAttempt(ctx);
+            }
 
             int active = 0;
             curl_multi_perform(multi, &active);
-            curl_multi_wait(multi, nullptr, 0, 20 /*ms*/, nullptr);
+            curl_multi_wait(multi, nullptr, 0, nextWaitMs(), nullptr);
 
             // Harvest completed requests
             int msgs_left = 0;
@@ -95,54 +435,317 @@ struct HttpClient::Impl {
                     continue;
 
                 CURL* easy = msg->easy_handle;
+                const CURLcode result = msg->data.result;
                 RequestCtx* ctx = nullptr;
                 curl_easy_getinfo(easy, CURLINFO_PRIVATE, &ctx);
 
-                HttpResponse resp;
                 long code = 0;
                 curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &code);
+                curl_multi_remove_handle(multi, easy);
+                in_flight.erase(ctx);
+
+                if (result == CURLE_OPERATION_TIMEDOUT)
+                    ++stat_timeouts;
+                else if (result == CURLE_OK)
+                    recordBodyBytes(ctx);
+                recordTimings(ctx, static_cast<int>(code));
+
+                if (scheduleRetry(ctx, result, static_cast<int>(code)))
+                    continue;
+
+                // Make streamed bytes visible to the callback (size checks, rename).
+                if (ctx->sink)
+                    std::fflush(ctx->sink);
+
+                HttpResponse resp;
                 resp.status_code = static_cast<int>(code);
                 resp.body = std::move(ctx->response_body);
-                if (msg->data.result != CURLE_OK)
-                    resp.error = curl_easy_strerror(msg->data.result);
-
-                curl_multi_remove_handle(multi, easy);
-                if (ctx->headers)
-                    curl_slist_free_all(ctx->headers);
-                curl_easy_cleanup(easy);
+                resp.headers = std::move(ctx->response_headers);
+                if (result != CURLE_OK) {
+                    resp.error = curl_easy_strerror(result);
+                    ++stat_failed;
+                } else if (ctx->file && ctx->on_progress) {
+                    reportProgress(ctx, ctx->file_length, ctx->file_length);
+                }
 
                 if (ctx->callback)
                     ctx->callback(std::move(resp));
-                delete ctx;
+                releaseCtx(ctx);
+            }
+        }
+    }
+
+    void recordBodyBytes(RequestCtx* ctx) {
+        curl_off_t sent = 0;
+        curl_off_t received = 0;
+        curl_easy_getinfo(ctx->easy, CURLINFO_SIZE_UPLOAD_T, &sent);
+        curl_easy_getinfo(ctx->easy, CURLINFO_SIZE_DOWNLOAD_T, &received);
+        stat_request_body_bytes += static_cast<uint64_t>(ctx->body_bytes);
+        stat_request_wire_bytes += static_cast<uint64_t>(sent);
+        stat_response_body_bytes +=
+            ctx->response_body.size() + static_cast<uint64_t>(ctx->sink_written + ctx->streamed);
+        stat_response_wire_bytes += static_cast<uint64_t>(received);
+    }
+
+    void recordTimings(RequestCtx* ctx, int status_code) {
+        // All CURLINFO times are measured from the start of the attempt.
+        curl_off_t dns = 0, connect = 0, tls = 0, pretransfer = 0, first_byte = 0, total = 0;
+        curl_easy_getinfo(ctx->easy, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+        curl_easy_getinfo(ctx->easy, CURLINFO_CONNECT_TIME_T, &connect);
+        curl_easy_getinfo(ctx->easy, CURLINFO_APPCONNECT_TIME_T, &tls);
+        curl_easy_getinfo(ctx->easy, CURLINFO_PRETRANSFER_TIME_T, &pretransfer);
+        curl_easy_getinfo(ctx->easy, CURLINFO_STARTTRANSFER_TIME_T, &first_byte);
+        curl_easy_getinfo(ctx->easy, CURLINFO_TOTAL_TIME_T, &total);
+
+        long new_connections = 0;
+        curl_off_t sent = 0;
+        curl_off_t received = 0;
+        curl_easy_getinfo(ctx->easy, CURLINFO_NUM_CONNECTS, &new_connections);
+        curl_easy_getinfo(ctx->easy, CURLINFO_SIZE_UPLOAD_T, &sent);
+        curl_easy_getinfo(ctx->easy, CURLINFO_SIZE_DOWNLOAD_T, &received);
+
+        route_metrics.record(
+            ctx->route,
+            HttpAttemptSample{
+                .status_code = status_code,
+                .new_connection = new_connections > 0,
+                .dns_us = dns,
+                .connect_us = connect - dns,
+                .tls_us = tls > 0 ? tls - connect : 0,
+                .ttfb_us = first_byte - pretransfer,
+                .total_us = total,
+                .bytes_sent = static_cast<uint64_t>(sent),
+                .bytes_received = static_cast<uint64_t>(received),
             }
+        );
+    }
+
+    // Replaces ctx->body with its gzip encoding when the request or its route
+    // opts in and compression actually saves bytes.
+    bool maybeCompressBody(RequestCtx* ctx, const HttpRequest& request) {
+        if (ctx->body.empty() || ctx->method == HttpMethod::Get || ctx->method == HttpMethod::Delete)
+            return false;
+
+        bool wanted = false;
+        {
+            std::lock_guard<std::mutex> lk(defaults_mutex);
+            if (request.compress_body.has_value()) {
+                wanted = *request.compress_body;
+            } else if (compression.enabled && ctx->body.size() >= compression.min_body_bytes) {
+                wanted = std::any_of(compression.routes.begin(), compression.routes.end(), [&](const auto& route) {
+                    return routeMatches(request.path, route);
+                });
+            }
+        }
+        if (!wanted)
+            return false;
+
+#ifdef ANYCHAT_HAVE_ZLIB
+        std::string gz;
+        if (!gzipCompress(ctx->body, gz) || gz.size() >= ctx->body.size())
+            return false;
+        ctx->body = std::move(gz);
+        ++stat_compressed_requests;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    int nextWaitMs() const {
+        if (delayed.empty())
+            return kMaxIdleWaitMs;
+        const auto until = std::chrono::duration_cast<std::chrono::milliseconds>(delayed.front()->due - Clock::now());
+        return static_cast<int>(std::clamp<int64_t>(until.count(), 0, kMaxIdleWaitMs));
+    }
+
+    void startAttempt(RequestCtx* ctx) {
+        ++ctx->attempt;
+        ++stat_attempts;
+
+        // Never let a single attempt outlive the overall deadline.
+        long timeout_ms = ctx->timeouts.total_timeout_ms;
+        if (ctx->has_deadline) {
+            const auto remaining =
+                std::chrono::duration_cast<std::chrono::milliseconds>(ctx->deadline - Clock::now()).count();
+            if (timeout_ms <= 0 || remaining < timeout_ms)
+                timeout_ms = static_cast<long>(std::max<int64_t>(remaining, 1));
+        }
+        curl_easy_setopt(ctx->easy, CURLOPT_TIMEOUT_MS, timeout_ms);
+
+        ctx->response_body.clear();
+        ctx->response_headers.clear();
+        ctx->last_progress = -1;
+        if (ctx->file) {
+            seekFile(ctx->file, ctx->file_offset);
+            ctx->file_read = 0;
+        }
+        if (ctx->sink) {
+            seekFile(ctx->sink, ctx->sink_offset);
+            ctx->sink_written = 0;
+        }
+        curl_multi_add_handle(multi, ctx->easy);
+        in_flight.insert(ctx);
+    }
+
+    // Returns true when |ctx| has been parked for another attempt.
+    bool scheduleRetry(RequestCtx* ctx, CURLcode result, int status_code) {
+        const RetryPolicy& policy = ctx->retry;
+        if (ctx->attempt >= policy.max_attempts || ctx->streamed > 0)
+            return false;
+
+        const bool idempotent = isIdempotent(ctx->method, policy);
+        bool retryable = false;
+        if (result != CURLE_OK) {
+            retryable = isConnectFailure(result) || (idempotent && isTransientTransportError(result));
+        } else {
+            retryable = idempotent && isRetryableStatus(policy, status_code);
+        }
+        if (!retryable)
+            return false;
+
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        int64_t delay_ms = computeBackoffMs(policy, ctx->attempt, dist(rng));
+
+        // Honour Retry-After on 429/503, but give up rather than wait longer
+        // than the policy allows.
+        curl_off_t retry_after_s = 0;
+        if (result == CURLE_OK && curl_easy_getinfo(ctx->easy, CURLINFO_RETRY_AFTER, &retry_after_s) == CURLE_OK
+            && retry_after_s > 0) {
+            const int64_t retry_after_ms = static_cast<int64_t>(retry_after_s) * 1000;
+            if (retry_after_ms > policy.max_backoff_ms)
+                return false;
+            delay_ms = std::max(delay_ms, retry_after_ms);
+        }
+
+        const auto due = Clock::now() + std::chrono::milliseconds(delay_ms);
+        if (ctx->has_deadline && due >= ctx->deadline) {
+            ++stat_deadline_exceeded;
+            return false;
+        }
+
+        ++stat_retries;
+        ctx->due = due;
+        delayed.push_back(ctx);
+        std::push_heap(delayed.begin(), delayed.end(), DueLater{});
+        return true;
+    }
+
+    // Opens |body| and validates the requested range; on failure the reason
+    // is recorded in setup_error and delivered from the worker thread.
+    static void openFileBody(RequestCtx* ctx, const HttpFileBody& body) {
+        if (ctx->method != HttpMethod::Put && ctx->method != HttpMethod::Post) {
+            ctx->setup_error = "file body requires PUT or POST";
+            return;
+        }
+        ctx->file = std::fopen(body.path.c_str(), "rb");
+        if (!ctx->file || !seekFile(ctx->file, 0, SEEK_END)) {
+            ctx->setup_error = "cannot open file: " + body.path;
+            return;
+        }
+        const int64_t file_size = tellFile(ctx->file);
+        const int64_t available = file_size - body.offset;
+        if (body.offset < 0 || available < 0 || (body.length >= 0 && body.length > available)) {
+            ctx->setup_error = "file range out of bounds: " + body.path;
+            return;
         }
+        ctx->file_offset = body.offset;
+        ctx->file_length = body.length >= 0 ? body.length : available;
     }
 
-    void enqueue(Method method, const std::string& path, std::string body, HttpCallback cb) {
+    static void openFileSink(RequestCtx* ctx, const HttpFileSink& sink) {
+        ctx->sink = std::fopen(sink.path.c_str(), "r+b");
+        if (!ctx->sink) {
+            ctx->setup_error = "cannot open file for writing: " + sink.path;
+            return;
+        }
+        ctx->sink_offset = sink.offset;
+        ctx->sink_max = sink.max_bytes;
+    }
+
+    void enqueue(HttpRequest request, HttpCallback cb) {
         auto* ctx = new RequestCtx;
-        ctx->body = std::move(body);
+        ctx->method = request.method;
+        ctx->body = std::move(request.body);
         ctx->callback = std::move(cb);
+        ctx->on_progress = std::move(request.on_progress);
+        ctx->route = std::string(methodName(request.method)) + " "
+                     + (request.route.empty() ? normalizeRoute(request.path) : request.route);
+        if (!request.file_sink)
+            ctx->on_body_data = std::move(request.on_body_data);
+        if (request.file_body)
+            openFileBody(ctx, *request.file_body);
+        if (request.file_sink && ctx->setup_error.empty())
+            openFileSink(ctx, *request.file_sink);
+        {
+            std::lock_guard<std::mutex> lk(defaults_mutex);
+            const RttStats measured = rtt ? rtt->stats() : RttStats{};
+            ctx->retry = request.retry ? std::move(*request.retry) : adaptRetryPolicy(default_retry, measured);
+            ctx->timeouts = request.timeouts ? *request.timeouts : adaptTimeouts(default_timeouts, measured);
+        }
+        if (ctx->retry.deadline_ms > 0) {
+            ctx->has_deadline = true;
+            ctx->deadline = Clock::now() + std::chrono::milliseconds(ctx->retry.deadline_ms);
+        }
         ctx->easy = curl_easy_init();
 
+        const std::string& path = request.path;
         const std::string url = isAbsoluteUrl(path) ? path : (base_url + path);
         curl_easy_setopt(ctx->easy, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(ctx->easy, CURLOPT_WRITEFUNCTION, write_cb);
-        curl_easy_setopt(ctx->easy, CURLOPT_WRITEDATA, &ctx->response_body);
+        if (ctx->sink) {
+            curl_easy_setopt(ctx->easy, CURLOPT_WRITEFUNCTION, sink_write_cb);
+            curl_easy_setopt(ctx->easy, CURLOPT_WRITEDATA, ctx);
+        } else if (ctx->on_body_data) {
+            curl_easy_setopt(ctx->easy, CURLOPT_WRITEFUNCTION, stream_write_cb);
+            curl_easy_setopt(ctx->easy, CURLOPT_WRITEDATA, ctx);
+        } else {
+            curl_easy_setopt(ctx->easy, CURLOPT_WRITEFUNCTION, write_cb);
+            curl_easy_setopt(ctx->easy, CURLOPT_WRITEDATA, &ctx->response_body);
+        }
+        curl_easy_setopt(ctx->easy, CURLOPT_HEADERFUNCTION, header_cb);
+        curl_easy_setopt(ctx->easy, CURLOPT_HEADERDATA, &ctx->response_headers);
         curl_easy_setopt(ctx->easy, CURLOPT_PRIVATE, ctx);
         curl_easy_setopt(ctx->easy, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(ctx->easy, CURLOPT_TIMEOUT_MS, 30000L);
+        curl_easy_setopt(ctx->easy, CURLOPT_NOSIGNAL, 1L);
+
+        // Timeouts (CURLOPT_TIMEOUT_MS is set per attempt in startAttempt)
+        const HttpTimeouts& t = ctx->timeouts;
+        if (t.connect_timeout_ms > 0)
+            curl_easy_setopt(ctx->easy, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(t.connect_timeout_ms));
+        if (t.low_speed_time_s > 0 && t.low_speed_limit_bytes > 0) {
+            curl_easy_setopt(ctx->easy, CURLOPT_LOW_SPEED_LIMIT, static_cast<long>(t.low_speed_limit_bytes));
+            curl_easy_setopt(ctx->easy, CURLOPT_LOW_SPEED_TIME, static_cast<long>(t.low_speed_time_s));
+        }
+
+        if (request.max_send_bytes_per_sec > 0) {
+            curl_easy_setopt(
+                ctx->easy,
+                CURLOPT_MAX_SEND_SPEED_LARGE,
+                static_cast<curl_off_t>(request.max_send_bytes_per_sec)
+            );
+        }
 
         const bool absolute_url = isAbsoluteUrl(path);
+        ctx->body_bytes = ctx->file ? ctx->file_length : static_cast<int64_t>(ctx->body.size());
+        const bool compressed = !absolute_url && !ctx->file && maybeCompressBody(ctx, request);
+
+        // API responses are decoded transparently by libcurl (every coding it
+        // was built with). Storage URLs are left alone: Range requests against
+        // a content-coded representation would address the wrong bytes.
+        if (!absolute_url)
+            curl_easy_setopt(ctx->easy, CURLOPT_ACCEPT_ENCODING, "");
 
         // Headers
         curl_slist* hdrs = nullptr;
         if (absolute_url) {
-            if (method == Method::PUT) {
+            if (ctx->method == HttpMethod::Put) {
                 hdrs = curl_slist_append(hdrs, "Content-Type: application/octet-stream");
             }
         } else {
             hdrs = curl_slist_append(hdrs, "Content-Type: application/json");
             hdrs = curl_slist_append(hdrs, "Accept: application/json");
+            if (compressed)
+                hdrs = curl_slist_append(hdrs, "Content-Encoding: gzip");
             {
                 std::lock_guard<std::mutex> lk(token_mutex);
                 if (!auth_token.empty()) {
@@ -151,34 +754,67 @@ struct HttpClient::Impl {
                 }
             }
         }
+        if (ctx->file) {
+            // Skip the 100-continue round trip; the body is already known to be wanted.
+            hdrs = curl_slist_append(hdrs, "Expect:");
+        }
+        for (const auto& header : request.headers)
+            hdrs = curl_slist_append(hdrs, header.c_str());
         curl_easy_setopt(ctx->easy, CURLOPT_HTTPHEADER, hdrs);
         ctx->headers = hdrs;
 
+        if (ctx->on_progress) {
+            curl_easy_setopt(ctx->easy, CURLOPT_XFERINFOFUNCTION, xferinfo_cb);
+            curl_easy_setopt(ctx->easy, CURLOPT_XFERINFODATA, ctx);
+            curl_easy_setopt(ctx->easy, CURLOPT_NOPROGRESS, 0L);
+        }
+
+        if (ctx->file) {
+            curl_easy_setopt(ctx->easy, CURLOPT_READFUNCTION, read_cb);
+            curl_easy_setopt(ctx->easy, CURLOPT_READDATA, ctx);
+            curl_easy_setopt(ctx->easy, CURLOPT_SEEKFUNCTION, seek_cb);
+            curl_easy_setopt(ctx->easy, CURLOPT_SEEKDATA, ctx);
+            if (ctx->method == HttpMethod::Put) {
+                curl_easy_setopt(ctx->easy, CURLOPT_UPLOAD, 1L);
+                curl_easy_setopt(ctx->easy, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(ctx->file_length));
+            } else {
+                curl_easy_setopt(ctx->easy, CURLOPT_POST, 1L);
+                curl_easy_setopt(ctx->easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(ctx->file_length));
+            }
+            enqueueCtx(ctx);
+            return;
+        }
+
         // Method-specific options
-        switch (method) {
-            case Method::POST:
+        switch (ctx->method) {
+            case HttpMethod::Post:
                 curl_easy_setopt(ctx->easy, CURLOPT_POST, 1L);
                 curl_easy_setopt(ctx->easy, CURLOPT_POSTFIELDS, ctx->body.c_str());
                 curl_easy_setopt(ctx->easy, CURLOPT_POSTFIELDSIZE, static_cast<long>(ctx->body.size()));
                 break;
-            case Method::PUT:
+            case HttpMethod::Put:
                 curl_easy_setopt(ctx->easy, CURLOPT_CUSTOMREQUEST, "PUT");
                 curl_easy_setopt(ctx->easy, CURLOPT_POSTFIELDS, ctx->body.c_str());
                 curl_easy_setopt(ctx->easy, CURLOPT_POSTFIELDSIZE, static_cast<long>(ctx->body.size()));
                 break;
-            case Method::PATCH:
+            case HttpMethod::Patch:
                 curl_easy_setopt(ctx->easy, CURLOPT_CUSTOMREQUEST, "PATCH");
                 curl_easy_setopt(ctx->easy, CURLOPT_POSTFIELDS, ctx->body.c_str());
                 curl_easy_setopt(ctx->easy, CURLOPT_POSTFIELDSIZE, static_cast<long>(ctx->body.size()));
                 break;
-            case Method::DEL:
+            case HttpMethod::Delete:
                 curl_easy_setopt(ctx->easy, CURLOPT_CUSTOMREQUEST, "DELETE");
                 break;
-            case Method::GET:
+            case HttpMethod::Get:
             default:
                 break;
         }
 
+        enqueueCtx(ctx);
+    }
+
+    void enqueueCtx(RequestCtx* ctx) {
+        ++stat_requests;
         std::lock_guard<std::mutex> lk(queue_mutex);
         pending.push(ctx);
     }
@@ -201,24 +837,72 @@ void HttpClient::clearAuthToken() {
     impl_->auth_token.clear();
 }
 
+void HttpClient::setDefaultRetryPolicy(RetryPolicy policy) {
+    std::lock_guard<std::mutex> lk(impl_->defaults_mutex);
+    impl_->default_retry = std::move(policy);
+}
+
+void HttpClient::setDefaultTimeouts(HttpTimeouts timeouts) {
+    std::lock_guard<std::mutex> lk(impl_->defaults_mutex);
+    impl_->default_timeouts = timeouts;
+}
+
+void HttpClient::setRttEstimator(std::shared_ptr<const RttEstimator> rtt) {
+    std::lock_guard<std::mutex> lk(impl_->defaults_mutex);
+    impl_->rtt = std::move(rtt);
+}
+
+void HttpClient::setCompression(HttpCompressionOptions options) {
+    std::lock_guard<std::mutex> lk(impl_->defaults_mutex);
+    impl_->compression = std::move(options);
+}
+
 void HttpClient::get(const std::string& path, HttpCallback cb) {
-    impl_->enqueue(Method::GET, path, {}, std::move(cb));
+    impl_->enqueue({ .method = HttpMethod::Get, .path = path }, std::move(cb));
 }
 
 void HttpClient::post(const std::string& path, const std::string& body, HttpCallback cb) {
-    impl_->enqueue(Method::POST, path, body, std::move(cb));
+    impl_->enqueue({ .method = HttpMethod::Post, .path = path, .body = body }, std::move(cb));
 }
 
 void HttpClient::put(const std::string& path, const std::string& body, HttpCallback cb) {
-    impl_->enqueue(Method::PUT, path, body, std::move(cb));
+    impl_->enqueue({ .method = HttpMethod::Put, .path = path, .body = body }, std::move(cb));
 }
 
 void HttpClient::patch(const std::string& path, const std::string& body, HttpCallback cb) {
-    impl_->enqueue(Method::PATCH, path, body, std::move(cb));
+    impl_->enqueue({ .method = HttpMethod::Patch, .path = path, .body = body }, std::move(cb));
 }
 
 void HttpClient::del(const std::string& path, HttpCallback cb) {
-    impl_->enqueue(Method::DEL, path, {}, std::move(cb));
+    impl_->enqueue({ .method = HttpMethod::Delete, .path = path }, std::move(cb));
+}
+
+void HttpClient::send(HttpRequest request, HttpCallback cb) {
+    impl_->enqueue(std::move(request), std::move(cb));
+}
+
+HttpStats HttpClient::stats() const {
+    HttpStats s;
+    s.requests = impl_->stat_requests.load();
+    s.attempts = impl_->stat_attempts.load();
+    s.retries = impl_->stat_retries.load();
+    s.timeouts = impl_->stat_timeouts.load();
+    s.deadline_exceeded = impl_->stat_deadline_exceeded.load();
+    s.failed = impl_->stat_failed.load();
+    s.request_body_bytes = impl_->stat_request_body_bytes.load();
+    s.request_wire_bytes = impl_->stat_request_wire_bytes.load();
+    s.response_body_bytes = impl_->stat_response_body_bytes.load();
+    s.response_wire_bytes = impl_->stat_response_wire_bytes.load();
+    s.compressed_requests = impl_->stat_compressed_requests.load();
+    return s;
+}
+
+std::vector<HttpRouteStats> HttpClient::routeStats() const {
+    return impl_->route_metrics.snapshot();
+}
+
+void HttpClient::resetRouteStats() {
+    impl_->route_metrics.reset();
 }
 
 } // namespace anychat::network
@@ -1,20 +1,176 @@
 #pragma once
 
+#include "http_metrics.h"
+#include "rtt_estimator.h"
+
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace anychat {
 namespace network {
 
+enum class HttpMethod
+{
+    Get,
+    Post,
+    Put,
+    Patch,
+    Delete
+};
+
 struct HttpResponse {
     int status_code = 0;
     std::string body;
     std::string error; // non-empty on transport failure (not HTTP errors)
+    std::unordered_map<std::string, std::string> headers; // names lower-cased
+
+    std::string header(const std::string& name) const {
+        auto it = headers.find(name);
+        return it == headers.end() ? std::string{} : it->second;
+    }
 };
 
 using HttpCallback = std::function<void(HttpResponse)>;
 
+// Bytes transferred so far and the expected total (0 when unknown).
+using HttpProgressCallback = std::function<void(int64_t transferred, int64_t total)>;
+
+// Receives a 2xx response body chunk by chunk as it arrives. Returning false
+// aborts the transfer.
+using HttpBodyDataCallback = std::function<bool(std::string_view chunk)>;
+
+// A byte range of a local file streamed as the request body, so large
+// uploads never have to be held in memory.
+struct HttpFileBody {
+    std::string path;
+    int64_t offset = 0;
+    int64_t length = -1; // -1: until end of file
+};
+
+// Streams a 2xx response body into a local file (which must already exist)
+// at |offset| instead of collecting it in HttpResponse::body. Non-2xx bodies
+// still land in HttpResponse::body. Each attempt rewrites from |offset|.
+struct HttpFileSink {
+    std::string path;
+    int64_t offset = 0;
+    int64_t max_bytes = -1; // fail the transfer if the body is larger, -1 = no limit
+};
+
+// Per-attempt transfer limits. The connect and low-speed limits fail a stalled
+// attempt early instead of letting it run into the total timeout.
+struct HttpTimeouts {
+    int connect_timeout_ms = 10000;
+    int total_timeout_ms = 30000; // 0 = no limit
+    int low_speed_limit_bytes = 1; // abort when slower than this many bytes/s ...
+    int low_speed_time_s = 20; // ... for this many seconds (0 disables)
+};
+
+// Declarative retry behaviour for one request.
+//
+// Requests are only retried when it is safe to do so: idempotent requests on
+// transport failures and retryable status codes, non-idempotent requests only
+// when the connection could not be established (the server never saw them).
+struct RetryPolicy {
+    int max_attempts = 3; // 1 disables retries
+    std::optional<bool> idempotent; // unset: derived from the HTTP method
+    int base_backoff_ms = 200;
+    int max_backoff_ms = 5000;
+    double jitter = 0.5; // fraction of each delay that is randomised, 0..1
+    std::vector<int> retryable_status = { 408, 429, 500, 502, 503, 504 };
+    int deadline_ms = 0; // budget across all attempts and back-offs, 0 = none
+};
+
+struct HttpRequest {
+    HttpMethod method = HttpMethod::Get;
+    std::string path; // relative to base_url, or an absolute http(s) URL
+    std::string body;
+    std::optional<RetryPolicy> retry; // unset: client default
+    std::optional<HttpTimeouts> timeouts; // unset: client default
+
+    // Extra request headers, e.g. "Range: bytes=0-1023".
+    std::vector<std::string> headers;
+
+    // PUT/POST only: stream the body from disk instead of |body|.
+    std::optional<HttpFileBody> file_body;
+
+    // Write the response body to disk instead of memory.
+    std::optional<HttpFileSink> file_sink;
+
+    // Hand the 2xx response body to a consumer instead of collecting it in
+    // HttpResponse::body (non-2xx bodies are still collected). Ignored when
+    // file_sink is set. An attempt that already delivered bytes is never
+    // retried, so the consumer sees each byte once.
+    HttpBodyDataCallback on_body_data;
+
+    // gzip the body (Content-Encoding: gzip). Unset: decided by the client's
+    // HttpCompressionOptions for this route. Ignored for file bodies, absolute
+    // URLs and when the SDK is built without zlib.
+    std::optional<bool> compress_body;
+
+    // Upload bandwidth cap for this transfer (CURLOPT_MAX_SEND_SPEED_LARGE),
+    // 0 = unlimited.
+    int64_t max_send_bytes_per_sec = 0;
+
+    // Upload progress when file_body is set, download progress otherwise.
+    // Reported from the worker thread, throttled to coarse steps.
+    HttpProgressCallback on_progress;
+
+    // Route template the timings are recorded under, e.g. "/users/{id}".
+    // Empty: derived from |path| with normalizeRoute().
+    std::string route;
+};
+
+// Request-body compression for JSON API calls. Responses are always
+// negotiated (Accept-Encoding) independently of this.
+struct HttpCompressionOptions {
+    bool enabled = false; // the server must accept Content-Encoding: gzip
+    size_t min_body_bytes = 4096; // smaller bodies are not worth the CPU
+    std::vector<std::string> routes = { "/sync" }; // path prefixes that opt in
+};
+
+struct HttpStats {
+    uint64_t requests = 0; // logical requests submitted
+    uint64_t attempts = 0; // transfers started, including retries
+    uint64_t retries = 0;
+    uint64_t timeouts = 0; // attempts that ended in a curl timeout
+    uint64_t deadline_exceeded = 0; // requests abandoned because of deadline_ms
+    uint64_t failed = 0; // requests completed with a transport error
+
+    // Body bytes of completed attempts, before/after content coding.
+    uint64_t request_body_bytes = 0; // as handed to the client
+    uint64_t request_wire_bytes = 0; // as sent, after compression
+    uint64_t response_body_bytes = 0; // after decoding
+    uint64_t response_wire_bytes = 0; // as received
+    uint64_t compressed_requests = 0;
+};
+
+// Delay before retry number |retry| (1-based) with exponential growth capped at
+// max_backoff_ms. |random01| in [0, 1) selects the jittered part of the delay.
+int computeBackoffMs(const RetryPolicy& policy, int retry, double random01);
+
+bool isRetryableStatus(const RetryPolicy& policy, int status_code);
+
+bool isIdempotent(HttpMethod method, const RetryPolicy& policy);
+
+// Round trips a new connection needs before the request goes out (TCP, then
+// a TLS 1.2 handshake).
+constexpr int kConnectRoundTrips = 3;
+
+// Stretches |timeouts| for a slow network: the connect limit allows
+// kConnectRoundTrips RTOs and the total limit grows by as much. Never
+// shortens a limit or enables a disabled one; unchanged without samples.
+HttpTimeouts adaptTimeouts(HttpTimeouts timeouts, const RttStats& rtt);
+
+// The first back-off is no shorter than one smoothed RTT: retrying sooner
+// only queues behind the attempt that just failed.
+RetryPolicy adaptRetryPolicy(RetryPolicy policy, const RttStats& rtt);
+
 // Async HTTP client backed by libcurl CURLM (multi interface).
 // All callbacks are invoked from an internal worker thread.
 class HttpClient {
@@ -29,6 +185,18 @@ public:
     void setAuthToken(const std::string& token);
     void clearAuthToken();
 
+    // Defaults for requests that do not carry their own policy/timeouts.
+    void setDefaultRetryPolicy(RetryPolicy policy);
+    void setDefaultTimeouts(HttpTimeouts timeouts);
+
+    // Requests without their own policy/timeouts get the defaults passed
+    // through adaptTimeouts()/adaptRetryPolicy() with this estimate. The
+    // WebSocket heartbeat feeds it; it describes the device's network
+    // rather than the API host, which is close enough to size timeouts.
+    void setRttEstimator(std::shared_ptr<const RttEstimator> rtt);
+
+    void setCompression(HttpCompressionOptions options);
+
     // Async HTTP methods. |path| is appended to the base_url set at construction.
     // |body| for POST/PUT must be a JSON string.
     void get(const std::string& path, HttpCallback cb);
@@ -37,6 +205,17 @@ public:
     void patch(const std::string& path, const std::string& body, HttpCallback cb);
     void del(const std::string& path, HttpCallback cb);
 
+    // Generic entry point used by the helpers above; |cb| receives the result of
+    // the last attempt.
+    void send(HttpRequest request, HttpCallback cb);
+
+    HttpStats stats() const;
+
+    // Per-route timings and status codes of every attempt, keyed by
+    // "METHOD /route/{id}".
+    std::vector<HttpRouteStats> routeStats() const;
+    void resetRouteStats();
+
 private:
     struct Impl;
     std::unique_ptr<Impl> impl_;
@@ -0,0 +1,116 @@
+#include "http_metrics.h"
+
+#include <algorithm>
+
+namespace anychat::network {
+
+namespace {
+
+constexpr size_t kMaxNamedSegmentLength = 24;
+
+bool isIdSegment(const std::string& segment) {
+    if (segment.size() > kMaxNamedSegmentLength)
+        return true;
+    return std::any_of(segment.begin(), segment.end(), [](char c) {
+        return !((c >= 'a' && c <= 'z') || c == '_' || c == '-');
+    });
+}
+
+} // namespace
+
+void LatencyHistogram::record(int64_t us) {
+    us = std::max<int64_t>(us, 0);
+    const auto bucket = std::lower_bound(kBoundsMs.begin(), kBoundsMs.end(), us, [](int64_t bound_ms, int64_t value) {
+        return bound_ms * 1000 < value;
+    });
+    ++buckets[static_cast<size_t>(bucket - kBoundsMs.begin())];
+    ++count;
+    sum_us += us;
+    max_us = std::max(max_us, us);
+}
+
+double LatencyHistogram::meanMs() const {
+    return count == 0 ? 0.0 : static_cast<double>(sum_us) / static_cast<double>(count) / 1000.0;
+}
+
+double LatencyHistogram::quantileMs(double q) const {
+    if (count == 0)
+        return 0.0;
+    const auto rank = static_cast<uint64_t>(std::max(q, 0.0) * static_cast<double>(count) + 0.5);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBoundsMs.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= std::max<uint64_t>(rank, 1))
+            return std::min(static_cast<double>(kBoundsMs[i]), static_cast<double>(max_us) / 1000.0);
+    }
+    return static_cast<double>(max_us) / 1000.0;
+}
+
+std::string normalizeRoute(const std::string& path) {
+    const size_t scheme = path.find("://");
+    if (scheme != std::string::npos) {
+        // Storage and CDN URLs: object keys and signatures carry no route.
+        const size_t path_start = path.find('/', scheme + 3);
+        return path.substr(0, path_start) + "/*";
+    }
+
+    const std::string bare = path.substr(0, path.find_first_of("?#"));
+    std::string route;
+    size_t pos = 0;
+    while (pos < bare.size()) {
+        const size_t slash = bare.find('/', pos);
+        const size_t end = slash == std::string::npos ? bare.size() : slash;
+        const std::string segment = bare.substr(pos, end - pos);
+        if (!segment.empty())
+            route += '/' + (isIdSegment(segment) ? std::string("{id}") : segment);
+        pos = end + 1;
+    }
+    return route.empty() ? "/" : route;
+}
+
+void HttpRouteMetrics::record(const std::string& route, const HttpAttemptSample& sample) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = routes_.find(route);
+    if (it == routes_.end()) {
+        const std::string& key = routes_.size() < kMaxRoutes ? route : std::string(kOverflowRoute);
+        it = routes_.try_emplace(key).first;
+        it->second.route = key;
+    }
+
+    HttpRouteStats& stats = it->second;
+    ++stats.attempts;
+    ++stats.status_codes[sample.status_code];
+    stats.bytes_sent += sample.bytes_sent;
+    stats.bytes_received += sample.bytes_received;
+    if (sample.new_connection) {
+        ++stats.new_connections;
+        stats.dns.record(sample.dns_us);
+        stats.connect.record(sample.connect_us);
+        if (sample.tls_us > 0)
+            stats.tls.record(sample.tls_us);
+    }
+    if (sample.status_code != 0)
+        stats.ttfb.record(sample.ttfb_us);
+    stats.total.record(sample.total_us);
+}
+
+std::vector<HttpRouteStats> HttpRouteMetrics::snapshot() const {
+    std::vector<HttpRouteStats> out;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out.reserve(routes_.size());
+        for (const auto& [route, stats] : routes_)
+            out.push_back(stats);
+    }
+    std::sort(out.begin(), out.end(), [](const HttpRouteStats& a, const HttpRouteStats& b) {
+        return a.route < b.route;
+    });
+    return out;
+}
+
+void HttpRouteMetrics::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    routes_.clear();
+}
+
+} // namespace anychat::network
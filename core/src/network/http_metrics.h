@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace anychat {
+namespace network {
+
+// Latency distribution over fixed buckets. Bucket i counts samples above
+// kBoundsMs[i - 1] and up to kBoundsMs[i]; the last bucket counts the rest.
+struct LatencyHistogram {
+    static constexpr std::array<int64_t, 13> kBoundsMs = {
+        1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000,
+    };
+
+    std::array<uint64_t, kBoundsMs.size() + 1> buckets{};
+    uint64_t count = 0;
+    int64_t sum_us = 0;
+    int64_t max_us = 0;
+
+    void record(int64_t us);
+
+    double meanMs() const;
+
+    // Upper bound of the bucket holding the |q| quantile (0 < q <= 1), so an
+    // estimate that errs high; the overflow bucket reports the maximum.
+    double quantileMs(double q) const;
+};
+
+// One transfer attempt as reported by CURLINFO_*_TIME_T.
+struct HttpAttemptSample {
+    int status_code = 0; // 0: no HTTP response (transport error)
+    bool new_connection = false; // false: reused a kept-alive connection
+    int64_t dns_us = 0;
+    int64_t connect_us = 0; // TCP handshake, after DNS
+    int64_t tls_us = 0; // TLS handshake, 0 for plain HTTP
+    int64_t ttfb_us = 0; // request ready to first response byte
+    int64_t total_us = 0;
+    uint64_t bytes_sent = 0; // on the wire
+    uint64_t bytes_received = 0; // on the wire
+};
+
+// Timings of all attempts for one route template. dns, connect and tls only
+// hold attempts that opened a new connection; ttfb is server time plus one
+// round trip, so it separates a slow backend from a slow network.
+struct HttpRouteStats {
+    std::string route; // "GET /conversations/{id}"
+    uint64_t attempts = 0;
+    uint64_t new_connections = 0;
+    std::map<int, uint64_t> status_codes; // 0: transport error
+    uint64_t bytes_sent = 0;
+    uint64_t bytes_received = 0;
+    LatencyHistogram dns;
+    LatencyHistogram connect;
+    LatencyHistogram tls;
+    LatencyHistogram ttfb;
+    LatencyHistogram total;
+};
+
+// Maps a request path to its route template: the query string is dropped and
+// id-like segments (containing a digit or anything besides [a-z_-], or longer
+// than 24 characters) become "{id}". Absolute URLs collapse to their origin.
+std::string normalizeRoute(const std::string& path);
+
+// Thread-safe per-route aggregation. The number of routes is capped; samples
+// for routes beyond the cap are counted under kOverflowRoute.
+class HttpRouteMetrics {
+public:
+    static constexpr size_t kMaxRoutes = 128;
+    static constexpr const char* kOverflowRoute = "{other}";
+
+    void record(const std::string& route, const HttpAttemptSample& sample);
+
+    // Sorted by route.
+    std::vector<HttpRouteStats> snapshot() const;
+
+    void reset();
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, HttpRouteStats> routes_;
+};
+
+} // namespace network
+} // namespace anychat
@@ -2,31 +2,59 @@
 
 #include <functional>
 #include <string>
+#include <string_view>
 
 namespace anychat {
 namespace network {
 
+// Outbound lanes, sent in this order. See WsSendQueue.
+enum class SendPriority {
+    Control, // heartbeats and one-off commands; never dropped
+    Transient, // superseded state such as typing; oldest dropped when backed up
+    Bulk, // message sends; refused while the queue is congested
+};
+
 // IWebSocketClient — WebSocketClient 的可测试抽象接口。
 // 生产代码使用 WebSocketClient（libwebsockets），
 // 测试代码使用 FakeWebSocketClient。
 class IWebSocketClient {
 public:
-    using MessageHandler = std::function<void(const std::string& msg)>;
+    // |msg| is one complete message; the view is only valid during the call.
+    // |binary|: it arrived in binary frames, text frames otherwise.
+    using MessageHandler = std::function<void(std::string_view msg, bool binary)>;
     using ConnectedHandler = std::function<void()>;
     using DisconnectedHandler = std::function<void()>;
     using ErrorHandler = std::function<void(const std::string& error)>;
+    // Bulk sends are accepted again after a refusal.
+    using DrainedHandler = std::function<void()>;
+    // A pong control frame arrived; |payload| echoes the ping's.
+    using PongHandler = std::function<void(std::string_view payload)>;
 
     virtual ~IWebSocketClient() = default;
 
     virtual void connect() = 0;
     virtual void disconnect() = 0;
-    virtual void send(const std::string& message) = 0;
+    // Queue a text (send) or binary (sendBinary) frame. False if the frame
+    // was refused; bulk senders should wait for the drained handler.
+    virtual bool send(const std::string& message, SendPriority priority = SendPriority::Bulk) = 0;
+    virtual bool sendBinary(const std::string& message, SendPriority priority = SendPriority::Bulk) = 0;
     virtual bool isConnected() const = 0;
 
+    // Send a ping control frame (at most 125 bytes of payload) ahead of all
+    // queued frames; it may go out between the fragments of a large message.
+    // Replaces a ping not yet written. False if not connected.
+    virtual bool sendPing(std::string_view payload) = 0;
+
+    // Subprotocol the server selected for the current connection, "" if it
+    // selected none.
+    virtual std::string subprotocol() const = 0;
+
     virtual void setOnMessage(MessageHandler handler) = 0;
     virtual void setOnConnected(ConnectedHandler handler) = 0;
     virtual void setOnDisconnected(DisconnectedHandler handler) = 0;
     virtual void setOnError(ErrorHandler handler) = 0;
+    virtual void setOnDrained(DrainedHandler handler) = 0;
+    virtual void setOnPong(PongHandler handler) = 0;
 };
 
 } // namespace network
@@ -0,0 +1,185 @@
+#include "json_stream.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace anychat::network {
+
+namespace {
+
+bool isJsonWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+} // namespace
+
+void JsonArrayStreamer::onArray(std::vector<std::string> path, ElementHandler handler) {
+    routes_.push_back(Route{ std::move(path), std::move(handler) });
+}
+
+bool JsonArrayStreamer::feed(std::string_view chunk) {
+    for (const char c : chunk) {
+        if (!error_.empty())
+            return false;
+
+        if (in_string_) {
+            put(c);
+            if (escape_) {
+                escape_ = false;
+            } else if (c == '\\') {
+                escape_ = true;
+            } else if (c == '"') {
+                in_string_ = false;
+                reading_key_ = false;
+                continue;
+            }
+            if (reading_key_)
+                stack_.back().key += c;
+            continue;
+        }
+
+        if (isJsonWhitespace(c)) {
+            // Whitespace between the elements of a selected array is dropped,
+            // so the skeleton always shows it as "[]".
+            const bool between_elements = element_route_ < 0 && !stack_.empty() && stack_.back().route >= 0
+                                          && stack_.size() == element_depth_;
+            if (!between_elements)
+                put(c);
+            continue;
+        }
+        if (done_)
+            return fail("trailing data after JSON document");
+        if (stack_.empty()) {
+            if (c != '{' && c != '[')
+                return fail("expected a JSON object or array");
+            openContainer(c);
+            continue;
+        }
+
+        Frame& top = stack_.back();
+        const bool at_selected_array = top.route >= 0 && stack_.size() == element_depth_;
+        switch (c) {
+            case '{':
+            case '[':
+                openContainer(c);
+                break;
+            case '}':
+            case ']':
+                if (!closeContainer(c))
+                    return false;
+                break;
+            case ',':
+                if (at_selected_array) {
+                    if (element_route_ < 0)
+                        return fail("unexpected ',' in array");
+                    if (!endElement())
+                        return false;
+                    break;
+                }
+                if (top.is_object)
+                    top.expect_key = true;
+                put(c);
+                break;
+            case ':':
+                if (top.is_object)
+                    top.expect_key = false;
+                put(c);
+                break;
+            case '"':
+                if (at_selected_array && element_route_ < 0)
+                    element_route_ = top.route;
+                if (top.is_object && top.expect_key) {
+                    reading_key_ = true;
+                    top.key.clear();
+                }
+                in_string_ = true;
+                put(c);
+                break;
+            default:
+                if (at_selected_array && element_route_ < 0)
+                    element_route_ = top.route;
+                put(c);
+                break;
+        }
+    }
+    return error_.empty();
+}
+
+bool JsonArrayStreamer::finish() {
+    if (!error_.empty())
+        return false;
+    if (!done_ || in_string_)
+        return fail("truncated JSON document");
+    return true;
+}
+
+void JsonArrayStreamer::put(char c) {
+    if (element_route_ >= 0)
+        element_ += c;
+    else
+        skeleton_ += c;
+}
+
+void JsonArrayStreamer::openContainer(char c) {
+    // A container directly inside a selected array starts an element.
+    if (!stack_.empty() && stack_.back().route >= 0 && stack_.size() == element_depth_ && element_route_ < 0)
+        element_route_ = stack_.back().route;
+
+    const int route = (c == '[' && element_route_ < 0) ? matchRoute() : -1;
+    put(c);
+    stack_.push_back(Frame{ .is_object = c == '{', .expect_key = c == '{', .route = route });
+    if (route >= 0)
+        element_depth_ = stack_.size();
+}
+
+bool JsonArrayStreamer::closeContainer(char c) {
+    const Frame& top = stack_.back();
+    if (top.is_object != (c == '}'))
+        return fail(std::string("mismatched '") + c + "'");
+
+    if (top.route >= 0) {
+        if (element_route_ >= 0 && !endElement())
+            return false;
+        element_depth_ = 0;
+    }
+    put(c);
+    stack_.pop_back();
+    done_ = stack_.empty();
+    return true;
+}
+
+bool JsonArrayStreamer::endElement() {
+    while (!element_.empty() && isJsonWhitespace(element_.back()))
+        element_.pop_back();
+
+    const int route = element_route_;
+    element_route_ = -1;
+    ++elements_;
+    peak_element_bytes_ = std::max(peak_element_bytes_, element_.size());
+
+    const bool keep_going = routes_[static_cast<size_t>(route)].handler(element_);
+    element_.clear();
+    return keep_going || fail("element handler aborted the stream");
+}
+
+int JsonArrayStreamer::matchRoute() const {
+    for (size_t i = 0; i < routes_.size(); ++i) {
+        const auto& path = routes_[i].path;
+        if (path.size() != stack_.size())
+            continue;
+        bool match = true;
+        for (size_t depth = 0; depth < path.size() && match; ++depth)
+            match = stack_[depth].is_object && stack_[depth].key == path[depth];
+        if (match)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool JsonArrayStreamer::fail(std::string message) {
+    if (error_.empty())
+        error_ = std::move(message);
+    return false;
+}
+
+} // namespace anychat::network
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace anychat {
+namespace network {
+
+// Splits the elements of selected JSON arrays out of a document while it is
+// still arriving, so large response bodies never have to be held in memory.
+//
+// Arrays are selected by their object-key path from the root, e.g.
+// {"data", "conversations"}. Each of their elements is handed to the handler
+// as soon as its last byte has been fed, as a complete JSON text that can be
+// decoded on its own. Everything outside the selected arrays is kept as the
+// skeleton: the original document with those arrays left empty ("[]"), small
+// enough to decode with the regular envelope structs.
+//
+// This is a splitter, not a validator: it tracks strings and nesting only.
+// Element contents and the skeleton are validated by whoever decodes them.
+// Selected arrays nested inside another selected array are not split.
+class JsonArrayStreamer {
+public:
+    // Returning false aborts the stream; feed() then fails.
+    using ElementHandler = std::function<bool(const std::string& element)>;
+
+    void onArray(std::vector<std::string> path, ElementHandler handler);
+
+    // Returns false once the input is malformed or a handler aborted.
+    bool feed(std::string_view chunk);
+
+    // Returns true if a complete document was fed.
+    bool finish();
+
+    bool failed() const {
+        return !error_.empty();
+    }
+    const std::string& error() const {
+        return error_;
+    }
+
+    const std::string& skeleton() const {
+        return skeleton_;
+    }
+    std::string takeSkeleton() {
+        return std::move(skeleton_);
+    }
+
+    uint64_t elementsDelivered() const {
+        return elements_;
+    }
+
+    // Largest single element buffered so far; a bound on the memory the
+    // streamed arrays needed.
+    size_t peakElementBytes() const {
+        return peak_element_bytes_;
+    }
+
+private:
+    struct Frame {
+        bool is_object = false;
+        bool expect_key = false; // objects: the next string is a key
+        std::string key; // objects: key of the value being read
+        int route = -1; // arrays: index into routes_ when selected
+    };
+
+    struct Route {
+        std::vector<std::string> path;
+        ElementHandler handler;
+    };
+
+    void put(char c);
+    void openContainer(char c);
+    bool closeContainer(char c);
+    bool endElement();
+    int matchRoute() const;
+    bool fail(std::string message);
+
+    std::vector<Route> routes_;
+    std::vector<Frame> stack_;
+    std::string skeleton_;
+    std::string element_;
+    int element_route_ = -1; // route of the element being buffered
+    size_t element_depth_ = 0; // stack size of the selected array
+    bool in_string_ = false;
+    bool escape_ = false;
+    bool reading_key_ = false;
+    bool done_ = false; // root value closed
+    uint64_t elements_ = 0;
+    size_t peak_element_bytes_ = 0;
+    std::string error_;
+};
+
+} // namespace network
+} // namespace anychat
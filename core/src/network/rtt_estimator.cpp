@@ -0,0 +1,40 @@
+#include "rtt_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace anychat::network {
+
+void RttEstimator::addSample(int64_t rtt_ms) {
+    const double r = static_cast<double>(std::max<int64_t>(rtt_ms, 0));
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stats_.samples == 0) {
+        srtt_ = r;
+        rttvar_ = r / 2;
+        stats_.min_ms = static_cast<int>(r);
+    } else {
+        // rttvar uses the srtt from before this sample.
+        rttvar_ = 0.75 * rttvar_ + 0.25 * std::abs(srtt_ - r);
+        srtt_ = 0.875 * srtt_ + 0.125 * r;
+        stats_.min_ms = std::min(stats_.min_ms, static_cast<int>(r));
+    }
+    ++stats_.samples;
+    stats_.last_ms = static_cast<int>(r);
+    stats_.srtt_ms = static_cast<int>(std::lround(srtt_));
+    stats_.rttvar_ms = static_cast<int>(std::lround(rttvar_));
+    stats_.rto_ms = std::max(kMinRtoMs, static_cast<int>(std::lround(srtt_ + 4 * rttvar_)));
+}
+
+RttStats RttEstimator::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void RttEstimator::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = {};
+    srtt_ = 0;
+    rttvar_ = 0;
+}
+
+} // namespace anychat::network
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+namespace anychat {
+namespace network {
+
+// Round-trip estimate of the gateway connection. All fields are 0 until the
+// first sample.
+struct RttStats {
+    uint64_t samples = 0;
+    int last_ms = 0;
+    int min_ms = 0;
+    int srtt_ms = 0; // smoothed RTT
+    int rttvar_ms = 0; // smoothed mean deviation, i.e. the jitter
+    int rto_ms = 0; // srtt + 4 * rttvar, at least RttEstimator::kMinRtoMs
+};
+
+// Smoothed RTT and RTT variation as computed for TCP's retransmission timer
+// (RFC 6298 §2): the first sample seeds srtt = r and rttvar = r / 2, later
+// ones fold in with gains of 1/8 and 1/4. Fed by the heartbeat; read by
+// anything that wants a timeout that follows the network, e.g. HttpClient.
+//
+// Thread-safe.
+class RttEstimator {
+public:
+    static constexpr int kMinRtoMs = 1000;
+
+    void addSample(int64_t rtt_ms);
+
+    RttStats stats() const;
+
+    // Forget all samples, e.g. when the device moves to another network.
+    void reset();
+
+private:
+    mutable std::mutex mutex_;
+    RttStats stats_;
+    double srtt_ = 0;
+    double rttvar_ = 0;
+};
+
+} // namespace network
+} // namespace anychat
@@ -1,11 +1,18 @@
 #include "websocket_client.h"
 
+#include "ws_frame_assembler.h"
+#include "ws_frame_pool.h"
+#include "ws_send_queue.h"
+
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstring>
 #include <mutex>
-#include <queue>
+#include <optional>
+#include <string_view>
 #include <thread>
+#include <vector>
 
 #include <libwebsockets.h>
 
@@ -13,13 +20,24 @@ namespace anychat::network {
 
 // ── constants ─────────────────────────────────────────────────────────────────
 
-static constexpr int HEARTBEAT_INTERVAL_S = 30;
 static constexpr int MAX_RECONNECT = 5;
 static constexpr long RECONNECT_BASE_MS = 1000; // base for 2^n back-off
+static constexpr int MAX_FRAMES_PER_WRITABLE = 16;
+static constexpr size_t MAX_FRAGMENT_BYTES = 16 * 1024; // larger payloads go out in fragments
+static constexpr int MIN_WINDOW_BITS = 9; // zlib does not support raw deflate with 8
+static constexpr int MAX_WINDOW_BITS = 15;
+static constexpr size_t MAX_CONTROL_PAYLOAD = 125; // RFC 6455 §5.5
 
 // ── Impl ──────────────────────────────────────────────────────────────────────
 
 struct WebSocketClient::Impl {
+    // lws timers carry no user pointer. Each one sits first in a
+    // standard-layout holder so its callback can get back to the owner.
+    struct Timer {
+        lws_sorted_usec_list_t sul{}; // must stay the first member
+        Impl* owner = nullptr;
+    };
+
     // ── config ────────────────────────────────────────────────────────────────
     std::string url;
     std::string host;
@@ -27,19 +45,80 @@ struct WebSocketClient::Impl {
     int port = 443;
     bool use_ssl = true;
 
+    // Copied by the service thread when it creates the context.
+    // config_mutex also guards |negotiated_protocol|.
+    mutable std::mutex config_mutex;
+    WebSocketCompressionOptions compression;
+    std::vector<std::string> subprotocols{ "anychat" };
+    std::string negotiated_protocol;
+
     // ── lws objects ──────────────────────────────────────────────────────────
+    // |ctx| is written by the service thread under ctx_mutex; other threads
+    // only use it to wake the loop. |wsi| is service-thread only.
+    std::mutex ctx_mutex;
     lws_context* ctx = nullptr;
     lws* wsi = nullptr;
 
+    // The context keeps pointers into these; service-thread only.
+    std::string deflate_offer;
+    lws_extension extensions[2]{};
+    std::vector<std::string> protocol_names;
+    std::vector<lws_protocols> protocols;
+    std::string protocol_offer; // "a, b" for Sec-WebSocket-Protocol
+
     // ── state ─────────────────────────────────────────────────────────────────
     std::atomic<bool> connected{ false };
     std::atomic<bool> running{ false };
+
+    // Service-thread only.
     int reconnect_count = 0;
-    std::chrono::steady_clock::time_point last_ping;
+    bool reconnect_scheduled = false;
+    Timer reconnect_timer;
+    bool offer_compression = false; // cleared by a handshake failure
+
+    // ── counters (see WebSocketStats) ─────────────────────────────────────────
+    std::atomic<bool> compression_active{ false };
+    std::atomic<uint64_t> compression_fallbacks{ 0 };
+    std::atomic<uint64_t> messages_sent{ 0 };
+    std::atomic<uint64_t> messages_received{ 0 };
+    std::atomic<uint64_t> payload_bytes_sent{ 0 };
+    std::atomic<uint64_t> payload_bytes_received{ 0 };
+    std::atomic<uint64_t> deflate_in_bytes{ 0 };
+    std::atomic<uint64_t> deflate_out_bytes{ 0 };
+    std::atomic<uint64_t> inflate_in_bytes{ 0 };
+    std::atomic<uint64_t> inflate_out_bytes{ 0 };
+    std::atomic<uint64_t> pings_sent{ 0 };
+    std::atomic<uint64_t> pongs_received{ 0 };
 
     // ── outbound queue ────────────────────────────────────────────────────────
-    std::mutex send_mutex;
-    std::queue<std::string> send_queue;
+    // Frames are built LWS_PRE-padded by send(), so writing a message that
+    // fits in one fragment is copy-free.
+    WsFramePool frame_pool{ LWS_PRE };
+    WsSendQueue send_queue{ frame_pool };
+
+    // Service-thread only: the message being written and how much of it is
+    // out. A message cut off by a disconnect is sent again from the start.
+    std::optional<WsFrame> writing;
+    size_t write_offset = 0;
+    // Service-thread only: LWS_PRE-padded copy of the fragment being written
+    // when a message spans several. lws writes frame headers into the bytes
+    // in front of the payload and masks the payload in place, so fragments
+    // never go out of |writing| itself: it has to stay intact for a resend.
+    std::vector<unsigned char> fragment_buf;
+
+    // The next ping; the heartbeat owner decides when. Control frames skip
+    // the send queue.
+    std::mutex ping_mutex;
+    std::atomic<bool> ping_due{ false };
+    std::string ping_payload;
+
+    // ── inbound ───────────────────────────────────────────────────────────────
+    WsFrameAssembler rx; // service-thread only
+
+    // Reading stops while the consumer is backed up. Requested from any
+    // thread, applied on the service thread to the current connection.
+    std::atomic<bool> rx_pause_wanted{ false };
+    bool rx_paused = false; // service-thread only
 
     // ── worker thread ─────────────────────────────────────────────────────────
     std::thread worker;
@@ -50,6 +129,12 @@ struct WebSocketClient::Impl {
     WebSocketClient::ConnectedHandler on_connected;
     WebSocketClient::DisconnectedHandler on_disconnected;
     WebSocketClient::ErrorHandler on_error;
+    WebSocketClient::DrainedHandler on_drained;
+    WebSocketClient::PongHandler on_pong;
+
+    Impl() {
+        reconnect_timer.owner = this;
+    }
 
     // ── parse url ─────────────────────────────────────────────────────────────
     void parse_url() {
@@ -73,6 +158,218 @@ struct WebSocketClient::Impl {
         }
     }
 
+    // ── cross-thread wake-up ──────────────────────────────────────────────────
+    // Safe from any thread: lws_cancel_service() makes the service thread
+    // return from its wait and deliver LWS_CALLBACK_EVENT_WAIT_CANCELLED.
+    void wake() {
+        std::lock_guard<std::mutex> lk(ctx_mutex);
+        if (ctx)
+            lws_cancel_service(ctx);
+    }
+
+    // ── compression ───────────────────────────────────────────────────────────
+    // Builds the permessage-deflate offer. Defaults are left out so the
+    // header stays short; a bare client_max_window_bits tells the server we
+    // accept any window it picks for us.
+    static std::string build_deflate_offer(const WebSocketCompressionOptions& options) {
+        const int client_bits = std::clamp(options.client_max_window_bits, MIN_WINDOW_BITS, MAX_WINDOW_BITS);
+        const int server_bits = std::clamp(options.server_max_window_bits, MIN_WINDOW_BITS, MAX_WINDOW_BITS);
+
+        std::string offer = "permessage-deflate; client_max_window_bits";
+        if (client_bits < MAX_WINDOW_BITS)
+            offer += "=" + std::to_string(client_bits);
+        if (server_bits < MAX_WINDOW_BITS)
+            offer += "; server_max_window_bits=" + std::to_string(server_bits);
+        if (options.client_no_context_takeover)
+            offer += "; client_no_context_takeover";
+        if (options.server_no_context_takeover)
+            offer += "; server_no_context_takeover";
+        return offer;
+    }
+
+    void count_sent(size_t bytes) {
+        payload_bytes_sent += bytes;
+        if (compression_active)
+            deflate_in_bytes += bytes;
+    }
+
+    void count_received(size_t bytes) {
+        payload_bytes_received += bytes;
+        if (compression_active)
+            inflate_out_bytes += bytes;
+    }
+
+#if !defined(LWS_WITHOUT_EXTENSIONS)
+    // Wraps the stock permessage-deflate callback to see the compressed
+    // side of each payload: TX reports what deflate produced, RX how much
+    // compressed input inflate consumed. The uncompressed side is counted
+    // where the payload enters and leaves the client.
+    static int deflate_callback(
+        lws_context* context,
+        const lws_extension* ext,
+        lws* wsi_in,
+        lws_extension_callback_reasons reason,
+        void* user,
+        void* in,
+        size_t len
+    ) {
+        auto* ebufs = static_cast<lws_ext_pm_deflate_rx_ebufs*>(in);
+        const int in_before = (reason == LWS_EXT_CB_PAYLOAD_RX && ebufs) ? ebufs->eb_in.len : 0;
+
+        const int n = lws_extension_callback_pm_deflate(context, ext, wsi_in, reason, user, in, len);
+
+        auto* self = static_cast<Impl*>(lws_context_user(context));
+        if (!self || n < 0)
+            return n;
+        switch (reason) {
+            case LWS_EXT_CB_CLIENT_CONSTRUCT:
+                self->compression_active = true;
+                break;
+            case LWS_EXT_CB_PAYLOAD_TX:
+                if (ebufs && ebufs->eb_out.len > 0)
+                    self->deflate_out_bytes += static_cast<uint64_t>(ebufs->eb_out.len);
+                break;
+            case LWS_EXT_CB_PAYLOAD_RX:
+                if (ebufs && in_before > ebufs->eb_in.len)
+                    self->inflate_in_bytes += static_cast<uint64_t>(in_before - ebufs->eb_in.len);
+                break;
+            default:
+                break;
+        }
+        return n;
+    }
+#endif
+
+    // Safe from any thread.
+    bool enqueue(const std::string& message, bool binary, SendPriority priority) {
+        WsFrame frame = frame_pool.make(message);
+        frame.binary = binary;
+        if (!send_queue.push(std::move(frame), priority))
+            return false;
+        // lws_callback_on_writable() is not thread-safe; let the service
+        // thread request writability itself.
+        wake();
+        return true;
+    }
+
+    // Safe from any thread.
+    bool queue_ping(std::string_view payload) {
+        if (!connected || payload.size() > MAX_CONTROL_PAYLOAD)
+            return false;
+        {
+            std::lock_guard<std::mutex> lk(ping_mutex);
+            ping_payload.assign(payload);
+            ping_due = true;
+        }
+        wake();
+        return true;
+    }
+
+    // ── service-thread helpers ────────────────────────────────────────────────
+    // Ask for a writable callback only when there is something to write, so
+    // an idle connection causes no wake-ups.
+    void request_write() {
+        if (!connected || !wsi)
+            return;
+        if (ping_due || writing.has_value() || !send_queue.empty())
+            lws_callback_on_writable(wsi);
+    }
+
+    void apply_rx_pause() {
+        if (!connected || !wsi)
+            return;
+        const bool wanted = rx_pause_wanted;
+        if (wanted != rx_paused && lws_rx_flow_control(wsi, wanted ? 0 : 1) == 0)
+            rx_paused = wanted;
+    }
+
+    // Writes the pending ping, if any. Control frames are never deflated,
+    // so the payload counters leave it out. Returns false if the connection
+    // failed.
+    bool write_ping(lws* wsi_out) {
+        WsFrame ping;
+        {
+            std::lock_guard<std::mutex> lk(ping_mutex);
+            if (!ping_due)
+                return true;
+            ping_due = false;
+            ping = frame_pool.make(ping_payload);
+        }
+        const bool ok = lws_write(wsi_out, ping.payload(), ping.size(), LWS_WRITE_PING) >= 0;
+        frame_pool.recycle(std::move(ping));
+        if (ok)
+            ++pings_sent;
+        return ok;
+    }
+
+    // Reconnect with exponential back-off
+    void schedule_reconnect() {
+        if (!running || reconnect_scheduled || reconnect_count >= MAX_RECONNECT)
+            return;
+        const long wait_ms = RECONNECT_BASE_MS * (1L << reconnect_count);
+        reconnect_count++;
+        reconnect_scheduled = true;
+        lws_sul_schedule(ctx, 0, &reconnect_timer.sul, on_reconnect_timer, wait_ms * LWS_US_PER_MS);
+    }
+
+    static void on_reconnect_timer(lws_sorted_usec_list_t* sul) {
+        Impl* self = reinterpret_cast<Timer*>(sul)->owner;
+        self->reconnect_scheduled = false;
+        if (self->running && !self->wsi)
+            self->do_connect();
+    }
+
+    // Writes queued messages, highest priority first, until the batch budget
+    // is spent or the socket is choked. Each pass writes at most
+    // MAX_FRAGMENT_BYTES of a message. Single-fragment messages are written
+    // in place; the fragments of larger ones go through fragment_buf. Sets
+    // |bulk_drained| when the bulk lane drained below its low watermark.
+    // Returns false if the connection failed.
+    bool drain(lws* wsi_out, bool& bulk_drained) {
+        for (int i = 0; i < MAX_FRAMES_PER_WRITABLE && !lws_send_pipe_choked(wsi_out); ++i) {
+            if (!writing) {
+                bool drained = false;
+                writing = send_queue.pop(drained);
+                if (!writing)
+                    break;
+                write_offset = 0;
+                bulk_drained = bulk_drained || drained;
+            }
+
+            const size_t remaining = writing->size() - write_offset;
+            const size_t chunk = std::min(remaining, MAX_FRAGMENT_BYTES);
+            const bool fin = chunk == remaining;
+            const int first = writing->binary ? LWS_WRITE_BINARY : LWS_WRITE_TEXT;
+            int flags = write_offset == 0 ? first : LWS_WRITE_CONTINUATION;
+            if (!fin)
+                flags |= LWS_WRITE_NO_FIN;
+            unsigned char* data = writing->payload() + write_offset;
+            if (!(write_offset == 0 && fin)) {
+                fragment_buf.resize(LWS_PRE + chunk);
+                std::memcpy(fragment_buf.data() + LWS_PRE, data, chunk);
+                data = fragment_buf.data() + LWS_PRE;
+            }
+            if (lws_write(wsi_out, data, chunk, static_cast<lws_write_protocol>(flags)) < 0) {
+                // An in-place write may have masked part of the payload
+                // already; drop the message rather than resend garbage.
+                if (write_offset == 0 && fin) {
+                    frame_pool.recycle(std::move(*writing));
+                    writing.reset();
+                }
+                return false;
+            }
+
+            write_offset += chunk;
+            count_sent(chunk);
+            if (fin) {
+                ++messages_sent;
+                frame_pool.recycle(std::move(*writing));
+                writing.reset();
+            }
+        }
+        return true;
+    }
+
     // ── lws callback (static, dispatches to instance) ─────────────────────────
     static int lws_callback(lws* wsi_in, lws_callback_reasons reason, void* user, void* in, size_t len) {
         auto* self = static_cast<Impl*>(lws_context_user(lws_get_context(wsi_in)));
@@ -80,51 +377,122 @@ struct WebSocketClient::Impl {
             return 0;
 
         switch (reason) {
+            case LWS_CALLBACK_EVENT_WAIT_CANCELLED: {
+                // Woken by send(), disconnect() or setReceivePaused() on
+                // another thread.
+                self->apply_rx_pause();
+                self->request_write();
+                break;
+            }
+            case LWS_CALLBACK_CLIENT_FILTER_PRE_ESTABLISH: {
+                // lws has checked that the selection is one we offered.
+                std::string selected;
+                const int n = lws_hdr_total_length(wsi_in, WSI_TOKEN_PROTOCOL);
+                if (n > 0) {
+                    selected.resize(static_cast<size_t>(n) + 1);
+                    lws_hdr_copy(wsi_in, selected.data(), n + 1, WSI_TOKEN_PROTOCOL);
+                    selected.resize(static_cast<size_t>(n));
+                }
+                std::lock_guard<std::mutex> lk(self->config_mutex);
+                self->negotiated_protocol = std::move(selected);
+                break;
+            }
+            case LWS_CALLBACK_CLIENT_CONFIRM_EXTENSION_SUPPORTED: {
+                // Nonzero leaves the extension out of this handshake.
+                return self->offer_compression ? 0 : 1;
+            }
             case LWS_CALLBACK_CLIENT_ESTABLISHED: {
                 self->connected = true;
                 self->reconnect_count = 0;
-                self->last_ping = std::chrono::steady_clock::now();
-                std::lock_guard<std::mutex> lk(self->cb_mutex);
-                if (self->on_connected)
-                    self->on_connected();
-                lws_callback_on_writable(wsi_in);
+                {
+                    std::lock_guard<std::mutex> lk(self->cb_mutex);
+                    if (self->on_connected)
+                        self->on_connected();
+                }
+                self->apply_rx_pause();
+                self->request_write();
                 break;
             }
             case LWS_CALLBACK_CLIENT_RECEIVE: {
-                std::string msg(static_cast<const char*>(in), len);
+                // Large messages arrive in several fragments and rx-buffer
+                // sized pieces; only a complete one is dispatched.
+                const size_t remaining = lws_remaining_packet_payload(wsi_in);
+                const bool final = lws_is_final_fragment(wsi_in) && remaining == 0;
+                self->count_received(len);
+                const auto result =
+                    self->rx.append(std::string_view(static_cast<const char*>(in), len), final, remaining);
+                if (result == WsFrameAssembler::Result::Incomplete)
+                    break;
+                if (result == WsFrameAssembler::Result::Complete)
+                    ++self->messages_received;
+
+                if (result == WsFrameAssembler::Result::Dropped) {
+                    std::lock_guard<std::mutex> lk(self->cb_mutex);
+                    if (self->on_error)
+                        self->on_error("inbound message too large, dropped");
+                    break;
+                }
+                // Called without cb_mutex: the handler may take a while, and
+                // setters on other threads must not wait for it.
+                WebSocketClient::MessageHandler handler;
+                {
+                    std::lock_guard<std::mutex> lk(self->cb_mutex);
+                    handler = self->on_message;
+                }
+                if (handler)
+                    handler(self->rx.message(), lws_frame_is_binary(wsi_in) != 0);
+                self->apply_rx_pause();
+                break;
+            }
+            case LWS_CALLBACK_CLIENT_RECEIVE_PONG: {
+                ++self->pongs_received;
                 std::lock_guard<std::mutex> lk(self->cb_mutex);
-                if (self->on_message)
-                    self->on_message(msg);
+                if (self->on_pong)
+                    self->on_pong(std::string_view(static_cast<const char*>(in), len));
                 break;
             }
             case LWS_CALLBACK_CLIENT_WRITEABLE: {
-                // Send ping if interval elapsed
-                auto now = std::chrono::steady_clock::now();
-                auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - self->last_ping).count();
-                if (elapsed >= HEARTBEAT_INTERVAL_S) {
-                    const std::string ping = R"({"type":"ping"})";
-                    std::vector<unsigned char> buf(LWS_PRE + ping.size());
-                    std::memcpy(buf.data() + LWS_PRE, ping.data(), ping.size());
-                    lws_write(wsi_in, buf.data() + LWS_PRE, ping.size(), LWS_WRITE_TEXT);
-                    self->last_ping = now;
-                }
-                // Drain outbound queue
-                std::lock_guard<std::mutex> lk(self->send_mutex);
-                if (!self->send_queue.empty()) {
-                    const std::string& msg = self->send_queue.front();
-                    std::vector<unsigned char> buf(LWS_PRE + msg.size());
-                    std::memcpy(buf.data() + LWS_PRE, msg.data(), msg.size());
-                    lws_write(wsi_in, buf.data() + LWS_PRE, msg.size(), LWS_WRITE_TEXT);
-                    self->send_queue.pop();
-                    if (!self->send_queue.empty())
-                        lws_callback_on_writable(wsi_in);
+                // A control frame may sit between the fragments of a data
+                // message, so the ping never waits for a large write.
+                bool drained = false;
+                if (!self->write_ping(wsi_in) || !self->drain(wsi_in, drained))
+                    return -1;
+                // Outside drain() and cb_mutex: the handler resumes producers,
+                // which may send from here.
+                if (drained) {
+                    WebSocketClient::DrainedHandler handler;
+                    {
+                        std::lock_guard<std::mutex> lk(self->cb_mutex);
+                        handler = self->on_drained;
+                    }
+                    if (handler)
+                        handler();
                 }
+                self->request_write();
                 break;
             }
             case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
+            case LWS_CALLBACK_CLIENT_CLOSED:
             case LWS_CALLBACK_CLOSED: {
+                // A failed upgrade ("HS: ..." errors) with the offer made may
+                // be an intermediary choking on the extension header: retry
+                // without it. Unreachable-server errors keep the offer.
+                if (reason == LWS_CALLBACK_CLIENT_CONNECTION_ERROR && self->offer_compression && in
+                    && std::string_view(static_cast<const char*>(in)).starts_with("HS:")) {
+                    self->offer_compression = false;
+                    ++self->compression_fallbacks;
+                }
                 self->connected = false;
+                self->compression_active = false;
                 self->wsi = nullptr;
+                {
+                    std::lock_guard<std::mutex> lk(self->config_mutex);
+                    self->negotiated_protocol.clear();
+                }
+                self->ping_due = false;
+                self->write_offset = 0;
+                self->rx.reset();
+                self->rx_paused = false;
                 {
                     std::lock_guard<std::mutex> lk(self->cb_mutex);
                     if (self->on_disconnected)
@@ -135,6 +503,7 @@ struct WebSocketClient::Impl {
                             self->on_error(err);
                     }
                 }
+                self->schedule_reconnect();
                 break;
             }
             default:
@@ -144,45 +513,74 @@ struct WebSocketClient::Impl {
     }
 
     // ── event loop ─────────────────────────────────────────────────────────────
+    // Fully event-driven: lws_service() sleeps until socket activity, a timer
+    // (reconnect) or a wake() from another thread.
     void loop() {
-        static const lws_protocols protocols[] = { { "anychat", lws_callback, 0, 4096, 0, nullptr, 0 },
-                                                   { nullptr, nullptr, 0, 0, 0, nullptr, 0 } };
+        WebSocketCompressionOptions options;
+        {
+            std::lock_guard<std::mutex> lk(config_mutex);
+            options = compression;
+            protocol_names = subprotocols;
+        }
+
+        // Every offered subprotocol needs an entry: lws binds the connection
+        // to the one the server selects.
+        protocols.clear();
+        protocol_offer.clear();
+        for (const auto& name : protocol_names) {
+            protocols.push_back(lws_protocols{ name.c_str(), lws_callback, 0, 4096, 0, nullptr, 0 });
+            protocol_offer += (protocol_offer.empty() ? "" : ", ") + name;
+        }
+        protocols.push_back(lws_protocols{ nullptr, nullptr, 0, 0, 0, nullptr, 0 });
 
         lws_context_creation_info info{};
         info.port = CONTEXT_PORT_NO_LISTEN;
-        info.protocols = protocols;
+        info.protocols = protocols.data();
         info.user = this;
+#if !defined(LWS_WITHOUT_EXTENSIONS)
+        offer_compression = options.enabled;
+        if (options.enabled) {
+            deflate_offer = build_deflate_offer(options);
+            extensions[0] = lws_extension{ "permessage-deflate", deflate_callback, deflate_offer.c_str() };
+            extensions[1] = lws_extension{ nullptr, nullptr, nullptr };
+            info.extensions = extensions;
+        }
+#else
+        offer_compression = false;
+#endif
         if (use_ssl)
             info.options |= LWS_SERVER_OPTION_DO_SSL_GLOBAL_INIT;
 
-        ctx = lws_create_context(&info);
-        if (!ctx) {
+        lws_context* created = lws_create_context(&info);
+        if (!created) {
             std::lock_guard<std::mutex> lk(cb_mutex);
             if (on_error)
                 on_error("lws_create_context failed");
             return;
         }
+        {
+            std::lock_guard<std::mutex> lk(ctx_mutex);
+            ctx = created;
+        }
 
         do_connect();
 
         while (running) {
-            lws_service(ctx, 20 /*ms*/);
-
-            // Schedule writable callback to flush queue / send ping
-            if (connected && wsi)
-                lws_callback_on_writable(wsi);
-
-            // Reconnect with exponential back-off
-            if (!connected && running && reconnect_count < MAX_RECONNECT) {
-                long wait_ms = RECONNECT_BASE_MS * (1L << reconnect_count);
-                std::this_thread::sleep_for(std::chrono::milliseconds(wait_ms));
-                reconnect_count++;
-                do_connect();
-            }
+            if (lws_service(ctx, 0) < 0)
+                break;
         }
 
-        lws_context_destroy(ctx);
-        ctx = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(ctx_mutex);
+            ctx = nullptr;
+        }
+        lws_context_destroy(created);
+        wsi = nullptr;
+        connected = false;
+        compression_active = false;
+        reconnect_count = 0;
+        reconnect_scheduled = false;
+        reconnect_timer.sul = {};
     }
 
     void do_connect() {
@@ -193,9 +591,11 @@ struct WebSocketClient::Impl {
         ci.path = path.c_str();
         ci.host = host.c_str();
         ci.origin = host.c_str();
-        ci.protocol = "anychat";
+        ci.protocol = protocol_offer.c_str();
         ci.ssl_connection = use_ssl ? LCCSCF_USE_SSL : 0;
-        wsi = lws_client_connect_via_info(&ci);
+        ci.pwsi = &wsi;
+        if (!lws_client_connect_via_info(&ci))
+            schedule_reconnect();
     }
 };
 
@@ -220,23 +620,74 @@ void WebSocketClient::connect() {
 
 void WebSocketClient::disconnect() {
     impl_->running = false;
+    impl_->wake();
     if (impl_->worker.joinable())
         impl_->worker.join();
 }
 
-void WebSocketClient::send(const std::string& message) {
-    {
-        std::lock_guard<std::mutex> lk(impl_->send_mutex);
-        impl_->send_queue.push(message);
-    }
-    if (impl_->connected && impl_->wsi)
-        lws_callback_on_writable(impl_->wsi);
+bool WebSocketClient::send(const std::string& message, SendPriority priority) {
+    return impl_->enqueue(message, false, priority);
+}
+
+bool WebSocketClient::sendBinary(const std::string& message, SendPriority priority) {
+    return impl_->enqueue(message, true, priority);
+}
+
+bool WebSocketClient::sendPing(std::string_view payload) {
+    return impl_->queue_ping(payload);
 }
 
 bool WebSocketClient::isConnected() const {
     return impl_->connected;
 }
 
+std::string WebSocketClient::subprotocol() const {
+    std::lock_guard<std::mutex> lk(impl_->config_mutex);
+    return impl_->negotiated_protocol;
+}
+
+void WebSocketClient::setSubprotocols(std::vector<std::string> names) {
+    if (names.empty())
+        return;
+    std::lock_guard<std::mutex> lk(impl_->config_mutex);
+    impl_->subprotocols = std::move(names);
+}
+
+void WebSocketClient::setSendQueueLimits(WsSendQueueLimits limits) {
+    impl_->send_queue.setLimits(limits);
+}
+
+void WebSocketClient::setReceivePaused(bool paused) {
+    impl_->rx_pause_wanted = paused;
+    impl_->wake();
+}
+
+void WebSocketClient::setCompression(WebSocketCompressionOptions options) {
+    std::lock_guard<std::mutex> lk(impl_->config_mutex);
+    impl_->compression = options;
+}
+
+WebSocketStats WebSocketClient::stats() const {
+    const WsSendQueueStats queue = impl_->send_queue.stats();
+    return WebSocketStats{
+        .compression_active = impl_->compression_active,
+        .compression_fallbacks = impl_->compression_fallbacks,
+        .messages_sent = impl_->messages_sent,
+        .messages_received = impl_->messages_received,
+        .payload_bytes_sent = impl_->payload_bytes_sent,
+        .payload_bytes_received = impl_->payload_bytes_received,
+        .deflate_in_bytes = impl_->deflate_in_bytes,
+        .deflate_out_bytes = impl_->deflate_out_bytes,
+        .inflate_in_bytes = impl_->inflate_in_bytes,
+        .inflate_out_bytes = impl_->inflate_out_bytes,
+        .transient_frames_dropped = queue.transient_dropped,
+        .bulk_frames_refused = queue.bulk_refused,
+        .send_queue_bytes = queue.bulk_bytes,
+        .pings_sent = impl_->pings_sent,
+        .pongs_received = impl_->pongs_received,
+    };
+}
+
 void WebSocketClient::setOnMessage(MessageHandler handler) {
     std::lock_guard<std::mutex> lk(impl_->cb_mutex);
     impl_->on_message = std::move(handler);
@@ -257,4 +708,14 @@ void WebSocketClient::setOnError(ErrorHandler handler) {
     impl_->on_error = std::move(handler);
 }
 
+void WebSocketClient::setOnDrained(DrainedHandler handler) {
+    std::lock_guard<std::mutex> lk(impl_->cb_mutex);
+    impl_->on_drained = std::move(handler);
+}
+
+void WebSocketClient::setOnPong(PongHandler handler) {
+    std::lock_guard<std::mutex> lk(impl_->cb_mutex);
+    impl_->on_pong = std::move(handler);
+}
+
 } // namespace anychat::network
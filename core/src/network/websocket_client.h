@@ -1,13 +1,49 @@
 #pragma once
 
 #include "iwebsocket_client.h"
+#include "ws_send_queue.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace anychat {
 namespace network {
 
+// permessage-deflate (RFC 7692) offer. Window bits trade compression ratio
+// for memory (2^bits bytes of history per direction); "no context takeover"
+// resets the dictionary after every message, which saves that memory on
+// idle connections but compresses small repetitive messages much worse.
+struct WebSocketCompressionOptions {
+    bool enabled = false;
+    int client_max_window_bits = 15; // 9..15, our deflate window
+    int server_max_window_bits = 15; // 9..15, the server's deflate window
+    bool client_no_context_takeover = false;
+    bool server_no_context_takeover = false;
+};
+
+// Byte counters since construction. The deflate counters only move while
+// the extension is active; their output/input ratio is the compression
+// ratio (frame headers and the TLS layer are not included).
+struct WebSocketStats {
+    bool compression_active = false; // negotiated on the current connection
+    uint64_t compression_fallbacks = 0; // handshakes retried without the offer
+    uint64_t messages_sent = 0;
+    uint64_t messages_received = 0;
+    uint64_t payload_bytes_sent = 0; // uncompressed
+    uint64_t payload_bytes_received = 0; // uncompressed
+    uint64_t deflate_in_bytes = 0; // outbound payload fed to deflate
+    uint64_t deflate_out_bytes = 0; // compressed bytes written
+    uint64_t inflate_in_bytes = 0; // compressed bytes read
+    uint64_t inflate_out_bytes = 0; // inbound payload after inflate
+    uint64_t transient_frames_dropped = 0; // superseded before they were sent
+    uint64_t bulk_frames_refused = 0; // send() returned false
+    uint64_t send_queue_bytes = 0; // bulk payload waiting to be written
+    uint64_t pings_sent = 0; // control frames, not in the payload counters
+    uint64_t pongs_received = 0;
+};
+
 // Async WebSocket client backed by libwebsockets.
 // The internal event loop runs on a dedicated thread.
 // All handlers are invoked from that thread — callers must synchronise if needed.
@@ -23,13 +59,41 @@ public:
 
     void connect() override;
     void disconnect() override;
-    void send(const std::string& message) override;
+    bool send(const std::string& message, SendPriority priority = SendPriority::Bulk) override;
+    bool sendBinary(const std::string& message, SendPriority priority = SendPriority::Bulk) override;
+    bool sendPing(std::string_view payload) override;
     bool isConnected() const override;
+    std::string subprotocol() const override;
 
     void setOnMessage(MessageHandler handler) override;
     void setOnConnected(ConnectedHandler handler) override;
     void setOnDisconnected(DisconnectedHandler handler) override;
     void setOnError(ErrorHandler handler) override;
+    void setOnDrained(DrainedHandler handler) override;
+    void setOnPong(PongHandler handler) override;
+
+    // Takes effect on the next connect(). If a handshake carrying the offer
+    // fails (e.g. a proxy rejecting the extension header), later attempts go
+    // without it until the next connect(). A server that ignores the offer
+    // simply gets an uncompressed connection. No effect if the SDK was built
+    // without WebSocket extensions (requires zlib).
+    void setCompression(WebSocketCompressionOptions options);
+
+    WebSocketStats stats() const;
+
+    // Subprotocols offered in Sec-WebSocket-Protocol, most preferred first;
+    // default {"anychat"}. Takes effect on the next connect().
+    void setSubprotocols(std::vector<std::string> names);
+
+    // Stops reading inbound frames while |paused|, so TCP flow control holds
+    // the server back; pongs wait too, writes and pings go on. Safe from any
+    // thread, including the message handler. Stays in effect across
+    // reconnects.
+    void setReceivePaused(bool paused);
+
+    // Bounds of the outbound queue. Frames queued while disconnected stay
+    // queued for the next connection.
+    void setSendQueueLimits(WsSendQueueLimits limits);
 
 private:
     struct Impl;
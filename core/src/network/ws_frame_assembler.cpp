@@ -0,0 +1,44 @@
+#include "ws_frame_assembler.h"
+
+namespace anychat::network {
+
+WsFrameAssembler::WsFrameAssembler(size_t max_message_bytes)
+    : max_message_bytes_(max_message_bytes) {}
+
+WsFrameAssembler::Result WsFrameAssembler::append(std::string_view chunk, bool final, size_t remaining) {
+    if (complete_) {
+        // The previous message has been consumed.
+        complete_ = false;
+        if (buffer_.capacity() > kRetainedCapacity)
+            std::string().swap(buffer_);
+        buffer_.clear();
+    }
+
+    if (!dropping_ && buffer_.size() + chunk.size() > max_message_bytes_) {
+        dropping_ = true;
+        std::string().swap(buffer_);
+    }
+    if (dropping_) {
+        if (final)
+            dropping_ = false;
+        return final ? Result::Dropped : Result::Incomplete;
+    }
+
+    if (buffer_.size() + chunk.size() + remaining <= max_message_bytes_)
+        buffer_.reserve(buffer_.size() + chunk.size() + remaining);
+    buffer_.append(chunk);
+    if (!final)
+        return Result::Incomplete;
+    complete_ = true;
+    return Result::Complete;
+}
+
+void WsFrameAssembler::reset() {
+    complete_ = false;
+    dropping_ = false;
+    if (buffer_.capacity() > kRetainedCapacity)
+        std::string().swap(buffer_);
+    buffer_.clear();
+}
+
+} // namespace anychat::network
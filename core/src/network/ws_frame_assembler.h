@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace anychat {
+namespace network {
+
+// Reassembles WebSocket messages from the pieces libwebsockets delivers: a
+// message may arrive as several fragments, and each fragment in several
+// receive callbacks when it exceeds the rx buffer.
+//
+// Chunks are copied once into a buffer that is reused across messages, and
+// complete messages are handed out as views into it. The view stays valid
+// until the next append() and is followed by a NUL, so it can go straight to
+// the JSON reader.
+class WsFrameAssembler {
+public:
+    enum class Result
+    {
+        Incomplete, // more chunks to come
+        Complete, // message() holds a whole message
+        Dropped, // the message exceeded max_message_bytes and was discarded
+    };
+
+    explicit WsFrameAssembler(size_t max_message_bytes = 32 * 1024 * 1024);
+
+    // |final| marks the last chunk of the message: the last fragment with no
+    // payload left (lws_is_final_fragment() && !lws_remaining_packet_payload()).
+    // |remaining| is the rest of the current fragment, used to size the
+    // buffer up front.
+    Result append(std::string_view chunk, bool final, size_t remaining = 0);
+
+    std::string_view message() const {
+        return complete_ ? std::string_view(buffer_) : std::string_view{};
+    }
+
+    // Forget a partial message, e.g. when the connection closed mid-message.
+    void reset();
+
+    size_t capacity() const {
+        return buffer_.capacity();
+    }
+
+private:
+    // Buffers grown past this by a large message are released afterwards.
+    static constexpr size_t kRetainedCapacity = 256 * 1024;
+
+    const size_t max_message_bytes_;
+    std::string buffer_;
+    bool complete_ = false;
+    bool dropping_ = false;
+};
+
+} // namespace network
+} // namespace anychat
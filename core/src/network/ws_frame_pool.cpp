@@ -0,0 +1,51 @@
+#include "ws_frame_pool.h"
+
+#include <cstring>
+#include <utility>
+
+namespace anychat::network {
+
+WsFramePool::WsFramePool(size_t headroom, size_t max_pooled, size_t max_pooled_capacity)
+    : headroom_(headroom)
+    , max_pooled_(max_pooled)
+    , max_pooled_capacity_(max_pooled_capacity) {}
+
+WsFrame WsFramePool::make(std::string_view payload) {
+    WsFrame frame;
+    frame.headroom = headroom_;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.empty()) {
+            ++allocations_;
+        } else {
+            frame.buf = std::move(free_.back());
+            free_.pop_back();
+        }
+    }
+
+    // resize() keeps the capacity of a recycled buffer.
+    frame.buf.resize(headroom_ + payload.size());
+    if (!payload.empty())
+        std::memcpy(frame.payload(), payload.data(), payload.size());
+    return frame;
+}
+
+void WsFramePool::recycle(WsFrame&& frame) {
+    if (frame.buf.capacity() > max_pooled_capacity_)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.size() < max_pooled_)
+        free_.push_back(std::move(frame.buf));
+}
+
+size_t WsFramePool::pooled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_.size();
+}
+
+uint64_t WsFramePool::allocations() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocations_;
+}
+
+} // namespace anychat::network
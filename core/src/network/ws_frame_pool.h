@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace anychat {
+namespace network {
+
+// An outbound WebSocket payload with |headroom| spare bytes in front of it,
+// where the transport writes the frame header (LWS_PRE for libwebsockets), so
+// the payload goes to the socket without another copy.
+struct WsFrame {
+    std::vector<unsigned char> buf; // headroom + payload
+    size_t headroom = 0;
+    bool binary = false; // binary frame, text otherwise
+
+    unsigned char* payload() {
+        return buf.data() + headroom;
+    }
+    size_t size() const {
+        return buf.size() - headroom;
+    }
+};
+
+// Recycles frame buffers so steady traffic does not allocate. make() may be
+// called from any thread; buffers come back through recycle() once written.
+class WsFramePool {
+public:
+    explicit WsFramePool(size_t headroom, size_t max_pooled = 32, size_t max_pooled_capacity = 64 * 1024);
+
+    WsFrame make(std::string_view payload);
+    void recycle(WsFrame&& frame);
+
+    size_t pooled() const;
+
+    // Buffers created because none could be reused.
+    uint64_t allocations() const;
+
+private:
+    const size_t headroom_;
+    const size_t max_pooled_;
+    const size_t max_pooled_capacity_; // larger buffers are freed, not kept
+
+    mutable std::mutex mutex_;
+    std::vector<std::vector<unsigned char>> free_;
+    uint64_t allocations_ = 0;
+};
+
+} // namespace network
+} // namespace anychat
@@ -0,0 +1,94 @@
+#include "ws_send_queue.h"
+
+#include <utility>
+
+namespace anychat::network {
+
+WsSendQueue::WsSendQueue(WsFramePool& pool, WsSendQueueLimits limits)
+    : pool_(pool)
+    , limits_(limits) {}
+
+bool WsSendQueue::push(WsFrame&& frame, SendPriority priority) {
+    std::optional<WsFrame> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        switch (priority) {
+            case SendPriority::Control:
+                control_.push_back(std::move(frame));
+                return true;
+            case SendPriority::Transient:
+                transient_.push_back(std::move(frame));
+                if (transient_.size() > limits_.max_transient_frames) {
+                    evicted = std::move(transient_.front());
+                    transient_.pop_front();
+                    ++transient_dropped_;
+                }
+                break;
+            case SendPriority::Bulk:
+                if (congested_) {
+                    ++bulk_refused_;
+                    evicted = std::move(frame);
+                    break;
+                }
+                bulk_bytes_ += frame.size();
+                bulk_.push_back(std::move(frame));
+                // The frame that crosses the watermark is still taken, so a
+                // single oversized frame cannot be refused forever.
+                if (bulk_bytes_ >= limits_.high_watermark_bytes)
+                    congested_ = true;
+                return true;
+        }
+    }
+    if (!evicted)
+        return true;
+    pool_.recycle(std::move(*evicted));
+    return priority != SendPriority::Bulk;
+}
+
+std::optional<WsFrame> WsSendQueue::pop(bool& drained) {
+    drained = false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto* lane : { &control_, &transient_ }) {
+        if (!lane->empty()) {
+            WsFrame frame = std::move(lane->front());
+            lane->pop_front();
+            return frame;
+        }
+    }
+    if (bulk_.empty())
+        return std::nullopt;
+
+    WsFrame frame = std::move(bulk_.front());
+    bulk_.pop_front();
+    bulk_bytes_ -= frame.size();
+    if (congested_ && bulk_bytes_ <= limits_.low_watermark_bytes) {
+        congested_ = false;
+        drained = true;
+    }
+    return frame;
+}
+
+bool WsSendQueue::empty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return control_.empty() && transient_.empty() && bulk_.empty();
+}
+
+WsSendQueueStats WsSendQueue::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WsSendQueueStats{
+        .control_frames = control_.size(),
+        .transient_frames = transient_.size(),
+        .bulk_frames = bulk_.size(),
+        .bulk_bytes = bulk_bytes_,
+        .congested = congested_,
+        .transient_dropped = transient_dropped_,
+        .bulk_refused = bulk_refused_,
+    };
+}
+
+void WsSendQueue::setLimits(WsSendQueueLimits limits) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limits_ = limits;
+}
+
+} // namespace anychat::network
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "iwebsocket_client.h"
+#include "ws_frame_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace anychat {
+namespace network {
+
+struct WsSendQueueLimits {
+    size_t max_transient_frames = 64; // the oldest is dropped beyond this
+    size_t high_watermark_bytes = 1024 * 1024; // bulk frames are refused from here...
+    size_t low_watermark_bytes = 256 * 1024; // ...until the bulk lane drains to this
+};
+
+struct WsSendQueueStats {
+    size_t control_frames = 0;
+    size_t transient_frames = 0;
+    size_t bulk_frames = 0;
+    size_t bulk_bytes = 0;
+    bool congested = false; // above the high watermark, not yet drained
+    uint64_t transient_dropped = 0;
+    uint64_t bulk_refused = 0;
+};
+
+// Outbound frames in three lanes, popped strictly by SendPriority: a long
+// bulk backlog (e.g. the outbound queue flushing after a reconnect) cannot
+// hold back heartbeats or typing updates. Frames within a lane keep their
+// order.
+//
+// Only the bulk lane pushes back: once its payload bytes reach the high
+// watermark it refuses bulk frames until pops take it down to the low
+// watermark, which pop() reports so the producer can resume. Transient
+// frames are superseded by newer ones, so a full transient lane drops its
+// oldest frame instead. Control frames are always queued.
+//
+// Thread-safe. Dropped and refused frames go back to |pool|.
+class WsSendQueue {
+public:
+    explicit WsSendQueue(WsFramePool& pool, WsSendQueueLimits limits = {});
+
+    // False if the frame was refused (bulk lane congested).
+    bool push(WsFrame&& frame, SendPriority priority);
+
+    // The next frame to write, if any. |drained| is set when this pop ended
+    // a congestion, i.e. bulk frames are accepted again.
+    std::optional<WsFrame> pop(bool& drained);
+
+    bool empty() const;
+
+    WsSendQueueStats stats() const;
+
+    void setLimits(WsSendQueueLimits limits);
+
+private:
+    WsFramePool& pool_;
+
+    mutable std::mutex mutex_;
+    WsSendQueueLimits limits_;
+    std::deque<WsFrame> control_;
+    std::deque<WsFrame> transient_;
+    std::deque<WsFrame> bulk_;
+    size_t bulk_bytes_ = 0;
+    bool congested_ = false;
+    uint64_t transient_dropped_ = 0;
+    uint64_t bulk_refused_ = 0;
+};
+
+} // namespace network
+} // namespace anychat
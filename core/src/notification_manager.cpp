@@ -5,22 +5,17 @@
 #include <optional>
 #include <shared_mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 
 namespace anychat::notification_manager_detail {
 
-using json_common::readJsonRelaxed;
 using json_common::parseInt64Value;
 
 using IntegerValue = std::variant<int64_t, double, std::string>;
 using OptionalIntegerValue = std::optional<IntegerValue>;
 
-struct WsFramePayload {
-    std::string type{};
-    std::optional<glz::raw_json> payload{};
-};
-
 struct MsgSentAckPayload {
     std::string message_id{};
     OptionalIntegerValue sequence{};
@@ -28,27 +23,144 @@ struct MsgSentAckPayload {
     std::string local_id{};
 };
 
+struct ResumeResultPayload {
+    OptionalIntegerValue last_seq{};
+    std::string reason{};
+};
+
 struct NotificationEnvelopePayload {
     std::string type{};
     OptionalIntegerValue timestamp{};
-    std::optional<glz::raw_json> payload{};
+    std::optional<glz::raw_json_view> payload{};
+};
+
+// BEVE forms of the structs above. BEVE is typed, so numbers that JSON
+// accepts as number-or-string are plain integers, and the event payload is
+// nested as opaque bytes like the frame payload (see frame_codec.h).
+struct MsgSentAckBevePayload {
+    std::string message_id{};
+    int64_t sequence = 0;
+    int64_t timestamp = 0;
+    std::string local_id{};
+};
+
+struct NotificationEnvelopeBevePayload {
+    std::string type{};
+    int64_t timestamp = 0;
+    std::string_view payload{};
+};
+
+struct ResumeResultBevePayload {
+    int64_t last_seq = 0;
+    std::string reason{};
 };
 
-template <typename T>
-bool parseRawObject(const std::optional<glz::raw_json>& raw, T& out) {
-    if (!raw.has_value() || raw->str.empty()) {
+bool decodeMsgSentAck(const FrameCodec& codec, std::string_view data, MsgSentAck& ack) {
+    std::string err;
+    if (codec.encoding() == FrameEncoding::Json) {
+        MsgSentAckPayload payload{};
+        if (!codec.decodePayload(data, payload, err)) {
+            return false;
+        }
+        ack.message_id = std::move(payload.message_id);
+        ack.sequence = parseInt64Value(payload.sequence, 0);
+        ack.timestamp = parseInt64Value(payload.timestamp, 0);
+        ack.local_id = std::move(payload.local_id);
+        return true;
+    }
+    MsgSentAckBevePayload payload{};
+    if (!codec.decodePayload(data, payload, err)) {
         return false;
     }
+    ack.message_id = std::move(payload.message_id);
+    ack.sequence = payload.sequence;
+    ack.timestamp = payload.timestamp;
+    ack.local_id = std::move(payload.local_id);
+    return true;
+}
+
+// Both answers may come without a payload.
+void decodeResumeResult(const FrameCodec& codec, std::string_view data, ResumeResult& result) {
+    if (data.empty()) {
+        return;
+    }
+    std::string err;
+    if (codec.encoding() == FrameEncoding::Json) {
+        ResumeResultPayload payload{};
+        if (codec.decodePayload(data, payload, err)) {
+            result.last_seq = parseInt64Value(payload.last_seq, 0);
+            result.reason = std::move(payload.reason);
+        }
+        return;
+    }
+    ResumeResultBevePayload payload{};
+    if (codec.decodePayload(data, payload, err)) {
+        result.last_seq = payload.last_seq;
+        result.reason = std::move(payload.reason);
+    }
+}
 
+// Decodes the inner notification envelope. |json| is set to the event
+// payload as JSON: a view into |data| for JSON frames, into |transcoded|
+// for BEVE ones, "{}" when there is none.
+bool decodeNotification(
+    const FrameCodec& codec,
+    std::string_view data,
+    NotificationEvent& evt,
+    std::string_view& json,
+    std::string& transcoded
+) {
     std::string err;
-    return readJsonRelaxed(std::string(raw->str), out, err);
+    json = {};
+    if (codec.encoding() == FrameEncoding::Json) {
+        NotificationEnvelopePayload payload{};
+        if (!codec.decodePayload(data, payload, err)) {
+            return false;
+        }
+        evt.notification_type = std::move(payload.type);
+        evt.timestamp = parseInt64Value(payload.timestamp, 0);
+        if (payload.payload.has_value()) {
+            json = payload.payload->str;
+        }
+    } else {
+        NotificationEnvelopeBevePayload payload{};
+        if (!codec.decodePayload(data, payload, err)) {
+            return false;
+        }
+        evt.notification_type = std::move(payload.type);
+        evt.timestamp = payload.timestamp;
+        // Typed subscribers share the JSON payload structs, so BEVE event
+        // payloads go through JSON once.
+        if (!payload.payload.empty()) {
+            if (!codec.payloadToJson(payload.payload, transcoded, err)) {
+                return false;
+            }
+            json = transcoded;
+        }
+    }
+    if (json.empty()) {
+        json = "{}";
+    }
+    return !evt.notification_type.empty();
 }
 
-std::string rawJsonToString(const std::optional<glz::raw_json>& raw) {
-    if (!raw.has_value() || raw->str.empty()) {
-        return "";
+// Lets the dispatch table look up a string_view without building a string.
+struct TypeHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view s) const noexcept {
+        return std::hash<std::string_view>{}(s);
     }
-    return std::string(raw->str);
+};
+
+// Whether a subscription key matches a route key. Both are exact types or
+// prefixes ending in '.'; an exact key matches only itself, a prefix key
+// every route under it, and "" every route.
+bool keyMatches(const std::string& subscription, const std::string& route) {
+    if (subscription.empty() || subscription == route) {
+        return true;
+    }
+    return subscription.back() == '.' && route.starts_with(subscription);
 }
 
 } // namespace anychat::notification_manager_detail
@@ -56,6 +168,60 @@ std::string rawJsonToString(const std::optional<glz::raw_json>& raw) {
 namespace anychat {
 using namespace notification_manager_detail;
 
+struct NotificationManager::DispatchTable {
+    struct Route {
+        std::vector<RouteHandler> handlers;
+        bool wants_data = false; // some handler is untyped
+    };
+
+    std::unordered_map<std::string, uint32_t, TypeHash, std::equal_to<>> ids;
+    std::vector<Route> routes; // by id
+    Route fallback; // "*" subscribers: types without a route
+
+    static void add(Route& route, const Subscription& sub) {
+        route.handlers.push_back(sub.handler);
+        route.wants_data = route.wants_data || sub.wants_data;
+    }
+
+    static std::shared_ptr<const DispatchTable> build(const std::vector<Subscription>& subscriptions) {
+        auto table = std::make_shared<DispatchTable>();
+        for (const auto& sub : subscriptions) {
+            if (sub.key.empty()) {
+                add(table->fallback, sub);
+            } else {
+                table->ids.try_emplace(sub.key, static_cast<uint32_t>(table->ids.size()));
+            }
+        }
+        // Each route gets its handlers precomputed, so dispatch is one lookup.
+        table->routes.resize(table->ids.size());
+        for (const auto& [route, id] : table->ids) {
+            for (const auto& sub : subscriptions) {
+                if (keyMatches(sub.key, route)) {
+                    add(table->routes[id], sub);
+                }
+            }
+        }
+        return table;
+    }
+
+    // The exact type's route, else the longest subscribed prefix's, else
+    // the "*" subscribers.
+    const Route& find(std::string_view type) const {
+        if (auto it = ids.find(type); it != ids.end()) {
+            return routes[it->second];
+        }
+        for (size_t dot = type.rfind('.'); dot != std::string_view::npos;
+             dot = dot == 0 ? std::string_view::npos : type.rfind('.', dot - 1)) {
+            if (auto it = ids.find(type.substr(0, dot + 1)); it != ids.end()) {
+                return routes[it->second];
+            }
+        }
+        return fallback;
+    }
+};
+
+NotificationManager::NotificationManager(std::shared_ptr<util::DispatchExecutor> executor)
+    : executor_(std::move(executor)) {}
 
 // ---------------------------------------------------------------------------
 // Handler registration
@@ -66,9 +232,48 @@ void NotificationManager::setOnMessageSent(MsgSentHandler h) {
     on_msg_sent_ = std::move(h);
 }
 
+void NotificationManager::subscribe(std::string_view pattern, NotifHandler h) {
+    if (!h) {
+        return;
+    }
+    auto handler = std::make_shared<const NotifHandler>(std::move(h));
+    addSubscription(
+        pattern,
+        [this, handler](const NotificationEvent& event, std::string_view) {
+            if (!executor_) {
+                (*handler)(event);
+                return;
+            }
+            post({}, [handler, event] {
+                (*handler)(event);
+            });
+        },
+        true
+    );
+}
+
+void NotificationManager::addSubscription(std::string_view pattern, RouteHandler handler, bool wants_data) {
+    std::string key(pattern);
+    if (key == "*") {
+        key.clear();
+    } else if (key.ends_with(".*")) {
+        key.pop_back(); // "group.*" -> "group."
+    }
+
+    std::lock_guard<std::mutex> lock(subscribe_mu_);
+    subscriptions_.push_back(Subscription{ std::move(key), std::move(handler), wants_data });
+    std::shared_ptr<const DispatchTable> table = DispatchTable::build(subscriptions_);
+    std::lock_guard<std::mutex> table_lock(table_mu_);
+    table_ = std::move(table);
+}
+
+std::shared_ptr<const NotificationManager::DispatchTable> NotificationManager::tableSnapshot() const {
+    std::lock_guard<std::mutex> lock(table_mu_);
+    return table_;
+}
+
 void NotificationManager::addNotificationHandler(NotifHandler h) {
-    std::unique_lock lock(mu_);
-    notification_handlers_.push_back(std::move(h));
+    subscribe("*", std::move(h));
 }
 
 void NotificationManager::setOnPong(PongHandler h) {
@@ -76,20 +281,46 @@ void NotificationManager::setOnPong(PongHandler h) {
     on_pong_ = std::move(h);
 }
 
+void NotificationManager::setOnResume(ResumeHandler h) {
+    std::unique_lock lock(mu_);
+    on_resume_ = std::move(h);
+}
+
+void NotificationManager::setOnSequence(SequenceHandler h) {
+    std::unique_lock lock(mu_);
+    on_sequence_ = std::move(h);
+}
+
 // ---------------------------------------------------------------------------
 // Frame dispatch
 // ---------------------------------------------------------------------------
 
-void NotificationManager::handleRaw(const std::string& raw_json) {
-    WsFramePayload frame{};
+void NotificationManager::handleRaw(std::string_view raw, FrameEncoding encoding) {
+    const FrameCodec codec(encoding);
+    FrameEnvelope frame;
     std::string err;
-    if (!readJsonRelaxed(raw_json, frame, err)) {
+    if (!codec.decodeEnvelope(raw, frame, err)) {
         return;
     }
-    const std::string& type = frame.type;
-    if (type.empty()) {
+    if (frame.type.empty()) {
         return;
     }
+    dispatch(codec, frame);
+
+    if (frame.seq > 0) {
+        SequenceHandler handler;
+        {
+            std::shared_lock lock(mu_);
+            handler = on_sequence_;
+        }
+        if (handler) {
+            handler(frame.seq);
+        }
+    }
+}
+
+void NotificationManager::dispatch(const FrameCodec& codec, const FrameEnvelope& frame) {
+    const std::string& type = frame.type;
 
     // ---- pong ---------------------------------------------------------------
     if (type == "pong") {
@@ -106,55 +337,61 @@ void NotificationManager::handleRaw(const std::string& raw_json) {
 
     // ---- message.sent -------------------------------------------------------
     if (type == "message.sent") {
-        MsgSentAckPayload payload{};
-        if (!parseRawObject(frame.payload, payload)) {
+        MsgSentAck ack;
+        if (!decodeMsgSentAck(codec, frame.payload, ack)) {
             return;
         }
 
-        MsgSentAck ack;
-        ack.message_id = payload.message_id;
-        ack.sequence = parseInt64Value(payload.sequence, 0);
-        ack.timestamp = parseInt64Value(payload.timestamp, 0);
-        ack.local_id = payload.local_id;
-
         MsgSentHandler handler;
         {
             std::shared_lock lock(mu_);
             handler = on_msg_sent_;
         }
         if (handler) {
-            handler(ack);
+            post({}, [handler = std::move(handler), ack = std::move(ack)] {
+                handler(ack);
+            });
         }
         return;
     }
 
     // ---- notification -------------------------------------------------------
     if (type == "notification") {
-        NotificationEnvelopePayload payload{};
-        if (!parseRawObject(frame.payload, payload)) {
+        NotificationEvent evt;
+        std::string_view json;
+        std::string transcoded;
+        if (!decodeNotification(codec, frame.payload, evt, json, transcoded)) {
             return;
         }
 
-        NotificationEvent evt;
-        evt.notification_type = payload.type;
-        if (evt.notification_type.empty()) {
+        // Holding the snapshot keeps the handlers alive while they run.
+        const auto table = tableSnapshot();
+        if (!table) {
             return;
         }
-        evt.timestamp = parseInt64Value(payload.timestamp, 0);
-        evt.data = rawJsonToString(payload.payload);
-        if (evt.data.empty()) {
-            evt.data = "{}";
+        const DispatchTable::Route& route = table->find(evt.notification_type);
+        if (route.wants_data) {
+            evt.data.assign(json);
+        }
+        for (const auto& h : route.handlers) {
+            h(evt, json);
         }
+        return;
+    }
+
+    // ---- resume.ok / resume.rejected ----------------------------------------
+    if (type == "resume.ok" || type == "resume.rejected") {
+        ResumeResult result;
+        result.resumed = type == "resume.ok";
+        decodeResumeResult(codec, frame.payload, result);
 
-        std::vector<NotifHandler> handlers;
+        ResumeHandler handler;
         {
             std::shared_lock lock(mu_);
-            handlers = notification_handlers_;
+            handler = on_resume_;
         }
-        for (const auto& h : handlers) {
-            if (h) {
-                h(evt);
-            }
+        if (handler) {
+            handler(result);
         }
         return;
     }
@@ -162,4 +399,16 @@ void NotificationManager::handleRaw(const std::string& raw_json) {
     // Unknown type — silently ignore.
 }
 
+void NotificationManager::post(std::string_view key, std::function<void()> task) {
+    if (!executor_) {
+        task();
+        return;
+    }
+    // Never blocks: this is the WebSocket thread, which must go on writing
+    // and answering heartbeats. The owner pauses reading while the executor
+    // is full() instead. False once the client shuts down; the task is
+    // dropped with it.
+    executor_->postNoWait(key, std::move(task));
+}
+
 } // namespace anychat
@@ -1,8 +1,14 @@
 #pragma once
 
+#include "frame_codec.h"
+#include "util/dispatch_executor.h"
+
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <shared_mutex>
@@ -17,59 +23,167 @@ struct MsgSentAck {
     std::string local_id; // echoed client-generated local ID
 };
 
+// Server answer to a session resume request (see SessionResumer).
+struct ResumeResult {
+    bool resumed = false; // missed pushes were replayed; false: fall back to /sync
+    int64_t last_seq = 0; // the server's latest push sequence, 0 if not given
+    std::string reason; // why the server refused, e.g. "gap_too_large"
+};
+
 // Payload delivered for all server-pushed notification events.
 struct NotificationEvent {
     std::string notification_type;
     int64_t timestamp = 0; // Unix seconds
-    std::string data = "{}";
+    std::string data = "{}"; // the event payload; only filled in for untyped handlers
 };
 
-// NotificationManager parses raw JSON frames received from the WebSocket and
-// dispatches them to the appropriate registered handler.
+// NotificationManager parses raw frames received from the WebSocket (JSON
+// text or BEVE binary) and dispatches them to the appropriate registered
+// handler. NotificationEvent::data is always JSON text.
+//
+// Each frame is decoded once: the envelopes keep their payloads as views
+// into the frame, and a typed subscriber's payload struct is read straight
+// from that view, without intermediate strings.
 //
 // Server frame types handled:
-//   "pong"          → on_pong_ callback
-//   "message.sent"  → on_msg_sent_ callback (MsgSentAck)
-//   "notification"  → all registered notification handlers (NotificationEvent)
+//   "pong"            → on_pong_ callback
+//   "message.sent"    → on_msg_sent_ callback (MsgSentAck)
+//   "notification"    → the handlers subscribed to its type (NotificationEvent)
+//   "resume.ok"       → on_resume_ callback (ResumeResult)
+//   "resume.rejected" → on_resume_ callback (ResumeResult)
 //
-// Unknown type values are silently ignored.
+// Unknown type values are silently ignored. A frame carrying a push sequence
+// number reports it to on_sequence_ once it has been dispatched.
 //
-// All handler slots are protected by a shared_mutex so they can be replaced
-// from any thread without data races.
+// The single-slot handlers are protected by a shared_mutex so they can be
+// replaced from any thread without data races. Notification subscriptions
+// are compiled into an immutable dispatch table that is swapped whole on
+// registration, so dispatching a notification only takes a lock to copy the
+// table pointer and does not allocate.
+//
+// With a DispatchExecutor, frames are still decoded on the WebSocket thread
+// but the notification and message.sent handlers run on the executor, keyed
+// so that the events of one conversation keep their order while different
+// conversations are handled in parallel. Pong, resume and sequence handlers
+// stay on the WebSocket thread: they only update connection state.
 class NotificationManager {
 public:
     using MsgSentHandler = std::function<void(const MsgSentAck&)>;
     using NotifHandler = std::function<void(const NotificationEvent&)>;
     using PongHandler = std::function<void()>;
+    using ResumeHandler = std::function<void(const ResumeResult&)>;
+    using SequenceHandler = std::function<void(int64_t seq)>;
 
-    NotificationManager() = default;
+    // Without an executor, handlers run inline on the calling thread.
+    explicit NotificationManager(std::shared_ptr<util::DispatchExecutor> executor = nullptr);
     ~NotificationManager() = default;
 
     // Not copyable or movable — handlers are expected to be stable pointers.
     NotificationManager(const NotificationManager&) = delete;
     NotificationManager& operator=(const NotificationManager&) = delete;
 
-    // Register callbacks. Passing nullptr clears the slot (message-sent / pong).
+    // Register callbacks. Passing nullptr clears the slot.
     void setOnMessageSent(MsgSentHandler h);
     void setOnPong(PongHandler h);
+    void setOnResume(ResumeHandler h);
+    void setOnSequence(SequenceHandler h);
+
+    // Registers |h| for the notification types matching |pattern|: one type
+    // ("message.new"), every type under a prefix ("group.*"), or every type
+    // ("*"). A type is routed to the handlers of its exact subscription and
+    // of every matching prefix, in registration order. Independent managers
+    // each subscribe to their own types without overwriting one another.
+    //
+    // Rebuilds the dispatch table: meant for setup, not for every frame.
+    // Safe to call concurrently with dispatch, including from a handler
+    // (the new table applies from the next frame).
+    void subscribe(std::string_view pattern, NotifHandler h);
+
+    // Typed form: the event payload is decoded from the frame straight into
+    // |Payload|, a glaze struct read with unknown keys ignored, and handed
+    // over next to the event (whose |data| may be left as "{}"). A payload
+    // that does not decode skips the handler.
+    //
+    // |key| picks the executor key from the payload, normally its
+    // conversation id; handlers posted under one key run in frame order.
+    // Without it the handler shares the "" key with the untyped ones.
+    template<typename Payload>
+    void subscribe(
+        std::string_view pattern,
+        std::function<void(const NotificationEvent&, const Payload&)> h,
+        std::function<std::string_view(const Payload&)> key = nullptr
+    ) {
+        if (!h) {
+            return;
+        }
+        auto handler = std::make_shared<const decltype(h)>(std::move(h)); // shared by the posted tasks
+        addSubscription(
+            pattern,
+            [this, handler, key = std::move(key)](const NotificationEvent& event, std::string_view json) {
+                Payload payload{};
+                std::string err;
+                if (!json_common::readJsonView(json, payload, err)) {
+                    return;
+                }
+                if (!executor_) {
+                    (*handler)(event, payload);
+                    return;
+                }
+                // Copied: the view may point into the payload moved below.
+                std::string task_key(key ? key(payload) : std::string_view{});
+                post(task_key, [handler, event, payload = std::move(payload)] {
+                    (*handler)(event, payload);
+                });
+            },
+            false
+        );
+    }
 
-    // Append a notification handler.  All registered handlers are invoked on
-    // every "notification" frame — each handler is responsible for filtering
-    // on event.notification_type.  Multiple subscribers are supported so that
-    // independent managers (MessageManager, ConversationManager, etc.) can each
-    // register their own handler without overwriting one another.
+    // Same as subscribe("*", h): the handler sees every notification and
+    // filters on event.notification_type itself.
     void addNotificationHandler(NotifHandler h);
 
-    // Parse `raw_json` and dispatch to the appropriate handler.
+    // Parse `raw` and dispatch to the appropriate handler.
     // Called from the WebSocket receive thread. Must not block.
-    void handleRaw(const std::string& raw_json);
+    // JSON `raw` must be NUL-terminated past its end (see readJsonRelaxed).
+    void handleRaw(std::string_view raw, FrameEncoding encoding = FrameEncoding::Json);
 
 private:
+    // Notification types and prefixes interned to integer ids, each id
+    // mapping to its precomputed handler list. Defined in the .cpp.
+    struct DispatchTable;
+
+    // Gets the event and its payload as JSON.
+    using RouteHandler = std::function<void(const NotificationEvent&, std::string_view json)>;
+
+    struct Subscription {
+        std::string key; // exact type, prefix ending in '.', or "" for all
+        RouteHandler handler;
+        bool wants_data = false; // untyped: needs NotificationEvent::data
+    };
+
+    void addSubscription(std::string_view pattern, RouteHandler handler, bool wants_data);
+    // The current table; holding it keeps its handlers alive.
+    std::shared_ptr<const DispatchTable> tableSnapshot() const;
+    void dispatch(const FrameCodec& codec, const FrameEnvelope& frame);
+    // Runs |task| on the executor under |key|, or inline without one.
+    void post(std::string_view key, std::function<void()> task);
+
+    const std::shared_ptr<util::DispatchExecutor> executor_;
+
     mutable std::shared_mutex mu_;
 
     MsgSentHandler on_msg_sent_;
-    std::vector<NotifHandler> notification_handlers_;
     PongHandler on_pong_;
+    ResumeHandler on_resume_;
+    SequenceHandler on_sequence_;
+
+    std::mutex subscribe_mu_; // serialises table rebuilds
+    std::vector<Subscription> subscriptions_; // guarded by subscribe_mu_
+    // Swapped whole on each rebuild. Held only to copy or replace the
+    // pointer: libc++ has no std::atomic<std::shared_ptr>.
+    mutable std::mutex table_mu_;
+    std::shared_ptr<const DispatchTable> table_; // guarded by table_mu_
 };
 
 } // namespace anychat
@@ -1,15 +1,11 @@
 #include "outbound_queue.h"
 
-#include "json_common.h"
-
 #include <chrono>
 #include <cstdint>
 #include <utility>
 
 namespace anychat::outbound_queue_detail {
 
-using json_common::writeJson;
-
 struct SendMessagePayload {
     std::string conversation_id{};
     std::string conversation_type{};
@@ -18,10 +14,8 @@ struct SendMessagePayload {
     std::string local_id{};
 };
 
-struct SendMessageFrame {
-    std::string type{};
-    SendMessagePayload payload{};
-};
+constexpr const char* kPendingRowsSql = "SELECT local_id, conv_id, conv_type, content_type, content "
+                                        "FROM outbound_queue ORDER BY created_at ASC";
 
 } // namespace anychat::outbound_queue_detail
 
@@ -36,6 +30,14 @@ using namespace outbound_queue_detail;
 OutboundQueue::OutboundQueue(db::Database* db)
     : db_(db) {}
 
+OutboundQueue::~OutboundQueue() {
+    // A resume queued by onDrained() may still be waiting on the DB worker;
+    // it runs tasks in order, so this returns once that one has run.
+    if (db_->isOpen()) {
+        db_->querySync("SELECT 1");
+    }
+}
+
 // ---------------------------------------------------------------------------
 // Public interface
 // ---------------------------------------------------------------------------
@@ -63,61 +65,58 @@ void OutboundQueue::enqueue(
     );
 
     // Store the callback in memory and, if connected, send immediately.
-    SendFn current_send_fn;
+    // While paused the row waits for onDrained() so it keeps its place.
+    bool can_send = false;
     {
         std::lock_guard lock(mu_);
         if (cb.on_success || cb.on_error) {
             callbacks_.emplace(local_id, std::move(cb));
         }
-        current_send_fn = send_fn_;
+        can_send = send_fn_ && !paused_;
     }
 
-    if (current_send_fn) {
+    if (can_send) {
         sendRow(conv_id, conv_type, content_type, content, local_id);
     }
 }
 
-void OutboundQueue::onConnected(SendFn send_fn) {
+void OutboundQueue::onConnected(SendFn send_fn, FrameCodec codec) {
     {
         std::lock_guard lock(mu_);
         send_fn_ = std::move(send_fn);
+        codec_ = codec;
+        paused_ = false;
+        in_flight_.clear();
     }
 
-    // Flush all pending rows from the DB (retry_count is informational only;
-    // we re-send every pending row on reconnect).
-    db::Rows rows = db_->querySync("SELECT local_id, conv_id, conv_type, content_type, content "
-                                   "FROM outbound_queue ORDER BY created_at ASC");
-
-    for (const auto& row : rows) {
-        // Guard: skip rows with missing mandatory columns.
-        auto it_lid = row.find("local_id");
-        auto it_cid = row.find("conv_id");
-        auto it_ct = row.find("conv_type");
-        auto it_ctype = row.find("content_type");
-        auto it_body = row.find("content");
-
-        if (it_lid == row.end() || it_cid == row.end() || it_ct == row.end() || it_ctype == row.end()
-            || it_body == row.end()) {
-            continue;
-        }
-
-        int32_t content_type = 0;
-        try {
-            content_type = static_cast<int32_t>(std::stoll(it_ctype->second));
-        } catch (...) {
-            continue;
-        }
-
-        sendRow(it_cid->second, it_ct->second, content_type, it_body->second, it_lid->second);
-    }
+    // Re-send every pending row (retry_count is informational only).
+    flush();
 }
 
 void OutboundQueue::onDisconnected() {
     std::lock_guard lock(mu_);
     send_fn_ = nullptr;
+    paused_ = false;
+    in_flight_.clear();
 }
 
-bool OutboundQueue::sendTransient(const std::string& json_payload) {
+void OutboundQueue::onDrained() {
+    {
+        std::lock_guard lock(mu_);
+        ++drained_count_;
+        if (!send_fn_ || !paused_) {
+            return;
+        }
+        paused_ = false;
+    }
+    // Runs on the WebSocket thread: read the rows on the DB worker rather
+    // than wait for it here.
+    db_->query(kPendingRowsSql, {}, [this](db::Rows rows, const std::string& /*err*/) {
+        sendRows(rows);
+    });
+}
+
+bool OutboundQueue::sendTransient(const std::string& frame, network::SendPriority priority) {
     SendFn fn;
     {
         std::lock_guard lock(mu_);
@@ -126,8 +125,7 @@ bool OutboundQueue::sendTransient(const std::string& json_payload) {
     if (!fn) {
         return false;
     }
-    fn(json_payload);
-    return true;
+    return fn(frame, priority);
 }
 
 void OutboundQueue::onMessageSentAck(const MsgSentAck& ack) {
@@ -142,6 +140,7 @@ void OutboundQueue::onMessageSentAck(const MsgSentAck& ack) {
     AnyChatCallback cb{};
     {
         std::lock_guard lock(mu_);
+        in_flight_.erase(ack.local_id);
         auto it = callbacks_.find(ack.local_id);
         if (it != callbacks_.end()) {
             cb = std::move(it->second);
@@ -158,60 +157,109 @@ void OutboundQueue::onMessageSentAck(const MsgSentAck& ack) {
 // Private helpers
 // ---------------------------------------------------------------------------
 
+void OutboundQueue::flush() {
+    sendRows(db_->querySync(kPendingRowsSql));
+}
+
+void OutboundQueue::sendRows(const db::Rows& rows) {
+    for (const auto& row : rows) {
+        // Guard: skip rows with missing mandatory columns.
+        auto it_lid = row.find("local_id");
+        auto it_cid = row.find("conv_id");
+        auto it_ct = row.find("conv_type");
+        auto it_ctype = row.find("content_type");
+        auto it_body = row.find("content");
+
+        if (it_lid == row.end() || it_cid == row.end() || it_ct == row.end() || it_ctype == row.end()
+            || it_body == row.end()) {
+            continue;
+        }
+
+        int32_t content_type = 0;
+        try {
+            content_type = static_cast<int32_t>(std::stoll(it_ctype->second));
+        } catch (...) {
+            continue;
+        }
+
+        if (!sendRow(it_cid->second, it_ct->second, content_type, it_body->second, it_lid->second)) {
+            break;
+        }
+    }
+}
+
 // static
 std::string OutboundQueue::buildSendFrame(
+    const FrameCodec& codec,
     const std::string& conv_id,
     const std::string& conv_type,
     int32_t content_type,
     const std::string& content,
     const std::string& local_id
 ) {
-    SendMessageFrame frame{
-        .type = "message.send",
-        .payload =
-            SendMessagePayload{
-                .conversation_id = conv_id,
-                .conversation_type = conv_type,
-                .content_type = content_type,
-                .content = content,
-                .local_id = local_id,
-            },
+    const SendMessagePayload payload{
+        .conversation_id = conv_id,
+        .conversation_type = conv_type,
+        .content_type = content_type,
+        .content = content,
+        .local_id = local_id,
     };
 
-    std::string json;
+    std::string frame;
     std::string err;
-    if (!writeJson(frame, json, err)) {
+    if (!codec.encodeFrame("message.send", payload, frame, err)) {
         return "";
     }
-    return json;
+    return frame;
 }
 
-void OutboundQueue::sendRow(
+bool OutboundQueue::sendRow(
     const std::string& conv_id,
     const std::string& conv_type,
     int32_t content_type,
     const std::string& content,
     const std::string& local_id
 ) {
-    // Capture send_fn under the lock, then call it outside.
+    // Capture send_fn under the lock, then call it outside. Claiming the
+    // local_id first keeps a concurrent enqueue() and flush() from sending
+    // the same row twice.
     SendFn fn;
+    FrameCodec codec;
+    uint64_t drained_count = 0;
     {
         std::lock_guard lock(mu_);
+        if (!send_fn_ || paused_) {
+            return false;
+        }
+        if (!in_flight_.insert(local_id).second) {
+            return true;
+        }
         fn = send_fn_;
-    }
-    if (!fn) {
-        return;
+        codec = codec_;
+        drained_count = drained_count_;
     }
 
-    const std::string payload = buildSendFrame(conv_id, conv_type, content_type, content, local_id);
+    const std::string payload = buildSendFrame(codec, conv_id, conv_type, content_type, content, local_id);
     if (payload.empty()) {
-        return;
+        return true;
     }
 
-    // Bump retry_count in the DB before sending (best-effort; ignore errors).
-    db_->exec("UPDATE outbound_queue SET retry_count = retry_count + 1 WHERE local_id = ?", { local_id });
+    while (!fn(payload, network::SendPriority::Bulk)) {
+        std::lock_guard lock(mu_);
+        // The transport may have drained between refusing the frame and
+        // here; that onDrained() found nothing paused, so try again rather
+        // than wait for a drain that already happened.
+        if (drained_count_ == drained_count) {
+            in_flight_.erase(local_id);
+            paused_ = true;
+            return false;
+        }
+        drained_count = drained_count_;
+    }
 
-    fn(payload);
+    // Bump retry_count in the DB (best-effort; ignore errors).
+    db_->exec("UPDATE outbound_queue SET retry_count = retry_count + 1 WHERE local_id = ?", { local_id });
+    return true;
 }
 
 } // namespace anychat
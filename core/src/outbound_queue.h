@@ -1,16 +1,20 @@
 #pragma once
 
+#include "frame_codec.h"
 #include "notification_manager.h"
 
 #include "sdk_callbacks.h"
 #include "db/database.h"
+#include "network/iwebsocket_client.h"
 
 #include <functional>
 #include <cstdint>
 // `memory` include not needed (no shared_ptr)
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace anychat {
 
@@ -18,21 +22,30 @@ namespace anychat {
 //
 // Lifecycle:
 //   1. Call enqueue() to persist a message and store its completion callback.
-//   2. Call onConnected(send_fn) whenever the WebSocket connects; the queue
-//      will immediately flush all rows whose status is "pending".
+//   2. Call onConnected(send_fn, codec) whenever the WebSocket connects; the
+//      queue will immediately flush all rows whose status is "pending".
+//      Frames are encoded with |codec|, the encoding negotiated for that
+//      connection.
 //   3. Call onMessageSentAck() with acks received via NotificationManager to
 //      mark rows as sent and invoke their callbacks.
 //   4. Call onDisconnected() when the WebSocket drops; the queue stops
 //      sending but retains pending rows for the next onConnected() call.
 //
+// Flow control: message frames are sent at SendPriority::Bulk. When the
+// transport refuses one (its send queue is congested) the queue pauses and
+// leaves the remaining rows in the DB; onDrained() resumes the flush where
+// it stopped. Rows enqueued while paused wait their turn.
+//
 // Thread-safety: all public methods are safe to call from any thread.
 class OutboundQueue {
 public:
-    // `send_fn` is provided by onConnected(); it wraps the live WebSocket send.
-    using SendFn = std::function<void(const std::string& json_payload)>;
+    // `send_fn` is provided by onConnected(); it wraps the live WebSocket send
+    // and receives frames already encoded with the connection's codec.
+    // Returns false if the transport refused the frame.
+    using SendFn = std::function<bool(const std::string& frame, network::SendPriority priority)>;
 
     explicit OutboundQueue(db::Database* db);
-    ~OutboundQueue() = default;
+    ~OutboundQueue(); // waits for a resume onDrained() queued
 
     OutboundQueue(const OutboundQueue&) = delete;
     OutboundQueue& operator=(const OutboundQueue&) = delete;
@@ -51,16 +64,53 @@ public:
 
     // Called when the WebSocket connection is established.
     // Flushes all pending rows through `send_fn`.
-    void onConnected(SendFn send_fn);
+    void onConnected(SendFn send_fn, FrameCodec codec = {});
 
     // Called when the WebSocket connection is lost.
     // Clears the active send function; pending rows will be retried next time
     // onConnected() is called.
     void onDisconnected();
 
+    // Called when the transport accepts bulk frames again after refusing
+    // one; resumes a paused flush. Returns at once: the rows are read and
+    // sent on the DB worker, so the WebSocket thread never waits for it.
+    void onDrained();
+
     // Send a transient frame without persisting/retrying. Returns false when
     // no active WebSocket sender is available.
-    bool sendTransient(const std::string& json_payload);
+    bool sendTransient(const std::string& frame, network::SendPriority priority = network::SendPriority::Control);
+
+    // Encode {type, payload} with the connection's codec and send it as a
+    // transient frame. On failure |err| says why (not connected, refused,
+    // encoding).
+    template<typename T>
+    bool sendTransient(
+        std::string_view type,
+        const T& payload,
+        std::string& err,
+        network::SendPriority priority = network::SendPriority::Control
+    ) {
+        SendFn fn;
+        FrameCodec codec;
+        {
+            std::lock_guard lock(mu_);
+            fn = send_fn_;
+            codec = codec_;
+        }
+        if (!fn) {
+            err = "websocket not connected";
+            return false;
+        }
+        std::string frame;
+        if (!codec.encodeFrame(type, payload, frame, err)) {
+            return false;
+        }
+        if (!fn(frame, priority)) {
+            err = "websocket send queue full";
+            return false;
+        }
+        return true;
+    }
 
     // Called by NotificationManager (or equivalent) when the server echoes a
     // message.sent acknowledgement. Matches by local_id, removes the DB row,
@@ -68,8 +118,9 @@ public:
     void onMessageSentAck(const MsgSentAck& ack);
 
 private:
-    // Build the JSON payload for a message.send frame.
+    // Build a message.send frame in the encoding of `codec`.
     static std::string buildSendFrame(
+        const FrameCodec& codec,
         const std::string& conv_id,
         const std::string& conv_type,
         int32_t content_type,
@@ -77,10 +128,15 @@ private:
         const std::string& local_id
     );
 
-    // Send a single row and increment its retry_count in the DB.
-    // Must be called while holding mu_ (shared or exclusive as appropriate)
-    // and while send_fn_ is valid.
-    void sendRow(
+    // Send every pending row not yet sent on this connection, oldest first,
+    // until the transport refuses one.
+    void flush();
+    void sendRows(const db::Rows& rows);
+
+    // Send a single row and increment its retry_count in the DB. Returns
+    // false if the transport refused it, which pauses the queue. Rows
+    // already sent on this connection are skipped. Call without holding mu_.
+    bool sendRow(
         const std::string& conv_id,
         const std::string& conv_type,
         int32_t content_type,
@@ -94,6 +150,16 @@ private:
 
     // Active WebSocket send function; null when disconnected.
     SendFn send_fn_;
+    FrameCodec codec_;
+
+    // Flow control for the current connection: set when a send was refused,
+    // cleared by onDrained().
+    bool paused_ = false;
+    // onDrained() calls so far; lets sendRow() notice a drain that raced
+    // with a refused send.
+    uint64_t drained_count_ = 0;
+    // local_ids sent on the current connection and not yet acknowledged.
+    std::unordered_set<std::string> in_flight_;
 
     // In-memory map from local_id → completion callback.
     // Populated by enqueue(), consumed by onMessageSentAck().
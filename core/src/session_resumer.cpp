@@ -0,0 +1,163 @@
+#include "session_resumer.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace anychat::session_resumer_detail {
+
+struct ResumeRequestPayload {
+    int64_t last_seq = 0;
+};
+
+} // namespace anychat::session_resumer_detail
+
+namespace anychat {
+using namespace session_resumer_detail;
+
+SessionResumer::SessionResumer(
+    std::shared_ptr<util::TimerScheduler> timers,
+    std::function<void()> full_sync,
+    std::chrono::milliseconds timeout
+)
+    : timers_(std::move(timers))
+    , full_sync_(std::move(full_sync))
+    , timeout_(timeout) {}
+
+SessionResumer::~SessionResumer() {
+    util::TimerId timer = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer = settleLocked();
+    }
+    // Waits for a running timeout callback.
+    timers_->cancel(timer);
+}
+
+void SessionResumer::onConnected(const FrameCodec& codec, SendFn send) {
+    util::TimerId superseded = 0;
+    int64_t last_seq = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        superseded = settleLocked();
+        last_seq = last_seq_;
+    }
+    timers_->cancel(superseded);
+
+    std::string frame;
+    std::string err;
+    if (last_seq <= 0 || !codec.encodeFrame("resume", ResumeRequestPayload{ .last_seq = last_seq }, frame, err)) {
+        fullSync();
+        return;
+    }
+
+    // Armed before sending so that an answer cannot overtake the attempt.
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = true;
+        const uint64_t attempt = ++attempt_;
+        timer_ = timers_->schedule(timeout_, [this, attempt]() {
+            onTimeout(attempt);
+        });
+    }
+    if (!send(frame)) {
+        util::TimerId timer = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            timer = settleLocked();
+        }
+        timers_->cancel(timer);
+        fullSync();
+    }
+}
+
+void SessionResumer::onDisconnected() {
+    util::TimerId timer = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer = settleLocked();
+    }
+    timers_->cancel(timer);
+}
+
+void SessionResumer::onResumeResult(const ResumeResult& result) {
+    util::TimerId timer = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (result.resumed) {
+            last_seq_ = std::max(last_seq_, result.last_seq);
+        } else if (result.last_seq > 0) {
+            // The sync covers everything up to now. Taken as is: a server
+            // that lost its history may have restarted its numbering.
+            last_seq_ = result.last_seq;
+        }
+        if (!pending_) {
+            return; // late answer, the attempt already fell back
+        }
+        timer = settleLocked();
+        if (result.resumed) {
+            ++stats_.resumed;
+        } else {
+            ++stats_.rejected;
+        }
+    }
+    timers_->cancel(timer);
+    if (!result.resumed) {
+        fullSync();
+    }
+}
+
+void SessionResumer::onSequence(int64_t seq) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_seq_ = std::max(last_seq_, seq);
+}
+
+void SessionResumer::reset() {
+    util::TimerId timer = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer = settleLocked();
+        last_seq_ = 0;
+    }
+    timers_->cancel(timer);
+}
+
+int64_t SessionResumer::lastSeq() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_seq_;
+}
+
+SessionResumeStats SessionResumer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+util::TimerId SessionResumer::settleLocked() {
+    pending_ = false;
+    ++attempt_;
+    return std::exchange(timer_, 0);
+}
+
+void SessionResumer::onTimeout(uint64_t attempt) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!pending_ || attempt != attempt_) {
+            return; // settled while firing
+        }
+        pending_ = false;
+        timer_ = 0;
+        ++stats_.timed_out;
+    }
+    fullSync();
+}
+
+void SessionResumer::fullSync() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.full_syncs;
+    }
+    if (full_sync_) {
+        full_sync_();
+    }
+}
+
+} // namespace anychat
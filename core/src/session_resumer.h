@@ -0,0 +1,94 @@
+#pragma once
+
+#include "frame_codec.h"
+#include "notification_manager.h"
+
+#include "util/timer_wheel.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace anychat {
+
+struct SessionResumeStats {
+    uint64_t resumed = 0; // reconnects caught up over the socket
+    uint64_t rejected = 0; // the server no longer had the missed pushes
+    uint64_t timed_out = 0; // no answer, e.g. a server without resume support
+    uint64_t full_syncs = 0;
+};
+
+// Decides how the client catches up after the WebSocket (re)connects.
+//
+// A server that supports resume stamps every push with a sequence number
+// (the envelope's "seq") and keeps a window of recent pushes. After a
+// reconnect within the same login the client sends
+//
+//   {"type":"resume","payload":{"last_seq":N}}
+//
+// ahead of everything else; the server replays the pushes after N over the
+// socket and answers "resume.ok", or answers "resume.rejected" when N has
+// left its window. Only a rejection, a missing answer or the first
+// connection of a login fall back to the full POST /sync.
+//
+// Thread-safe. |full_sync| runs on the thread that settles the attempt (the
+// WebSocket or the timer thread) and must not block.
+class SessionResumer {
+public:
+    // Sends an encoded frame; false if it could not be queued.
+    using SendFn = std::function<bool(const std::string& frame)>;
+
+    static constexpr std::chrono::milliseconds kDefaultTimeout{ 5000 };
+
+    SessionResumer(
+        std::shared_ptr<util::TimerScheduler> timers,
+        std::function<void()> full_sync,
+        std::chrono::milliseconds timeout = kDefaultTimeout
+    );
+    ~SessionResumer();
+
+    SessionResumer(const SessionResumer&) = delete;
+    SessionResumer& operator=(const SessionResumer&) = delete;
+
+    // The connection is ready: ask to resume from the last sequence seen,
+    // or sync if there is none.
+    void onConnected(const FrameCodec& codec, SendFn send);
+
+    // Abandons a pending attempt; the next connection decides again.
+    void onDisconnected();
+
+    void onResumeResult(const ResumeResult& result);
+
+    // A push carrying |seq| has been dispatched.
+    void onSequence(int64_t seq);
+
+    // New login: the next connection syncs.
+    void reset();
+
+    int64_t lastSeq() const;
+    SessionResumeStats stats() const;
+
+private:
+    // Ends the pending attempt, if any; returns its timer for the caller to
+    // cancel after unlocking. mutex_ must be held.
+    util::TimerId settleLocked();
+
+    void onTimeout(uint64_t attempt);
+    void fullSync();
+
+    std::shared_ptr<util::TimerScheduler> timers_;
+    std::function<void()> full_sync_;
+    const std::chrono::milliseconds timeout_;
+
+    mutable std::mutex mutex_;
+    int64_t last_seq_ = 0;
+    bool pending_ = false;
+    uint64_t attempt_ = 0; // identifies the pending attempt's timer
+    util::TimerId timer_ = 0;
+    SessionResumeStats stats_;
+};
+
+} // namespace anychat
@@ -2,6 +2,7 @@
 
 #include "json_common.h"
 
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -11,11 +12,13 @@
 namespace anychat::sync_engine_detail {
 
 using json_common::ApiEnvelope;
+using json_common::finishStreamedBody;
 using json_common::nowMs;
 using json_common::parseBoolValue;
 using json_common::parseInt64Value;
 using json_common::parseTimestampMs;
 using json_common::readJsonRelaxed;
+using json_common::streamJsonBody;
 using json_common::toLower;
 using json_common::writeJson;
 
@@ -119,207 +122,166 @@ std::string parseMessageContent(const std::optional<MessageContentValue>& value)
     return parsed ? *parsed : raw;
 }
 
-const std::vector<FriendDeltaPayload>* toFriendPayloadList(const std::optional<FriendListPayload>& value) {
-    return (value.has_value() && value->friends.has_value()) ? &(*value->friends) : nullptr;
-}
-
-const std::vector<GroupDeltaPayload>* toGroupPayloadList(const std::optional<GroupListPayload>& value) {
-    return (value.has_value() && value->groups.has_value()) ? &(*value->groups) : nullptr;
-}
-
-const std::vector<ConversationDeltaPayload>*
-toConversationDeltaPayloadList(const std::optional<ConversationDeltaListPayload>& value) {
-    return (value.has_value() && value->conversations.has_value()) ? &(*value->conversations) : nullptr;
-}
+bool mergeFriend(db::Database* db, const FriendDeltaPayload& payload) {
+    if (payload.user_id.empty()) {
+        return true;
+    }
 
-const std::vector<ConversationMessagesPayload>*
-toConversationPayloadList(const std::optional<std::vector<ConversationMessagesPayload>>& value) {
-    return value.has_value() ? &(*value) : nullptr;
+    return db->execSync(
+        "INSERT INTO friends (user_id, remark, updated_at_ms, is_deleted) "
+        "VALUES (?, ?, ?, ?) "
+        "ON CONFLICT(user_id) DO UPDATE SET "
+        "  remark       = excluded.remark, "
+        "  updated_at_ms = excluded.updated_at_ms, "
+        "  is_deleted   = excluded.is_deleted",
+        { payload.user_id,
+          payload.remark,
+          parseInt64Value(payload.updated_at, 0),
+          static_cast<int64_t>(parseBoolValue(payload.is_deleted, false) ? 1 : 0) }
+    );
 }
 
-void mergeFriends(db::Database* db, const std::vector<FriendDeltaPayload>& friends) {
-    for (const auto& payload : friends) {
-        if (payload.user_id.empty()) {
-            continue;
-        }
-
-        db->execSync(
-            "INSERT INTO friends (user_id, remark, updated_at_ms, is_deleted) "
-            "VALUES (?, ?, ?, ?) "
-            "ON CONFLICT(user_id) DO UPDATE SET "
-            "  remark       = excluded.remark, "
-            "  updated_at_ms = excluded.updated_at_ms, "
-            "  is_deleted   = excluded.is_deleted",
-            { payload.user_id,
-              payload.remark,
-              parseInt64Value(payload.updated_at, 0),
-              static_cast<int64_t>(parseBoolValue(payload.is_deleted, false) ? 1 : 0) }
-        );
+bool mergeGroup(db::Database* db, const GroupDeltaPayload& payload) {
+    if (payload.group_id.empty()) {
+        return true;
     }
-}
 
-void mergeGroups(db::Database* db, const std::vector<GroupDeltaPayload>& groups) {
-    for (const auto& payload : groups) {
-        if (payload.group_id.empty()) {
-            continue;
-        }
-
-        db->execSync(
-            "INSERT INTO groups (group_id, name, avatar_url, member_count, updated_at_ms) "
-            "VALUES (?, ?, ?, ?, ?) "
-            "ON CONFLICT(group_id) DO UPDATE SET "
-            "  name          = excluded.name, "
-            "  avatar_url    = excluded.avatar_url, "
-            "  member_count  = excluded.member_count, "
-            "  updated_at_ms = excluded.updated_at_ms",
-            { payload.group_id,
-              payload.name,
-              payload.avatar,
-              parseInt64Value(payload.member_count, 0),
-              parseInt64Value(payload.updated_at, 0) }
-        );
-    }
+    return db->execSync(
+        "INSERT INTO groups (group_id, name, avatar_url, member_count, updated_at_ms) "
+        "VALUES (?, ?, ?, ?, ?) "
+        "ON CONFLICT(group_id) DO UPDATE SET "
+        "  name          = excluded.name, "
+        "  avatar_url    = excluded.avatar_url, "
+        "  member_count  = excluded.member_count, "
+        "  updated_at_ms = excluded.updated_at_ms",
+        { payload.group_id,
+          payload.name,
+          payload.avatar,
+          parseInt64Value(payload.member_count, 0),
+          parseInt64Value(payload.updated_at, 0) }
+    );
 }
 
-void mergeSessions(
+bool mergeSession(
     db::Database* db,
     cache::ConversationCache* conv_cache,
-    const std::vector<ConversationDeltaPayload>& sessions
+    const ConversationDeltaPayload& payload
 ) {
-    for (const auto& payload : sessions) {
-        if (payload.conversation_id.empty()) {
-            continue;
-        }
+    if (payload.conversation_id.empty()) {
+        return true;
+    }
 
-        const std::string conversation_type = toLower(payload.conversation_type);
-        const std::string session_type = (conversation_type == "group") ? "group" : "private";
-        std::string last_msg_text = parseMessageContent(payload.last_message_content);
-
-        const int64_t last_msg_time = parseTimestampMs(payload.last_message_time);
-        const int32_t unread_count = static_cast<int32_t>(parseInt64Value(payload.unread_count, 0));
-        const bool is_pinned = parseBoolValue(payload.is_pinned, false);
-        const bool is_muted = parseBoolValue(payload.is_muted, false);
-        const int64_t now = nowMs();
-
-        db->execSync(
-            "INSERT INTO conversations "
-            "  (conv_id, conv_type, target_id, last_msg_text, "
-            "   last_msg_time_ms, unread_count, is_pinned, is_muted, updated_at_ms) "
-            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?) "
-            "ON CONFLICT(conv_id) DO UPDATE SET "
-            "  conv_type        = excluded.conv_type, "
-            "  target_id        = excluded.target_id, "
-            "  last_msg_text    = excluded.last_msg_text, "
-            "  last_msg_time_ms = excluded.last_msg_time_ms, "
-            "  unread_count     = excluded.unread_count, "
-            "  is_pinned        = excluded.is_pinned, "
-            "  is_muted         = excluded.is_muted, "
-            "  updated_at_ms    = excluded.updated_at_ms",
-            { payload.conversation_id,
-              session_type,
-              payload.target_id,
-              last_msg_text,
-              last_msg_time,
-              static_cast<int64_t>(unread_count),
-              static_cast<int64_t>(is_pinned ? 1 : 0),
-              static_cast<int64_t>(is_muted ? 1 : 0),
-              now }
-        );
-
-        Conversation conv;
-        conv.conv_id = payload.conversation_id;
-        conv.conv_type = (session_type == "group") ? ConversationType::Group : ConversationType::Private;
-        conv.target_id = payload.target_id;
-        conv.last_msg_text = last_msg_text;
-        conv.last_msg_time_ms = last_msg_time;
-        conv.unread_count = unread_count;
-        conv.is_pinned = is_pinned;
-        conv.is_muted = is_muted;
-        conv.updated_at_ms = now;
-
-        conv_cache->upsert(std::move(conv));
+    const std::string conversation_type = toLower(payload.conversation_type);
+    const std::string session_type = (conversation_type == "group") ? "group" : "private";
+    std::string last_msg_text = parseMessageContent(payload.last_message_content);
+
+    const int64_t last_msg_time = parseTimestampMs(payload.last_message_time);
+    const int32_t unread_count = static_cast<int32_t>(parseInt64Value(payload.unread_count, 0));
+    const bool is_pinned = parseBoolValue(payload.is_pinned, false);
+    const bool is_muted = parseBoolValue(payload.is_muted, false);
+    const int64_t now = nowMs();
+
+    const bool stored = db->execSync(
+        "INSERT INTO conversations "
+        "  (conv_id, conv_type, target_id, last_msg_text, "
+        "   last_msg_time_ms, unread_count, is_pinned, is_muted, updated_at_ms) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?) "
+        "ON CONFLICT(conv_id) DO UPDATE SET "
+        "  conv_type        = excluded.conv_type, "
+        "  target_id        = excluded.target_id, "
+        "  last_msg_text    = excluded.last_msg_text, "
+        "  last_msg_time_ms = excluded.last_msg_time_ms, "
+        "  unread_count     = excluded.unread_count, "
+        "  is_pinned        = excluded.is_pinned, "
+        "  is_muted         = excluded.is_muted, "
+        "  updated_at_ms    = excluded.updated_at_ms",
+        { payload.conversation_id,
+          session_type,
+          payload.target_id,
+          last_msg_text,
+          last_msg_time,
+          static_cast<int64_t>(unread_count),
+          static_cast<int64_t>(is_pinned ? 1 : 0),
+          static_cast<int64_t>(is_muted ? 1 : 0),
+          now }
+    );
+    if (!stored) {
+        return false;
     }
+
+    Conversation conv;
+    conv.conv_id = payload.conversation_id;
+    conv.conv_type = (session_type == "group") ? ConversationType::Group : ConversationType::Private;
+    conv.target_id = payload.target_id;
+    conv.last_msg_text = last_msg_text;
+    conv.last_msg_time_ms = last_msg_time;
+    conv.unread_count = unread_count;
+    conv.is_pinned = is_pinned;
+    conv.is_muted = is_muted;
+    conv.updated_at_ms = now;
+
+    conv_cache->upsert(std::move(conv));
+    return true;
 }
 
-void mergeConvMessages(
-    db::Database* db,
-    cache::ConversationCache* conv_cache,
-    cache::MessageCache* msg_cache,
-    const std::vector<ConversationMessagesPayload>& conversations
-) {
-    for (const auto& conv : conversations) {
-        if (conv.conversation_id.empty()) {
-            continue;
-        }
-        if (!conv.messages.has_value()) {
+void mergeConvMessages(MessageIngestor* ingestor, const ConversationMessagesPayload& conv) {
+    if (conv.conversation_id.empty()) {
+        return;
+    }
+    if (!conv.messages.has_value()) {
+        return;
+    }
+
+    std::vector<Message> messages;
+    messages.reserve(conv.messages->size());
+    for (const auto& payload : *conv.messages) {
+        if (payload.message_id.empty()) {
             continue;
         }
 
-        const std::string& conv_id = conv.conversation_id;
-        int64_t max_seq_seen = 0;
+        const int32_t content_type_raw = static_cast<int32_t>(parseInt64Value(payload.content_type, 1));
+
+        Message msg;
+        msg.message_id = payload.message_id;
+        msg.conv_id = conv.conversation_id;
+        msg.sender_id = payload.sender_id;
+        msg.content_type = (content_type_raw >= 1 && content_type_raw <= 7) ? content_type_raw : 1;
+        msg.content = parseMessageContent(payload.content);
+        msg.seq = parseInt64Value(payload.sequence, 0);
+        msg.reply_to = payload.reply_to;
+        msg.status = static_cast<int>(parseInt64Value(payload.status, 0));
+        msg.send_state = 1;
+        msg.timestamp_ms = parseTimestampMs(payload.created_at);
+        messages.push_back(std::move(msg));
+    }
 
-        for (const auto& payload : *conv.messages) {
-            if (payload.message_id.empty()) {
-                continue;
-            }
+    // Stored without overwriting local rows, and local_seq moves up to the
+    // highest seq seen.
+    ingestor->ingest(std::move(messages), IngestSource::Sync);
+}
 
-            const int64_t sequence = parseInt64Value(payload.sequence, 0);
-            const int64_t timestamp_ms = parseTimestampMs(payload.created_at);
-            const std::string content = parseMessageContent(payload.content);
-            const int status = static_cast<int>(parseInt64Value(payload.status, 0));
-            const int32_t content_type_raw = static_cast<int32_t>(parseInt64Value(payload.content_type, 1));
-            const int32_t content_type = (content_type_raw >= 1 && content_type_raw <= 7) ? content_type_raw : 1;
-
-            db->execSync(
-                "INSERT OR IGNORE INTO messages "
-                "  (message_id, conv_id, sender_id, content_type, content, "
-                "   seq, reply_to, status, send_state, timestamp_ms, local_id) "
-                "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
-                { payload.message_id,
-                  conv_id,
-                  payload.sender_id,
-                  static_cast<int64_t>(content_type),
-                  content,
-                  sequence,
-                  payload.reply_to,
-                  static_cast<int64_t>(status),
-                  static_cast<int64_t>(1),
-                  timestamp_ms,
-                  std::string{} }
-            );
-
-            Message msg;
-            msg.message_id = payload.message_id;
-            msg.conv_id = conv_id;
-            msg.sender_id = payload.sender_id;
-            msg.content_type = content_type;
-            msg.content = content;
-            msg.seq = sequence;
-            msg.reply_to = payload.reply_to;
-            msg.status = status;
-            msg.send_state = 1;
-            msg.timestamp_ms = timestamp_ms;
-            msg_cache->insert(msg);
-
-            if (sequence > max_seq_seen) {
-                max_seq_seen = sequence;
-            }
-        }
+// The delta lists of one /sync response, decoded while the body arrives and
+// merged once the envelope confirmed success.
+struct SyncDeltas {
+    std::vector<FriendDeltaPayload> friends;
+    std::vector<GroupDeltaPayload> groups;
+    std::vector<ConversationDeltaPayload> sessions;
+    std::vector<ConversationMessagesPayload> conversations;
+};
 
-        if (max_seq_seen > 0) {
-            db->execSync(
-                "UPDATE conversations SET local_seq = MAX(local_seq, ?) "
-                "WHERE conv_id = ?",
-                { max_seq_seen, conv_id }
-            );
-
-            auto cached = conv_cache->get(conv_id);
-            if (cached.has_value() && max_seq_seen > cached->local_seq) {
-                cached->local_seq = max_seq_seen;
-                conv_cache->upsert(std::move(*cached));
-            }
+// Decodes each element of the array at |path| into |out|. An element that
+// does not decode aborts the stream, so the sync fails rather than skip it.
+template<typename Payload>
+void collectArray(network::JsonArrayStreamer& streamer, std::vector<std::string> path, std::vector<Payload>& out) {
+    streamer.onArray(std::move(path), [&out](const std::string& element) {
+        Payload payload{};
+        std::string parse_err;
+        if (!readJsonRelaxed(element, payload, parse_err)) {
+            return false;
         }
-    }
+        out.push_back(std::move(payload));
+        return true;
+    });
 }
 
 } // namespace anychat::sync_engine_detail
@@ -331,12 +293,12 @@ using namespace sync_engine_detail;
 SyncEngine::SyncEngine(
     db::Database* db,
     cache::ConversationCache* conv_cache,
-    cache::MessageCache* msg_cache,
+    MessageIngestor* ingestor,
     std::shared_ptr<network::HttpClient> http
 )
     : db_(db)
     , conv_cache_(conv_cache)
-    , msg_cache_(msg_cache)
+    , ingestor_(ingestor)
     , http_(std::move(http)) {}
 
 void SyncEngine::sync() {
@@ -390,43 +352,66 @@ void SyncEngine::sync() {
         return;
     }
 
-    http_->post("/sync", body_str, [this](network::HttpResponse resp) {
+    // The delta lists can be large after a long offline period: decode each
+    // element as it arrives instead of the whole body at once. As with the
+    // message fetches, nothing is merged before the envelope is checked.
+    auto streamer = std::make_shared<network::JsonArrayStreamer>();
+    auto deltas = std::make_shared<SyncDeltas>();
+    collectArray(*streamer, { "data", "friends", "friends" }, deltas->friends);
+    collectArray(*streamer, { "data", "groups", "groups" }, deltas->groups);
+    collectArray(*streamer, { "data", "conversation_data", "conversations" }, deltas->sessions);
+    collectArray(*streamer, { "data", "conversations" }, deltas->conversations);
+
+    network::HttpRequest req;
+    req.method = network::HttpMethod::Post;
+    req.path = "/sync";
+    req.body = std::move(body_str);
+    streamJsonBody(req, streamer);
+
+    http_->send(std::move(req), [this, streamer, deltas](network::HttpResponse resp) {
+        finishStreamedBody(resp, *streamer);
         if (!resp.error.empty()) {
             return;
         }
         if (resp.status_code != 200) {
             return;
         }
-        handleSyncResponse(resp.body);
+        handleSyncResponse(resp.body, *deltas);
     });
 }
 
-void SyncEngine::handleSyncResponse(const std::string& body) {
+void SyncEngine::handleSyncResponse(const std::string& skeleton, const SyncDeltas& deltas) {
     ApiEnvelope<SyncResponseDataPayload> root{};
     std::string err;
-    if (!readJsonRelaxed(body, root, err)) {
+    if (!readJsonRelaxed(skeleton, root, err)) {
         return;
     }
     if (root.code != 0) {
         return;
     }
 
-    if (const auto* friends = toFriendPayloadList(root.data.friends); friends != nullptr) {
-        mergeFriends(db_, *friends);
+    bool merged = true;
+    for (const auto& payload : deltas.friends) {
+        merged = mergeFriend(db_, payload) && merged;
     }
-
-    if (const auto* groups = toGroupPayloadList(root.data.groups); groups != nullptr) {
-        mergeGroups(db_, *groups);
+    for (const auto& payload : deltas.groups) {
+        merged = mergeGroup(db_, payload) && merged;
     }
-
-    if (const auto* sessions = toConversationDeltaPayloadList(root.data.conversation_data); sessions != nullptr) {
-        mergeSessions(db_, conv_cache_, *sessions);
+    for (const auto& payload : deltas.sessions) {
+        merged = mergeSession(db_, conv_cache_, payload) && merged;
     }
-
-    if (const auto* conversations = toConversationPayloadList(root.data.conversations); conversations != nullptr) {
-        mergeConvMessages(db_, conv_cache_, msg_cache_, *conversations);
+    // Messages track their own progress: local_seq only moves once the
+    // ingestor committed every row of the conversation, and the next sync
+    // asks from there.
+    for (const auto& conv : deltas.conversations) {
+        mergeConvMessages(ingestor_, conv);
     }
 
+    // Only advance the sync point once every delta is stored; the merges are
+    // idempotent, so a failed sync is simply repeated.
+    if (!merged) {
+        return;
+    }
     const int64_t sync_time = parseInt64Value(root.data.sync_time, 0);
     if (sync_time > 0) {
         db_->setMeta("last_sync_time", std::to_string(sync_time));
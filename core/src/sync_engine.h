@@ -1,7 +1,8 @@
 #pragma once
 
+#include "message_ingestor.h"
+
 #include "cache/conversation_cache.h"
-#include "cache/message_cache.h"
 #include "db/database.h"
 #include "network/http_client.h"
 
@@ -10,19 +11,24 @@
 
 namespace anychat {
 
+namespace sync_engine_detail {
+struct SyncDeltas;
+} // namespace sync_engine_detail
+
 // SyncEngine performs incremental data sync against the POST /sync endpoint.
 //
 // Called by ConnectionManager (via the on_ready hook) each time the WebSocket
 // connection is established.  It reads the persisted last_sync_time from the
 // local database, collects the current per-conversation sequence numbers,
 // posts the sync request, and merges the response into both the database and
-// the in-memory caches.
+// the in-memory caches. The delta lists are decoded element by element while
+// the body is still arriving, and merged once the envelope reports success.
 class SyncEngine {
 public:
     SyncEngine(
         db::Database* db,
         cache::ConversationCache* conv_cache,
-        cache::MessageCache* msg_cache,
+        MessageIngestor* ingestor,
         std::shared_ptr<network::HttpClient> http
     );
 
@@ -32,12 +38,13 @@ public:
     void sync();
 
 private:
-    // Parse and dispatch the raw JSON response body.
-    void handleSyncResponse(const std::string& body);
+    // Check the envelope of the response skeleton (the body with the streamed
+    // delta lists left empty), merge |deltas| and persist the new sync_time.
+    void handleSyncResponse(const std::string& skeleton, const sync_engine_detail::SyncDeltas& deltas);
 
     db::Database* db_;
     cache::ConversationCache* conv_cache_;
-    cache::MessageCache* msg_cache_;
+    MessageIngestor* ingestor_; // conversation messages go through it
     std::shared_ptr<network::HttpClient> http_;
 };
 
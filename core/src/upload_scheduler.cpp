@@ -0,0 +1,308 @@
+#include "upload_scheduler.h"
+
+#include "json_common.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+
+namespace anychat::upload_scheduler_detail {
+
+using db::rowInt64;
+using db::rowText;
+using json_common::nowMs;
+
+constexpr int kMaxConcurrentUploads = 8;
+
+struct UploadJob {
+    UploadJobInfo info;
+    AnyChatValueCallback<FileInfo> on_done; // empty for restored jobs
+    int64_t uploaded = 0; // guarded by UploadScheduler::mutex_ while running
+};
+
+UploadSchedulerConfig normalizeConfig(UploadSchedulerConfig config) {
+    config.max_concurrent = std::clamp(config.max_concurrent, 1, kMaxConcurrentUploads);
+    config.max_bytes_per_sec = std::max<int64_t>(config.max_bytes_per_sec, 0);
+    return config;
+}
+
+} // namespace anychat::upload_scheduler_detail
+
+namespace anychat {
+using namespace upload_scheduler_detail;
+
+UploadScheduler::UploadScheduler(Runner runner, db::Database* db, UploadSchedulerConfig config)
+    : runner_(std::move(runner))
+    , db_(db)
+    , config_(normalizeConfig(config))
+    , starter_(std::make_unique<util::DispatchExecutor>(util::DispatchExecutorOptions{ .threads = 1 })) {
+    restoreJobs();
+}
+
+void UploadScheduler::restoreJobs() {
+    if (!db_ || !db_->isOpen())
+        return;
+
+    const db::Rows rows =
+        db_->querySync("SELECT job_id, local_path, file_type, priority, file_size FROM upload_jobs ORDER BY job_id");
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& row : rows) {
+        auto job = std::make_shared<UploadJob>();
+        job->info = UploadJobInfo{
+            .job_id = rowInt64(row, "job_id"),
+            .local_path = rowText(row, "local_path"),
+            .file_type = static_cast<int32_t>(rowInt64(row, "file_type")),
+            .priority = static_cast<int32_t>(rowInt64(row, "priority")),
+            .file_size = rowInt64(row, "file_size"),
+        };
+        if (job->info.job_id <= 0)
+            continue;
+        next_job_id_ = std::max(next_job_id_, job->info.job_id + 1);
+        batch_total_bytes_ += job->info.file_size;
+        queued_[{ -job->info.priority, job->info.job_id }] = std::move(job);
+    }
+    // Hold restored work until the application is ready for it.
+    paused_ = !queued_.empty();
+}
+
+int64_t UploadScheduler::enqueue(
+    const std::string& local_path,
+    int32_t file_type,
+    int32_t priority,
+    AnyChatValueCallback<FileInfo> on_done
+) {
+    std::error_code ec;
+    const auto file_size = std::filesystem::file_size(std::filesystem::path(local_path), ec);
+    if (ec) {
+        if (on_done.on_error) {
+            on_done.on_error(-1, "cannot read file: " + local_path);
+        }
+        return 0;
+    }
+
+    auto job = std::make_shared<UploadJob>();
+    job->on_done = std::move(on_done);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->info = UploadJobInfo{
+            .job_id = next_job_id_++,
+            .local_path = local_path,
+            .file_type = file_type,
+            .priority = priority,
+            .file_size = static_cast<int64_t>(file_size),
+        };
+        batch_total_bytes_ += job->info.file_size;
+        queued_[{ -priority, job->info.job_id }] = job;
+    }
+
+    if (db_ && db_->isOpen()) {
+        db_->exec(
+            "INSERT OR REPLACE INTO upload_jobs (job_id, local_path, file_type, priority, file_size, created_at) "
+            "VALUES (?, ?, ?, ?, ?, ?)",
+            { job->info.job_id,
+              local_path,
+              static_cast<int64_t>(file_type),
+              static_cast<int64_t>(priority),
+              job->info.file_size,
+              nowMs() }
+        );
+    }
+
+    notifyProgress();
+    pump();
+    return job->info.job_id;
+}
+
+bool UploadScheduler::cancel(int64_t job_id) {
+    JobPtr job;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(queued_.begin(), queued_.end(), [job_id](const auto& entry) {
+            return entry.first.second == job_id;
+        });
+        if (it == queued_.end())
+            return false;
+        job = std::move(it->second);
+        queued_.erase(it);
+        batch_total_bytes_ -= job->info.file_size;
+    }
+
+    onJobDone(job, -1, "upload cancelled", FileInfo{});
+    return true;
+}
+
+void UploadScheduler::pause() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    paused_ = true;
+}
+
+void UploadScheduler::resume() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        paused_ = false;
+    }
+    pump();
+}
+
+bool UploadScheduler::isPaused() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return paused_;
+}
+
+void UploadScheduler::setConfig(UploadSchedulerConfig config) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        config_ = normalizeConfig(config);
+    }
+    // A larger concurrency limit can start more jobs right away. Running
+    // transfers keep the bandwidth share they started with.
+    pump();
+}
+
+UploadSchedulerConfig UploadScheduler::config() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return config_;
+}
+
+void UploadScheduler::setQueueProgressListener(QueueProgressListener listener) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    progress_listener_ = std::move(listener);
+}
+
+void UploadScheduler::setJobListener(JobListener listener) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_listener_ = std::move(listener);
+}
+
+UploadQueueProgress UploadScheduler::progress() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return progressLocked();
+}
+
+UploadQueueProgress UploadScheduler::progressLocked() const {
+    int64_t uploaded = batch_done_bytes_;
+    for (const auto& [job_id, job] : running_)
+        uploaded += job->uploaded;
+    return UploadQueueProgress{
+        .uploaded_bytes = uploaded,
+        .total_bytes = batch_total_bytes_,
+        .queued = static_cast<int>(queued_.size()),
+        .running = static_cast<int>(running_.size()),
+        .succeeded = batch_succeeded_,
+        .failed = batch_failed_,
+    };
+}
+
+int64_t UploadScheduler::perJobRateLocked() const {
+    if (config_.max_bytes_per_sec <= 0)
+        return 0;
+    return std::max<int64_t>(config_.max_bytes_per_sec / config_.max_concurrent, 1);
+}
+
+void UploadScheduler::pump() {
+    std::vector<std::pair<JobPtr, int64_t>> to_start;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!paused_ && static_cast<int>(running_.size()) < config_.max_concurrent && !queued_.empty()) {
+            JobPtr job = std::move(queued_.begin()->second);
+            queued_.erase(queued_.begin());
+            running_[job->info.job_id] = job;
+            to_start.emplace_back(std::move(job), perJobRateLocked());
+        }
+    }
+
+    if (!to_start.empty()) {
+        notifyProgress();
+    }
+
+    for (auto& [job, rate] : to_start) {
+        starter_->post("start", [this, job, rate] {
+            runner_(
+                job->info,
+                rate,
+                [this, job](int64_t uploaded, int64_t /*total*/) {
+                    onJobProgress(job, uploaded);
+                },
+                AnyChatValueCallback<FileInfo>{
+                    .on_success = [this, job](const FileInfo& info) { onJobDone(job, 0, {}, info); },
+                    .on_error =
+                        [this, job](int code, const std::string& error) { onJobDone(job, code, error, FileInfo{}); },
+                }
+            );
+        });
+    }
+}
+
+void UploadScheduler::onJobProgress(const JobPtr& job, int64_t uploaded) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.count(job->info.job_id))
+            return;
+        job->uploaded = std::min(uploaded, job->info.file_size);
+    }
+    notifyProgress();
+}
+
+void UploadScheduler::onJobDone(const JobPtr& job, int code, const std::string& error, const FileInfo& info) {
+    // Failed jobs are dropped as well: retrying is the caller's decision, and a
+    // retried multipart upload resumes from its persisted parts anyway.
+    if (db_ && db_->isOpen()) {
+        db_->exec("DELETE FROM upload_jobs WHERE job_id = ?", { job->info.job_id });
+    }
+
+    JobListener job_listener;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const bool was_running = running_.erase(job->info.job_id) > 0;
+        if (was_running) {
+            batch_done_bytes_ += job->info.file_size;
+            if (code == 0) {
+                ++batch_succeeded_;
+            } else {
+                ++batch_failed_;
+            }
+        }
+        job_listener = job_listener_;
+    }
+
+    if (code == 0) {
+        if (job->on_done.on_success) {
+            job->on_done.on_success(info);
+        }
+    } else if (job->on_done.on_error) {
+        job->on_done.on_error(code, error);
+    }
+    if (job_listener) {
+        job_listener(job->info.job_id, code, error, info);
+    }
+
+    notifyProgress();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queued_.empty() && running_.empty()) {
+            batch_total_bytes_ = 0;
+            batch_done_bytes_ = 0;
+            batch_succeeded_ = 0;
+            batch_failed_ = 0;
+        }
+    }
+    pump();
+}
+
+void UploadScheduler::notifyProgress() {
+    QueueProgressListener listener;
+    UploadQueueProgress snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!progress_listener_)
+            return;
+        listener = progress_listener_;
+        snapshot = progressLocked();
+    }
+    listener(snapshot);
+}
+
+} // namespace anychat
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "sdk_callbacks.h"
+#include "sdk_types.h"
+
+#include "db/database.h"
+#include "util/dispatch_executor.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace anychat {
+
+using UploadProgressCallback = std::function<void(int64_t uploaded, int64_t total)>;
+
+struct UploadSchedulerConfig {
+    int max_concurrent = 2; // uploads running at once, clamped to [1, 8]
+    int64_t max_bytes_per_sec = 0; // aggregate upload bandwidth, 0 = unlimited
+};
+
+struct UploadJobInfo {
+    int64_t job_id = 0;
+    std::string local_path;
+    int32_t file_type = 0;
+    int32_t priority = 0; // higher runs first; equal priorities run FIFO
+    int64_t file_size = 0;
+};
+
+// Aggregate progress of the current batch: every job enqueued since the queue
+// was last idle. Counters reset once the queue drains.
+struct UploadQueueProgress {
+    int64_t uploaded_bytes = 0;
+    int64_t total_bytes = 0;
+    int queued = 0;
+    int running = 0;
+    int succeeded = 0;
+    int failed = 0;
+};
+
+namespace upload_scheduler_detail {
+struct UploadJob;
+} // namespace upload_scheduler_detail
+
+// Global queue in front of the file uploads.
+//
+// At most max_concurrent jobs run at a time, highest priority first. The
+// bandwidth limit is split evenly across the concurrency slots and handed to
+// each job as its own cap (curl throttles per transfer), so the aggregate
+// stays under the limit. pause() stops new jobs from starting; transfers that
+// are already running finish normally.
+//
+// The runner is called on the scheduler's own thread, one job at a time and
+// in start order, never on the thread that enqueued a job or reported one
+// done. A finished transfer reports from the HTTP worker, and starting the
+// next job can mean hashing the file and querying the database first.
+//
+// Queued jobs are persisted in the database. Completion callbacks cannot
+// survive a restart, so restored jobs report through the job listener only,
+// and the scheduler starts paused when it restored anything: the application
+// calls resume() once it is logged in and its listeners are in place.
+class UploadScheduler {
+public:
+    // Performs one upload. |max_bytes_per_sec| is this job's bandwidth share,
+    // 0 = unlimited.
+    using Runner = std::function<void(
+        const UploadJobInfo& job,
+        int64_t max_bytes_per_sec,
+        UploadProgressCallback on_progress,
+        AnyChatValueCallback<FileInfo> on_done
+    )>;
+
+    using QueueProgressListener = std::function<void(const UploadQueueProgress& progress)>;
+
+    // Called for every finished job, restored or not. |code| is 0 on success.
+    using JobListener =
+        std::function<void(int64_t job_id, int code, const std::string& error, const FileInfo& info)>;
+
+    // |db| is optional; without an open database queued jobs are lost on exit.
+    UploadScheduler(Runner runner, db::Database* db = nullptr, UploadSchedulerConfig config = {});
+
+    // Queues |local_path| and returns its job id, or 0 with on_done.on_error
+    // called if the file cannot be read.
+    int64_t enqueue(
+        const std::string& local_path,
+        int32_t file_type,
+        int32_t priority,
+        AnyChatValueCallback<FileInfo> on_done
+    );
+
+    // Removes a job that has not started yet; on_done receives an error.
+    // Returns false if the job is unknown or already running.
+    bool cancel(int64_t job_id);
+
+    void pause();
+    void resume();
+    bool isPaused() const;
+
+    void setConfig(UploadSchedulerConfig config);
+    UploadSchedulerConfig config() const;
+
+    void setQueueProgressListener(QueueProgressListener listener);
+    void setJobListener(JobListener listener);
+
+    UploadQueueProgress progress() const;
+
+private:
+    using JobPtr = std::shared_ptr<upload_scheduler_detail::UploadJob>;
+    using QueueKey = std::pair<int32_t, int64_t>; // (-priority, job_id)
+
+    void restoreJobs();
+    void pump();
+    void onJobProgress(const JobPtr& job, int64_t uploaded);
+    void onJobDone(const JobPtr& job, int code, const std::string& error, const FileInfo& info);
+    void notifyProgress();
+    UploadQueueProgress progressLocked() const;
+    int64_t perJobRateLocked() const;
+
+    Runner runner_;
+    db::Database* db_;
+
+    mutable std::mutex mutex_;
+    UploadSchedulerConfig config_;
+    bool paused_ = false;
+    int64_t next_job_id_ = 1;
+    std::map<QueueKey, JobPtr> queued_;
+    std::unordered_map<int64_t, JobPtr> running_;
+
+    // Current batch.
+    int64_t batch_total_bytes_ = 0;
+    int64_t batch_done_bytes_ = 0;
+    int batch_succeeded_ = 0;
+    int batch_failed_ = 0;
+
+    QueueProgressListener progress_listener_;
+    JobListener job_listener_;
+
+    // Calls runner_. Last, so it is joined before the members its tasks use
+    // go away.
+    std::unique_ptr<util::DispatchExecutor> starter_;
+};
+
+} // namespace anychat
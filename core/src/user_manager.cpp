@@ -198,14 +198,8 @@ int32_t normalizeUserStatus(const std::optional<std::variant<int64_t, double, bo
     }
 }
 
-UserInfo parseNotificationUserInfo(const std::string& data) {
+UserInfo parseNotificationUserInfo(const NotificationUserInfoPayload& payload) {
     UserInfo info;
-    NotificationUserInfoPayload payload{};
-    std::string err;
-    if (!parseJsonObject(data, payload, err)) {
-        return info;
-    }
-
     info.user_id = payload.user_id;
     info.username = payload.nickname;
     info.avatar_url = payload.avatar;
@@ -217,14 +211,8 @@ UserInfo parseNotificationUserInfo(const std::string& data) {
     return info;
 }
 
-UserStatusEvent parseNotificationStatusEvent(const std::string& data) {
+UserStatusEvent parseNotificationStatusEvent(const NotificationUserStatusPayload& payload) {
     UserStatusEvent event;
-    NotificationUserStatusPayload payload{};
-    std::string err;
-    if (!parseJsonObject(data, payload, err)) {
-        return event;
-    }
-
     event.user_id = payload.user_id;
     event.status = normalizeUserStatus(payload.status);
     event.last_active_at_ms = parseTimestampMs(payload.last_active_at);
@@ -330,9 +318,24 @@ UserManagerImpl::UserManagerImpl(
     , notif_mgr_(notif_mgr)
     , device_id_(std::move(device_id)) {
     if (notif_mgr_) {
-        notif_mgr_->addNotificationHandler([this](const NotificationEvent& event) {
-            handleUserNotification(event);
-        });
+        notif_mgr_->subscribe<NotificationUserInfoPayload>(
+            "user.profile_updated",
+            [this](const NotificationEvent&, const NotificationUserInfoPayload& payload) {
+                handleProfileUpdated(payload);
+            }
+        );
+        notif_mgr_->subscribe<NotificationUserInfoPayload>(
+            "user.friend_profile_changed",
+            [this](const NotificationEvent&, const NotificationUserInfoPayload& payload) {
+                handleFriendProfileChanged(payload);
+            }
+        );
+        notif_mgr_->subscribe<NotificationUserStatusPayload>(
+            "user.status_changed",
+            [this](const NotificationEvent&, const NotificationUserStatusPayload& payload) {
+                handleUserStatusChanged(payload);
+            }
+        );
     }
 }
 
@@ -751,45 +754,39 @@ void UserManagerImpl::setListener(std::shared_ptr<UserListener> listener) {
     listener_ = std::move(listener);
 }
 
-void UserManagerImpl::handleUserNotification(const NotificationEvent& event) {
-    const std::string& type = event.notification_type;
+void UserManagerImpl::handleProfileUpdated(const NotificationUserInfoPayload& payload) {
+    auto listener = snapshotListener(handler_mutex_, listener_);
+    if (!listener) {
+        return;
+    }
 
-    if (type == "user.profile_updated") {
-        auto listener = snapshotListener(handler_mutex_, listener_);
-        if (!listener) {
-            return;
-        }
+    try {
+        listener->onProfileUpdated(parseNotificationUserInfo(payload));
+    } catch (...) {
+    }
+}
 
-        try {
-            listener->onProfileUpdated(parseNotificationUserInfo(event.data));
-        } catch (...) {
-        }
+void UserManagerImpl::handleFriendProfileChanged(const NotificationUserInfoPayload& payload) {
+    auto listener = snapshotListener(handler_mutex_, listener_);
+    if (!listener) {
         return;
     }
 
-    if (type == "user.friend_profile_changed") {
-        auto listener = snapshotListener(handler_mutex_, listener_);
-        if (!listener) {
-            return;
-        }
+    try {
+        listener->onFriendProfileChanged(parseNotificationUserInfo(payload));
+    } catch (...) {
+    }
+}
 
-        try {
-            listener->onFriendProfileChanged(parseNotificationUserInfo(event.data));
-        } catch (...) {
-        }
+void UserManagerImpl::handleUserStatusChanged(const NotificationUserStatusPayload& payload) {
+    auto listener = snapshotListener(handler_mutex_, listener_);
+    if (!listener) {
         return;
     }
 
-    if (type == "user.status_changed") {
-        auto listener = snapshotListener(handler_mutex_, listener_);
-        if (!listener) {
-            return;
-        }
-
-        try {
-            listener->onUserStatusChanged(parseNotificationStatusEvent(event.data));
-        } catch (...) {
-        }
+    try {
+        listener->onUserStatusChanged(parseNotificationStatusEvent(payload));
+    } catch (...) {
     }
 }
 
@@ -31,6 +31,11 @@ public:
     }
 };
 
+namespace user_manager_detail {
+struct NotificationUserInfoPayload;
+struct NotificationUserStatusPayload;
+} // namespace user_manager_detail
+
 class UserManagerImpl {
 public:
     explicit UserManagerImpl(
@@ -87,7 +92,9 @@ public:
 
 private:
     static std::string urlEncode(const std::string& input);
-    void handleUserNotification(const NotificationEvent& event);
+    void handleProfileUpdated(const user_manager_detail::NotificationUserInfoPayload& payload);
+    void handleFriendProfileChanged(const user_manager_detail::NotificationUserInfoPayload& payload);
+    void handleUserStatusChanged(const user_manager_detail::NotificationUserStatusPayload& payload);
 
     std::shared_ptr<network::HttpClient> http_;
     NotificationManager* notif_mgr_ = nullptr;
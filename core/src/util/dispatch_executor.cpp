@@ -0,0 +1,167 @@
+#include "dispatch_executor.h"
+
+#include <algorithm>
+
+namespace anychat::util {
+
+namespace {
+
+// The executor whose task the current thread is running, if any.
+thread_local const DispatchExecutor* t_running_on = nullptr;
+
+} // namespace
+
+DispatchExecutor::DispatchExecutor(DispatchExecutorOptions options)
+    : max_queued_(std::max<size_t>(options.max_queued, 1)) {
+    const int threads = std::max(options.threads, 1);
+    workers_.reserve(static_cast<size_t>(threads));
+    for (int i = 0; i < threads; ++i) {
+        workers_.emplace_back([this] {
+            run();
+        });
+    }
+}
+
+DispatchExecutor::~DispatchExecutor() {
+    shutdown();
+}
+
+bool DispatchExecutor::post(std::string_view key, std::function<void()> task) {
+    return enqueue(key, std::move(task), true);
+}
+
+bool DispatchExecutor::postNoWait(std::string_view key, std::function<void()> task) {
+    return enqueue(key, std::move(task), false);
+}
+
+bool DispatchExecutor::enqueue(std::string_view key, std::function<void()> task, bool wait_for_space) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (wait_for_space && stats_.queued >= max_queued_ && t_running_on != this && !stopping_) {
+        ++stats_.producer_waits;
+        space_cv_.wait(lock, [this] {
+            return stats_.queued < max_queued_ || stopping_;
+        });
+    }
+    if (stopping_) {
+        return false;
+    }
+
+    auto it = strands_.find(key);
+    if (it == strands_.end()) {
+        it = strands_.try_emplace(std::string(key)).first;
+    }
+    Strand& strand = it->second;
+    strand.tasks.push_back(std::move(task));
+    ++stats_.posted;
+    stats_.peak_queued = std::max(stats_.peak_queued, ++stats_.queued);
+    if (!strand.scheduled) {
+        strand.scheduled = true;
+        ready_.push_back(&*it);
+        work_cv_.notify_one();
+    }
+    return true;
+}
+
+bool DispatchExecutor::full() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (space_wanted_) {
+        return true;
+    }
+    if (stats_.queued < max_queued_) {
+        return false;
+    }
+    ++stats_.full_reports;
+    space_wanted_ = true;
+    return true;
+}
+
+void DispatchExecutor::setOnSpace(std::function<void()> handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    on_space_ = std::move(handler);
+}
+
+void DispatchExecutor::drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait(lock, [this] {
+        return strands_.empty() || stopping_;
+    });
+}
+
+void DispatchExecutor::shutdown() {
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        workers.swap(workers_);
+    }
+    work_cv_.notify_all();
+    space_cv_.notify_all();
+    idle_cv_.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Destroyed outside the lock: a task's captures may post again.
+    StrandMap dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dropped.swap(strands_);
+        ready_.clear();
+        stats_.queued = 0;
+    }
+}
+
+DispatchExecutorStats DispatchExecutor::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DispatchExecutorStats stats = stats_;
+    stats.keys = strands_.size();
+    return stats;
+}
+
+void DispatchExecutor::run() {
+    t_running_on = this;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        work_cv_.wait(lock, [this] {
+            return !ready_.empty() || stopping_;
+        });
+        if (stopping_) {
+            return;
+        }
+
+        // One task per turn, then the strand goes to the back, so a busy
+        // conversation does not hold a worker while others wait.
+        auto* entry = ready_.front();
+        ready_.pop_front();
+        std::function<void()> task = std::move(entry->second.tasks.front());
+        entry->second.tasks.pop_front();
+        --stats_.queued;
+        space_cv_.notify_one();
+        std::function<void()> on_space;
+        if (space_wanted_ && stats_.queued <= max_queued_ / 2) {
+            space_wanted_ = false;
+            on_space = on_space_;
+        }
+
+        lock.unlock();
+        if (on_space) {
+            on_space();
+        }
+        task();
+        task = nullptr; // captures go before the strand can be erased
+        lock.lock();
+
+        ++stats_.executed;
+        if (!entry->second.tasks.empty()) {
+            ready_.push_back(entry);
+            work_cv_.notify_one();
+        } else {
+            strands_.erase(strands_.find(entry->first));
+            if (strands_.empty()) {
+                idle_cv_.notify_all();
+            }
+        }
+    }
+}
+
+} // namespace anychat::util
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace anychat {
+namespace util {
+
+struct DispatchExecutorOptions {
+    int threads = 2;
+    size_t max_queued = 10'000; // tasks waiting over all keys; post() blocks beyond it
+};
+
+struct DispatchExecutorStats {
+    uint64_t posted = 0;
+    uint64_t executed = 0;
+    uint64_t producer_waits = 0; // posts that blocked on a full queue
+    uint64_t full_reports = 0; // times full() found the queue full
+    size_t queued = 0; // waiting, not running
+    size_t peak_queued = 0;
+    size_t keys = 0; // keys with tasks waiting or running
+};
+
+// Runs tasks on a small pool of threads, one at a time per key and in the
+// order they were posted for that key; tasks of different keys run in
+// parallel. Used to take listener callbacks and manager work off the
+// WebSocket thread while keeping each conversation's events in order.
+//
+// The queue is bounded: once |max_queued| tasks wait, post() blocks until a
+// worker takes one. Posts from a task never block, since the pool may be
+// waiting on that task. A producer that must not block, such as the
+// WebSocket reader, uses postNoWait() and checks full() instead: it pauses
+// its input while the queue is full and resumes from the space handler, so
+// TCP flow control passes the pressure back to the server rather than
+// memory growing without limit.
+class DispatchExecutor {
+public:
+    explicit DispatchExecutor(DispatchExecutorOptions options = {});
+    ~DispatchExecutor(); // shutdown()
+
+    DispatchExecutor(const DispatchExecutor&) = delete;
+    DispatchExecutor& operator=(const DispatchExecutor&) = delete;
+
+    // Queues |task| behind the earlier tasks of |key|. False once shut down,
+    // in which case the task is dropped.
+    bool post(std::string_view key, std::function<void()> task);
+
+    // Like post(), but queues past |max_queued| rather than wait. For
+    // callers that must never block, such as timer callbacks.
+    bool postNoWait(std::string_view key, std::function<void()> task);
+
+    // True once |max_queued| tasks wait, until the queue is down to half of
+    // that and the space handler has been called.
+    bool full();
+
+    // Called on a worker, before it runs its next task, when the queue has
+    // room again after full() returned true.
+    void setOnSpace(std::function<void()> handler);
+
+    // Blocks until no task is waiting or running. Tasks posted meanwhile are
+    // waited for too. Must not be called from a task.
+    void drain();
+
+    // Stops accepting tasks, drops the waiting ones and joins the workers
+    // once the running ones return. Idempotent; must not be called from a
+    // task.
+    void shutdown();
+
+    DispatchExecutorStats stats() const;
+
+private:
+    struct Hash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view s) const noexcept {
+            return std::hash<std::string_view>{}(s);
+        }
+    };
+
+    struct Strand {
+        std::deque<std::function<void()>> tasks;
+        bool scheduled = false; // ready or running; cleared when it empties
+    };
+
+    using StrandMap = std::unordered_map<std::string, Strand, Hash, std::equal_to<>>;
+
+    bool enqueue(std::string_view key, std::function<void()> task, bool wait_for_space);
+    void run();
+
+    const size_t max_queued_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_; // ready_ gained a strand, or stopping
+    std::condition_variable space_cv_; // a task left the queue
+    std::condition_variable idle_cv_; // a strand ran dry
+    StrandMap strands_;
+    // Strands with tasks and no worker. Map nodes keep their address across
+    // rehashing, so the pointers stay valid until the strand is erased.
+    std::deque<StrandMap::value_type*> ready_;
+    bool stopping_ = false;
+    bool space_wanted_ = false; // full() returned true; cleared at half
+    std::function<void()> on_space_;
+    DispatchExecutorStats stats_;
+
+    std::vector<std::thread> workers_;
+};
+
+} // namespace util
+} // namespace anychat
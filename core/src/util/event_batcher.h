@@ -0,0 +1,175 @@
+#pragma once
+
+#include "util/dispatch_executor.h"
+#include "util/timer_wheel.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace anychat {
+namespace util {
+
+struct EventBatcherStats {
+    uint64_t events = 0; // added
+    uint64_t coalesced = 0; // replaced a pending event of the same key
+    uint64_t batches = 0; // delivered
+};
+
+// Collects events for |window| after the first one and hands them over as
+// one batch, so that an event storm (a reconnect, a busy group) costs the
+// listener one call per window instead of one per event. Events added with
+// the same non-empty key while a batch is open collapse into the latest one,
+// which keeps the position of the first.
+//
+// When the window closes, the batch is delivered on |executor| under |key|,
+// or on the timer thread when there is no executor (the deliver callback
+// must then be short). Batches are delivered one at a time and in order.
+// The executor must stop running tasks before the batcher is destroyed;
+// events still pending then are dropped.
+template<typename Event>
+class EventBatcher {
+public:
+    using Deliver = std::function<void(std::vector<Event>&& batch)>;
+
+    EventBatcher(
+        std::shared_ptr<TimerScheduler> timers,
+        std::shared_ptr<DispatchExecutor> executor,
+        std::string key,
+        std::chrono::milliseconds window,
+        Deliver deliver
+    )
+        : timers_(std::move(timers))
+        , executor_(std::move(executor))
+        , key_(std::move(key))
+        , window_(window)
+        , deliver_(std::move(deliver)) {}
+
+    ~EventBatcher() {
+        TimerId timer = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            timer = disarmLocked();
+        }
+        timers_->cancel(timer);
+        // A timer-thread delivery may have disarmed already; wait for it.
+        std::lock_guard<std::mutex> deliver_lock(deliver_mutex_);
+    }
+
+    EventBatcher(const EventBatcher&) = delete;
+    EventBatcher& operator=(const EventBatcher&) = delete;
+
+    void add(Event event, std::string_view key = {}) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.events;
+        if (!key.empty()) {
+            auto [it, inserted] = index_.try_emplace(std::string(key), pending_.size());
+            if (!inserted) {
+                pending_[it->second] = std::move(event);
+                ++stats_.coalesced;
+                return;
+            }
+        }
+        pending_.push_back(std::move(event));
+        if (armed_ == 0) {
+            const uint64_t window = armed_ = ++windows_;
+            timer_ = timers_->schedule(window_, [this, window] {
+                onWindowClosed(window);
+            });
+        }
+    }
+
+    // Delivers the pending events now, on the calling thread. Used before an
+    // event that must not overtake them. Must not be called from |deliver|.
+    void flush() {
+        TimerId timer = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            timer = disarmLocked();
+        }
+        timers_->cancel(timer);
+        deliverPending(std::nullopt);
+    }
+
+    EventBatcherStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    struct Hash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view s) const noexcept {
+            return std::hash<std::string_view>{}(s);
+        }
+    };
+
+    // The timer of the open window, 0 if none; a late callback of it no
+    // longer matches |armed_|.
+    TimerId disarmLocked() {
+        armed_ = 0;
+        return std::exchange(timer_, 0);
+    }
+
+    // Timer thread: must not block, so the delivery itself is posted.
+    void onWindowClosed(uint64_t window) {
+        if (!executor_) {
+            deliverPending(window);
+            return;
+        }
+        executor_->postNoWait(key_, [this, window] {
+            deliverPending(window);
+        });
+    }
+
+    // With |window|, delivers only if that window is still open: a flush
+    // may have taken its events meanwhile.
+    void deliverPending(std::optional<uint64_t> window) {
+        std::lock_guard<std::mutex> deliver_lock(deliver_mutex_);
+        std::vector<Event> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (window) {
+                if (*window != armed_) {
+                    return;
+                }
+                disarmLocked();
+            }
+            if (pending_.empty()) {
+                return;
+            }
+            batch.swap(pending_);
+            index_.clear();
+            ++stats_.batches;
+        }
+        deliver_(std::move(batch));
+    }
+
+    const std::shared_ptr<TimerScheduler> timers_;
+    const std::shared_ptr<DispatchExecutor> executor_;
+    const std::string key_;
+    const std::chrono::milliseconds window_;
+    const Deliver deliver_;
+
+    std::mutex deliver_mutex_; // one batch at a time, in order
+    mutable std::mutex mutex_;
+    std::vector<Event> pending_;
+    std::unordered_map<std::string, size_t, Hash, std::equal_to<>> index_; // key -> position in pending_
+    TimerId timer_ = 0;
+    uint64_t armed_ = 0; // the open window, 0 if none
+    uint64_t windows_ = 0; // windows opened so far
+    EventBatcherStats stats_;
+};
+
+} // namespace util
+} // namespace anychat
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace anychat {
+namespace util {
+
+// 64-bit FNV-1a. Used for ids kept in a RecentIdWindow, where a collision
+// means a dropped message: std::hash is only 32 bits wide on 32-bit targets.
+inline uint64_t fnv1a64(std::string_view data, uint64_t hash = 0xcbf29ce484222325ULL) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Remembers the last |capacity| ids recorded, each with a version (e.g. a
+// hash of the content it was stored with), and forgets the oldest as new
+// ones arrive. Ids and versions are 64-bit hashes, so an entry costs a few
+// dozen bytes whatever the length of the id.
+//
+// Not thread-safe.
+class RecentIdWindow {
+public:
+    explicit RecentIdWindow(size_t capacity)
+        : ring_(capacity > 0 ? capacity : 1) {
+        entries_.reserve(ring_.size());
+    }
+
+    // The version |id| was last recorded with, if it is still in the window.
+    std::optional<uint64_t> find(uint64_t id) const {
+        auto it = entries_.find(id);
+        if (it == entries_.end()) {
+            return std::nullopt;
+        }
+        return it->second.version;
+    }
+
+    // Records |id| at |version| as the newest id; when the window is full,
+    // the oldest one leaves it.
+    void record(uint64_t id, uint64_t version) {
+        // A slot whose id was recorded again since, or forgotten, no longer
+        // owns the entry.
+        if (filled_ == ring_.size()) {
+            auto victim = entries_.find(ring_[next_]);
+            if (victim != entries_.end() && victim->second.slot == next_) {
+                entries_.erase(victim);
+            }
+        } else {
+            ++filled_;
+        }
+        ring_[next_] = id;
+        entries_[id] = Entry{ version, next_ };
+        next_ = (next_ + 1) % ring_.size();
+    }
+
+    // Forgets |id| unless it was recorded again with another version.
+    void forget(uint64_t id, uint64_t version) {
+        auto it = entries_.find(id);
+        if (it != entries_.end() && it->second.version == version) {
+            entries_.erase(it);
+        }
+    }
+
+    size_t size() const {
+        return entries_.size();
+    }
+
+    size_t capacity() const {
+        return ring_.size();
+    }
+
+private:
+    struct Entry {
+        uint64_t version = 0;
+        size_t slot = 0; // position in ring_
+    };
+
+    std::vector<uint64_t> ring_; // ids in the order recorded
+    size_t next_ = 0; // slot of the next id
+    size_t filled_ = 0;
+    std::unordered_map<uint64_t, Entry> entries_;
+};
+
+} // namespace util
+} // namespace anychat
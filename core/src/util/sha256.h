@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace anychat {
+namespace util {
+
+// Incremental SHA-256 (FIPS 180-4). Feed data with update() in any chunking,
+// then call finish() once.
+class Sha256 {
+public:
+    using Digest = std::array<uint8_t, 32>;
+
+    Sha256();
+
+    void update(const void* data, size_t len);
+    Digest finish();
+
+    static std::string toHex(const Digest& digest);
+
+private:
+    void compress(const uint8_t* block);
+
+    std::array<uint32_t, 8> state_;
+    std::array<uint8_t, 64> buffer_{};
+    size_t buffered_ = 0;
+    uint64_t total_len_ = 0;
+};
+
+// Hashes |path| in fixed-size chunks without loading it into memory.
+// Returns false and sets |err| if the file cannot be read.
+bool sha256File(const std::string& path, std::string& hex_digest, std::string& err);
+
+} // namespace util
+} // namespace anychat
@@ -0,0 +1,214 @@
+#include "timer_wheel.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace anychat::util {
+
+namespace {
+
+constexpr uint64_t kSlotMask = TimerWheel::kSlots - 1;
+
+int shiftOf(int level) {
+    return TimerWheel::kLevelBits * level;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// TimerWheel
+// ---------------------------------------------------------------------------
+
+void TimerWheel::add(TimerId id, uint64_t deadline_tick, std::function<void()> fn) {
+    // now_ has been processed already.
+    const uint64_t deadline = std::max(deadline_tick, now_ + 1);
+    timers_[id] = Entry{ deadline, std::move(fn) };
+    place(id, deadline);
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    return timers_.erase(id) > 0;
+}
+
+// Level L holds deadlines less than kSlots^(L+1) ticks away, in the slot of
+// their level-L digit. That slot is cascaded when now_ reaches the start of
+// the deadline's level-L block, which re-places the timer at a lower level.
+void TimerWheel::place(TimerId id, uint64_t deadline) {
+    const uint64_t delta = deadline - now_;
+    for (int level = 0; level < kLevels; ++level) {
+        if ((delta >> shiftOf(level + 1)) == 0) {
+            wheels_[level][(deadline >> shiftOf(level)) & kSlotMask].push_back(id);
+            return;
+        }
+    }
+    // Too far out: park it in the top level; its cascade places it again.
+    const uint64_t parked = now_ + (uint64_t{ 1 } << shiftOf(kLevels)) - 1;
+    wheels_[kLevels - 1][(parked >> shiftOf(kLevels - 1)) & kSlotMask].push_back(id);
+}
+
+void TimerWheel::step() {
+    ++now_;
+    for (int level = kLevels - 1; level >= 1; --level) {
+        if ((now_ & ((uint64_t{ 1 } << shiftOf(level)) - 1)) != 0)
+            continue;
+        std::vector<TimerId> ids;
+        ids.swap(wheels_[level][(now_ >> shiftOf(level)) & kSlotMask]);
+        for (TimerId id : ids) {
+            auto it = timers_.find(id);
+            if (it != timers_.end())
+                place(id, it->second.deadline);
+        }
+    }
+
+    // Cascaded timers land behind ones placed directly; ids restore the
+    // insertion order.
+    auto& slot = wheels_[0][now_ & kSlotMask];
+    std::sort(slot.begin(), slot.end());
+    for (TimerId id : slot) {
+        if (timers_.count(id))
+            due_.push_back(id);
+    }
+    slot.clear();
+}
+
+std::optional<TimerWheel::Expired> TimerWheel::popExpired(uint64_t to_tick) {
+    while (true) {
+        while (!due_.empty()) {
+            const TimerId id = due_.front();
+            due_.pop_front();
+            auto it = timers_.find(id);
+            if (it == timers_.end())
+                continue; // cancelled after it became due
+            Expired expired{ id, std::move(it->second.fn) };
+            timers_.erase(it);
+            return expired;
+        }
+        if (now_ >= to_tick)
+            return std::nullopt;
+
+        const std::optional<uint64_t> next = ticksUntilNext();
+        if (!next) {
+            // Nothing pending: drop the ids of cancelled timers and jump.
+            for (auto& wheel : wheels_) {
+                for (auto& slot : wheel)
+                    slot.clear();
+            }
+            now_ = to_tick;
+            return std::nullopt;
+        }
+        // Slots before |next| are empty, so skipping them is exact.
+        now_ += std::min(*next, to_tick - now_) - 1;
+        step();
+    }
+}
+
+std::optional<uint64_t> TimerWheel::ticksUntilNext() const {
+    if (!due_.empty())
+        return 0;
+    if (timers_.empty())
+        return std::nullopt;
+
+    uint64_t best = std::numeric_limits<uint64_t>::max();
+    for (uint64_t k = 1; k <= kSlots; ++k) {
+        if (!wheels_[0][(now_ + k) & kSlotMask].empty()) {
+            best = k;
+            break;
+        }
+    }
+    for (int level = 1; level < kLevels; ++level) {
+        const uint64_t block = now_ >> shiftOf(level);
+        for (uint64_t k = 1; k <= kSlots; ++k) {
+            if (!wheels_[level][(block + k) & kSlotMask].empty()) {
+                best = std::min(best, ((block + k) << shiftOf(level)) - now_);
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+// ---------------------------------------------------------------------------
+// TimerScheduler
+// ---------------------------------------------------------------------------
+
+TimerScheduler::TimerScheduler(std::chrono::milliseconds resolution)
+    : resolution_(std::max<Clock::duration>(resolution, std::chrono::milliseconds(1)))
+    , epoch_(Clock::now()) {
+    thread_ = std::thread([this] {
+        run();
+    });
+}
+
+TimerScheduler::~TimerScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_cv_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+TimerId TimerScheduler::schedule(std::chrono::milliseconds delay, std::function<void()> fn) {
+    // Whole ticks from the start of the current one, plus that one: never
+    // early, at most one resolution late.
+    const auto ticks = (std::max<Clock::duration>(delay, Clock::duration::zero()) + resolution_ - Clock::duration(1))
+                       / resolution_;
+    TimerId id = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_id_++;
+        wheel_.add(id, tickAt(Clock::now()) + static_cast<uint64_t>(ticks) + 1, std::move(fn));
+    }
+    wake_cv_.notify_one();
+    return id;
+}
+
+bool TimerScheduler::cancel(TimerId id) {
+    if (id == 0)
+        return false;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (wheel_.cancel(id))
+        return true;
+    if (std::this_thread::get_id() != thread_.get_id()) {
+        idle_cv_.wait(lock, [this, id] {
+            return running_ != id;
+        });
+    }
+    return false;
+}
+
+size_t TimerScheduler::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wheel_.size();
+}
+
+uint64_t TimerScheduler::tickAt(Clock::time_point t) const {
+    return static_cast<uint64_t>((t - epoch_) / resolution_);
+}
+
+void TimerScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        std::optional<TimerWheel::Expired> expired = wheel_.popExpired(tickAt(Clock::now()));
+        if (expired) {
+            running_ = expired->id;
+            lock.unlock();
+            expired->fn();
+            expired.reset(); // release captures outside the lock
+            lock.lock();
+            running_ = 0;
+            idle_cv_.notify_all();
+            continue;
+        }
+
+        const std::optional<uint64_t> next = wheel_.ticksUntilNext();
+        if (next)
+            wake_cv_.wait_until(lock, epoch_ + resolution_ * static_cast<int64_t>(wheel_.now() + *next));
+        else
+            wake_cv_.wait(lock);
+    }
+}
+
+} // namespace anychat::util
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace anychat {
+namespace util {
+
+using TimerId = uint64_t; // 0 is never a valid id
+
+// Hierarchical timing wheel over an abstract tick counter (kLevels wheels of
+// kSlots slots; each level spans kSlots times the one below). Adding and
+// cancelling is O(1); advancing costs one slot per tick plus the cascade of
+// timers moving down a level. Deadlines beyond the top level are parked in
+// it and re-placed when their slot comes round. Not thread-safe.
+class TimerWheel {
+public:
+    static constexpr int kLevelBits = 6;
+    static constexpr size_t kSlots = size_t{ 1 } << kLevelBits;
+    static constexpr int kLevels = 4;
+
+    struct Expired {
+        TimerId id = 0;
+        std::function<void()> fn;
+    };
+
+    explicit TimerWheel(uint64_t now_tick = 0)
+        : now_(now_tick) {}
+
+    uint64_t now() const {
+        return now_;
+    }
+
+    // Expires at |deadline_tick|, or on the next tick if that has passed.
+    void add(TimerId id, uint64_t deadline_tick, std::function<void()> fn);
+
+    // False if |id| is not pending (fired, cancelled or unknown).
+    bool cancel(TimerId id);
+
+    // Removes and returns the next timer expired by |to_tick|, moving time
+    // forward only as far as needed to find it. Timers come out in deadline
+    // order, ties in insertion order. Call until it returns nullopt; timers
+    // not yet returned can still be cancelled.
+    std::optional<Expired> popExpired(uint64_t to_tick);
+
+    // Ticks until the next slot that needs processing (an expiry or a
+    // cascade), or nullopt when no timer is pending. May be early, never
+    // late.
+    std::optional<uint64_t> ticksUntilNext() const;
+
+    size_t size() const {
+        return timers_.size();
+    }
+
+private:
+    struct Entry {
+        uint64_t deadline = 0;
+        std::function<void()> fn;
+    };
+
+    void place(TimerId id, uint64_t deadline);
+    void step(); // one tick: cascade, then move the due slot to due_
+
+    uint64_t now_;
+    std::unordered_map<TimerId, Entry> timers_;
+    // Slots hold ids only; a cancelled id stays until its slot is visited.
+    std::array<std::array<std::vector<TimerId>, kSlots>, kLevels> wheels_{};
+    std::deque<TimerId> due_; // expired at now_, not yet popped
+};
+
+// One thread serving timers for the whole client. Callbacks run on that
+// thread, one at a time, and must not block; they may schedule and cancel
+// timers. The thread sleeps until the next deadline, so idle timers cost no
+// wake-ups.
+class TimerScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TimerScheduler(std::chrono::milliseconds resolution = std::chrono::milliseconds(10));
+    ~TimerScheduler();
+
+    TimerScheduler(const TimerScheduler&) = delete;
+    TimerScheduler& operator=(const TimerScheduler&) = delete;
+
+    // Runs |fn| once, no earlier than |delay| from now (rounded up to the
+    // resolution).
+    TimerId schedule(std::chrono::milliseconds delay, std::function<void()> fn);
+
+    // Returns true if the timer was pending and will not run. If its
+    // callback is running on the scheduler thread, waits for it to return
+    // (unless called from that callback) so the caller may then release
+    // what it captured.
+    bool cancel(TimerId id);
+
+    size_t pending() const;
+
+private:
+    uint64_t tickAt(Clock::time_point t) const;
+    void run();
+
+    const Clock::duration resolution_;
+    const Clock::time_point epoch_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable idle_cv_; // signalled when a callback returns
+    TimerWheel wheel_;
+    TimerId next_id_ = 1;
+    TimerId running_ = 0; // the callback being run, 0 if none
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+} // namespace util
+} // namespace anychat
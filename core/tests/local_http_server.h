@@ -0,0 +1,276 @@
+#pragma once
+
+// Minimal HTTP/1.1 server bound to 127.0.0.1 on an ephemeral port. Tests use
+// it as a stand-in for the API gateway and object storage so that the real
+// libcurl transfer paths can be exercised without network access.
+//
+// Each connection is served on its own thread with keep-alive; requests must
+// carry a Content-Length body (or none). The handler runs on the connection
+// thread and must be thread-safe when the client issues parallel requests.
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace anychat::test {
+
+struct LocalHttpRequest {
+    std::string method;
+    std::string target; // path + query as sent by the client
+    std::map<std::string, std::string> headers; // lower-cased names
+    std::string body;
+
+    std::string header(const std::string& name) const {
+        auto it = headers.find(name);
+        return it == headers.end() ? std::string{} : it->second;
+    }
+};
+
+struct LocalHttpReply {
+    int status = 200;
+    std::string body;
+    std::vector<std::pair<std::string, std::string>> headers;
+};
+
+class LocalHttpServer {
+public:
+    using Handler = std::function<LocalHttpReply(const LocalHttpRequest&)>;
+
+    explicit LocalHttpServer(Handler handler)
+        : handler_(std::move(handler)) {
+#ifdef _WIN32
+        WSADATA wsa;
+        WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        int yes = 1;
+        ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&yes), sizeof(yes));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        ::listen(listen_fd_, 16);
+
+        socklen_t len = sizeof(addr);
+        ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+
+        accept_thread_ = std::thread([this] { acceptLoop(); });
+    }
+
+    ~LocalHttpServer() {
+        stopping_ = true;
+        shutdownSocket(listen_fd_);
+        closeSocket(listen_fd_);
+        if (accept_thread_.joinable())
+            accept_thread_.join();
+
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            for (Socket fd : client_fds_)
+                shutdownSocket(fd);
+            threads = std::move(threads_);
+        }
+        for (auto& t : threads) {
+            if (t.joinable())
+                t.join();
+        }
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+
+    LocalHttpServer(const LocalHttpServer&) = delete;
+    LocalHttpServer& operator=(const LocalHttpServer&) = delete;
+
+    int port() const {
+        return port_;
+    }
+
+    std::string baseUrl() const {
+        return "http://127.0.0.1:" + std::to_string(port_);
+    }
+
+private:
+#ifdef _WIN32
+    using Socket = SOCKET;
+    static void closeSocket(Socket fd) {
+        ::closesocket(fd);
+    }
+    static void shutdownSocket(Socket fd) {
+        ::shutdown(fd, SD_BOTH);
+    }
+#else
+    using Socket = int;
+    static void closeSocket(Socket fd) {
+        ::close(fd);
+    }
+    static void shutdownSocket(Socket fd) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+#endif
+
+    void acceptLoop() {
+        while (!stopping_) {
+            Socket fd = ::accept(listen_fd_, nullptr, nullptr);
+#ifdef _WIN32
+            if (fd == INVALID_SOCKET)
+                return;
+#else
+            if (fd < 0)
+                return;
+#endif
+            std::lock_guard<std::mutex> lk(mutex_);
+            client_fds_.push_back(fd);
+            threads_.emplace_back([this, fd] {
+                serve(fd);
+                {
+                    std::lock_guard<std::mutex> inner(mutex_);
+                    client_fds_.erase(std::remove(client_fds_.begin(), client_fds_.end(), fd), client_fds_.end());
+                }
+                closeSocket(fd);
+            });
+        }
+    }
+
+    static bool sendAll(Socket fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            const int n = static_cast<int>(::send(fd, data.data() + sent, static_cast<int>(data.size() - sent), 0));
+            if (n <= 0)
+                return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    static const char* reason(int status) {
+        switch (status) {
+            case 200:
+                return "OK";
+            case 201:
+                return "Created";
+            case 206:
+                return "Partial Content";
+            case 404:
+                return "Not Found";
+            case 416:
+                return "Range Not Satisfiable";
+            case 500:
+                return "Internal Server Error";
+            case 503:
+                return "Service Unavailable";
+            default:
+                return "Status";
+        }
+    }
+
+    void serve(Socket fd) {
+        std::string buf;
+        char chunk[16 * 1024];
+
+        auto fill = [&]() {
+            const int n = static_cast<int>(::recv(fd, chunk, sizeof(chunk), 0));
+            if (n <= 0)
+                return false;
+            buf.append(chunk, static_cast<size_t>(n));
+            return true;
+        };
+
+        while (!stopping_) {
+            size_t header_end;
+            while ((header_end = buf.find("\r\n\r\n")) == std::string::npos) {
+                if (!fill())
+                    return;
+            }
+
+            LocalHttpRequest req;
+            const std::string head = buf.substr(0, header_end);
+            buf.erase(0, header_end + 4);
+
+            size_t line_end = head.find("\r\n");
+            const std::string request_line = head.substr(0, line_end);
+            const size_t sp1 = request_line.find(' ');
+            const size_t sp2 = request_line.find(' ', sp1 + 1);
+            req.method = request_line.substr(0, sp1);
+            req.target = request_line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+            size_t pos = line_end == std::string::npos ? head.size() : line_end + 2;
+            while (pos < head.size()) {
+                size_t eol = head.find("\r\n", pos);
+                if (eol == std::string::npos)
+                    eol = head.size();
+                const std::string line = head.substr(pos, eol - pos);
+                const size_t colon = line.find(':');
+                if (colon != std::string::npos) {
+                    std::string name = line.substr(0, colon);
+                    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+                        return static_cast<char>(std::tolower(c));
+                    });
+                    size_t value_start = colon + 1;
+                    while (value_start < line.size() && line[value_start] == ' ')
+                        ++value_start;
+                    req.headers[name] = line.substr(value_start);
+                }
+                pos = eol + 2;
+            }
+
+            if (req.header("expect") == "100-continue" && !sendAll(fd, "HTTP/1.1 100 Continue\r\n\r\n"))
+                return;
+
+            const std::string content_length = req.header("content-length");
+            const size_t body_len = content_length.empty() ? 0 : static_cast<size_t>(std::stoull(content_length));
+            while (buf.size() < body_len) {
+                if (!fill())
+                    return;
+            }
+            req.body = buf.substr(0, body_len);
+            buf.erase(0, body_len);
+
+            LocalHttpReply reply = handler_(req);
+
+            std::string out = "HTTP/1.1 " + std::to_string(reply.status) + " " + reason(reply.status) + "\r\n";
+            out += "Content-Length: " + std::to_string(reply.body.size()) + "\r\n";
+            for (const auto& [name, value] : reply.headers)
+                out += name + ": " + value + "\r\n";
+            out += "\r\n";
+            out += reply.body;
+            if (!sendAll(fd, out))
+                return;
+        }
+    }
+
+    Handler handler_;
+    Socket listen_fd_{};
+    int port_ = 0;
+    std::atomic<bool> stopping_{ false };
+    std::thread accept_thread_;
+
+    std::mutex mutex_;
+    std::vector<Socket> client_fds_;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace anychat::test
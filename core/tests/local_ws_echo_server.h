@@ -0,0 +1,185 @@
+#pragma once
+
+// Minimal libwebsockets echo server bound to 127.0.0.1 on an ephemeral port.
+// Every complete text message is sent back unchanged, or answered by the
+// responder when one is set (a stand-in for the gateway's protocol). With
+// permessage_deflate the server accepts the extension like a production
+// gateway would; otherwise it ignores the offer.
+//
+// One client at a time; the service loop runs on its own thread.
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libwebsockets.h>
+
+namespace anychat::test {
+
+class LocalWsEchoServer {
+public:
+    explicit LocalWsEchoServer(bool permessage_deflate) {
+        static const lws_protocols protocols[] = { { "anychat", callback, 0, 4096, 0, nullptr, 0 },
+                                                   { nullptr, nullptr, 0, 0, 0, nullptr, 0 } };
+#if !defined(LWS_WITHOUT_EXTENSIONS)
+        static const lws_extension extensions[] = {
+            { "permessage-deflate", lws_extension_callback_pm_deflate, "permessage-deflate" },
+            { nullptr, nullptr, nullptr },
+        };
+#endif
+        lws_set_log_level(LLL_ERR, nullptr);
+
+        lws_context_creation_info info{};
+        info.port = 0;
+        info.iface = "127.0.0.1";
+        info.protocols = protocols;
+        info.user = this;
+#if !defined(LWS_WITHOUT_EXTENSIONS)
+        if (permessage_deflate)
+            info.extensions = extensions;
+#else
+        (void)permessage_deflate;
+#endif
+        ctx_ = lws_create_context(&info);
+        if (ctx_)
+            port_ = lws_get_vhost_listen_port(lws_get_vhost_by_name(ctx_, "default"));
+
+        thread_ = std::thread([this] {
+            while (!stop_ && ctx_) {
+                if (lws_service(ctx_, 0) < 0)
+                    break;
+            }
+        });
+    }
+
+    ~LocalWsEchoServer() {
+        stop_ = true;
+        if (ctx_)
+            lws_cancel_service(ctx_);
+        if (thread_.joinable())
+            thread_.join();
+        if (ctx_)
+            lws_context_destroy(ctx_);
+    }
+
+    LocalWsEchoServer(const LocalWsEchoServer&) = delete;
+    LocalWsEchoServer& operator=(const LocalWsEchoServer&) = delete;
+
+    std::string url() const {
+        return "ws://127.0.0.1:" + std::to_string(port_) + "/api/v1/ws";
+    }
+
+    // Replies to each complete message instead of echoing it; the replies
+    // go out in order.
+    using Responder = std::function<std::vector<std::string>(const std::string& message)>;
+
+    void setResponder(Responder responder) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        responder_ = std::move(responder);
+    }
+
+    // Complete messages received, in order.
+    std::vector<std::string> received() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return received_;
+    }
+
+    // Closes the connection once, as soon as more than |bytes| of a message
+    // arrived without its end: a disconnect in the middle of a message.
+    void dropOnceAfter(size_t bytes) {
+        drop_after_ = bytes;
+    }
+
+    // Sec-WebSocket-Extensions of each upgrade request ("" when absent).
+    std::vector<std::string> extensionOffers() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return offers_;
+    }
+
+private:
+    static int callback(lws* wsi, lws_callback_reasons reason, void*, void* in, size_t len) {
+        auto* self = static_cast<LocalWsEchoServer*>(lws_context_user(lws_get_context(wsi)));
+        if (!self)
+            return 0;
+
+        switch (reason) {
+            case LWS_CALLBACK_FILTER_PROTOCOL_CONNECTION: {
+                std::string offer;
+                const int n = lws_hdr_total_length(wsi, WSI_TOKEN_EXTENSIONS);
+                if (n > 0) {
+                    offer.resize(static_cast<size_t>(n) + 1);
+                    lws_hdr_copy(wsi, offer.data(), n + 1, WSI_TOKEN_EXTENSIONS);
+                    offer.resize(static_cast<size_t>(n));
+                }
+                std::lock_guard<std::mutex> lock(self->mutex_);
+                self->offers_.push_back(std::move(offer));
+                break;
+            }
+            case LWS_CALLBACK_ESTABLISHED:
+                self->rx_.clear();
+                self->tx_.clear();
+                break;
+            case LWS_CALLBACK_RECEIVE:
+                self->rx_.append(static_cast<const char*>(in), len);
+                if (self->drop_after_ > 0 && self->rx_.size() > self->drop_after_) {
+                    self->drop_after_ = 0;
+                    return -1;
+                }
+                if (lws_is_final_fragment(wsi) && lws_remaining_packet_payload(wsi) == 0) {
+                    Responder responder;
+                    {
+                        std::lock_guard<std::mutex> lock(self->mutex_);
+                        self->received_.push_back(self->rx_);
+                        responder = self->responder_;
+                    }
+                    if (responder) {
+                        for (auto& reply : responder(self->rx_))
+                            self->tx_.push_back(std::move(reply));
+                    } else {
+                        self->tx_.push_back(std::move(self->rx_));
+                    }
+                    self->rx_.clear();
+                    if (!self->tx_.empty())
+                        lws_callback_on_writable(wsi);
+                }
+                break;
+            case LWS_CALLBACK_SERVER_WRITEABLE: {
+                if (self->tx_.empty())
+                    break;
+                std::string frame(LWS_PRE, '\0');
+                frame += self->tx_.front();
+                self->tx_.pop_front();
+                auto* payload = reinterpret_cast<unsigned char*>(frame.data()) + LWS_PRE;
+                if (lws_write(wsi, payload, frame.size() - LWS_PRE, LWS_WRITE_TEXT) < 0)
+                    return -1;
+                if (!self->tx_.empty())
+                    lws_callback_on_writable(wsi);
+                break;
+            }
+            default:
+                break;
+        }
+        return 0;
+    }
+
+    lws_context* ctx_ = nullptr;
+    int port_ = 0;
+    std::atomic<bool> stop_{ false };
+    std::atomic<size_t> drop_after_{ 0 };
+    std::thread thread_;
+
+    // Service-thread only.
+    std::string rx_;
+    std::deque<std::string> tx_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::string> offers_;
+    std::vector<std::string> received_;
+    Responder responder_;
+};
+
+} // namespace anychat::test
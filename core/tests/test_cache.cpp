@@ -163,6 +163,33 @@ TEST(MessageCacheTest, MaxSeq) {
     EXPECT_EQ(cache.maxSeq("c1"), 7);
 }
 
+TEST(MessageCacheTest, InsertBatchMergesAndTrims) {
+    // bucket_size=4: the batch is merged into the sorted bucket, then the
+    // lowest seqs are evicted.
+    anychat::cache::MessageCache cache(/*bucket_size=*/4);
+    cache.insert(makeMsg("c1", "m3", 3));
+    cache.insert(makeMsg("c1", "m5", 5));
+
+    const std::vector<anychat::Message> batch{
+        makeMsg("c1", "m6", 6),
+        makeMsg("c1", "m1", 1),
+        makeMsg("c2", "x1", 1),
+        makeMsg("c1", "m3", 3), // already cached
+        makeMsg("c1", "m4", 4),
+        makeMsg("c1", "m6", 6), // repeated in the batch
+    };
+    const std::vector<bool> added = cache.insertBatch(batch);
+    EXPECT_EQ(added, (std::vector<bool>{ true, true, true, false, true, false }));
+
+    auto msgs = cache.get("c1");
+    ASSERT_EQ(msgs.size(), 4u);
+    EXPECT_EQ(msgs[0].seq, 3);
+    EXPECT_EQ(msgs[1].seq, 4);
+    EXPECT_EQ(msgs[2].seq, 5);
+    EXPECT_EQ(msgs[3].seq, 6);
+    EXPECT_EQ(cache.get("c2").size(), 1u);
+}
+
 TEST(MessageCacheTest, RemoveConversation) {
     anychat::cache::MessageCache cache;
     cache.insert(makeMsg("c1", "m1", 1));
@@ -288,6 +315,30 @@ TEST(ConversationCacheTest, SetLastMessage) {
     EXPECT_EQ(result->last_msg_time_ms, 9999);
 }
 
+TEST(ConversationCacheTest, AdvanceSummaryNeverMovesBack) {
+    anychat::cache::ConversationCache cache;
+    anychat::Conversation conv = makeConv("c1", false, 1000);
+    conv.local_seq = 10;
+    cache.upsert(conv);
+
+    anychat::Message newer;
+    newer.message_id = "msg-new";
+    newer.content = "new";
+    newer.timestamp_ms = 2000;
+    cache.advanceSummary("c1", newer, 5); // local_seq 5 < 10: kept
+
+    anychat::Message older = newer;
+    older.message_id = "msg-old";
+    older.timestamp_ms = 1500;
+    cache.advanceSummary("c1", older, 12);
+
+    auto result = cache.get("c1");
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->last_msg_id, "msg-new");
+    EXPECT_EQ(result->last_msg_time_ms, 2000);
+    EXPECT_EQ(result->local_seq, 12);
+}
+
 TEST(ConversationCacheTest, SetAll) {
     anychat::cache::ConversationCache cache;
     cache.upsert(makeConv("old", false, 100)); // will be replaced
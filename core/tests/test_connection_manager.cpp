@@ -11,6 +11,8 @@
 #include <atomic>
 #include <chrono>
 #include <mutex>
+#include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 
@@ -88,14 +90,30 @@ public:
         }
     }
 
-    void send(const std::string&) override {
+    bool send(const std::string&, SendPriority) override {
         ++send_count;
+        return true;
+    }
+
+    bool sendBinary(const std::string&, SendPriority) override {
+        ++send_count;
+        return true;
+    }
+
+    bool sendPing(std::string_view payload) override {
+        std::lock_guard<std::mutex> lock(ping_mutex_);
+        pings_.emplace_back(payload);
+        return connected_;
     }
 
     bool isConnected() const override {
         return connected_;
     }
 
+    std::string subprotocol() const override {
+        return "";
+    }
+
     void setOnMessage(IWebSocketClient::MessageHandler h) override {
         on_message_ = std::move(h);
     }
@@ -108,6 +126,10 @@ public:
     void setOnError(IWebSocketClient::ErrorHandler h) override {
         on_error_ = std::move(h);
     }
+    void setOnDrained(IWebSocketClient::DrainedHandler) override {}
+    void setOnPong(IWebSocketClient::PongHandler h) override {
+        on_pong_ = std::move(h);
+    }
 
     // ---- 测试辅助：手动触发事件 -----------------------------------------------
     void simulateConnected() {
@@ -127,6 +149,29 @@ public:
             on_error_(err);
     }
 
+    void simulatePong(std::string_view payload) {
+        if (on_pong_)
+            on_pong_(payload);
+    }
+
+    // 等待第 n 个 ping（心跳在定时器线程上发送），返回其 payload；超时返回空串
+    std::string waitPing(size_t n) {
+        for (int i = 0; i < 500; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(ping_mutex_);
+                if (pings_.size() >= n)
+                    return pings_[n - 1];
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return {};
+    }
+
+    size_t pingCount() {
+        std::lock_guard<std::mutex> lock(ping_mutex_);
+        return pings_.size();
+    }
+
     // ---- 计数器 ---------------------------------------------------------------
     int connect_count = 0;
     int disconnect_count = 0;
@@ -141,6 +186,9 @@ private:
     IWebSocketClient::DisconnectedHandler on_disconnected_;
     IWebSocketClient::ErrorHandler on_error_;
     IWebSocketClient::MessageHandler on_message_;
+    IWebSocketClient::PongHandler on_pong_;
+    std::mutex ping_mutex_;
+    std::vector<std::string> pings_;
 };
 
 // ===========================================================================
@@ -638,3 +686,143 @@ TEST_F(ConnectionManagerTest, Destructor_WhileConnecting_DoesNotCrash) {
     EXPECT_EQ(cm->state(), ConnectionState::Connecting);
     EXPECT_NO_THROW({ cm.reset(); });
 }
+
+// ===========================================================================
+// 12. 共享定时器调度
+// ===========================================================================
+
+TEST_F(ConnectionManagerTest, SharedScheduler_TimersFollowConnectionState) {
+    auto timers = std::make_shared<anychat::util::TimerScheduler>();
+    cm = std::make_unique<ConnectionManager>(
+        "ws://fake:9999/ws",
+        monitor,
+        ws,
+        [](ConnectionState) {},
+        []() {},
+        timers
+    );
+    EXPECT_EQ(timers->pending(), 0u);
+
+    cm->connect();
+    ws->simulateConnected();
+    EXPECT_EQ(timers->pending(), 1u); // 心跳
+
+    ws->simulateDisconnected();
+    EXPECT_EQ(timers->pending(), 1u); // 心跳已取消，外层重连已排期
+
+    ws->simulateConnected();
+    EXPECT_EQ(timers->pending(), 1u); // 连接恢复：重连计划取消，只剩心跳
+
+    cm.reset();
+    EXPECT_EQ(timers->pending(), 0u) << "析构后不应残留定时器";
+}
+
+// ===========================================================================
+// 13. 心跳：RTT 测量与自适应间隔
+// ===========================================================================
+
+namespace {
+
+// 毫秒级的心跳参数，让定时器在测试中真实触发
+constexpr anychat::network::HeartbeatOptions kFastHeartbeat{
+    .min_interval_ms = 20,
+    .max_interval_ms = 60,
+    .step_ms = 20,
+    .probe_after = 1,
+    .min_pong_timeout_ms = 50,
+    .max_pong_timeout_ms = 50,
+};
+
+} // namespace
+
+TEST_F(ConnectionManagerTest, Heartbeat_PongIsAnRttSampleAndLengthensInterval) {
+    auto rtt = std::make_shared<anychat::network::RttEstimator>();
+    cm = std::make_unique<ConnectionManager>(
+        "ws://fake:9999/ws",
+        monitor,
+        ws,
+        [](ConnectionState) {},
+        []() {},
+        nullptr,
+        rtt,
+        kFastHeartbeat
+    );
+    cm->connect();
+    ws->simulateConnected();
+
+    const std::string first = ws->waitPing(1);
+    ASSERT_FALSE(first.empty());
+    ws->simulatePong("not-a-ping");
+    EXPECT_EQ(rtt->stats().samples, 0u) << "不匹配的 pong 不计入 RTT";
+
+    ws->simulatePong(first);
+    EXPECT_EQ(rtt->stats().samples, 1u);
+    EXPECT_EQ(cm->rtt().samples, 1u);
+    EXPECT_EQ(cm->heartbeatIntervalMs(), 40);
+
+    ws->simulatePong(first);
+    EXPECT_EQ(rtt->stats().samples, 1u) << "重复的 pong 被忽略";
+
+    const std::string second = ws->waitPing(2);
+    ASSERT_FALSE(second.empty());
+    EXPECT_NE(second, first);
+    ws->simulatePong(second);
+    EXPECT_EQ(rtt->stats().samples, 2u);
+    EXPECT_EQ(cm->heartbeatIntervalMs(), 60);
+    EXPECT_EQ(cm->state(), ConnectionState::Connected);
+}
+
+TEST_F(ConnectionManagerTest, Heartbeat_MissedPongMarksConnectionDeadAndSettlesInterval) {
+    cm = std::make_unique<ConnectionManager>(
+        "ws://fake:9999/ws",
+        monitor,
+        ws,
+        [this](ConnectionState s) {
+            std::lock_guard<std::mutex> lock(history_mutex);
+            state_history.push_back(s);
+        },
+        []() {},
+        nullptr,
+        nullptr,
+        kFastHeartbeat
+    );
+    cm->connect();
+    ws->simulateConnected();
+
+    ws->simulatePong(ws->waitPing(1)); // 20 ms 已验证，开始探测 40 ms
+    ASSERT_EQ(cm->heartbeatIntervalMs(), 40);
+    ASSERT_FALSE(ws->waitPing(2).empty()); // 不回 pong
+
+    for (int i = 0; i < 500 && cm->state() == ConnectionState::Connected; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    EXPECT_EQ(cm->state(), ConnectionState::Reconnecting);
+    EXPECT_EQ(cm->heartbeatIntervalMs(), 20) << "回落到最后一个成功的间隔";
+
+    const size_t pings = ws->pingCount();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(ws->pingCount(), pings) << "断线后心跳停止";
+}
+
+TEST_F(ConnectionManagerTest, Heartbeat_NetworkSwitchResetsEstimates) {
+    auto rtt = std::make_shared<anychat::network::RttEstimator>();
+    cm = std::make_unique<ConnectionManager>(
+        "ws://fake:9999/ws",
+        monitor,
+        ws,
+        [](ConnectionState) {},
+        []() {},
+        nullptr,
+        rtt,
+        kFastHeartbeat
+    );
+    cm->connect();
+    ws->simulateConnected();
+    ws->simulatePong(ws->waitPing(1));
+    ASSERT_EQ(rtt->stats().samples, 1u);
+    ASSERT_EQ(cm->heartbeatIntervalMs(), 40);
+
+    monitor->setStatus(NetworkStatus::ReachableViaCellular);
+    EXPECT_EQ(rtt->stats().samples, 0u);
+    EXPECT_EQ(cm->heartbeatIntervalMs(), 20);
+}
+
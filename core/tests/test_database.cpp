@@ -1,4 +1,5 @@
 #include "db/database.h"
+#include "db/migrations.h"
 
 #include <gtest/gtest.h>
 // Note: runMigrations() takes a raw sqlite3*, which is only accessible internally.
@@ -36,7 +37,7 @@ TEST_F(DatabaseTest, OpenAndMigrate) {
     // Query the schema version as additional confirmation.
     Rows rows = db_->querySync("PRAGMA user_version");
     ASSERT_FALSE(rows.empty());
-    EXPECT_EQ(rows[0].at("user_version"), "1");
+    EXPECT_EQ(rows[0].at("user_version"), std::to_string(kCurrentSchemaVersion));
 }
 
 // ---------------------------------------------------------------------------
@@ -0,0 +1,257 @@
+#include "util/dispatch_executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using anychat::util::DispatchExecutor;
+using anychat::util::DispatchExecutorOptions;
+using anychat::util::DispatchExecutorStats;
+
+namespace {
+
+// Holds tasks until opened.
+class Gate {
+public:
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++waiting_;
+        cv_.notify_all();
+        cv_.wait(lock, [this] {
+            return open_;
+        });
+    }
+
+    bool waitForWaiters(int n) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, std::chrono::seconds(5), [this, n] {
+            return waiting_ >= n;
+        });
+    }
+
+    void open() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = true;
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int waiting_ = 0;
+    bool open_ = false;
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 1. PreservesOrderPerKey
+//    Interleaved posts for several keys come out in post order per key.
+// ---------------------------------------------------------------------------
+TEST(DispatchExecutorTest, PreservesOrderPerKey) {
+    DispatchExecutor executor(DispatchExecutorOptions{ .threads = 4 });
+
+    std::mutex mutex;
+    std::map<std::string, std::vector<int>> seen;
+    for (int i = 0; i < 2000; ++i) {
+        const std::string key = "conv-" + std::to_string(i % 7);
+        ASSERT_TRUE(executor.post(key, [&, key, i] {
+            std::lock_guard<std::mutex> lock(mutex);
+            seen[key].push_back(i);
+        }));
+    }
+    executor.drain();
+
+    ASSERT_EQ(seen.size(), 7u);
+    for (const auto& [key, order] : seen) {
+        EXPECT_EQ(order.size(), 2000u / 7 + (key < "conv-5" ? 1 : 0)) << key;
+        EXPECT_TRUE(std::is_sorted(order.begin(), order.end())) << key;
+    }
+    const DispatchExecutorStats stats = executor.stats();
+    EXPECT_EQ(stats.posted, 2000u);
+    EXPECT_EQ(stats.executed, 2000u);
+    EXPECT_EQ(stats.queued, 0u);
+    EXPECT_EQ(stats.keys, 0u);
+}
+
+// ---------------------------------------------------------------------------
+// 2. KeysRunInParallel
+//    A blocked conversation does not hold up another one.
+// ---------------------------------------------------------------------------
+TEST(DispatchExecutorTest, KeysRunInParallel) {
+    DispatchExecutor executor(DispatchExecutorOptions{ .threads = 2 });
+    Gate gate;
+    std::atomic<int> behind_gate{ 0 };
+    std::atomic<bool> other_ran{ false };
+
+    executor.post("slow", [&] {
+        gate.wait();
+    });
+    executor.post("slow", [&] {
+        ++behind_gate;
+    });
+    ASSERT_TRUE(gate.waitForWaiters(1));
+    executor.post("fast", [&] {
+        other_ran = true;
+    });
+
+    for (int i = 0; i < 500 && !other_ran; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(other_ran);
+    EXPECT_EQ(behind_gate, 0); // same key: still waiting its turn
+
+    gate.open();
+    executor.drain();
+    EXPECT_EQ(behind_gate, 1);
+}
+
+// ---------------------------------------------------------------------------
+// 3. FullQueueBlocksProducer
+//    Beyond max_queued, post() waits for a worker to take a task.
+// ---------------------------------------------------------------------------
+TEST(DispatchExecutorTest, FullQueueBlocksProducer) {
+    DispatchExecutor executor(DispatchExecutorOptions{ .threads = 1, .max_queued = 2 });
+    Gate gate;
+    executor.post("a", [&] {
+        gate.wait();
+    });
+    ASSERT_TRUE(gate.waitForWaiters(1)); // running, no longer queued
+    executor.post("a", [] {});
+    executor.post("b", [] {});
+
+    std::atomic<bool> posted{ false };
+    std::thread producer([&] {
+        executor.post("c", [] {});
+        posted = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(posted);
+
+    gate.open();
+    producer.join();
+    EXPECT_TRUE(posted);
+    executor.drain();
+
+    const DispatchExecutorStats stats = executor.stats();
+    EXPECT_EQ(stats.producer_waits, 1u);
+    EXPECT_EQ(stats.peak_queued, 2u);
+    EXPECT_EQ(stats.executed, 4u);
+}
+
+// ---------------------------------------------------------------------------
+// 4. TasksMayPostOnFullQueue
+//    A task posting to its own executor never waits on itself.
+// ---------------------------------------------------------------------------
+TEST(DispatchExecutorTest, TasksMayPostOnFullQueue) {
+    DispatchExecutor executor(DispatchExecutorOptions{ .threads = 1, .max_queued = 1 });
+    std::atomic<int> ran{ 0 };
+    executor.post("a", [&] {
+        for (int i = 0; i < 3; ++i) {
+            executor.post("a", [&] {
+                ++ran;
+            });
+        }
+    });
+    executor.drain();
+    EXPECT_EQ(ran, 3);
+    EXPECT_EQ(executor.stats().producer_waits, 0u);
+}
+
+// ---------------------------------------------------------------------------
+// 5. ShutdownDropsWaitingTasks
+// ---------------------------------------------------------------------------
+TEST(DispatchExecutorTest, ShutdownDropsWaitingTasks) {
+    DispatchExecutor executor(DispatchExecutorOptions{ .threads = 1 });
+    Gate gate;
+    std::atomic<int> ran{ 0 };
+    executor.post("a", [&] {
+        gate.wait();
+        ++ran;
+    });
+    ASSERT_TRUE(gate.waitForWaiters(1));
+    executor.post("a", [&] {
+        ++ran;
+    });
+
+    std::thread stopper([&] {
+        executor.shutdown();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    gate.open();
+    stopper.join();
+
+    EXPECT_EQ(ran, 1); // the running task finished, the waiting one was dropped
+    EXPECT_FALSE(executor.post("a", [] {}));
+}
+
+// ---------------------------------------------------------------------------
+// 6. PostNoWaitExceedsLimit
+//    For timer callbacks: queues past the limit instead of blocking.
+// ---------------------------------------------------------------------------
+TEST(DispatchExecutorTest, PostNoWaitExceedsLimit) {
+    DispatchExecutor executor(DispatchExecutorOptions{ .threads = 1, .max_queued = 1 });
+    Gate gate;
+    executor.post("a", [&] {
+        gate.wait();
+    });
+    ASSERT_TRUE(gate.waitForWaiters(1));
+    executor.post("a", [] {});
+    EXPECT_TRUE(executor.postNoWait("b", [] {}));
+    EXPECT_EQ(executor.stats().queued, 2u);
+
+    gate.open();
+    executor.drain();
+    EXPECT_EQ(executor.stats().producer_waits, 0u);
+    EXPECT_EQ(executor.stats().executed, 3u);
+}
+
+// ---------------------------------------------------------------------------
+// 7. SpaceHandlerFiresAtHalfAfterFull
+//    The WebSocket reader's backpressure: full() arms the space handler,
+//    which runs once the queue is back down to half of max_queued.
+// ---------------------------------------------------------------------------
+TEST(DispatchExecutorTest, SpaceHandlerFiresAtHalfAfterFull) {
+    DispatchExecutor executor(DispatchExecutorOptions{ .threads = 1, .max_queued = 4 });
+    std::mutex mutex;
+    std::vector<int> events; // task ids, -1 for the space handler
+    executor.setOnSpace([&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back(-1);
+    });
+
+    Gate gate;
+    executor.post("a", [&] {
+        gate.wait();
+    });
+    ASSERT_TRUE(gate.waitForWaiters(1));
+    EXPECT_FALSE(executor.full());
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(executor.postNoWait("a", [&, i] {
+            std::lock_guard<std::mutex> lock(mutex);
+            events.push_back(i);
+        }));
+    }
+    EXPECT_TRUE(executor.full());
+    EXPECT_TRUE(executor.full()); // still pending, counted once
+
+    gate.open();
+    executor.drain();
+    // Taking task 1 leaves two of four queued.
+    EXPECT_EQ(events, std::vector<int>({ 0, -1, 1, 2, 3 }));
+    EXPECT_EQ(executor.stats().full_reports, 1u);
+    EXPECT_FALSE(executor.full());
+
+    // Not armed again without another full().
+    executor.post("a", [] {});
+    executor.drain();
+    EXPECT_EQ(std::count(events.begin(), events.end(), -1), 1);
+}
@@ -0,0 +1,422 @@
+#include "download_manager.h"
+
+#include "db/database.h"
+#include "local_http_server.h"
+#include "network/http_client.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// Presigned-storage stand-in serving one blob at /blob with Range support.
+// ignore_range answers every request with the full body; fail_offset makes
+// ranges starting at that offset return 500; change_offset replaces the blob
+// with a new version once the range starting there has been served.
+class FakeBlobServer {
+public:
+    explicit FakeBlobServer(size_t size)
+        : server_([this](const anychat::test::LocalHttpRequest& req) {
+            return handle(req);
+        }) {
+        blob.resize(size);
+        for (size_t i = 0; i < size; ++i)
+            blob[i] = static_cast<char>((i * 13 + i / 4096) & 0xff);
+    }
+
+    std::string url() const {
+        return server_.baseUrl() + "/blob";
+    }
+
+    std::mutex mutex;
+    std::string blob;
+    std::string etag = "\"v1\"";
+    bool ignore_range = false;
+    int64_t fail_offset = -1;
+    int64_t change_offset = -1;
+    int max_concurrent = 0;
+    std::map<int64_t, int> served_ranges; // first byte -> successful 206 replies
+    int full_replies = 0;
+
+private:
+    anychat::test::LocalHttpReply handle(const anychat::test::LocalHttpRequest& req) {
+        anychat::test::LocalHttpReply reply;
+        if (req.method != "GET" || req.target != "/blob") {
+            reply.status = 404;
+            return reply;
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            max_concurrent = std::max(max_concurrent, ++concurrent_);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        std::lock_guard<std::mutex> lk(mutex);
+        --concurrent_;
+        reply.headers.emplace_back("ETag", etag);
+
+        const std::string range = req.header("range");
+        if (ignore_range || range.rfind("bytes=", 0) != 0) {
+            ++full_replies;
+            reply.body = blob;
+            return reply;
+        }
+
+        const size_t dash = range.find('-');
+        const int64_t first = std::stoll(range.substr(6, dash - 6));
+        const int64_t last = std::min<int64_t>(std::stoll(range.substr(dash + 1)), blob.size() - 1);
+        if (first == fail_offset) {
+            reply.status = 500;
+            return reply;
+        }
+
+        ++served_ranges[first];
+        reply.status = 206;
+        reply.body = blob.substr(static_cast<size_t>(first), static_cast<size_t>(last - first + 1));
+        reply.headers.emplace_back(
+            "Content-Range",
+            "bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(blob.size())
+        );
+        if (first == change_offset) {
+            change_offset = -1;
+            etag = "\"v2\"";
+            for (auto& c : blob)
+                c = static_cast<char>(c ^ 0x5a);
+        }
+        return reply;
+    }
+
+    int concurrent_ = 0;
+    anychat::test::LocalHttpServer server_;
+};
+
+struct DownloadOutcome {
+    bool ok = false;
+    std::string path;
+    std::string error;
+};
+
+std::future<DownloadOutcome> startDownload(
+    anychat::DownloadManager& mgr,
+    const std::string& file_id,
+    const std::string& dest,
+    anychat::DownloadProgressCallback on_progress = nullptr
+) {
+    auto done = std::make_shared<std::promise<DownloadOutcome>>();
+    auto fut = done->get_future();
+    mgr.download(
+        file_id,
+        dest,
+        std::move(on_progress),
+        anychat::AnyChatValueCallback<std::string>{
+            .on_success = [done](const std::string& path) { done->set_value({ true, path, {} }); },
+            .on_error = [done](int, const std::string& error) { done->set_value({ false, {}, error }); },
+        }
+    );
+    return fut;
+}
+
+DownloadOutcome waitFor(std::future<DownloadOutcome>& fut) {
+    EXPECT_EQ(fut.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    return fut.get();
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+}
+
+std::string tempPath(const std::string& name) {
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove(path);
+    std::filesystem::remove(path.string() + ".part");
+    return path.string();
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 1. LargeFileIsFetchedInParallelRanges
+//    300 KiB in 64 KiB segments -> 5 ranges, several in flight at once; the
+//    result matches the blob and the part file is gone.
+// ---------------------------------------------------------------------------
+TEST(DownloadManagerTest, LargeFileIsFetchedInParallelRanges) {
+    FakeBlobServer server(300 * 1024);
+    auto http = std::make_shared<anychat::network::HttpClient>("http://127.0.0.1:1");
+
+    std::atomic<int> resolves{ 0 };
+    anychat::DownloadManager mgr(
+        http,
+        nullptr,
+        [&](const std::string&, anychat::AnyChatValueCallback<std::string> cb) {
+            ++resolves;
+            cb.on_success(server.url());
+        },
+        anychat::DownloadOptions{ .segment_size = 64 * 1024, .parallelism = 3 }
+    );
+
+    const std::string dest = tempPath("anychat_download_parallel.bin");
+    std::atomic<int64_t> last_downloaded{ 0 };
+    std::atomic<int64_t> last_total{ 0 };
+    auto fut = startDownload(mgr, "f-1", dest, [&](int64_t downloaded, int64_t total) {
+        last_downloaded = downloaded;
+        last_total = total;
+    });
+
+    const DownloadOutcome outcome = waitFor(fut);
+    ASSERT_TRUE(outcome.ok) << outcome.error;
+    EXPECT_EQ(outcome.path, dest);
+    EXPECT_EQ(resolves.load(), 1);
+    EXPECT_EQ(last_downloaded.load(), 300 * 1024);
+    EXPECT_EQ(last_total.load(), 300 * 1024);
+    EXPECT_FALSE(std::filesystem::exists(dest + ".part"));
+
+    std::lock_guard<std::mutex> lk(server.mutex);
+    EXPECT_EQ(readFile(dest), server.blob);
+    EXPECT_EQ(server.served_ranges.size(), 5u);
+    EXPECT_GT(server.max_concurrent, 1);
+    EXPECT_LE(server.max_concurrent, 3);
+
+    std::filesystem::remove(dest);
+}
+
+// ---------------------------------------------------------------------------
+// 2. ServerWithoutRangeSupportStreamsWholeFile
+// ---------------------------------------------------------------------------
+TEST(DownloadManagerTest, ServerWithoutRangeSupportStreamsWholeFile) {
+    FakeBlobServer server(200 * 1024);
+    server.ignore_range = true;
+    auto http = std::make_shared<anychat::network::HttpClient>("http://127.0.0.1:1");
+    anychat::DownloadManager mgr(
+        http,
+        nullptr,
+        [&](const std::string&, anychat::AnyChatValueCallback<std::string> cb) {
+            cb.on_success(server.url());
+        },
+        anychat::DownloadOptions{ .segment_size = 64 * 1024, .parallelism = 3 }
+    );
+
+    const std::string dest = tempPath("anychat_download_norange.bin");
+    auto fut = startDownload(mgr, "f-2", dest);
+    const DownloadOutcome outcome = waitFor(fut);
+    ASSERT_TRUE(outcome.ok) << outcome.error;
+
+    std::lock_guard<std::mutex> lk(server.mutex);
+    EXPECT_EQ(server.full_replies, 1);
+    EXPECT_EQ(readFile(dest), server.blob);
+
+    std::filesystem::remove(dest);
+}
+
+// ---------------------------------------------------------------------------
+// 3. ConcurrentRequestsForSameFileShareOneTransfer
+// ---------------------------------------------------------------------------
+TEST(DownloadManagerTest, ConcurrentRequestsForSameFileShareOneTransfer) {
+    FakeBlobServer server(128 * 1024);
+    auto http = std::make_shared<anychat::network::HttpClient>("http://127.0.0.1:1");
+
+    std::atomic<int> resolves{ 0 };
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    anychat::DownloadManager mgr(
+        http,
+        nullptr,
+        [&, released](const std::string&, anychat::AnyChatValueCallback<std::string> cb) {
+            ++resolves;
+            // Hold the first transfer until the second caller has joined.
+            std::thread([released, cb, url = server.url()] {
+                released.wait();
+                cb.on_success(url);
+            }).detach();
+        },
+        anychat::DownloadOptions{ .segment_size = 64 * 1024, .parallelism = 2 }
+    );
+
+    const std::string dest = tempPath("anychat_download_dedupe.bin");
+    auto first = startDownload(mgr, "f-3", dest);
+    auto second = startDownload(mgr, "f-3", dest + ".other");
+    release.set_value();
+
+    const DownloadOutcome a = waitFor(first);
+    const DownloadOutcome b = waitFor(second);
+    ASSERT_TRUE(a.ok) << a.error;
+    ASSERT_TRUE(b.ok) << b.error;
+    EXPECT_EQ(a.path, dest);
+    EXPECT_EQ(b.path, dest);
+    EXPECT_EQ(resolves.load(), 1);
+
+    std::lock_guard<std::mutex> lk(server.mutex);
+    for (const auto& [first_byte, count] : server.served_ranges)
+        EXPECT_EQ(count, 1) << "range at " << first_byte << " fetched more than once";
+
+    std::filesystem::remove(dest);
+}
+
+// ---------------------------------------------------------------------------
+// 4. FailedDownloadResumesMissingSegments
+//    The first attempt fails on the third segment. The retry validates the
+//    recorded state and fetches only what is missing.
+// ---------------------------------------------------------------------------
+TEST(DownloadManagerTest, FailedDownloadResumesMissingSegments) {
+    FakeBlobServer server(300 * 1024);
+    server.fail_offset = 128 * 1024;
+
+    anychat::db::Database db(":memory:");
+    ASSERT_TRUE(db.open());
+
+    auto http = std::make_shared<anychat::network::HttpClient>("http://127.0.0.1:1");
+    http->setDefaultRetryPolicy(anychat::network::RetryPolicy{ .max_attempts = 1 });
+    anychat::DownloadManager mgr(
+        http,
+        &db,
+        [&](const std::string&, anychat::AnyChatValueCallback<std::string> cb) {
+            cb.on_success(server.url());
+        },
+        anychat::DownloadOptions{ .segment_size = 64 * 1024, .parallelism = 2 }
+    );
+
+    const std::string dest = tempPath("anychat_download_resume.bin");
+    auto first = startDownload(mgr, "f-4", dest);
+    const DownloadOutcome failed = waitFor(first);
+    EXPECT_FALSE(failed.ok);
+    EXPECT_TRUE(std::filesystem::exists(dest + ".part"));
+
+    {
+        std::lock_guard<std::mutex> lk(server.mutex);
+        server.fail_offset = -1;
+    }
+
+    auto second = startDownload(mgr, "f-4", dest);
+    const DownloadOutcome resumed = waitFor(second);
+    ASSERT_TRUE(resumed.ok) << resumed.error;
+
+    {
+        std::lock_guard<std::mutex> lk(server.mutex);
+        EXPECT_EQ(readFile(dest), server.blob);
+        // Offset 0 is also hit by the one-byte validation request.
+        for (const auto& [first_byte, count] : server.served_ranges) {
+            if (first_byte != 0)
+                EXPECT_EQ(count, 1) << "range at " << first_byte << " fetched more than once";
+        }
+    }
+
+    auto tasks = db.querySync("SELECT COUNT(*) AS n FROM download_tasks");
+    ASSERT_FALSE(tasks.empty());
+    EXPECT_EQ(tasks[0].at("n"), "0");
+
+    db.close();
+    std::filesystem::remove(dest);
+}
+
+// ---------------------------------------------------------------------------
+// 5. ChangedRemoteFileRestartsDownload
+//    A different ETag on resume discards the recorded segments.
+// ---------------------------------------------------------------------------
+TEST(DownloadManagerTest, ChangedRemoteFileRestartsDownload) {
+    FakeBlobServer server(256 * 1024);
+    server.fail_offset = 192 * 1024;
+
+    anychat::db::Database db(":memory:");
+    ASSERT_TRUE(db.open());
+
+    auto http = std::make_shared<anychat::network::HttpClient>("http://127.0.0.1:1");
+    http->setDefaultRetryPolicy(anychat::network::RetryPolicy{ .max_attempts = 1 });
+    anychat::DownloadManager mgr(
+        http,
+        &db,
+        [&](const std::string&, anychat::AnyChatValueCallback<std::string> cb) {
+            cb.on_success(server.url());
+        },
+        anychat::DownloadOptions{ .segment_size = 64 * 1024, .parallelism = 1 }
+    );
+
+    const std::string dest = tempPath("anychat_download_changed.bin");
+    auto first = startDownload(mgr, "f-5", dest);
+    EXPECT_FALSE(waitFor(first).ok);
+
+    {
+        std::lock_guard<std::mutex> lk(server.mutex);
+        server.fail_offset = -1;
+        server.etag = "\"v2\"";
+        for (auto& c : server.blob)
+            c = static_cast<char>(c ^ 0x5a);
+        server.served_ranges.clear();
+    }
+
+    auto second = startDownload(mgr, "f-5", dest);
+    const DownloadOutcome outcome = waitFor(second);
+    ASSERT_TRUE(outcome.ok) << outcome.error;
+
+    std::lock_guard<std::mutex> lk(server.mutex);
+    EXPECT_EQ(readFile(dest), server.blob);
+    EXPECT_EQ(server.served_ranges[64 * 1024], 1);
+
+    db.close();
+    std::filesystem::remove(dest);
+}
+
+// ---------------------------------------------------------------------------
+// 6. FileChangedMidDownloadRestarts
+//    A segment carrying another ETag is not spliced in; the download starts
+//    over and ends with the new version only.
+// ---------------------------------------------------------------------------
+TEST(DownloadManagerTest, FileChangedMidDownloadRestarts) {
+    FakeBlobServer server(256 * 1024);
+    server.change_offset = 0;
+
+    anychat::db::Database db(":memory:");
+    ASSERT_TRUE(db.open());
+
+    auto http = std::make_shared<anychat::network::HttpClient>("http://127.0.0.1:1");
+    http->setDefaultRetryPolicy(anychat::network::RetryPolicy{ .max_attempts = 1 });
+    anychat::DownloadManager mgr(
+        http,
+        &db,
+        [&](const std::string&, anychat::AnyChatValueCallback<std::string> cb) {
+            cb.on_success(server.url());
+        },
+        anychat::DownloadOptions{ .segment_size = 64 * 1024, .parallelism = 1 }
+    );
+
+    const std::string dest = tempPath("anychat_download_midchange.bin");
+    auto fut = startDownload(mgr, "f-6", dest);
+    const DownloadOutcome outcome = waitFor(fut);
+    ASSERT_TRUE(outcome.ok) << outcome.error;
+
+    std::lock_guard<std::mutex> lk(server.mutex);
+    EXPECT_EQ(readFile(dest), server.blob);
+    EXPECT_EQ(server.served_ranges[0], 2);
+
+    db.close();
+    std::filesystem::remove(dest);
+}
+
+// ---------------------------------------------------------------------------
+// 7. UrlResolutionFailureIsReported
+// ---------------------------------------------------------------------------
+TEST(DownloadManagerTest, UrlResolutionFailureIsReported) {
+    auto http = std::make_shared<anychat::network::HttpClient>("http://127.0.0.1:1");
+    anychat::DownloadManager mgr(http, nullptr, [](const std::string&, anychat::AnyChatValueCallback<std::string> cb) {
+        cb.on_error(404, "file not found");
+    });
+
+    const std::string dest = tempPath("anychat_download_missing.bin");
+    auto fut = startDownload(mgr, "missing", dest);
+    const DownloadOutcome outcome = waitFor(fut);
+    EXPECT_FALSE(outcome.ok);
+    EXPECT_EQ(outcome.error, "file not found");
+    EXPECT_FALSE(std::filesystem::exists(dest));
+}
@@ -0,0 +1,154 @@
+#include "util/event_batcher.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using anychat::util::DispatchExecutor;
+using anychat::util::EventBatcher;
+using anychat::util::EventBatcherStats;
+using anychat::util::TimerScheduler;
+
+namespace {
+
+constexpr auto kWindow = std::chrono::milliseconds(20);
+
+// Records delivered batches; waitable from the test thread.
+class BatchLog {
+public:
+    void operator()(std::vector<std::string>&& batch) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batches_.push_back(std::move(batch));
+        threads_.push_back(std::this_thread::get_id());
+        cv_.notify_all();
+    }
+
+    bool waitFor(size_t n) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, std::chrono::seconds(5), [this, n] {
+            return batches_.size() >= n;
+        });
+    }
+
+    std::vector<std::vector<std::string>> batches() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return batches_;
+    }
+
+    std::vector<std::thread::id> threads() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return threads_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::vector<std::string>> batches_;
+    std::vector<std::thread::id> threads_;
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Fixture
+// ---------------------------------------------------------------------------
+class EventBatcherTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        timers_ = std::make_shared<TimerScheduler>(std::chrono::milliseconds(1));
+    }
+
+    std::unique_ptr<EventBatcher<std::string>> makeBatcher(std::shared_ptr<DispatchExecutor> executor = nullptr) {
+        return std::make_unique<EventBatcher<std::string>>(
+            timers_,
+            std::move(executor),
+            "batch",
+            kWindow,
+            [this](std::vector<std::string>&& batch) {
+                log_(std::move(batch));
+            }
+        );
+    }
+
+    std::shared_ptr<TimerScheduler> timers_;
+    BatchLog log_;
+};
+
+// ---------------------------------------------------------------------------
+// 1. DeliversOneBatchPerWindow
+// ---------------------------------------------------------------------------
+TEST_F(EventBatcherTest, DeliversOneBatchPerWindow) {
+    auto batcher = makeBatcher();
+    batcher->add("a");
+    batcher->add("b");
+    batcher->add("c");
+    ASSERT_TRUE(log_.waitFor(1));
+
+    batcher->add("d");
+    ASSERT_TRUE(log_.waitFor(2));
+
+    const auto batches = log_.batches();
+    ASSERT_EQ(batches.size(), 2u);
+    EXPECT_EQ(batches[0], (std::vector<std::string>{ "a", "b", "c" }));
+    EXPECT_EQ(batches[1], std::vector<std::string>{ "d" });
+    EXPECT_EQ(batcher->stats().batches, 2u);
+}
+
+// ---------------------------------------------------------------------------
+// 2. CoalescesByKey
+//    A repeated key keeps the latest event at the first one's position.
+// ---------------------------------------------------------------------------
+TEST_F(EventBatcherTest, CoalescesByKey) {
+    auto batcher = makeBatcher();
+    batcher->add("typing-1", "conv-1");
+    batcher->add("typing-2", "conv-2");
+    batcher->add("plain");
+    batcher->add("typing-1b", "conv-1");
+    ASSERT_TRUE(log_.waitFor(1));
+
+    EXPECT_EQ(log_.batches()[0], (std::vector<std::string>{ "typing-1b", "typing-2", "plain" }));
+    const EventBatcherStats stats = batcher->stats();
+    EXPECT_EQ(stats.events, 4u);
+    EXPECT_EQ(stats.coalesced, 1u);
+}
+
+// ---------------------------------------------------------------------------
+// 3. FlushDeliversNow
+//    On the calling thread; the window's timer then finds nothing to send.
+// ---------------------------------------------------------------------------
+TEST_F(EventBatcherTest, FlushDeliversNow) {
+    auto batcher = makeBatcher();
+    batcher->add("a");
+    batcher->flush();
+
+    ASSERT_EQ(log_.batches().size(), 1u);
+    EXPECT_EQ(log_.threads()[0], std::this_thread::get_id());
+
+    std::this_thread::sleep_for(kWindow * 3);
+    EXPECT_EQ(log_.batches().size(), 1u);
+
+    batcher->add("b"); // opens a new window
+    ASSERT_TRUE(log_.waitFor(2));
+    EXPECT_EQ(log_.batches()[1], std::vector<std::string>{ "b" });
+}
+
+// ---------------------------------------------------------------------------
+// 4. DeliversOnExecutor
+//    The timer thread only posts the delivery.
+// ---------------------------------------------------------------------------
+TEST_F(EventBatcherTest, DeliversOnExecutor) {
+    auto executor = std::make_shared<DispatchExecutor>();
+    auto batcher = makeBatcher(executor);
+    batcher->add("a");
+    ASSERT_TRUE(log_.waitFor(1));
+    executor->shutdown(); // before the batcher goes
+
+    EXPECT_NE(log_.threads()[0], std::this_thread::get_id());
+    EXPECT_EQ(executor->stats().executed, 1u);
+}
@@ -1,10 +1,24 @@
 #include "file_manager.h"
 
 #include "anychat/types.h"
+#include "db/database.h"
+#include "local_http_server.h"
 #include "network/http_client.h"
+#include "util/sha256.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -133,3 +147,459 @@ TEST_F(FileManagerTest, UploadClientLogNonExistentFileReportsError) {
 TEST_F(FileManagerTest, DeleteFileDoesNotCrash) {
     EXPECT_NO_THROW(mgr_->deleteFile("file-id-999", makeNoopCallback()));
 }
+
+// ---------------------------------------------------------------------------
+// 7. UploadStreamsFileFromDisk
+//    Full token -> PUT -> complete flow against a local stand-in server; the
+//    PUT body must match the file on disk and progress must reach the total.
+// ---------------------------------------------------------------------------
+TEST(FileManagerUploadTest, UploadStreamsFileFromDisk) {
+    std::mutex mutex;
+    std::string base_url;
+    std::string put_body;
+    bool completed = false;
+
+    anychat::test::LocalHttpServer server([&](const anychat::test::LocalHttpRequest& req) {
+        std::lock_guard<std::mutex> lk(mutex);
+        anychat::test::LocalHttpReply reply;
+        if (req.method == "POST" && req.target == "/files/upload-token") {
+            reply.body = R"({"code":0,"message":"ok","data":{"file_id":"file-1","upload_url":")" + base_url
+                         + R"(/storage/file-1"}})";
+        } else if (req.method == "PUT" && req.target == "/storage/file-1") {
+            put_body = req.body;
+        } else if (req.method == "POST" && req.target == "/files/file-1/complete") {
+            completed = true;
+            reply.body = R"({"code":0,"message":"ok","data":{"file_id":"file-1","file_name":"photo.bin"}})";
+        } else {
+            reply.status = 404;
+        }
+        return reply;
+    });
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        base_url = server.baseUrl();
+    }
+
+    const auto path = std::filesystem::temp_directory_path() / "anychat_upload_stream.bin";
+    const std::string content(512 * 1024, 'x');
+    {
+        std::ofstream ofs(path, std::ios::binary);
+        ofs << content;
+    }
+
+    auto http = std::make_shared<anychat::network::HttpClient>(server.baseUrl());
+    anychat::FileManagerImpl mgr(http);
+
+    std::atomic<int64_t> last_uploaded{ -1 };
+    std::promise<anychat::FileInfo> done;
+    auto fut = done.get_future();
+    mgr.upload(
+        path.string(),
+        ANYCHAT_FILE_TYPE_FILE,
+        [&](int64_t uploaded, int64_t total) {
+            EXPECT_EQ(total, static_cast<int64_t>(content.size()));
+            last_uploaded = uploaded;
+        },
+        anychat::AnyChatValueCallback<anychat::FileInfo>{
+            .on_success = [&](const anychat::FileInfo& info) { done.set_value(info); },
+            .on_error = [&](int, const std::string& error) {
+                ADD_FAILURE() << error;
+                done.set_value({});
+            },
+        }
+    );
+
+    ASSERT_EQ(fut.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_EQ(fut.get().file_id, "file-1");
+    EXPECT_EQ(last_uploaded.load(), static_cast<int64_t>(content.size()));
+
+    std::lock_guard<std::mutex> lk(mutex);
+    EXPECT_TRUE(completed);
+    EXPECT_EQ(put_body, content);
+
+    std::filesystem::remove(path);
+}
+
+// ===========================================================================
+// Multipart upload against a stand-in storage server
+// ===========================================================================
+namespace {
+
+// Implements the multipart endpoints of the file service plus the presigned
+// part storage. fail_part makes every PUT of that part return 500.
+class FakeMultipartServer {
+public:
+    FakeMultipartServer()
+        : server_([this](const anychat::test::LocalHttpRequest& req) {
+            return handle(req);
+        }) {}
+
+    std::string baseUrl() const {
+        return server_.baseUrl();
+    }
+
+    std::mutex mutex;
+    int init_calls = 0;
+    int fail_part = 0;
+    bool parts_gone = false; // /parts answers 404, as for a purged upload
+    int max_concurrent_puts = 0;
+    std::map<int, std::string> parts; // stored part bodies
+    std::map<int, int> put_successes;
+    std::string complete_body;
+
+private:
+    anychat::test::LocalHttpReply handle(const anychat::test::LocalHttpRequest& req) {
+        anychat::test::LocalHttpReply reply;
+        const std::string storage_prefix = "/storage/mp-1/";
+
+        if (req.method == "POST" && req.target == "/files/multipart/init") {
+            std::lock_guard<std::mutex> lk(mutex);
+            ++init_calls;
+            reply.body = R"({"code":0,"message":"ok","data":{"file_id":"mp-1","upload_id":"up-1"}})";
+        } else if (req.method == "POST" && req.target == "/files/mp-1/parts" && partsGone()) {
+            reply.status = 404;
+        } else if (req.method == "POST" && req.target == "/files/mp-1/parts") {
+            // Echo a URL for every requested part number.
+            const size_t open = req.body.find('[');
+            const size_t close = req.body.find(']', open);
+            std::string list = req.body.substr(open + 1, close - open - 1);
+            std::string parts_json;
+            size_t pos = 0;
+            while (pos < list.size()) {
+                size_t comma = list.find(',', pos);
+                if (comma == std::string::npos)
+                    comma = list.size();
+                const std::string n = list.substr(pos, comma - pos);
+                if (!parts_json.empty())
+                    parts_json += ",";
+                parts_json += R"({"part_number":)" + n + R"(,"upload_url":")" + server_.baseUrl() + storage_prefix + n
+                              + R"("})";
+                pos = comma + 1;
+            }
+            reply.body = R"({"code":0,"message":"ok","data":{"parts":[)" + parts_json + "]}}";
+        } else if (req.method == "PUT" && req.target.rfind(storage_prefix, 0) == 0) {
+            const int part = std::stoi(req.target.substr(storage_prefix.size()));
+            {
+                std::lock_guard<std::mutex> lk(mutex);
+                max_concurrent_puts = std::max(max_concurrent_puts, ++concurrent_puts_);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            std::lock_guard<std::mutex> lk(mutex);
+            --concurrent_puts_;
+            if (part == fail_part) {
+                reply.status = 500;
+            } else {
+                parts[part] = req.body;
+                ++put_successes[part];
+                reply.headers.emplace_back("ETag", "\"etag-" + std::to_string(part) + "\"");
+            }
+        } else if (req.method == "POST" && req.target == "/files/mp-1/complete") {
+            std::lock_guard<std::mutex> lk(mutex);
+            complete_body = req.body;
+            reply.body = R"({"code":0,"message":"ok","data":{"file_id":"mp-1","file_name":"big.bin"}})";
+        } else {
+            reply.status = 404;
+        }
+        return reply;
+    }
+
+    bool partsGone() {
+        std::lock_guard<std::mutex> lk(mutex);
+        return parts_gone;
+    }
+
+    int concurrent_puts_ = 0;
+    anychat::test::LocalHttpServer server_;
+};
+
+std::string writeTempFile(const std::string& name, size_t size) {
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::string content(size, '\0');
+    for (size_t i = 0; i < size; ++i)
+        content[i] = static_cast<char>((i * 7 + i / 1024) & 0xff);
+    std::ofstream ofs(path, std::ios::binary);
+    ofs << content;
+    return path.string();
+}
+
+struct UploadOutcome {
+    bool ok = false;
+    anychat::FileInfo info;
+    std::string error;
+};
+
+UploadOutcome runMultipart(
+    anychat::FileManagerImpl& mgr,
+    const std::string& path,
+    anychat::MultipartUploadOptions options,
+    anychat::UploadProgressCallback on_progress = nullptr
+) {
+    std::promise<UploadOutcome> done;
+    auto fut = done.get_future();
+    mgr.uploadMultipart(
+        path,
+        ANYCHAT_FILE_TYPE_FILE,
+        options,
+        std::move(on_progress),
+        anychat::AnyChatValueCallback<anychat::FileInfo>{
+            .on_success = [&](const anychat::FileInfo& info) { done.set_value({ true, info, {} }); },
+            .on_error = [&](int, const std::string& error) { done.set_value({ false, {}, error }); },
+        }
+    );
+    EXPECT_EQ(fut.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    return fut.get();
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 8. MultipartUploadSendsPartsInParallel
+//    300 KiB in 64 KiB parts -> 5 parts, at most 3 in flight; the stored
+//    parts reassemble to the original file and complete lists every ETag.
+// ---------------------------------------------------------------------------
+TEST(FileManagerMultipartTest, MultipartUploadSendsPartsInParallel) {
+    FakeMultipartServer server;
+    const std::string path = writeTempFile("anychat_multipart_parallel.bin", 300 * 1024);
+
+    auto http = std::make_shared<anychat::network::HttpClient>(server.baseUrl());
+    anychat::FileManagerImpl mgr(http);
+
+    std::atomic<int64_t> last_uploaded{ 0 };
+    const UploadOutcome outcome = runMultipart(
+        mgr,
+        path,
+        anychat::MultipartUploadOptions{ .part_size = 64 * 1024, .parallelism = 3 },
+        [&](int64_t uploaded, int64_t total) {
+            EXPECT_EQ(total, 300 * 1024);
+            last_uploaded = uploaded;
+        }
+    );
+
+    ASSERT_TRUE(outcome.ok) << outcome.error;
+    EXPECT_EQ(outcome.info.file_id, "mp-1");
+    EXPECT_EQ(last_uploaded.load(), 300 * 1024);
+
+    std::ifstream ifs(path, std::ios::binary);
+    const std::string original((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+    std::lock_guard<std::mutex> lk(server.mutex);
+    ASSERT_EQ(server.parts.size(), 5u);
+    std::string assembled;
+    for (const auto& [part, body] : server.parts)
+        assembled += body;
+    EXPECT_EQ(assembled, original);
+    EXPECT_LE(server.max_concurrent_puts, 3);
+    EXPECT_NE(server.complete_body.find("up-1"), std::string::npos);
+    EXPECT_NE(server.complete_body.find("etag-5"), std::string::npos);
+
+    std::filesystem::remove(path);
+}
+
+// ---------------------------------------------------------------------------
+// 9. MultipartUploadResumesMissingParts
+//    The first attempt fails on part 3. The second attempt reuses the
+//    persisted session (no second init) and uploads each part exactly once
+//    in total; the session rows are removed after completion.
+// ---------------------------------------------------------------------------
+TEST(FileManagerMultipartTest, MultipartUploadResumesMissingParts) {
+    FakeMultipartServer server;
+    server.fail_part = 3;
+    const std::string path = writeTempFile("anychat_multipart_resume.bin", 300 * 1024);
+
+    anychat::db::Database db(":memory:");
+    ASSERT_TRUE(db.open());
+
+    auto http = std::make_shared<anychat::network::HttpClient>(server.baseUrl());
+    http->setDefaultRetryPolicy(anychat::network::RetryPolicy{ .max_attempts = 1 });
+    anychat::FileManagerImpl mgr(http, &db);
+
+    const anychat::MultipartUploadOptions options{ .part_size = 64 * 1024, .parallelism = 2 };
+    const UploadOutcome first = runMultipart(mgr, path, options);
+    EXPECT_FALSE(first.ok);
+    EXPECT_FALSE(first.error.empty());
+
+    {
+        std::lock_guard<std::mutex> lk(server.mutex);
+        server.fail_part = 0;
+    }
+
+    const UploadOutcome second = runMultipart(mgr, path, options);
+    ASSERT_TRUE(second.ok) << second.error;
+
+    {
+        std::lock_guard<std::mutex> lk(server.mutex);
+        EXPECT_EQ(server.init_calls, 1);
+        ASSERT_EQ(server.put_successes.size(), 5u);
+        for (const auto& [part, count] : server.put_successes)
+            EXPECT_EQ(count, 1) << "part " << part << " uploaded more than once";
+    }
+
+    auto sessions = db.querySync("SELECT COUNT(*) AS n FROM upload_sessions");
+    ASSERT_FALSE(sessions.empty());
+    EXPECT_EQ(sessions[0].at("n"), "0");
+
+    db.close();
+    std::filesystem::remove(path);
+}
+
+// ===========================================================================
+// Content-hash deduplication
+// ===========================================================================
+namespace {
+
+// Single-PUT upload endpoints plus an optional /files/hash-check that knows
+// one hash.
+class FakeDedupeServer {
+public:
+    FakeDedupeServer()
+        : server_([this](const anychat::test::LocalHttpRequest& req) {
+            return handle(req);
+        }) {}
+
+    std::string baseUrl() const {
+        return server_.baseUrl();
+    }
+
+    std::mutex mutex;
+    int token_calls = 0;
+    int hash_checks = 0;
+    std::string known_hash; // answered by /files/hash-check
+    std::string token_body;
+
+private:
+    anychat::test::LocalHttpReply handle(const anychat::test::LocalHttpRequest& req) {
+        std::lock_guard<std::mutex> lk(mutex);
+        anychat::test::LocalHttpReply reply;
+        if (req.method == "POST" && req.target == "/files/upload-token") {
+            ++token_calls;
+            token_body = req.body;
+            reply.body = R"({"code":0,"message":"ok","data":{"file_id":"dup-1","upload_url":")" + server_.baseUrl()
+                         + R"(/storage/dup-1"}})";
+        } else if (req.method == "PUT" && req.target == "/storage/dup-1") {
+            reply.status = 200;
+        } else if (req.method == "POST" && req.target == "/files/dup-1/complete") {
+            reply.body = R"({"code":0,"message":"ok","data":{"file_id":"dup-1","file_name":"forward.jpg"}})";
+        } else if (req.method == "POST" && req.target == "/files/hash-check") {
+            ++hash_checks;
+            if (!known_hash.empty() && req.body.find(known_hash) != std::string::npos) {
+                reply.body = R"({"code":0,"message":"ok","data":{"exists":true,)"
+                             R"("file":{"file_id":"srv-9","file_name":"x.jpg"}}})";
+            } else {
+                reply.body = R"({"code":0,"message":"ok","data":{"exists":false}})";
+            }
+        } else {
+            reply.status = 404;
+        }
+        return reply;
+    }
+
+    anychat::test::LocalHttpServer server_;
+};
+
+UploadOutcome runUpload(anychat::FileManagerImpl& mgr, const std::string& path) {
+    std::promise<UploadOutcome> done;
+    auto fut = done.get_future();
+    mgr.upload(
+        path,
+        ANYCHAT_FILE_TYPE_IMAGE,
+        nullptr,
+        anychat::AnyChatValueCallback<anychat::FileInfo>{
+            .on_success = [&](const anychat::FileInfo& info) { done.set_value({ true, info, {} }); },
+            .on_error = [&](int, const std::string& error) { done.set_value({ false, {}, error }); },
+        }
+    );
+    EXPECT_EQ(fut.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    return fut.get();
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 10. IdenticalContentIsUploadedOnce
+//     A second file with the same bytes resolves from the local hash index
+//     without contacting the server.
+// ---------------------------------------------------------------------------
+TEST(FileManagerDedupeTest, IdenticalContentIsUploadedOnce) {
+    FakeDedupeServer server;
+    const std::string first_path = writeTempFile("anychat_dedupe_a.bin", 64 * 1024);
+    const std::string second_path = writeTempFile("anychat_dedupe_b.bin", 64 * 1024);
+
+    anychat::db::Database db(":memory:");
+    ASSERT_TRUE(db.open());
+    auto http = std::make_shared<anychat::network::HttpClient>(server.baseUrl());
+    anychat::FileManagerImpl mgr(http, &db);
+
+    const UploadOutcome first = runUpload(mgr, first_path);
+    ASSERT_TRUE(first.ok) << first.error;
+
+    const UploadOutcome second = runUpload(mgr, second_path);
+    ASSERT_TRUE(second.ok) << second.error;
+    EXPECT_EQ(second.info.file_id, "dup-1");
+
+    {
+        std::lock_guard<std::mutex> lk(server.mutex);
+        EXPECT_EQ(server.token_calls, 1);
+        EXPECT_NE(server.token_body.find("\"sha256\""), std::string::npos);
+    }
+
+    db.close();
+    std::filesystem::remove(first_path);
+    std::filesystem::remove(second_path);
+}
+
+// ---------------------------------------------------------------------------
+// 11. ServerHashCheckSkipsUpload
+// ---------------------------------------------------------------------------
+TEST(FileManagerDedupeTest, ServerHashCheckSkipsUpload) {
+    FakeDedupeServer server;
+    const std::string path = writeTempFile("anychat_dedupe_server.bin", 1024);
+
+    std::string digest;
+    std::string err;
+    ASSERT_TRUE(anychat::util::sha256File(path, digest, err)) << err;
+    {
+        std::lock_guard<std::mutex> lk(server.mutex);
+        server.known_hash = digest;
+    }
+
+    auto http = std::make_shared<anychat::network::HttpClient>(server.baseUrl());
+    anychat::FileManagerImpl mgr(http);
+    mgr.setServerHashCheck(true);
+
+    const UploadOutcome outcome = runUpload(mgr, path);
+    ASSERT_TRUE(outcome.ok) << outcome.error;
+    EXPECT_EQ(outcome.info.file_id, "srv-9");
+
+    {
+        std::lock_guard<std::mutex> lk(server.mutex);
+        EXPECT_EQ(server.hash_checks, 1);
+        EXPECT_EQ(server.token_calls, 0);
+    }
+
+    std::filesystem::remove(path);
+}
+
+// ---------------------------------------------------------------------------
+// 12. ForgottenMultipartUploadRestartsOnce
+//     A server that keeps answering 404 for the parts gets one new init,
+//     then the upload fails instead of looping.
+// ---------------------------------------------------------------------------
+TEST(FileManagerMultipartTest, ForgottenMultipartUploadRestartsOnce) {
+    FakeMultipartServer server;
+    server.parts_gone = true;
+    const std::string path = writeTempFile("anychat_multipart_gone.bin", 300 * 1024);
+
+    auto http = std::make_shared<anychat::network::HttpClient>(server.baseUrl());
+    anychat::FileManagerImpl mgr(http);
+
+    const UploadOutcome outcome =
+        runMultipart(mgr, path, anychat::MultipartUploadOptions{ .part_size = 64 * 1024, .parallelism = 2 });
+    EXPECT_FALSE(outcome.ok);
+    EXPECT_FALSE(outcome.error.empty());
+    {
+        std::lock_guard<std::mutex> lk(server.mutex);
+        EXPECT_EQ(server.init_calls, 2);
+    }
+
+    std::filesystem::remove(path);
+}
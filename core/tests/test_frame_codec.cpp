@@ -0,0 +1,84 @@
+#include "frame_codec.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using anychat::FrameCodec;
+using anychat::FrameEncoding;
+using anychat::FrameEnvelope;
+
+namespace frame_codec_test_detail {
+
+struct TypingPayload {
+    std::string conversation_id{};
+    bool typing = false;
+    std::optional<int32_t> ttl_seconds{};
+};
+
+} // namespace frame_codec_test_detail
+
+using frame_codec_test_detail::TypingPayload;
+
+// ---------------------------------------------------------------------------
+// 1. JsonFramesKeepTheTextFormat
+//    The default codec writes exactly the frames the server already parses.
+// ---------------------------------------------------------------------------
+TEST(FrameCodecTest, JsonFramesKeepTheTextFormat) {
+    const FrameCodec codec;
+    EXPECT_EQ(codec.encoding(), FrameEncoding::Json);
+    EXPECT_FALSE(codec.binary());
+
+    std::string frame;
+    std::string err;
+    const TypingPayload typing{ .conversation_id = "c1", .typing = true };
+    ASSERT_TRUE(codec.encodeFrame("message.typing", typing, frame, err));
+    EXPECT_EQ(frame, R"({"type":"message.typing","payload":{"conversation_id":"c1","typing":true}})");
+
+    ASSERT_TRUE(codec.encodeFrame("ping", frame, err));
+    EXPECT_EQ(frame, R"({"type":"ping"})");
+}
+
+// ---------------------------------------------------------------------------
+// 2. BeveFramesRoundTrip
+//    Envelope first, payload second, into the same struct as JSON uses.
+// ---------------------------------------------------------------------------
+TEST(FrameCodecTest, BeveFramesRoundTrip) {
+    const FrameCodec codec(FrameEncoding::Beve);
+    EXPECT_TRUE(codec.binary());
+
+    const TypingPayload sent{ .conversation_id = "conv-42", .typing = true, .ttl_seconds = 5 };
+    std::string frame;
+    std::string err;
+    ASSERT_TRUE(codec.encodeFrame("message.typing", sent, frame, err)) << err;
+
+    FrameEnvelope envelope;
+    ASSERT_TRUE(codec.decodeEnvelope(frame, envelope, err)) << err;
+    EXPECT_EQ(envelope.type, "message.typing");
+
+    TypingPayload received{};
+    ASSERT_TRUE(codec.decodePayload(envelope.payload, received, err)) << err;
+    EXPECT_EQ(received.conversation_id, "conv-42");
+    EXPECT_TRUE(received.typing);
+    EXPECT_EQ(received.ttl_seconds, 5);
+
+    std::string json;
+    ASSERT_TRUE(codec.payloadToJson(envelope.payload, json, err)) << err;
+    EXPECT_EQ(json, R"({"conversation_id":"conv-42","typing":true,"ttl_seconds":5})");
+
+    // A JSON codec does not accept BEVE bytes, and vice versa.
+    EXPECT_FALSE(FrameCodec().decodeEnvelope(frame, envelope, err));
+    const std::string text = R"({"type":"pong"})";
+    EXPECT_FALSE(codec.decodeEnvelope(text, envelope, err));
+}
+
+// ---------------------------------------------------------------------------
+// 3. CodecFollowsTheSelectedSubprotocol
+// ---------------------------------------------------------------------------
+TEST(FrameCodecTest, CodecFollowsTheSelectedSubprotocol) {
+    EXPECT_EQ(FrameCodec::forSubprotocol(anychat::kBeveSubprotocol).encoding(), FrameEncoding::Beve);
+    EXPECT_EQ(FrameCodec::forSubprotocol(anychat::kJsonSubprotocol).encoding(), FrameEncoding::Json);
+    EXPECT_EQ(FrameCodec::forSubprotocol("").encoding(), FrameEncoding::Json);
+}
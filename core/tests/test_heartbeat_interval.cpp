@@ -0,0 +1,99 @@
+#include "network/heartbeat_interval.h"
+
+#include <gtest/gtest.h>
+
+using anychat::network::HeartbeatInterval;
+using anychat::network::HeartbeatOptions;
+using anychat::network::RttStats;
+
+namespace {
+
+constexpr HeartbeatOptions kOptions{
+    .min_interval_ms = 30'000,
+    .max_interval_ms = 150'000,
+    .step_ms = 30'000,
+    .probe_after = 2,
+};
+
+void answer(HeartbeatInterval& interval, int times) {
+    for (int i = 0; i < times; ++i)
+        interval.onAnswered();
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 1. AnsweredPingsLengthenTheInterval
+//    One step per |probe_after| answers, up to the maximum.
+// ---------------------------------------------------------------------------
+TEST(HeartbeatIntervalTest, AnsweredPingsLengthenTheInterval) {
+    HeartbeatInterval interval(kOptions);
+    EXPECT_EQ(interval.intervalMs(), 30'000);
+
+    interval.onAnswered();
+    EXPECT_EQ(interval.intervalMs(), 30'000);
+    interval.onAnswered();
+    EXPECT_EQ(interval.intervalMs(), 60'000);
+
+    answer(interval, 20);
+    EXPECT_EQ(interval.intervalMs(), 150'000);
+    EXPECT_FALSE(interval.settled());
+}
+
+// ---------------------------------------------------------------------------
+// 2. LossWhileProbingKeepsTheLastIntervalThatWorked
+//    The NAT forgot the connection somewhere between 60 s and 90 s of idle
+//    time: 60 s is kept and probing stops.
+// ---------------------------------------------------------------------------
+TEST(HeartbeatIntervalTest, LossWhileProbingKeepsTheLastIntervalThatWorked) {
+    HeartbeatInterval interval(kOptions);
+    answer(interval, 4); // 30 s and 60 s answered
+    ASSERT_EQ(interval.intervalMs(), 90'000);
+
+    interval.onLost();
+    EXPECT_TRUE(interval.settled());
+    EXPECT_EQ(interval.intervalMs(), 60'000);
+
+    answer(interval, 10);
+    EXPECT_EQ(interval.intervalMs(), 60'000) << "a settled interval does not probe again";
+}
+
+// ---------------------------------------------------------------------------
+// 3. LossAtAProvenIntervalStepsDown
+// ---------------------------------------------------------------------------
+TEST(HeartbeatIntervalTest, LossAtAProvenIntervalStepsDown) {
+    HeartbeatInterval interval(kOptions);
+    answer(interval, 4);
+    interval.onLost(); // settles at 60 s
+    interval.onAnswered();
+
+    interval.onLost();
+    EXPECT_EQ(interval.intervalMs(), 30'000);
+    interval.onLost();
+    EXPECT_EQ(interval.intervalMs(), 30'000) << "never below the minimum";
+}
+
+// ---------------------------------------------------------------------------
+// 4. ResetStartsOver
+// ---------------------------------------------------------------------------
+TEST(HeartbeatIntervalTest, ResetStartsOver) {
+    HeartbeatInterval interval(kOptions);
+    answer(interval, 4);
+    interval.onLost();
+
+    interval.reset();
+    EXPECT_FALSE(interval.settled());
+    EXPECT_EQ(interval.intervalMs(), 30'000);
+    answer(interval, 2);
+    EXPECT_EQ(interval.intervalMs(), 60'000);
+}
+
+// ---------------------------------------------------------------------------
+// 5. PongTimeoutFollowsTheRto
+// ---------------------------------------------------------------------------
+TEST(HeartbeatIntervalTest, PongTimeoutFollowsTheRto) {
+    HeartbeatInterval interval(kOptions);
+    EXPECT_EQ(interval.pongTimeoutMs(RttStats{}), 10'000) << "no samples: the lower bound";
+    EXPECT_EQ(interval.pongTimeoutMs(RttStats{ .samples = 5, .rto_ms = 25'000 }), 25'000);
+    EXPECT_EQ(interval.pongTimeoutMs(RttStats{ .samples = 5, .rto_ms = 90'000 }), 60'000);
+}
@@ -0,0 +1,554 @@
+#include "network/http_client.h"
+
+#include "local_http_server.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef ANYCHAT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using anychat::network::computeBackoffMs;
+using anychat::network::HttpClient;
+using anychat::network::HttpCompressionOptions;
+using anychat::network::HttpFileBody;
+using anychat::network::HttpMethod;
+using anychat::network::HttpRequest;
+using anychat::network::HttpResponse;
+using anychat::network::isIdempotent;
+using anychat::network::isRetryableStatus;
+using anychat::network::RetryPolicy;
+
+namespace {
+
+// Nothing listens on port 1 locally, so connects are refused immediately.
+constexpr const char* kRefusedBaseUrl = "http://127.0.0.1:1";
+
+HttpResponse waitFor(std::future<HttpResponse>& fut) {
+    EXPECT_EQ(fut.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    return fut.get();
+}
+
+#ifdef ANYCHAT_HAVE_ZLIB
+// gzip (windowBits 15 + 16) in both directions for the stand-in server.
+std::string gzipString(const std::string& in) {
+    z_stream zs{};
+    deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&zs, static_cast<uLong>(in.size())), '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = static_cast<uInt>(out.size());
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+std::string gunzipString(const std::string& in) {
+    z_stream zs{};
+    inflateInit2(&zs, 15 + 16);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    std::string out;
+    char chunk[16384];
+    int rc = Z_OK;
+    while (rc == Z_OK) {
+        zs.next_out = reinterpret_cast<Bytef*>(chunk);
+        zs.avail_out = sizeof(chunk);
+        rc = inflate(&zs, Z_NO_FLUSH);
+        out.append(chunk, sizeof(chunk) - zs.avail_out);
+    }
+    inflateEnd(&zs);
+    return rc == Z_STREAM_END ? out : std::string{};
+}
+#endif
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 1. BackoffGrowsExponentiallyAndIsCapped
+// ---------------------------------------------------------------------------
+TEST(HttpRetryPolicyTest, BackoffGrowsExponentiallyAndIsCapped) {
+    RetryPolicy policy;
+    policy.base_backoff_ms = 100;
+    policy.max_backoff_ms = 1000;
+    policy.jitter = 0.0;
+
+    EXPECT_EQ(computeBackoffMs(policy, 1, 0.5), 100);
+    EXPECT_EQ(computeBackoffMs(policy, 2, 0.5), 200);
+    EXPECT_EQ(computeBackoffMs(policy, 3, 0.5), 400);
+    EXPECT_EQ(computeBackoffMs(policy, 5, 0.5), 1000);
+    EXPECT_EQ(computeBackoffMs(policy, 64, 0.5), 1000);
+}
+
+// ---------------------------------------------------------------------------
+// 2. JitterStaysWithinBounds
+//    With jitter = 0.5 the delay lies in [delay/2, delay].
+// ---------------------------------------------------------------------------
+TEST(HttpRetryPolicyTest, JitterStaysWithinBounds) {
+    RetryPolicy policy;
+    policy.base_backoff_ms = 400;
+    policy.max_backoff_ms = 10000;
+    policy.jitter = 0.5;
+
+    EXPECT_EQ(computeBackoffMs(policy, 1, 0.0), 200);
+    EXPECT_EQ(computeBackoffMs(policy, 1, 1.0), 400);
+    const int mid = computeBackoffMs(policy, 1, 0.5);
+    EXPECT_GT(mid, 200);
+    EXPECT_LT(mid, 400);
+}
+
+// ---------------------------------------------------------------------------
+// 3. RetryableStatusAndIdempotencyDefaults
+// ---------------------------------------------------------------------------
+TEST(HttpRetryPolicyTest, RetryableStatusAndIdempotencyDefaults) {
+    RetryPolicy policy;
+    EXPECT_TRUE(isRetryableStatus(policy, 503));
+    EXPECT_TRUE(isRetryableStatus(policy, 429));
+    EXPECT_FALSE(isRetryableStatus(policy, 404));
+    EXPECT_FALSE(isRetryableStatus(policy, 200));
+
+    EXPECT_TRUE(isIdempotent(HttpMethod::Get, policy));
+    EXPECT_TRUE(isIdempotent(HttpMethod::Put, policy));
+    EXPECT_TRUE(isIdempotent(HttpMethod::Delete, policy));
+    EXPECT_FALSE(isIdempotent(HttpMethod::Post, policy));
+    EXPECT_FALSE(isIdempotent(HttpMethod::Patch, policy));
+
+    policy.idempotent = true;
+    EXPECT_TRUE(isIdempotent(HttpMethod::Post, policy));
+}
+
+// ---------------------------------------------------------------------------
+// 4. ConnectFailureIsRetriedUpToMaxAttempts
+// ---------------------------------------------------------------------------
+TEST(HttpClientRetryTest, ConnectFailureIsRetriedUpToMaxAttempts) {
+    HttpClient http(kRefusedBaseUrl);
+
+    RetryPolicy policy;
+    policy.max_attempts = 3;
+    policy.base_backoff_ms = 5;
+    policy.max_backoff_ms = 20;
+
+    std::promise<HttpResponse> done;
+    auto fut = done.get_future();
+    http.send(HttpRequest{ .method = HttpMethod::Get, .path = "/ping", .retry = policy }, [&](HttpResponse resp) {
+        done.set_value(std::move(resp));
+    });
+
+    HttpResponse resp = waitFor(fut);
+    EXPECT_FALSE(resp.error.empty());
+
+    auto stats = http.stats();
+    EXPECT_EQ(stats.requests, 1u);
+    EXPECT_EQ(stats.attempts, 3u);
+    EXPECT_EQ(stats.retries, 2u);
+    EXPECT_EQ(stats.failed, 1u);
+}
+
+// ---------------------------------------------------------------------------
+// 5. PostIsRetriedOnlyWhenNeverSent
+//    A refused connection means the server never saw the POST, so it is safe
+//    to send it again.
+// ---------------------------------------------------------------------------
+TEST(HttpClientRetryTest, PostIsRetriedOnlyWhenNeverSent) {
+    HttpClient http(kRefusedBaseUrl);
+
+    RetryPolicy policy;
+    policy.max_attempts = 2;
+    policy.base_backoff_ms = 5;
+    http.setDefaultRetryPolicy(policy);
+
+    std::promise<HttpResponse> done;
+    auto fut = done.get_future();
+    http.post("/messages", "{}", [&](HttpResponse resp) {
+        done.set_value(std::move(resp));
+    });
+
+    waitFor(fut);
+    EXPECT_EQ(http.stats().attempts, 2u);
+}
+
+// ---------------------------------------------------------------------------
+// 6. DeadlineStopsRetries
+//    The back-off before the second attempt would overrun the deadline.
+// ---------------------------------------------------------------------------
+TEST(HttpClientRetryTest, DeadlineStopsRetries) {
+    HttpClient http(kRefusedBaseUrl);
+
+    RetryPolicy policy;
+    policy.max_attempts = 5;
+    policy.base_backoff_ms = 2000;
+    policy.max_backoff_ms = 2000;
+    policy.jitter = 0.0;
+    policy.deadline_ms = 500;
+
+    std::promise<HttpResponse> done;
+    auto fut = done.get_future();
+    const auto start = std::chrono::steady_clock::now();
+    http.send(HttpRequest{ .method = HttpMethod::Get, .path = "/ping", .retry = policy }, [&](HttpResponse resp) {
+        done.set_value(std::move(resp));
+    });
+
+    HttpResponse resp = waitFor(fut);
+    EXPECT_FALSE(resp.error.empty());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+
+    auto stats = http.stats();
+    EXPECT_EQ(stats.attempts, 1u);
+    EXPECT_EQ(stats.deadline_exceeded, 1u);
+}
+
+// ---------------------------------------------------------------------------
+// 7. FileBodyRangeIsStreamedWithProgress
+//    Only the requested byte range is sent, with a matching Content-Length,
+//    and progress ends at the range length.
+// ---------------------------------------------------------------------------
+TEST(HttpClientStreamingTest, FileBodyRangeIsStreamedWithProgress) {
+    std::string received;
+    std::string content_length;
+    anychat::test::LocalHttpServer server([&](const anychat::test::LocalHttpRequest& req) {
+        received = req.body;
+        content_length = req.header("content-length");
+        return anychat::test::LocalHttpReply{};
+    });
+
+    const auto path = std::filesystem::temp_directory_path() / "anychat_http_file_body.bin";
+    std::string content(300 * 1024, '\0');
+    for (size_t i = 0; i < content.size(); ++i)
+        content[i] = static_cast<char>('a' + i % 26);
+    {
+        std::ofstream ofs(path, std::ios::binary);
+        ofs << content;
+    }
+
+    HttpClient http(server.baseUrl());
+    std::mutex progress_mutex;
+    std::vector<int64_t> progress;
+
+    HttpRequest req;
+    req.method = HttpMethod::Put;
+    req.path = "/blob";
+    req.file_body = HttpFileBody{ .path = path.string(), .offset = 1000, .length = 200 * 1024 };
+    req.on_progress = [&](int64_t done, int64_t total) {
+        std::lock_guard<std::mutex> lk(progress_mutex);
+        EXPECT_EQ(total, 200 * 1024);
+        progress.push_back(done);
+    };
+
+    std::promise<HttpResponse> done;
+    auto fut = done.get_future();
+    http.send(std::move(req), [&](HttpResponse resp) {
+        done.set_value(std::move(resp));
+    });
+
+    HttpResponse resp = waitFor(fut);
+    EXPECT_TRUE(resp.error.empty()) << resp.error;
+    EXPECT_EQ(resp.status_code, 200);
+    EXPECT_EQ(content_length, std::to_string(200 * 1024));
+    EXPECT_EQ(received, content.substr(1000, 200 * 1024));
+
+    std::lock_guard<std::mutex> lk(progress_mutex);
+    ASSERT_FALSE(progress.empty());
+    EXPECT_EQ(progress.back(), 200 * 1024);
+
+    std::filesystem::remove(path);
+}
+
+// ---------------------------------------------------------------------------
+// 8. MissingFileBodyReportsError
+// ---------------------------------------------------------------------------
+TEST(HttpClientStreamingTest, MissingFileBodyReportsError) {
+    HttpClient http(kRefusedBaseUrl);
+
+    HttpRequest req;
+    req.method = HttpMethod::Put;
+    req.path = "/blob";
+    req.file_body = HttpFileBody{ .path = "/nonexistent/path/file.bin" };
+
+    std::promise<HttpResponse> done;
+    auto fut = done.get_future();
+    http.send(std::move(req), [&](HttpResponse resp) {
+        done.set_value(std::move(resp));
+    });
+
+    HttpResponse resp = waitFor(fut);
+    EXPECT_FALSE(resp.error.empty());
+    EXPECT_EQ(http.stats().attempts, 0u);
+}
+
+// ---------------------------------------------------------------------------
+// 9. SendSpeedLimitThrottlesUpload
+//    128 KiB at 64 KiB/s cannot finish in much less than two seconds.
+// ---------------------------------------------------------------------------
+TEST(HttpClientStreamingTest, SendSpeedLimitThrottlesUpload) {
+    anychat::test::LocalHttpServer server([](const anychat::test::LocalHttpRequest&) {
+        return anychat::test::LocalHttpReply{};
+    });
+
+    HttpClient http(server.baseUrl());
+    HttpRequest req;
+    req.method = HttpMethod::Put;
+    req.path = "/blob";
+    req.body = std::string(128 * 1024, 'r');
+    req.max_send_bytes_per_sec = 64 * 1024;
+
+    std::promise<HttpResponse> done;
+    auto fut = done.get_future();
+    const auto start = std::chrono::steady_clock::now();
+    http.send(std::move(req), [&](HttpResponse resp) {
+        done.set_value(std::move(resp));
+    });
+
+    HttpResponse resp = waitFor(fut);
+    EXPECT_TRUE(resp.error.empty()) << resp.error;
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(1200));
+}
+
+// ---------------------------------------------------------------------------
+// 10. ApiRequestsNegotiateResponseEncoding
+//     Storage URLs never ask for a content coding.
+// ---------------------------------------------------------------------------
+TEST(HttpClientCompressionTest, ApiRequestsNegotiateResponseEncoding) {
+    std::mutex mu;
+    std::vector<std::string> accept_encodings;
+    anychat::test::LocalHttpServer server([&](const anychat::test::LocalHttpRequest& req) {
+        std::lock_guard<std::mutex> lock(mu);
+        accept_encodings.push_back(req.header("accept-encoding"));
+        return anychat::test::LocalHttpReply{ .body = "{}" };
+    });
+
+    HttpClient http(server.baseUrl());
+    for (const std::string path : { std::string("/api"), server.baseUrl() + "/blob" }) {
+        std::promise<HttpResponse> done;
+        auto fut = done.get_future();
+        http.get(path, [&](HttpResponse resp) {
+            done.set_value(std::move(resp));
+        });
+        waitFor(fut);
+    }
+
+    std::lock_guard<std::mutex> lock(mu);
+    ASSERT_EQ(accept_encodings.size(), 2u);
+    EXPECT_FALSE(accept_encodings[0].empty());
+    EXPECT_TRUE(accept_encodings[1].empty());
+}
+
+#ifdef ANYCHAT_HAVE_ZLIB
+// ---------------------------------------------------------------------------
+// 11. GzipResponseIsDecodedAndCounted
+// ---------------------------------------------------------------------------
+TEST(HttpClientCompressionTest, GzipResponseIsDecodedAndCounted) {
+    const std::string json = "[" + std::string(64 * 1024, '1') + "]";
+    anychat::test::LocalHttpServer server([&](const anychat::test::LocalHttpRequest&) {
+        return anychat::test::LocalHttpReply{
+            .body = gzipString(json),
+            .headers = { { "Content-Encoding", "gzip" } },
+        };
+    });
+
+    HttpClient http(server.baseUrl());
+    std::promise<HttpResponse> done;
+    auto fut = done.get_future();
+    http.get("/sync", [&](HttpResponse resp) {
+        done.set_value(std::move(resp));
+    });
+
+    HttpResponse resp = waitFor(fut);
+    EXPECT_TRUE(resp.body == json);
+    const auto stats = http.stats();
+    EXPECT_EQ(stats.response_body_bytes, json.size());
+    EXPECT_LT(stats.response_wire_bytes, json.size() / 10);
+}
+
+// ---------------------------------------------------------------------------
+// 12. LargeBodiesOnOptedInRoutesAreGzipped
+// ---------------------------------------------------------------------------
+TEST(HttpClientCompressionTest, LargeBodiesOnOptedInRoutesAreGzipped) {
+    std::mutex mu;
+    std::vector<anychat::test::LocalHttpRequest> seen;
+    anychat::test::LocalHttpServer server([&](const anychat::test::LocalHttpRequest& req) {
+        std::lock_guard<std::mutex> lock(mu);
+        seen.push_back(req);
+        return anychat::test::LocalHttpReply{ .body = "{}" };
+    });
+
+    HttpClient http(server.baseUrl());
+    http.setCompression(HttpCompressionOptions{ .enabled = true, .min_body_bytes = 1024 });
+
+    const std::string big = R"({"conversations":[)" + std::string(32 * 1024, ' ') + "]}";
+    const std::string small = R"({"conversations":[]})";
+    auto post = [&](const std::string& path, const std::string& body) {
+        std::promise<HttpResponse> done;
+        auto fut = done.get_future();
+        http.post(path, body, [&](HttpResponse resp) {
+            done.set_value(std::move(resp));
+        });
+        waitFor(fut);
+    };
+    post("/sync", big);
+    post("/sync", small);
+    post("/messages", big);
+
+    std::lock_guard<std::mutex> lock(mu);
+    ASSERT_EQ(seen.size(), 3u);
+    EXPECT_EQ(seen[0].header("content-encoding"), "gzip");
+    EXPECT_TRUE(gunzipString(seen[0].body) == big);
+    EXPECT_TRUE(seen[1].header("content-encoding").empty());
+    EXPECT_EQ(seen[1].body, small);
+    EXPECT_TRUE(seen[2].header("content-encoding").empty());
+
+    const auto stats = http.stats();
+    EXPECT_EQ(stats.compressed_requests, 1u);
+    EXPECT_EQ(stats.request_body_bytes, 2 * big.size() + small.size());
+    EXPECT_EQ(stats.request_wire_bytes, seen[0].body.size() + small.size() + big.size());
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// 13. BodyDataIsStreamedForSuccessOnly
+//     2xx bodies go to on_body_data and never reach HttpResponse::body; error
+//     bodies are still collected so the envelope can be inspected.
+// ---------------------------------------------------------------------------
+TEST(HttpClientStreamingTest, BodyDataIsStreamedForSuccessOnly) {
+    const std::string big(256 * 1024, 'x');
+    anychat::test::LocalHttpServer server([&](const anychat::test::LocalHttpRequest& req) {
+        if (req.target == "/missing")
+            return anychat::test::LocalHttpReply{ .status = 404, .body = R"({"code":404})" };
+        return anychat::test::LocalHttpReply{ .body = big };
+    });
+
+    HttpClient http(server.baseUrl());
+    auto fetch = [&](const std::string& path, std::string& streamed) {
+        HttpRequest req;
+        req.path = path;
+        req.on_body_data = [&streamed](std::string_view chunk) {
+            streamed.append(chunk);
+            return true;
+        };
+        std::promise<HttpResponse> done;
+        auto fut = done.get_future();
+        http.send(std::move(req), [&](HttpResponse resp) {
+            done.set_value(std::move(resp));
+        });
+        return waitFor(fut);
+    };
+
+    std::string streamed;
+    HttpResponse ok = fetch("/big", streamed);
+    EXPECT_EQ(ok.status_code, 200);
+    EXPECT_TRUE(ok.error.empty());
+    EXPECT_TRUE(ok.body.empty());
+    EXPECT_TRUE(streamed == big);
+
+    std::string not_streamed;
+    HttpResponse missing = fetch("/missing", not_streamed);
+    EXPECT_EQ(missing.status_code, 404);
+    EXPECT_EQ(missing.body, R"({"code":404})");
+    EXPECT_TRUE(not_streamed.empty());
+}
+
+// ---------------------------------------------------------------------------
+// 14. TimingsAreRecordedPerRouteTemplate
+// ---------------------------------------------------------------------------
+TEST(HttpClientMetricsTest, TimingsAreRecordedPerRouteTemplate) {
+    anychat::test::LocalHttpServer server([](const anychat::test::LocalHttpRequest& req) {
+        if (req.target == "/conversations/3")
+            return anychat::test::LocalHttpReply{ .status = 404, .body = "{}" };
+        return anychat::test::LocalHttpReply{ .body = R"({"code":0})" };
+    });
+
+    HttpClient http(server.baseUrl());
+    for (const char* path : { "/conversations/1", "/conversations/2?x=1", "/conversations/3" }) {
+        std::promise<HttpResponse> done;
+        auto fut = done.get_future();
+        http.get(path, [&](HttpResponse resp) {
+            done.set_value(std::move(resp));
+        });
+        waitFor(fut);
+    }
+
+    const auto routes = http.routeStats();
+    ASSERT_EQ(routes.size(), 1u);
+    const auto& stats = routes[0];
+    EXPECT_EQ(stats.route, "GET /conversations/{id}");
+    EXPECT_EQ(stats.attempts, 3u);
+    EXPECT_EQ(stats.status_codes.at(200), 2u);
+    EXPECT_EQ(stats.status_codes.at(404), 1u);
+    EXPECT_GE(stats.new_connections, 1u); // later requests reuse the connection
+    EXPECT_EQ(stats.ttfb.count, 3u);
+    EXPECT_EQ(stats.total.count, 3u);
+    EXPECT_GT(stats.total.sum_us, 0);
+    EXPECT_EQ(stats.tls.count, 0u);
+    EXPECT_GE(stats.bytes_received, 2 * std::string(R"({"code":0})").size() + 2);
+
+    http.resetRouteStats();
+    EXPECT_TRUE(http.routeStats().empty());
+}
+
+// ---------------------------------------------------------------------------
+// 15. MeasuredRttStretchesDefaults
+//    A slow network lengthens the connect limit, the total limit by as much,
+//    and the first back-off; a fast one leaves the defaults alone.
+// ---------------------------------------------------------------------------
+TEST(HttpRetryPolicyTest, MeasuredRttStretchesDefaults) {
+    using anychat::network::adaptRetryPolicy;
+    using anychat::network::adaptTimeouts;
+    using anychat::network::HttpTimeouts;
+    using anychat::network::RttStats;
+
+    const HttpTimeouts timeouts;
+    const RetryPolicy policy;
+    const RttStats fast{ .samples = 10, .srtt_ms = 40, .rttvar_ms = 5, .rto_ms = 1000 };
+    EXPECT_EQ(adaptTimeouts(timeouts, fast).connect_timeout_ms, timeouts.connect_timeout_ms);
+    EXPECT_EQ(adaptTimeouts(timeouts, fast).total_timeout_ms, timeouts.total_timeout_ms);
+    EXPECT_EQ(adaptRetryPolicy(policy, fast).base_backoff_ms, policy.base_backoff_ms);
+
+    const RttStats slow{ .samples = 10, .srtt_ms = 2500, .rttvar_ms = 1000, .rto_ms = 6500 };
+    const HttpTimeouts stretched = adaptTimeouts(timeouts, slow);
+    EXPECT_EQ(stretched.connect_timeout_ms, 19'500);
+    EXPECT_EQ(stretched.total_timeout_ms, timeouts.total_timeout_ms + 9'500);
+    EXPECT_EQ(adaptRetryPolicy(policy, slow).base_backoff_ms, 2500);
+
+    HttpTimeouts unlimited;
+    unlimited.total_timeout_ms = 0;
+    EXPECT_EQ(adaptTimeouts(unlimited, slow).total_timeout_ms, 0) << "a disabled limit stays disabled";
+    EXPECT_EQ(adaptTimeouts(timeouts, RttStats{}).connect_timeout_ms, timeouts.connect_timeout_ms);
+}
+
+// ---------------------------------------------------------------------------
+// 16. SetupErrorCallbackMayIssueRequest
+//    The callback runs outside the queue lock, so a retry from it does not
+//    deadlock the worker.
+// ---------------------------------------------------------------------------
+TEST(HttpClientStreamingTest, SetupErrorCallbackMayIssueRequest) {
+    HttpClient http(kRefusedBaseUrl);
+
+    const auto missingFileRequest = [] {
+        HttpRequest req;
+        req.method = HttpMethod::Put;
+        req.path = "/blob";
+        req.file_body = HttpFileBody{ .path = "/nonexistent/path/file.bin" };
+        return req;
+    };
+
+    std::promise<HttpResponse> done;
+    auto fut = done.get_future();
+    http.send(missingFileRequest(), [&](HttpResponse) {
+        http.send(missingFileRequest(), [&](HttpResponse resp) {
+            done.set_value(std::move(resp));
+        });
+    });
+
+    HttpResponse resp = waitFor(fut);
+    EXPECT_FALSE(resp.error.empty());
+    EXPECT_EQ(http.stats().failed, 2u);
+}
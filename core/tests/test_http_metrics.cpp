@@ -0,0 +1,105 @@
+#include "network/http_metrics.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+using anychat::network::HttpAttemptSample;
+using anychat::network::HttpRouteMetrics;
+using anychat::network::LatencyHistogram;
+using anychat::network::normalizeRoute;
+
+// ---------------------------------------------------------------------------
+// 1. RoutesAreNormalizedToTemplates
+// ---------------------------------------------------------------------------
+TEST(HttpMetricsTest, RoutesAreNormalizedToTemplates) {
+    EXPECT_EQ(normalizeRoute("/conversations/42"), "/conversations/{id}");
+    EXPECT_EQ(normalizeRoute("/conversations/conv-7/messages?limit=20"), "/conversations/{id}/messages");
+    EXPECT_EQ(normalizeRoute("/groups/550e8400-e29b-41d4-a716-446655440000/members"), "/groups/{id}/members");
+    EXPECT_EQ(normalizeRoute("/users/Alice"), "/users/{id}");
+    EXPECT_EQ(normalizeRoute("/files/upload-token"), "/files/upload-token");
+    EXPECT_EQ(normalizeRoute("/messages/read_receipts/"), "/messages/read_receipts");
+    EXPECT_EQ(normalizeRoute(""), "/");
+    EXPECT_EQ(normalizeRoute("https://cdn.example.com/media/a1/b2.jpg?sig=x"), "https://cdn.example.com/*");
+}
+
+// ---------------------------------------------------------------------------
+// 2. HistogramBucketsAndQuantiles
+// ---------------------------------------------------------------------------
+TEST(HttpMetricsTest, HistogramBucketsAndQuantiles) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.quantileMs(0.5), 0.0);
+
+    for (int i = 0; i < 90; ++i)
+        histogram.record(3'000); // 3 ms -> (2, 5]
+    for (int i = 0; i < 9; ++i)
+        histogram.record(200'000); // 200 ms -> (100, 250]
+    histogram.record(40'000'000); // 40 s -> overflow
+
+    EXPECT_EQ(histogram.count, 100u);
+    EXPECT_EQ(histogram.buckets[2], 90u);
+    EXPECT_EQ(histogram.buckets[7], 9u);
+    EXPECT_EQ(histogram.buckets.back(), 1u);
+    EXPECT_EQ(histogram.quantileMs(0.5), 5.0);
+    EXPECT_EQ(histogram.quantileMs(0.95), 250.0);
+    EXPECT_EQ(histogram.quantileMs(1.0), 40'000.0);
+    EXPECT_NEAR(histogram.meanMs(), (90 * 3.0 + 9 * 200.0 + 40'000.0) / 100, 1e-9);
+}
+
+// ---------------------------------------------------------------------------
+// 3. ConnectionPhasesOnlyForNewConnections
+//    Reused connections have no DNS/connect/TLS phase worth recording.
+// ---------------------------------------------------------------------------
+TEST(HttpMetricsTest, ConnectionPhasesOnlyForNewConnections) {
+    HttpRouteMetrics metrics;
+    metrics.record(
+        "GET /sync",
+        HttpAttemptSample{
+            .status_code = 200,
+            .new_connection = true,
+            .dns_us = 1'000,
+            .connect_us = 2'000,
+            .tls_us = 3'000,
+            .ttfb_us = 4'000,
+            .total_us = 10'000,
+            .bytes_sent = 10,
+            .bytes_received = 20,
+        }
+    );
+    metrics.record("GET /sync", HttpAttemptSample{ .status_code = 200, .ttfb_us = 4'000, .total_us = 5'000 });
+    metrics.record("GET /sync", HttpAttemptSample{ .status_code = 0, .total_us = 7'000 });
+
+    const auto snapshot = metrics.snapshot();
+    ASSERT_EQ(snapshot.size(), 1u);
+    const auto& stats = snapshot[0];
+    EXPECT_EQ(stats.attempts, 3u);
+    EXPECT_EQ(stats.new_connections, 1u);
+    EXPECT_EQ(stats.dns.count, 1u);
+    EXPECT_EQ(stats.tls.count, 1u);
+    EXPECT_EQ(stats.ttfb.count, 2u); // transport errors have no first byte
+    EXPECT_EQ(stats.total.count, 3u);
+    EXPECT_EQ(stats.status_codes.at(200), 2u);
+    EXPECT_EQ(stats.status_codes.at(0), 1u);
+    EXPECT_EQ(stats.bytes_received, 20u);
+}
+
+// ---------------------------------------------------------------------------
+// 4. RouteCountIsBounded
+// ---------------------------------------------------------------------------
+TEST(HttpMetricsTest, RouteCountIsBounded) {
+    HttpRouteMetrics metrics;
+    for (size_t i = 0; i < HttpRouteMetrics::kMaxRoutes + 10; ++i)
+        metrics.record("GET /r" + std::to_string(i), HttpAttemptSample{ .status_code = 200 });
+
+    const auto snapshot = metrics.snapshot();
+    EXPECT_EQ(snapshot.size(), HttpRouteMetrics::kMaxRoutes + 1);
+    uint64_t overflow = 0;
+    for (const auto& stats : snapshot) {
+        if (stats.route == HttpRouteMetrics::kOverflowRoute)
+            overflow = stats.attempts;
+    }
+    EXPECT_EQ(overflow, 10u);
+
+    metrics.reset();
+    EXPECT_TRUE(metrics.snapshot().empty());
+}
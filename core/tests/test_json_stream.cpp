@@ -0,0 +1,165 @@
+#include "network/json_stream.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using anychat::network::JsonArrayStreamer;
+
+namespace {
+
+const std::string kSyncBody = R"({"code":0,"message":"ok","data":{)"
+                              R"("friends":{"friends":[{"user_id":"u1"},)"
+                              R"({"user_id":"u2","tags":["a]","b"]}],"total":2},)"
+                              R"("conversations":[{"conversation_id":"c1","messages":[{"text":"}{"}]}],)"
+                              R"("sync_time":42}})";
+
+struct Collected {
+    std::vector<std::string> friends;
+    std::vector<std::string> conversations;
+};
+
+void selectSyncArrays(JsonArrayStreamer& streamer, Collected& out) {
+    streamer.onArray({ "data", "friends", "friends" }, [&out](const std::string& element) {
+        out.friends.push_back(element);
+        return true;
+    });
+    streamer.onArray({ "data", "conversations" }, [&out](const std::string& element) {
+        out.conversations.push_back(element);
+        return true;
+    });
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 1. ElementsAreSplitAndSkeletonKeepsTheRest
+// ---------------------------------------------------------------------------
+TEST(JsonArrayStreamerTest, ElementsAreSplitAndSkeletonKeepsTheRest) {
+    JsonArrayStreamer streamer;
+    Collected out;
+    selectSyncArrays(streamer, out);
+
+    ASSERT_TRUE(streamer.feed(kSyncBody));
+    ASSERT_TRUE(streamer.finish());
+
+    ASSERT_EQ(out.friends.size(), 2u);
+    EXPECT_EQ(out.friends[0], R"({"user_id":"u1"})");
+    EXPECT_EQ(out.friends[1], R"({"user_id":"u2","tags":["a]","b"]})");
+    ASSERT_EQ(out.conversations.size(), 1u);
+    EXPECT_EQ(out.conversations[0], R"({"conversation_id":"c1","messages":[{"text":"}{"}]})");
+
+    EXPECT_EQ(
+        streamer.skeleton(),
+        R"({"code":0,"message":"ok","data":{"friends":{"friends":[],"total":2},"conversations":[],"sync_time":42}})"
+    );
+    EXPECT_EQ(streamer.elementsDelivered(), 3u);
+    EXPECT_EQ(streamer.peakElementBytes(), out.conversations[0].size());
+}
+
+// ---------------------------------------------------------------------------
+// 2. ChunkBoundariesDoNotMatter
+//    Feeding one byte at a time yields exactly the same elements and skeleton.
+// ---------------------------------------------------------------------------
+TEST(JsonArrayStreamerTest, ChunkBoundariesDoNotMatter) {
+    JsonArrayStreamer whole;
+    Collected expected;
+    selectSyncArrays(whole, expected);
+    ASSERT_TRUE(whole.feed(kSyncBody));
+    ASSERT_TRUE(whole.finish());
+
+    JsonArrayStreamer bytewise;
+    Collected out;
+    selectSyncArrays(bytewise, out);
+    for (char c : kSyncBody)
+        ASSERT_TRUE(bytewise.feed(std::string_view(&c, 1)));
+    ASSERT_TRUE(bytewise.finish());
+
+    EXPECT_EQ(out.friends, expected.friends);
+    EXPECT_EQ(out.conversations, expected.conversations);
+    EXPECT_EQ(bytewise.skeleton(), whole.skeleton());
+}
+
+// ---------------------------------------------------------------------------
+// 3. EscapesAndScalarElements
+//    Escaped quotes do not end a string; scalar elements and whitespace
+//    between elements are handled.
+// ---------------------------------------------------------------------------
+TEST(JsonArrayStreamerTest, EscapesAndScalarElements) {
+    JsonArrayStreamer streamer;
+    std::vector<std::string> items;
+    streamer.onArray({ "items" }, [&items](const std::string& element) {
+        items.push_back(element);
+        return true;
+    });
+
+    ASSERT_TRUE(streamer.feed(R"({"items": [ "a\"],", 12 , true, null ], "key\"x": 1})"));
+    ASSERT_TRUE(streamer.finish());
+
+    const std::vector<std::string> expected = { R"("a\"],")", "12", "true", "null" };
+    EXPECT_EQ(items, expected);
+    EXPECT_EQ(streamer.skeleton(), R"({"items": [], "key\"x": 1})");
+}
+
+// ---------------------------------------------------------------------------
+// 4. UnselectedArraysStayInSkeleton
+//    Only an exact key path is selected; an array with the same key at a
+//    different depth is left untouched.
+// ---------------------------------------------------------------------------
+TEST(JsonArrayStreamerTest, UnselectedArraysStayInSkeleton) {
+    JsonArrayStreamer streamer;
+    int delivered = 0;
+    streamer.onArray({ "data", "messages" }, [&delivered](const std::string&) {
+        ++delivered;
+        return true;
+    });
+
+    const std::string body = R"({"messages":[1,2],"data":{"other":{"messages":[3]},"messages":[]}})";
+    ASSERT_TRUE(streamer.feed(body));
+    ASSERT_TRUE(streamer.finish());
+
+    EXPECT_EQ(delivered, 0);
+    EXPECT_EQ(streamer.skeleton(), body);
+}
+
+// ---------------------------------------------------------------------------
+// 5. MalformedAndTruncatedInputFail
+// ---------------------------------------------------------------------------
+TEST(JsonArrayStreamerTest, MalformedAndTruncatedInputFail) {
+    {
+        JsonArrayStreamer streamer;
+        EXPECT_FALSE(streamer.feed(R"({"a":[1})"));
+        EXPECT_TRUE(streamer.failed());
+    }
+    {
+        JsonArrayStreamer streamer;
+        EXPECT_TRUE(streamer.feed(R"({"data":{"messages":[{"id":1},)"));
+        EXPECT_FALSE(streamer.finish());
+        EXPECT_FALSE(streamer.error().empty());
+    }
+    {
+        JsonArrayStreamer streamer;
+        EXPECT_FALSE(streamer.feed(R"({} {})"));
+    }
+    {
+        JsonArrayStreamer streamer;
+        EXPECT_FALSE(streamer.feed("<html>"));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 6. HandlerCanAbortTheStream
+// ---------------------------------------------------------------------------
+TEST(JsonArrayStreamerTest, HandlerCanAbortTheStream) {
+    JsonArrayStreamer streamer;
+    int delivered = 0;
+    streamer.onArray({ "items" }, [&delivered](const std::string&) {
+        return ++delivered < 2;
+    });
+
+    EXPECT_FALSE(streamer.feed(R"({"items":[1,2,3]})"));
+    EXPECT_EQ(delivered, 2);
+    EXPECT_TRUE(streamer.failed());
+    EXPECT_FALSE(streamer.finish());
+}
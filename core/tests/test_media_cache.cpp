@@ -0,0 +1,219 @@
+#include "cache/media_cache.h"
+
+#include "db/database.h"
+#include "file_manager.h"
+#include "local_http_server.h"
+#include "network/http_client.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using anychat::cache::MappedFile;
+using anychat::cache::MediaCache;
+
+namespace {
+
+class MediaCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root_ = std::filesystem::temp_directory_path() / "anychat_media_cache_test";
+        std::filesystem::remove_all(root_);
+        std::filesystem::create_directories(root_);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root_);
+    }
+
+    std::string cacheDir() const {
+        return (root_ / "media").string();
+    }
+
+    // Writes |size| bytes outside the cache directory, as a download would.
+    std::string writeSource(const std::string& name, size_t size, char fill = 'x') const {
+        const auto path = root_ / name;
+        std::ofstream ofs(path, std::ios::binary);
+        ofs << std::string(size, fill);
+        return path.string();
+    }
+
+    std::filesystem::path root_;
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 1. InsertMovesFileIntoCacheAndLookupHits
+// ---------------------------------------------------------------------------
+TEST_F(MediaCacheTest, InsertMovesFileIntoCacheAndLookupHits) {
+    MediaCache cache(cacheDir(), 1024 * 1024);
+
+    EXPECT_FALSE(cache.lookup("img-1").has_value());
+
+    const std::string source = writeSource("img-1.jpg", 1000);
+    auto cached = cache.insert("img-1", source);
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(*cached, cache.pathFor("img-1"));
+    EXPECT_FALSE(std::filesystem::exists(source));
+
+    auto hit = cache.lookup("img-1");
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(*hit, *cached);
+
+    const auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.total_bytes, 1000);
+    EXPECT_EQ(stats.entries, 1u);
+}
+
+// ---------------------------------------------------------------------------
+// 2. ByteBudgetEvictsLeastRecentlyUsed
+//    Three 400-byte files against a 1000-byte budget: touching "a" before
+//    inserting "c" makes "b" the eviction victim.
+// ---------------------------------------------------------------------------
+TEST_F(MediaCacheTest, ByteBudgetEvictsLeastRecentlyUsed) {
+    MediaCache cache(cacheDir(), 1000);
+
+    ASSERT_TRUE(cache.insert("a", writeSource("a", 400)));
+    ASSERT_TRUE(cache.insert("b", writeSource("b", 400)));
+    ASSERT_TRUE(cache.lookup("a"));
+    ASSERT_TRUE(cache.insert("c", writeSource("c", 400)));
+
+    EXPECT_TRUE(cache.lookup("a").has_value());
+    EXPECT_FALSE(cache.lookup("b").has_value());
+    EXPECT_TRUE(cache.lookup("c").has_value());
+    EXPECT_FALSE(std::filesystem::exists(cache.pathFor("b")));
+
+    const auto stats = cache.stats();
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.total_bytes, 800);
+}
+
+// ---------------------------------------------------------------------------
+// 3. OversizedFileIsKeptAlone
+// ---------------------------------------------------------------------------
+TEST_F(MediaCacheTest, OversizedFileIsKeptAlone) {
+    MediaCache cache(cacheDir(), 1000);
+
+    ASSERT_TRUE(cache.insert("small", writeSource("small", 100)));
+    ASSERT_TRUE(cache.insert("huge", writeSource("huge", 5000)));
+
+    EXPECT_FALSE(cache.lookup("small").has_value());
+    EXPECT_TRUE(cache.lookup("huge").has_value());
+}
+
+// ---------------------------------------------------------------------------
+// 4. IndexSurvivesRestartAndDropsMissingFiles
+// ---------------------------------------------------------------------------
+TEST_F(MediaCacheTest, IndexSurvivesRestartAndDropsMissingFiles) {
+    const std::string db_path = (root_ / "index.db").string();
+    {
+        anychat::db::Database db(db_path);
+        ASSERT_TRUE(db.open());
+        MediaCache cache(cacheDir(), 1024 * 1024, &db);
+        ASSERT_TRUE(cache.insert("kept", writeSource("kept", 10)));
+        ASSERT_TRUE(cache.insert("lost", writeSource("lost", 10)));
+        db.close();
+    }
+    std::filesystem::remove(MediaCache(cacheDir()).pathFor("lost"));
+
+    anychat::db::Database db(db_path);
+    ASSERT_TRUE(db.open());
+    MediaCache cache(cacheDir(), 1024 * 1024, &db);
+    EXPECT_TRUE(cache.lookup("kept").has_value());
+    EXPECT_FALSE(cache.lookup("lost").has_value());
+    EXPECT_EQ(cache.stats().entries, 1u);
+    db.close();
+}
+
+// ---------------------------------------------------------------------------
+// 5. MapReadsCachedBytes
+// ---------------------------------------------------------------------------
+TEST_F(MediaCacheTest, MapReadsCachedBytes) {
+    MediaCache cache(cacheDir(), 1024 * 1024);
+    ASSERT_TRUE(cache.insert("doc", writeSource("doc", 4096, 'q')));
+
+    MappedFile mapped = cache.map("doc");
+    ASSERT_TRUE(mapped.valid());
+    ASSERT_EQ(mapped.size(), 4096);
+    EXPECT_EQ(mapped.data()[0], 'q');
+    EXPECT_EQ(mapped.data()[4095], 'q');
+
+    MappedFile moved = std::move(mapped);
+    EXPECT_FALSE(mapped.valid());
+    EXPECT_TRUE(moved.valid());
+
+    EXPECT_FALSE(cache.map("absent").valid());
+}
+
+// ---------------------------------------------------------------------------
+// 6. PathForNeverEscapesDirectory
+// ---------------------------------------------------------------------------
+TEST_F(MediaCacheTest, PathForNeverEscapesDirectory) {
+    MediaCache cache(cacheDir(), 1024 * 1024);
+    const auto path = std::filesystem::path(cache.pathFor("../../etc/passwd"));
+    EXPECT_EQ(path.parent_path(), std::filesystem::path(cacheDir()));
+    EXPECT_NE(cache.pathFor("a/b"), cache.pathFor("a_b"));
+}
+
+// ---------------------------------------------------------------------------
+// 7. FetchMediaHitsCacheWithoutNetwork
+//    The first fetch downloads through the file service; the second one is
+//    served from the cache and issues no request at all.
+// ---------------------------------------------------------------------------
+TEST_F(MediaCacheTest, FetchMediaHitsCacheWithoutNetwork) {
+    const std::string blob(10 * 1024, 'm');
+    std::atomic<int> requests{ 0 };
+    anychat::test::LocalHttpServer server([&](const anychat::test::LocalHttpRequest& req) {
+        ++requests;
+        anychat::test::LocalHttpReply reply;
+        if (req.target == "/files/media-1/download") {
+            reply.body = R"({"code":0,"message":"ok","data":{"download_url":"/blob"}})";
+        } else if (req.target == "/blob") {
+            reply.body = blob;
+        } else {
+            reply.status = 404;
+        }
+        return reply;
+    });
+
+    auto http = std::make_shared<anychat::network::HttpClient>(server.baseUrl());
+    MediaCache cache(cacheDir(), 1024 * 1024);
+    anychat::FileManagerImpl mgr(http, nullptr, &cache);
+
+    auto fetch = [&]() {
+        auto done = std::make_shared<std::promise<std::string>>();
+        auto fut = done->get_future();
+        mgr.fetchMedia(
+            "media-1",
+            nullptr,
+            anychat::AnyChatValueCallback<std::string>{
+                .on_success = [done](const std::string& path) { done->set_value(path); },
+                .on_error = [done](int, const std::string& error) { done->set_value("error: " + error); },
+            }
+        );
+        EXPECT_EQ(fut.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        return fut.get();
+    };
+
+    const std::string first = fetch();
+    EXPECT_EQ(first, cache.pathFor("media-1"));
+    const int after_first = requests.load();
+    EXPECT_GE(after_first, 2);
+
+    const std::string second = fetch();
+    EXPECT_EQ(second, first);
+    EXPECT_EQ(requests.load(), after_first);
+
+    std::ifstream ifs(second, std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    EXPECT_TRUE(content == blob);
+}
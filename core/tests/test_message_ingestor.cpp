@@ -0,0 +1,377 @@
+#include "message_ingestor.h"
+
+#include "cache/conversation_cache.h"
+#include "cache/message_cache.h"
+#include "db/database.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using anychat::IngestSource;
+using anychat::Message;
+using anychat::MessageIngestor;
+using anychat::MessageIngestorOptions;
+using anychat::MessageIngestorStats;
+
+namespace {
+
+Message makeMsg(const std::string& conv_id, const std::string& message_id, int64_t seq, int64_t timestamp_ms = 0) {
+    Message m;
+    m.conv_id = conv_id;
+    m.message_id = message_id;
+    m.seq = seq;
+    m.content = "content-" + message_id;
+    m.timestamp_ms = timestamp_ms;
+    return m;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Fixture
+// ---------------------------------------------------------------------------
+class MessageIngestorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        db_ = std::make_unique<anychat::db::Database>(":memory:");
+        ASSERT_TRUE(db_->open());
+        msg_cache_ = std::make_unique<anychat::cache::MessageCache>();
+        conv_cache_ = std::make_unique<anychat::cache::ConversationCache>();
+        ingestor_ = makeIngestor();
+    }
+
+    void TearDown() override {
+        ingestor_.reset();
+        db_->close();
+    }
+
+    std::unique_ptr<MessageIngestor> makeIngestor(MessageIngestorOptions options = {}) {
+        return std::make_unique<MessageIngestor>(db_.get(), msg_cache_.get(), conv_cache_.get(), options);
+    }
+
+    void addConversation(const std::string& conv_id, int64_t last_msg_time_ms) {
+        db_->execSync(
+            "INSERT INTO conversations (conv_id, conv_type, last_msg_time_ms, local_seq) VALUES (?, 'private', ?, 0)",
+            { conv_id, last_msg_time_ms }
+        );
+        anychat::Conversation conv;
+        conv.conv_id = conv_id;
+        conv.last_msg_time_ms = last_msg_time_ms;
+        conv_cache_->upsert(conv);
+    }
+
+    std::string column(const std::string& sql, const std::string& key, const std::string& name) {
+        const auto rows = db_->querySync(sql, { key });
+        return rows.empty() ? std::string{} : rows[0].at(name);
+    }
+
+    size_t messageRows() {
+        return db_->querySync("SELECT message_id FROM messages").size();
+    }
+
+    std::unique_ptr<anychat::db::Database> db_;
+    std::unique_ptr<anychat::cache::MessageCache> msg_cache_;
+    std::unique_ptr<anychat::cache::ConversationCache> conv_cache_;
+    std::unique_ptr<MessageIngestor> ingestor_;
+};
+
+// ---------------------------------------------------------------------------
+// 1. PersistsBatchInOneTransaction
+//    Messages without a local_id must not collide on its UNIQUE index.
+// ---------------------------------------------------------------------------
+TEST_F(MessageIngestorTest, PersistsBatchInOneTransaction) {
+    for (int i = 0; i < 3; ++i) {
+        addConversation("conv-" + std::to_string(i), 0);
+    }
+    std::vector<Message> batch;
+    for (int i = 0; i < 50; ++i) {
+        batch.push_back(makeMsg("conv-" + std::to_string(i % 3), "msg-" + std::to_string(i), i + 1));
+    }
+    const auto accepted = ingestor_->ingest(batch, IngestSource::Fetch);
+    ingestor_->flush();
+
+    EXPECT_EQ(accepted.size(), 50u);
+    EXPECT_EQ(messageRows(), 50u);
+    EXPECT_EQ(msg_cache_->get("conv-0").size(), 17u);
+
+    const MessageIngestorStats stats = ingestor_->stats();
+    EXPECT_EQ(stats.ingested, 50u);
+    EXPECT_EQ(stats.persisted, 50u);
+    EXPECT_EQ(stats.failed, 0u);
+    EXPECT_EQ(stats.transactions, 1u);
+    EXPECT_EQ(stats.pending, 0u);
+}
+
+// ---------------------------------------------------------------------------
+// 2. RepeatInBatchKeepsLatestCopy
+//    At the position of the first one.
+// ---------------------------------------------------------------------------
+TEST_F(MessageIngestorTest, RepeatInBatchKeepsLatestCopy) {
+    addConversation("conv-1", 0);
+    Message edited = makeMsg("conv-1", "msg-1", 1);
+    edited.content = "edited";
+    const auto accepted = ingestor_->ingest(
+        { makeMsg("conv-1", "msg-1", 1), makeMsg("conv-1", "msg-2", 2), edited, makeMsg("", "msg-3", 3) },
+        IngestSource::Push
+    );
+    ingestor_->flush();
+
+    ASSERT_EQ(accepted.size(), 2u);
+    EXPECT_EQ(accepted[0].content, "edited");
+    EXPECT_EQ(accepted[1].message_id, "msg-2");
+    EXPECT_EQ(column("SELECT content FROM messages WHERE message_id = ?", "msg-1", "content"), "edited");
+    EXPECT_EQ(ingestor_->stats().duplicates, 1u);
+}
+
+// ---------------------------------------------------------------------------
+// 3. SyncKeepsStoredRowAndAdvancesLocalSeq
+//    Even when the push delivered every message of the sync batch first.
+// ---------------------------------------------------------------------------
+TEST_F(MessageIngestorTest, SyncKeepsStoredRowAndAdvancesLocalSeq) {
+    addConversation("conv-1", 0);
+    ingestor_->ingest({ makeMsg("conv-1", "msg-7", 7) }, IngestSource::Push);
+
+    Message stale = makeMsg("conv-1", "msg-7", 7);
+    stale.content = "from sync";
+    ingestor_->ingest({ stale }, IngestSource::Sync);
+    ingestor_->flush();
+
+    EXPECT_EQ(column("SELECT content FROM messages WHERE message_id = ?", "msg-7", "content"), "content-msg-7");
+    EXPECT_EQ(column("SELECT local_seq FROM conversations WHERE conv_id = ?", "conv-1", "local_seq"), "7");
+    EXPECT_EQ(conv_cache_->get("conv-1")->local_seq, 7);
+    EXPECT_EQ(ingestor_->stats().persisted, 1u); // the cached copy was not written again
+}
+
+// ---------------------------------------------------------------------------
+// 4. PushLeavesLocalSeqToSync
+//    A push may have skipped a gap that sync has yet to fill.
+// ---------------------------------------------------------------------------
+TEST_F(MessageIngestorTest, PushLeavesLocalSeqToSync) {
+    addConversation("conv-1", 0);
+    ingestor_->ingest({ makeMsg("conv-1", "msg-9", 9) }, IngestSource::Push);
+    ingestor_->flush();
+
+    EXPECT_EQ(column("SELECT local_seq FROM conversations WHERE conv_id = ?", "conv-1", "local_seq"), "0");
+    EXPECT_EQ(conv_cache_->get("conv-1")->local_seq, 0);
+}
+
+// ---------------------------------------------------------------------------
+// 5. SummaryFollowsNewestMessage
+// ---------------------------------------------------------------------------
+TEST_F(MessageIngestorTest, SummaryFollowsNewestMessage) {
+    addConversation("conv-1", 1000);
+    ingestor_->ingest(
+        { makeMsg("conv-1", "msg-b", 2, 3000), makeMsg("conv-1", "msg-a", 1, 2000) },
+        IngestSource::Fetch
+    );
+    ingestor_->ingest({ makeMsg("conv-1", "msg-old", 0, 500) }, IngestSource::Fetch);
+    ingestor_->flush();
+
+    const std::string sql = "SELECT last_msg_id, last_msg_text FROM conversations WHERE conv_id = ?";
+    EXPECT_EQ(column(sql, "conv-1", "last_msg_id"), "msg-b");
+    EXPECT_EQ(column(sql, "conv-1", "last_msg_text"), "content-msg-b");
+    const auto cached = conv_cache_->get("conv-1");
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(cached->last_msg_id, "msg-b");
+    EXPECT_EQ(cached->last_msg_time_ms, 3000);
+}
+
+// ---------------------------------------------------------------------------
+// 6. RowsQueuedBehindATaskShareItsTransaction
+// ---------------------------------------------------------------------------
+TEST_F(MessageIngestorTest, RowsQueuedBehindATaskShareItsTransaction) {
+    addConversation("conv-1", 0);
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool blocked = false;
+    bool open = false;
+    // Holds the DB worker so the ingested rows pile up behind it.
+    db_->exec("SELECT 1", {}, [&](bool, std::string) {
+        std::unique_lock<std::mutex> lock(mutex);
+        blocked = true;
+        cv.notify_all();
+        cv.wait(lock, [&] {
+            return open;
+        });
+    });
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] {
+            return blocked;
+        });
+    }
+
+    for (int i = 0; i < 20; ++i) {
+        ingestor_->ingest({ makeMsg("conv-1", "msg-" + std::to_string(i), i + 1) }, IngestSource::Push);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = true;
+    }
+    cv.notify_all();
+    ingestor_->flush();
+
+    const MessageIngestorStats stats = ingestor_->stats();
+    EXPECT_EQ(stats.persisted, 20u);
+    EXPECT_EQ(stats.transactions, 1u);
+    EXPECT_EQ(stats.peak_pending, 20u);
+    EXPECT_EQ(messageRows(), 20u);
+}
+
+// ---------------------------------------------------------------------------
+// 7. FullQueueBlocksProducer
+//    Beyond max_pending uncommitted rows, ingest() waits for the DB.
+// ---------------------------------------------------------------------------
+TEST_F(MessageIngestorTest, FullQueueBlocksProducer) {
+    ingestor_ = makeIngestor(MessageIngestorOptions{ .max_pending = 2 });
+    addConversation("conv-1", 0);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool blocked = false;
+    bool open = false;
+    db_->exec("SELECT 1", {}, [&](bool, std::string) {
+        std::unique_lock<std::mutex> lock(mutex);
+        blocked = true;
+        cv.notify_all();
+        cv.wait(lock, [&] {
+            return open;
+        });
+    });
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] {
+            return blocked;
+        });
+    }
+
+    ingestor_->ingest({ makeMsg("conv-1", "msg-1", 1), makeMsg("conv-1", "msg-2", 2) }, IngestSource::Fetch);
+    std::atomic<bool> done{ false };
+    std::thread producer([&] {
+        ingestor_->ingest({ makeMsg("conv-1", "msg-3", 3) }, IngestSource::Push);
+        done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(done);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = true;
+    }
+    cv.notify_all();
+    producer.join();
+    ingestor_->flush();
+
+    const MessageIngestorStats stats = ingestor_->stats();
+    EXPECT_EQ(stats.producer_waits, 1u);
+    EXPECT_EQ(stats.persisted, 3u);
+    EXPECT_EQ(stats.transactions, 2u);
+}
+
+// ---------------------------------------------------------------------------
+// 8. RedeliveryOfStoredMessageIsDropped
+//    Unless the copy changed, e.g. it was recalled meanwhile.
+// ---------------------------------------------------------------------------
+TEST_F(MessageIngestorTest, RedeliveryOfStoredMessageIsDropped) {
+    addConversation("conv-1", 0);
+    ingestor_->ingest({ makeMsg("conv-1", "msg-1", 1) }, IngestSource::Push);
+    ingestor_->flush();
+
+    EXPECT_TRUE(ingestor_->ingest({ makeMsg("conv-1", "msg-1", 1) }, IngestSource::Fetch).empty());
+    EXPECT_TRUE(ingestor_->ingest({ makeMsg("conv-1", "msg-1", 1) }, IngestSource::Sync).empty());
+
+    Message recalled = makeMsg("conv-1", "msg-1", 1);
+    recalled.status = 1;
+    EXPECT_EQ(ingestor_->ingest({ recalled }, IngestSource::Fetch).size(), 1u);
+    ingestor_->flush();
+
+    EXPECT_EQ(column("SELECT status FROM messages WHERE message_id = ?", "msg-1", "status"), "1");
+    const MessageIngestorStats stats = ingestor_->stats();
+    EXPECT_EQ(stats.seen_recently, 2u);
+    EXPECT_EQ(stats.persisted, 2u);
+    EXPECT_EQ(stats.transactions, 2u);
+}
+
+// ---------------------------------------------------------------------------
+// 9. SyncBelowWatermarkIsDropped
+//    Once the ids have left the recent window.
+// ---------------------------------------------------------------------------
+TEST_F(MessageIngestorTest, SyncBelowWatermarkIsDropped) {
+    ingestor_ = makeIngestor(MessageIngestorOptions{ .recent_window = 1 });
+    addConversation("conv-1", 0);
+    ingestor_->ingest(
+        { makeMsg("conv-1", "msg-1", 1), makeMsg("conv-1", "msg-2", 2), makeMsg("conv-1", "msg-3", 3) },
+        IngestSource::Sync
+    );
+    ingestor_->flush();
+
+    const auto accepted = ingestor_->ingest(
+        { makeMsg("conv-1", "msg-1", 1), makeMsg("conv-1", "msg-2", 2), makeMsg("conv-1", "msg-4", 4) },
+        IngestSource::Sync
+    );
+    ingestor_->flush();
+
+    ASSERT_EQ(accepted.size(), 1u);
+    EXPECT_EQ(accepted[0].message_id, "msg-4");
+    EXPECT_EQ(column("SELECT local_seq FROM conversations WHERE conv_id = ?", "conv-1", "local_seq"), "4");
+    const MessageIngestorStats stats = ingestor_->stats();
+    EXPECT_EQ(stats.below_watermark, 2u);
+    EXPECT_EQ(stats.persisted, 4u);
+}
+
+// ---------------------------------------------------------------------------
+// 10. FailedRowIsNotRemembered
+//     The next copy is written once its conversation is stored.
+// ---------------------------------------------------------------------------
+TEST_F(MessageIngestorTest, FailedRowIsNotRemembered) {
+    ingestor_->ingest({ makeMsg("conv-1", "msg-1", 1) }, IngestSource::Push);
+    ingestor_->flush();
+    EXPECT_EQ(ingestor_->stats().failed, 1u);
+
+    addConversation("conv-1", 0);
+    EXPECT_EQ(ingestor_->ingest({ makeMsg("conv-1", "msg-1", 1) }, IngestSource::Push).size(), 1u);
+    ingestor_->flush();
+
+    EXPECT_EQ(messageRows(), 1u);
+    EXPECT_EQ(ingestor_->stats().seen_recently, 0u);
+}
+
+// ---------------------------------------------------------------------------
+// 11. FailedSyncRowHoldsLocalSeq
+//     Neither the stored nor the cached local_seq skips a row that failed,
+//     so the next sync brings it again.
+// ---------------------------------------------------------------------------
+TEST_F(MessageIngestorTest, FailedSyncRowHoldsLocalSeq) {
+    addConversation("conv-1", 0);
+    db_->execSync(
+        "CREATE TRIGGER fail_msg_2 BEFORE INSERT ON messages WHEN NEW.message_id = 'msg-2' "
+        "BEGIN SELECT RAISE(ABORT, 'rejected'); END"
+    );
+    const std::vector<Message> batch = {
+        makeMsg("conv-1", "msg-1", 1),
+        makeMsg("conv-1", "msg-2", 2),
+        makeMsg("conv-1", "msg-3", 3),
+    };
+    ingestor_->ingest(batch, IngestSource::Sync);
+    ingestor_->flush();
+
+    EXPECT_EQ(ingestor_->stats().failed, 1u);
+    EXPECT_EQ(column("SELECT local_seq FROM conversations WHERE conv_id = ?", "conv-1", "local_seq"), "0");
+    EXPECT_EQ(conv_cache_->get("conv-1")->local_seq, 0);
+
+    db_->execSync("DROP TRIGGER fail_msg_2");
+    ingestor_->ingest(batch, IngestSource::Sync);
+    ingestor_->flush();
+
+    EXPECT_EQ(messageRows(), 3u);
+    EXPECT_EQ(column("SELECT local_seq FROM conversations WHERE conv_id = ?", "conv-1", "local_seq"), "3");
+    EXPECT_EQ(conv_cache_->get("conv-1")->local_seq, 3);
+}
@@ -1,15 +1,22 @@
+#include "message_ingestor.h"
 #include "message_manager.h"
 #include "notification_manager.h"
 #include "outbound_queue.h"
 
+#include "cache/conversation_cache.h"
 #include "cache/message_cache.h"
 #include "db/database.h"
 #include "network/http_client.h"
+#include "util/timer_wheel.h"
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <functional>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -39,6 +46,8 @@ protected:
         ASSERT_TRUE(db_->open()) << "Failed to open in-memory DB";
 
         msg_cache_ = std::make_unique<anychat::cache::MessageCache>();
+        conv_cache_ = std::make_unique<anychat::cache::ConversationCache>();
+        ingestor_ = std::make_unique<anychat::MessageIngestor>(db_.get(), msg_cache_.get(), conv_cache_.get());
         notif_mgr_ = std::make_unique<anychat::NotificationManager>();
         outbound_q_ = std::make_unique<anychat::OutboundQueue>(db_.get());
         http_ = std::make_shared<anychat::network::HttpClient>("http://localhost:19999");
@@ -46,6 +55,7 @@ protected:
         mgr_ = std::make_unique<anychat::MessageManagerImpl>(
             db_.get(),
             msg_cache_.get(),
+            ingestor_.get(),
             outbound_q_.get(),
             notif_mgr_.get(),
             http_,
@@ -57,6 +67,8 @@ protected:
         mgr_.reset();
         outbound_q_.reset();
         notif_mgr_.reset();
+        ingestor_.reset();
+        conv_cache_.reset();
         msg_cache_.reset();
         http_.reset();
         db_->close();
@@ -73,6 +85,8 @@ protected:
 
     std::unique_ptr<anychat::db::Database> db_;
     std::unique_ptr<anychat::cache::MessageCache> msg_cache_;
+    std::unique_ptr<anychat::cache::ConversationCache> conv_cache_;
+    std::unique_ptr<anychat::MessageIngestor> ingestor_;
     std::unique_ptr<anychat::NotificationManager> notif_mgr_;
     std::unique_ptr<anychat::OutboundQueue> outbound_q_;
     std::shared_ptr<anychat::network::HttpClient> http_;
@@ -468,3 +482,97 @@ TEST_F(MessageManagerTest, DeleteMessageDoesNotCrash) {
 TEST_F(MessageManagerTest, EditMessageDoesNotCrash) {
     EXPECT_NO_THROW(mgr_->editMessage("msg-1", "updated", makeNoopCallback()));
 }
+
+namespace {
+
+// Records the calls it gets, in order, as text.
+class BatchingMessageListener final : public anychat::MessageListener {
+public:
+    void onMessagesReceived(const std::vector<anychat::Message>& messages) override {
+        std::string call = "received:";
+        for (const auto& message : messages) {
+            call += message.message_id + ",";
+        }
+        record(call);
+    }
+
+    void onMessageRecalled(const anychat::Message& message) override {
+        record("recalled:" + message.message_id);
+    }
+
+    void onMessageTypings(const std::vector<anychat::MessageTypingEvent>& events) override {
+        std::string call = "typing:";
+        for (const auto& event : events) {
+            call += event.from_user_id + (event.typing ? "+," : "-,");
+        }
+        record(call);
+    }
+
+    bool waitFor(size_t n) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, std::chrono::seconds(5), [this, n] {
+            return calls_.size() >= n;
+        });
+    }
+
+    std::vector<std::string> calls() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return calls_;
+    }
+
+private:
+    void record(std::string call) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        calls_.push_back(std::move(call));
+        cv_.notify_all();
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::string> calls_;
+};
+
+std::string messageNewFrame(const std::string& message_id) {
+    return R"({"type":"notification","payload":{"type":"message.new","timestamp":1708329600,"payload":{)"
+           R"("message_id":")"
+           + message_id + R"(","conversation_id":"conv-batch","content":"hi","seq":1}}})";
+}
+
+std::string typingFrame(const std::string& user_id, bool typing) {
+    return R"({"type":"notification","payload":{"type":"message.typing","payload":{"conversation_id":"conv-batch",)"
+           R"("from_user_id":")"
+           + user_id + R"(","typing":)" + (typing ? "true" : "false") + "}}}";
+}
+
+} // namespace
+
+TEST_F(MessageManagerTest, ListenerBatchingFlushesBeforeRecall) {
+    auto timers = std::make_shared<anychat::util::TimerScheduler>();
+    mgr_->setListenerBatching(timers, nullptr, std::chrono::hours(1)); // only the recall flushes
+    auto listener = std::make_shared<BatchingMessageListener>();
+    mgr_->setListener(listener);
+
+    notif_mgr_->handleRaw(messageNewFrame("msg-b1"));
+    notif_mgr_->handleRaw(messageNewFrame("msg-b2"));
+    notif_mgr_->handleRaw(messageNewFrame("msg-b1")); // redelivered
+    EXPECT_TRUE(listener->calls().empty());
+
+    notif_mgr_->handleRaw(R"({"type":"notification","payload":{"type":"message.recalled","payload":{)"
+                          R"("message_id":"msg-b2","conversation_id":"conv-batch"}}})");
+
+    EXPECT_EQ(listener->calls(), (std::vector<std::string>{ "received:msg-b1,msg-b2,", "recalled:msg-b2" }));
+}
+
+TEST_F(MessageManagerTest, ListenerBatchingCollapsesTyping) {
+    auto timers = std::make_shared<anychat::util::TimerScheduler>(std::chrono::milliseconds(1));
+    mgr_->setListenerBatching(timers, nullptr, std::chrono::milliseconds(20));
+    auto listener = std::make_shared<BatchingMessageListener>();
+    mgr_->setListener(listener);
+
+    notif_mgr_->handleRaw(typingFrame("user-a", true));
+    notif_mgr_->handleRaw(typingFrame("user-b", true));
+    notif_mgr_->handleRaw(typingFrame("user-a", false));
+    ASSERT_TRUE(listener->waitFor(1));
+
+    EXPECT_EQ(listener->calls(), std::vector<std::string>{ "typing:user-a-,user-b+," });
+}
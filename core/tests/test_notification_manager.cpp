@@ -1,9 +1,17 @@
 #include "notification_manager.h"
+#include "frame_codec.h"
 #include "json_common.h"
+#include "util/dispatch_executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -19,10 +27,28 @@ struct NotificationPayload {
     int64_t sent_at = 0;
 };
 
+struct BeveAckPayload {
+    std::string message_id{};
+    int64_t sequence = 0;
+    int64_t timestamp = 0;
+    std::string local_id{};
+};
+
+struct BeveNotificationPayload {
+    std::string type{};
+    int64_t timestamp = 0;
+    std::string payload{}; // BEVE bytes
+};
+
+struct FriendRequestPayload {
+    std::string request_id{};
+};
+
 } // namespace notification_manager_test_detail
 
-// The NotificationManager dispatches on the calling thread (handleRaw() is
-// synchronous), so no threading or async machinery is needed in these tests.
+// Without an executor the NotificationManager dispatches on the calling
+// thread (handleRaw() is synchronous), so apart from the executor test no
+// threading or async machinery is needed in these tests.
 
 // ===========================================================================
 // NotificationManager tests
@@ -231,3 +257,259 @@ TEST(NotificationManagerTest, MultipleHandlersFanOut) {
     EXPECT_EQ(count_a, 2);
     EXPECT_EQ(count_b, 2);
 }
+
+TEST(NotificationManagerTest, BeveFramesDispatchLikeJson) {
+    using namespace notification_manager_test_detail;
+    const anychat::FrameCodec codec(anychat::FrameEncoding::Beve);
+    anychat::NotificationManager mgr;
+
+    anychat::MsgSentAck received_ack{};
+    mgr.setOnMessageSent([&](const anychat::MsgSentAck& ack) {
+        received_ack = ack;
+    });
+    anychat::NotificationEvent received_evt{};
+    mgr.addNotificationHandler([&](const anychat::NotificationEvent& evt) {
+        received_evt = evt;
+    });
+
+    std::string frame;
+    std::string err;
+    ASSERT_TRUE(codec.encodeFrame(
+        "message.sent",
+        BeveAckPayload{ .message_id = "msg-1", .sequence = 42, .timestamp = 1708329600, .local_id = "local-1" },
+        frame,
+        err
+    ));
+    mgr.handleRaw(frame, anychat::FrameEncoding::Beve);
+    EXPECT_EQ(received_ack.message_id, "msg-1");
+    EXPECT_EQ(received_ack.sequence, 42);
+    EXPECT_EQ(received_ack.timestamp, 1708329600);
+    EXPECT_EQ(received_ack.local_id, "local-1");
+
+    BeveNotificationPayload notification{ .type = "friend.request", .timestamp = 1708329601 };
+    ASSERT_TRUE(codec.encodePayload(FriendRequestPayload{ .request_id = "req-7" }, notification.payload, err));
+    ASSERT_TRUE(codec.encodeFrame("notification", notification, frame, err));
+    mgr.handleRaw(frame, anychat::FrameEncoding::Beve);
+    EXPECT_EQ(received_evt.notification_type, "friend.request");
+    EXPECT_EQ(received_evt.timestamp, 1708329601);
+    EXPECT_EQ(received_evt.data, R"({"request_id":"req-7"})");
+
+    // The same bytes are not JSON.
+    received_evt = {};
+    mgr.handleRaw(frame);
+    EXPECT_TRUE(received_evt.notification_type.empty());
+}
+
+TEST(NotificationManagerTest, ResumeResultAndSequenceDispatch) {
+    anychat::NotificationManager mgr;
+
+    std::vector<anychat::ResumeResult> results;
+    mgr.setOnResume([&](const anychat::ResumeResult& result) {
+        results.push_back(result);
+    });
+    std::vector<int64_t> seqs;
+    mgr.setOnSequence([&](int64_t seq) {
+        seqs.push_back(seq);
+    });
+    int notifications = 0;
+    mgr.addNotificationHandler([&](const anychat::NotificationEvent&) {
+        ++notifications;
+    });
+
+    // The sequence is reported after the push has been dispatched.
+    mgr.handleRaw(R"({"type":"notification","seq":"17","payload":{"type":"message.new","timestamp":1}})");
+    EXPECT_EQ(notifications, 1);
+    mgr.handleRaw(R"({"type":"pong"})"); // no seq
+    mgr.handleRaw(R"({"type":"resume.ok","payload":{"last_seq":17}})");
+    mgr.handleRaw(R"({"type":"resume.rejected","payload":{"last_seq":"900","reason":"gap_too_large"}})");
+
+    EXPECT_EQ(seqs, std::vector<int64_t>{ 17 });
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_TRUE(results[0].resumed);
+    EXPECT_EQ(results[0].last_seq, 17);
+    EXPECT_FALSE(results[1].resumed);
+    EXPECT_EQ(results[1].last_seq, 900);
+    EXPECT_EQ(results[1].reason, "gap_too_large");
+}
+
+TEST(NotificationManagerTest, SubscriptionsRouteByTypeAndPrefix) {
+    anychat::NotificationManager mgr;
+
+    std::vector<std::string> calls;
+    mgr.subscribe("group.*", [&](const anychat::NotificationEvent& evt) {
+        calls.push_back("group.* " + evt.notification_type);
+    });
+    mgr.subscribe("group.invited", [&](const anychat::NotificationEvent& evt) {
+        calls.push_back("exact " + evt.notification_type);
+    });
+    mgr.addNotificationHandler([&](const anychat::NotificationEvent& evt) {
+        calls.push_back("* " + evt.notification_type);
+    });
+    mgr.subscribe("group.member.*", [&](const anychat::NotificationEvent& evt) {
+        calls.push_back("group.member.* " + evt.notification_type);
+    });
+
+    const auto push = [&](const std::string& type) {
+        calls.clear();
+        mgr.handleRaw(R"({"type":"notification","payload":{"type":")" + type + R"(","timestamp":1}})");
+        return calls;
+    };
+
+    // Registration order across the exact type, its prefixes and "*".
+    EXPECT_EQ(
+        push("group.invited"),
+        (std::vector<std::string>{ "group.* group.invited", "exact group.invited", "* group.invited" })
+    );
+    EXPECT_EQ(push("group.muted"), (std::vector<std::string>{ "group.* group.muted", "* group.muted" }));
+    EXPECT_EQ(
+        push("group.member.joined"),
+        (std::vector<std::string>{
+            "group.* group.member.joined", "* group.member.joined", "group.member.* group.member.joined" })
+    );
+    EXPECT_EQ(push("friend.added"), std::vector<std::string>{ "* friend.added" });
+    // "group" itself is not under "group.*".
+    EXPECT_EQ(push("group"), std::vector<std::string>{ "* group" });
+}
+
+TEST(NotificationManagerTest, SubscribeFromHandlerAppliesToNextFrame) {
+    anychat::NotificationManager mgr;
+    const std::string frame = R"({"type":"notification","payload":{"type":"friend.added","timestamp":1}})";
+
+    int outer = 0;
+    int inner = 0;
+    mgr.subscribe("friend.added", [&](const anychat::NotificationEvent&) {
+        if (outer++ == 0) {
+            mgr.subscribe("friend.*", [&](const anychat::NotificationEvent&) {
+                ++inner;
+            });
+        }
+    });
+
+    mgr.handleRaw(frame);
+    EXPECT_EQ(outer, 1);
+    EXPECT_EQ(inner, 0);
+    mgr.handleRaw(frame);
+    EXPECT_EQ(outer, 2);
+    EXPECT_EQ(inner, 1);
+}
+
+TEST(NotificationManagerTest, TypedSubscriptionDecodesPayloadOnce) {
+    using notification_manager_test_detail::NotificationPayload;
+    anychat::NotificationManager mgr;
+
+    std::vector<NotificationPayload> typed;
+    std::string typed_data;
+    mgr.subscribe<NotificationPayload>(
+        "message.new",
+        [&](const anychat::NotificationEvent& evt, const NotificationPayload& payload) {
+            typed.push_back(payload);
+            typed_data = evt.data;
+        }
+    );
+
+    const std::string frame = R"({"type":"notification","payload":{"type":"message.new","timestamp":1708329600,)"
+                              R"("payload":{"message_id":"msg-1","seq":43,"unknown":[1,{"x":"}"}]}}})";
+    mgr.handleRaw(frame);
+    ASSERT_EQ(typed.size(), 1u);
+    EXPECT_EQ(typed[0].message_id, "msg-1");
+    EXPECT_EQ(typed[0].seq, 43);
+    // Only typed handlers on the route: the JSON text is not copied out.
+    EXPECT_EQ(typed_data, "{}");
+
+    // An untyped handler on the same route gets the JSON text.
+    std::string untyped_data;
+    mgr.addNotificationHandler([&](const anychat::NotificationEvent& evt) {
+        untyped_data = evt.data;
+    });
+    mgr.handleRaw(frame);
+    ASSERT_EQ(typed.size(), 2u);
+    EXPECT_EQ(untyped_data, R"({"message_id":"msg-1","seq":43,"unknown":[1,{"x":"}"}]})");
+    EXPECT_EQ(typed_data, untyped_data);
+
+    // A payload of the wrong shape skips the typed handler only.
+    untyped_data.clear();
+    mgr.handleRaw(R"({"type":"notification","payload":{"type":"message.new","payload":{"seq":"x"}}})");
+    EXPECT_EQ(typed.size(), 2u);
+    EXPECT_EQ(untyped_data, R"({"seq":"x"})");
+}
+
+TEST(NotificationManagerTest, TypedSubscriptionDecodesBevePayload) {
+    using namespace notification_manager_test_detail;
+    const anychat::FrameCodec codec(anychat::FrameEncoding::Beve);
+    anychat::NotificationManager mgr;
+
+    FriendRequestPayload received{};
+    int calls = 0;
+    mgr.subscribe<FriendRequestPayload>(
+        "friend.*",
+        [&](const anychat::NotificationEvent&, const FriendRequestPayload& payload) {
+            received = payload;
+            ++calls;
+        }
+    );
+
+    std::string err;
+    BeveNotificationPayload notification{ .type = "friend.request", .timestamp = 1708329601 };
+    ASSERT_TRUE(codec.encodePayload(FriendRequestPayload{ .request_id = "req-7" }, notification.payload, err));
+    std::string frame;
+    ASSERT_TRUE(codec.encodeFrame("notification", notification, frame, err));
+    mgr.handleRaw(frame, anychat::FrameEncoding::Beve);
+
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(received.request_id, "req-7");
+}
+
+TEST(NotificationManagerTest, ExecutorKeepsConversationOrder) {
+    using namespace notification_manager_test_detail;
+    auto executor = std::make_shared<anychat::util::DispatchExecutor>(
+        anychat::util::DispatchExecutorOptions{ .threads = 4 }
+    );
+    anychat::NotificationManager mgr(executor);
+
+    std::mutex mutex;
+    std::map<std::string, std::vector<int64_t>> seen;
+    std::atomic<int> off_thread{ 0 };
+    const auto caller = std::this_thread::get_id();
+    mgr.subscribe<NotificationPayload>(
+        "message.new",
+        [&](const anychat::NotificationEvent&, const NotificationPayload& payload) {
+            if (std::this_thread::get_id() != caller) {
+                ++off_thread;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            seen[payload.conversation_id].push_back(payload.seq);
+        },
+        [](const NotificationPayload& payload) -> std::string_view {
+            return payload.conversation_id;
+        }
+    );
+    std::atomic<int> acks{ 0 };
+    mgr.setOnMessageSent([&](const anychat::MsgSentAck&) {
+        ++acks;
+    });
+    int pongs = 0;
+    mgr.setOnPong([&] {
+        EXPECT_EQ(std::this_thread::get_id(), caller); // connection state stays inline
+        ++pongs;
+    });
+
+    for (int i = 1; i <= 400; ++i) {
+        const std::string frame = R"({"type":"notification","payload":{"type":"message.new","payload":{)"
+                                  R"("conversation_id":"conv-)"
+                                  + std::to_string(i % 4) + R"(","seq":)" + std::to_string(i) + "}}}";
+        mgr.handleRaw(frame);
+    }
+    mgr.handleRaw(R"({"type":"message.sent","payload":{"message_id":"m","local_id":"l"}})");
+    mgr.handleRaw(R"({"type":"pong"})");
+    executor->drain();
+
+    EXPECT_EQ(off_thread, 400);
+    EXPECT_EQ(acks, 1);
+    EXPECT_EQ(pongs, 1);
+    ASSERT_EQ(seen.size(), 4u);
+    for (const auto& [conversation, seqs] : seen) {
+        EXPECT_EQ(seqs.size(), 100u) << conversation;
+        EXPECT_TRUE(std::is_sorted(seqs.begin(), seqs.end())) << conversation;
+    }
+    EXPECT_EQ(executor->stats().executed, 401u);
+}
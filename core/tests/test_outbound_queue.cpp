@@ -8,9 +8,12 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+using anychat::network::SendPriority;
+
 namespace outbound_queue_test_detail {
 
 struct SentPayload {
@@ -91,8 +94,9 @@ TEST_F(OutboundQueueTest, FlushOnConnect) {
     drainDb();
 
     std::vector<std::string> sent_payloads;
-    queue_->onConnected([&sent_payloads](const std::string& payload) {
+    queue_->onConnected([&sent_payloads](const std::string& payload, SendPriority) {
         sent_payloads.push_back(payload);
+        return true;
     });
 
     ASSERT_EQ(sent_payloads.size(), 1u) << "send_fn should have been called once for the queued message";
@@ -128,7 +132,9 @@ TEST_F(OutboundQueueTest, AckRemovesRow) {
     drainDb();
 
     // Connect (flush any pending rows).
-    queue_->onConnected([](const std::string&) { /* discard */ });
+    queue_->onConnected([](const std::string&, SendPriority) {
+        return true; // discard
+    });
 
     // Simulate server ack.
     anychat::MsgSentAck ack;
@@ -159,8 +165,9 @@ TEST_F(OutboundQueueTest, RetryOnReconnect) {
 
     // First connection — row is sent, but NOT acknowledged (no ack received).
     int first_send_count = 0;
-    queue_->onConnected([&first_send_count](const std::string&) {
+    queue_->onConnected([&first_send_count](const std::string&, SendPriority) {
         ++first_send_count;
+        return true;
     });
     EXPECT_EQ(first_send_count, 1);
 
@@ -173,8 +180,9 @@ TEST_F(OutboundQueueTest, RetryOnReconnect) {
 
     // Second connection — row should be re-sent.
     int second_send_count = 0;
-    queue_->onConnected([&second_send_count](const std::string&) {
+    queue_->onConnected([&second_send_count](const std::string&, SendPriority) {
         ++second_send_count;
+        return true;
     });
     EXPECT_EQ(second_send_count, 1) << "Unacknowledged message should be re-sent on reconnect";
 }
@@ -206,8 +214,9 @@ TEST_F(OutboundQueueTest, MultipleEnqueueFlushesAll) {
     EXPECT_EQ(totalRows(), 3);
 
     int send_count = 0;
-    queue_->onConnected([&send_count](const std::string&) {
+    queue_->onConnected([&send_count](const std::string&, SendPriority) {
         ++send_count;
+        return true;
     });
 
     EXPECT_EQ(send_count, 3) << "All three queued messages should be sent on connect";
@@ -217,10 +226,150 @@ TEST_F(OutboundQueueTest, SendTransientRequiresConnection) {
     EXPECT_FALSE(queue_->sendTransient("{\"type\":\"message.typing\"}"));
 
     int send_count = 0;
-    queue_->onConnected([&send_count](const std::string&) {
+    queue_->onConnected([&send_count](const std::string&, SendPriority) {
         ++send_count;
+        return true;
     });
 
     EXPECT_TRUE(queue_->sendTransient("{\"type\":\"message.typing\"}"));
     EXPECT_EQ(send_count, 1);
 }
+
+TEST_F(OutboundQueueTest, FramesUseTheConnectionCodec) {
+    using namespace outbound_queue_test_detail;
+    queue_->enqueue("conv-b", "private", 1, "hello", "local-b", anychat::AnyChatCallback{});
+    drainDb();
+
+    const anychat::FrameCodec codec(anychat::FrameEncoding::Beve);
+    std::vector<std::string> frames;
+    queue_->onConnected(
+        [&frames](const std::string& frame, SendPriority) {
+            frames.push_back(frame);
+            return true;
+        },
+        codec
+    );
+
+    std::string err;
+    EXPECT_TRUE(queue_->sendTransient("message.typing", SentPayload{ .conversation_id = "conv-b" }, err)) << err;
+
+    ASSERT_EQ(frames.size(), 2u);
+    anychat::FrameEnvelope envelope;
+    ASSERT_TRUE(codec.decodeEnvelope(frames[0], envelope, err)) << err;
+    EXPECT_EQ(envelope.type, "message.send");
+    SentPayload payload{};
+    ASSERT_TRUE(codec.decodePayload(envelope.payload, payload, err)) << err;
+    EXPECT_EQ(payload.conversation_id, "conv-b");
+    EXPECT_EQ(payload.local_id, "local-b");
+
+    ASSERT_TRUE(codec.decodeEnvelope(frames[1], envelope, err)) << err;
+    EXPECT_EQ(envelope.type, "message.typing");
+
+    queue_->onDisconnected();
+    EXPECT_FALSE(queue_->sendTransient("message.typing", SentPayload{}, err));
+    EXPECT_EQ(err, "websocket not connected");
+}
+
+// ---------------------------------------------------------------------------
+// 9. RefusedSendPausesUntilDrained
+//    A congested transport refuses a frame: the flush stops there, new rows
+//    wait, and onDrained() resumes in order without resending accepted rows.
+// ---------------------------------------------------------------------------
+TEST_F(OutboundQueueTest, RefusedSendPausesUntilDrained) {
+    using namespace outbound_queue_test_detail;
+    queue_->enqueue("conv-p", "private", 1, "msg-a", "local-a", anychat::AnyChatCallback{});
+    queue_->enqueue("conv-p", "private", 1, "msg-b", "local-b", anychat::AnyChatCallback{});
+    queue_->enqueue("conv-p", "private", 1, "msg-c", "local-c", anychat::AnyChatCallback{});
+    drainDb();
+
+    bool accepting = true;
+    int attempts = 0;
+    std::vector<std::string> accepted;
+    queue_->onConnected([&](const std::string& frame, SendPriority priority) {
+        EXPECT_EQ(priority, SendPriority::Bulk);
+        ++attempts;
+        if (!accepting) {
+            return false;
+        }
+        SentFrame sent{};
+        std::string err;
+        EXPECT_TRUE(anychat::json_common::readJsonRelaxed(frame, sent, err)) << err;
+        accepted.push_back(sent.payload.local_id);
+        accepting = false; // congested after the first frame
+        return true;
+    });
+    EXPECT_EQ(attempts, 2);
+    EXPECT_EQ(accepted, std::vector<std::string>({ "local-a" }));
+
+    queue_->enqueue("conv-p", "private", 1, "msg-d", "local-d", anychat::AnyChatCallback{});
+    drainDb();
+    EXPECT_EQ(attempts, 2) << "rows enqueued while paused wait for onDrained()";
+
+    accepting = true;
+    queue_->onDrained();
+    drainDb(); // the resume runs on the DB worker
+    EXPECT_EQ(accepted, std::vector<std::string>({ "local-a", "local-b" }));
+
+    // Each drain lets one more frame through in this fake; keep going.
+    while (accepted.size() < 4) {
+        accepting = true;
+        queue_->onDrained();
+        drainDb();
+    }
+    EXPECT_EQ(accepted, std::vector<std::string>({ "local-a", "local-b", "local-c", "local-d" }));
+}
+
+// ---------------------------------------------------------------------------
+// 10. DrainDuringRefusedSendDoesNotStall
+//     The transport drains between refusing a frame and sendRow() pausing:
+//     the frame is offered again instead of waiting for a drain that never
+//     comes.
+// ---------------------------------------------------------------------------
+TEST_F(OutboundQueueTest, DrainDuringRefusedSendDoesNotStall) {
+    using namespace outbound_queue_test_detail;
+    queue_->enqueue("conv-r", "private", 1, "msg-a", "local-a", anychat::AnyChatCallback{});
+    queue_->enqueue("conv-r", "private", 1, "msg-b", "local-b", anychat::AnyChatCallback{});
+    drainDb();
+
+    bool refuse_next = true;
+    int attempts = 0;
+    std::vector<std::string> accepted;
+    queue_->onConnected([&](const std::string& frame, SendPriority) {
+        ++attempts;
+        if (refuse_next) {
+            refuse_next = false;
+            queue_->onDrained(); // the service thread drains before we return
+            return false;
+        }
+        SentFrame sent{};
+        std::string err;
+        EXPECT_TRUE(anychat::json_common::readJsonRelaxed(frame, sent, err)) << err;
+        accepted.push_back(sent.payload.local_id);
+        return true;
+    });
+
+    EXPECT_EQ(attempts, 3);
+    EXPECT_EQ(accepted, std::vector<std::string>({ "local-a", "local-b" }));
+}
+
+// ---------------------------------------------------------------------------
+// 11. TransientFramesCarryTheirPriority
+// ---------------------------------------------------------------------------
+TEST_F(OutboundQueueTest, TransientFramesCarryTheirPriority) {
+    using namespace outbound_queue_test_detail;
+    std::vector<SendPriority> priorities;
+    queue_->onConnected([&priorities](const std::string&, SendPriority priority) {
+        priorities.push_back(priority);
+        return priority != SendPriority::Bulk;
+    });
+
+    std::string err;
+    EXPECT_TRUE(queue_->sendTransient("message.recall", SentPayload{}, err));
+    EXPECT_TRUE(queue_->sendTransient("message.typing", SentPayload{}, err, SendPriority::Transient));
+    EXPECT_FALSE(queue_->sendTransient("message.bulk", SentPayload{}, err, SendPriority::Bulk));
+    EXPECT_EQ(err, "websocket send queue full");
+    EXPECT_EQ(
+        priorities,
+        std::vector<SendPriority>({ SendPriority::Control, SendPriority::Transient, SendPriority::Bulk })
+    );
+}
@@ -0,0 +1,75 @@
+#include "util/recent_id_window.h"
+
+#include <gtest/gtest.h>
+
+using anychat::util::fnv1a64;
+using anychat::util::RecentIdWindow;
+
+// ---------------------------------------------------------------------------
+// 1. FindsRecordedVersion
+// ---------------------------------------------------------------------------
+TEST(RecentIdWindowTest, FindsRecordedVersion) {
+    RecentIdWindow window(4);
+    EXPECT_FALSE(window.find(1).has_value());
+
+    window.record(1, 10);
+    window.record(2, 20);
+    ASSERT_TRUE(window.find(1).has_value());
+    EXPECT_EQ(*window.find(1), 10u);
+
+    window.record(1, 11); // a new version replaces the old one
+    EXPECT_EQ(*window.find(1), 11u);
+    EXPECT_EQ(window.size(), 2u);
+}
+
+// ---------------------------------------------------------------------------
+// 2. OldestLeavesWhenFull
+// ---------------------------------------------------------------------------
+TEST(RecentIdWindowTest, OldestLeavesWhenFull) {
+    RecentIdWindow window(3);
+    for (uint64_t id = 1; id <= 5; ++id) {
+        window.record(id, id);
+    }
+    EXPECT_FALSE(window.find(1).has_value());
+    EXPECT_FALSE(window.find(2).has_value());
+    EXPECT_TRUE(window.find(3).has_value());
+    EXPECT_TRUE(window.find(5).has_value());
+    EXPECT_EQ(window.size(), 3u);
+}
+
+// ---------------------------------------------------------------------------
+// 3. RecordAgainKeepsIdLonger
+//    Its older slot no longer evicts it.
+// ---------------------------------------------------------------------------
+TEST(RecentIdWindowTest, RecordAgainKeepsIdLonger) {
+    RecentIdWindow window(3);
+    window.record(1, 1);
+    window.record(2, 2);
+    window.record(1, 1); // slot 0 is stale now
+    window.record(3, 3); // overwrites slot 0
+    EXPECT_TRUE(window.find(1).has_value());
+    window.record(4, 4); // overwrites slot 1: id 2 leaves
+    EXPECT_FALSE(window.find(2).has_value());
+    EXPECT_TRUE(window.find(1).has_value());
+}
+
+// ---------------------------------------------------------------------------
+// 4. ForgetMatchesVersion
+// ---------------------------------------------------------------------------
+TEST(RecentIdWindowTest, ForgetMatchesVersion) {
+    RecentIdWindow window(4);
+    window.record(1, 10);
+    window.forget(1, 99);
+    EXPECT_TRUE(window.find(1).has_value());
+    window.forget(1, 10);
+    EXPECT_FALSE(window.find(1).has_value());
+}
+
+// ---------------------------------------------------------------------------
+// 5. Fnv1a64
+// ---------------------------------------------------------------------------
+TEST(RecentIdWindowTest, Fnv1a64) {
+    EXPECT_EQ(fnv1a64(""), 0xcbf29ce484222325ULL);
+    EXPECT_EQ(fnv1a64("a"), 0xaf63dc4c8601ec8cULL);
+    EXPECT_NE(fnv1a64("msg-1"), fnv1a64("msg-2"));
+}
@@ -0,0 +1,76 @@
+#include "network/rtt_estimator.h"
+
+#include <gtest/gtest.h>
+
+using anychat::network::RttEstimator;
+using anychat::network::RttStats;
+
+// ---------------------------------------------------------------------------
+// 1. FirstSampleSeedsTheEstimate
+//    srtt = r, rttvar = r / 2 (RFC 6298 §2.2).
+// ---------------------------------------------------------------------------
+TEST(RttEstimatorTest, FirstSampleSeedsTheEstimate) {
+    RttEstimator rtt;
+    EXPECT_EQ(rtt.stats().samples, 0u);
+    EXPECT_EQ(rtt.stats().rto_ms, 0);
+
+    rtt.addSample(400);
+    const RttStats stats = rtt.stats();
+    EXPECT_EQ(stats.samples, 1u);
+    EXPECT_EQ(stats.last_ms, 400);
+    EXPECT_EQ(stats.min_ms, 400);
+    EXPECT_EQ(stats.srtt_ms, 400);
+    EXPECT_EQ(stats.rttvar_ms, 200);
+    EXPECT_EQ(stats.rto_ms, 1200);
+}
+
+// ---------------------------------------------------------------------------
+// 2. LaterSamplesAreSmoothed
+//    rttvar = 3/4 rttvar + 1/4 |srtt - r| with the old srtt, then
+//    srtt = 7/8 srtt + 1/8 r (RFC 6298 §2.3).
+// ---------------------------------------------------------------------------
+TEST(RttEstimatorTest, LaterSamplesAreSmoothed) {
+    RttEstimator rtt;
+    rtt.addSample(100);
+    rtt.addSample(180);
+
+    const RttStats stats = rtt.stats();
+    EXPECT_EQ(stats.samples, 2u);
+    EXPECT_EQ(stats.last_ms, 180);
+    EXPECT_EQ(stats.min_ms, 100);
+    EXPECT_EQ(stats.srtt_ms, 110); // 87.5 + 22.5
+    EXPECT_EQ(stats.rttvar_ms, 58); // 37.5 + 20 = 57.5
+    EXPECT_EQ(stats.rto_ms, 1000) << "the RTO has a floor";
+}
+
+// ---------------------------------------------------------------------------
+// 3. SteadyRttConvergesAndJitterDecays
+// ---------------------------------------------------------------------------
+TEST(RttEstimatorTest, SteadyRttConvergesAndJitterDecays) {
+    RttEstimator rtt;
+    rtt.addSample(2000);
+    for (int i = 0; i < 100; ++i)
+        rtt.addSample(300);
+
+    const RttStats stats = rtt.stats();
+    EXPECT_EQ(stats.srtt_ms, 300);
+    EXPECT_EQ(stats.rttvar_ms, 0);
+    EXPECT_EQ(stats.min_ms, 300);
+    EXPECT_EQ(stats.rto_ms, RttEstimator::kMinRtoMs);
+}
+
+// ---------------------------------------------------------------------------
+// 4. ResetForgetsSamples
+// ---------------------------------------------------------------------------
+TEST(RttEstimatorTest, ResetForgetsSamples) {
+    RttEstimator rtt;
+    rtt.addSample(500);
+    rtt.addSample(-5); // clock oddities count as 0
+    EXPECT_EQ(rtt.stats().min_ms, 0);
+
+    rtt.reset();
+    EXPECT_EQ(rtt.stats().samples, 0u);
+    rtt.addSample(80);
+    EXPECT_EQ(rtt.stats().srtt_ms, 80);
+    EXPECT_EQ(rtt.stats().min_ms, 80);
+}
@@ -0,0 +1,335 @@
+#include "session_resumer.h"
+
+#include "notification_manager.h"
+#include "network/websocket_client.h"
+#include "util/timer_wheel.h"
+
+#include "local_ws_echo_server.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using anychat::FrameCodec;
+using anychat::ResumeResult;
+using anychat::SessionResumer;
+using anychat::SessionResumeStats;
+using anychat::network::SendPriority;
+using anychat::network::WebSocketClient;
+using anychat::test::LocalWsEchoServer;
+
+namespace {
+
+constexpr auto kTimeout = std::chrono::milliseconds(50);
+
+// Counts full syncs; waitable from the test thread.
+class SyncCounter {
+public:
+    void operator()() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++count_;
+        cv_.notify_all();
+    }
+
+    bool waitFor(int n) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, std::chrono::seconds(5), [this, n] {
+            return count_ >= n;
+        });
+    }
+
+    int count() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int count_ = 0;
+};
+
+std::string notificationPush(int64_t seq) {
+    return R"({"type":"notification","seq":)" + std::to_string(seq)
+           + R"(,"payload":{"type":"message.new","timestamp":1708329600,"payload":{"seq":)" + std::to_string(seq)
+           + "}}}";
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Fixture
+// ---------------------------------------------------------------------------
+class SessionResumerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        timers_ = std::make_shared<anychat::util::TimerScheduler>(std::chrono::milliseconds(1));
+        resumer_ = std::make_unique<SessionResumer>(
+            timers_,
+            [this] {
+                syncs_();
+            },
+            kTimeout
+        );
+    }
+
+    void TearDown() override {
+        resumer_.reset();
+        timers_.reset();
+    }
+
+    // Connects, recording the frames the resumer sends.
+    void connect(bool send_ok = true) {
+        resumer_->onConnected(FrameCodec{}, [this, send_ok](const std::string& frame) {
+            sent_.push_back(frame);
+            return send_ok;
+        });
+    }
+
+    std::shared_ptr<anychat::util::TimerScheduler> timers_;
+    std::unique_ptr<SessionResumer> resumer_;
+    SyncCounter syncs_;
+    std::vector<std::string> sent_;
+};
+
+// ---------------------------------------------------------------------------
+// 1. FirstConnectionSyncs
+//    Without a sequence seen there is nothing to resume from.
+// ---------------------------------------------------------------------------
+TEST_F(SessionResumerTest, FirstConnectionSyncs) {
+    connect();
+
+    EXPECT_TRUE(sent_.empty());
+    EXPECT_EQ(syncs_.count(), 1);
+    EXPECT_EQ(resumer_->stats().full_syncs, 1u);
+}
+
+// ---------------------------------------------------------------------------
+// 2. ReconnectResumesFromHighestSequence
+//    The resume frame carries the highest sequence seen; resume.ok settles
+//    the attempt without a sync, and the timeout never fires.
+// ---------------------------------------------------------------------------
+TEST_F(SessionResumerTest, ReconnectResumesFromHighestSequence) {
+    resumer_->onSequence(41);
+    resumer_->onSequence(42);
+    resumer_->onSequence(40); // out of order
+    connect();
+
+    ASSERT_EQ(sent_.size(), 1u);
+    EXPECT_EQ(sent_[0], R"({"type":"resume","payload":{"last_seq":42}})");
+
+    resumer_->onResumeResult(ResumeResult{ .resumed = true, .last_seq = 45 });
+    std::this_thread::sleep_for(kTimeout * 3);
+
+    EXPECT_EQ(syncs_.count(), 0);
+    EXPECT_EQ(resumer_->lastSeq(), 45);
+    const SessionResumeStats stats = resumer_->stats();
+    EXPECT_EQ(stats.resumed, 1u);
+    EXPECT_EQ(stats.timed_out, 0u);
+    EXPECT_EQ(stats.full_syncs, 0u);
+}
+
+// ---------------------------------------------------------------------------
+// 3. RejectedResumeFallsBackToSync
+//    The server no longer has the gap: sync, and continue from the
+//    server's sequence.
+// ---------------------------------------------------------------------------
+TEST_F(SessionResumerTest, RejectedResumeFallsBackToSync) {
+    resumer_->onSequence(7);
+    connect();
+    resumer_->onResumeResult(ResumeResult{ .resumed = false, .last_seq = 900, .reason = "gap_too_large" });
+
+    EXPECT_EQ(syncs_.count(), 1);
+    EXPECT_EQ(resumer_->lastSeq(), 900);
+    EXPECT_EQ(resumer_->stats().rejected, 1u);
+}
+
+// ---------------------------------------------------------------------------
+// 4. UnansweredResumeTimesOut
+//    A server without resume support never answers: sync after the
+//    timeout. An answer arriving later does not sync again.
+// ---------------------------------------------------------------------------
+TEST_F(SessionResumerTest, UnansweredResumeTimesOut) {
+    resumer_->onSequence(7);
+    connect();
+    ASSERT_TRUE(syncs_.waitFor(1));
+    EXPECT_EQ(resumer_->stats().timed_out, 1u);
+
+    resumer_->onResumeResult(ResumeResult{ .resumed = false, .last_seq = 9 });
+    EXPECT_EQ(syncs_.count(), 1);
+    EXPECT_EQ(resumer_->stats().rejected, 0u);
+    EXPECT_EQ(resumer_->lastSeq(), 9);
+}
+
+// ---------------------------------------------------------------------------
+// 5. DisconnectAbandonsAttempt
+//    The connection dropped before the answer: the next connection decides,
+//    not the stale timer.
+// ---------------------------------------------------------------------------
+TEST_F(SessionResumerTest, DisconnectAbandonsAttempt) {
+    resumer_->onSequence(7);
+    connect();
+    resumer_->onDisconnected();
+    std::this_thread::sleep_for(kTimeout * 3);
+
+    EXPECT_EQ(syncs_.count(), 0);
+    EXPECT_EQ(resumer_->stats().timed_out, 0u);
+
+    connect();
+    EXPECT_EQ(sent_.size(), 2u);
+    ASSERT_TRUE(syncs_.waitFor(1));
+}
+
+// ---------------------------------------------------------------------------
+// 6. SendFailureSyncs
+// ---------------------------------------------------------------------------
+TEST_F(SessionResumerTest, SendFailureSyncs) {
+    resumer_->onSequence(7);
+    connect(false);
+
+    EXPECT_EQ(syncs_.count(), 1);
+    std::this_thread::sleep_for(kTimeout * 3);
+    EXPECT_EQ(syncs_.count(), 1);
+    EXPECT_EQ(resumer_->stats().timed_out, 0u);
+}
+
+// ---------------------------------------------------------------------------
+// 7. ResetForgetsSequence
+//    A new login starts from a full sync.
+// ---------------------------------------------------------------------------
+TEST_F(SessionResumerTest, ResetForgetsSequence) {
+    resumer_->onSequence(7);
+    resumer_->reset();
+    connect();
+
+    EXPECT_TRUE(sent_.empty());
+    EXPECT_EQ(syncs_.count(), 1);
+    EXPECT_EQ(resumer_->lastSeq(), 0);
+}
+
+// ---------------------------------------------------------------------------
+// Against a local stand-in server: WebSocketClient -> NotificationManager ->
+// SessionResumer, wired like ClientImpl.
+// ---------------------------------------------------------------------------
+namespace {
+
+class ResumeSession {
+public:
+    ResumeSession(const std::string& url, std::shared_ptr<anychat::util::TimerScheduler> timers)
+        : ws_(url)
+        , resumer_(
+              std::move(timers),
+              [this] {
+                  syncs_();
+              },
+              std::chrono::seconds(5)
+          ) {
+        notif_.setOnResume([this](const ResumeResult& result) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                results_.push_back(result);
+            }
+            resumer_.onResumeResult(result);
+            cv_.notify_all();
+        });
+        notif_.setOnSequence([this](int64_t seq) {
+            resumer_.onSequence(seq);
+        });
+        notif_.addNotificationHandler([this](const anychat::NotificationEvent&) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++pushes_;
+        });
+        ws_.setOnMessage([this](std::string_view msg, bool binary) {
+            notif_.handleRaw(msg, binary ? anychat::FrameEncoding::Beve : anychat::FrameEncoding::Json);
+        });
+        ws_.setOnConnected([this] {
+            resumer_.onConnected(FrameCodec{}, [this](const std::string& frame) {
+                return ws_.send(frame, SendPriority::Control);
+            });
+        });
+    }
+
+    ~ResumeSession() {
+        ws_.disconnect();
+    }
+
+    bool waitResult() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, std::chrono::seconds(5), [this] {
+            return !results_.empty();
+        });
+    }
+
+    int pushes() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pushes_;
+    }
+
+    WebSocketClient ws_;
+    anychat::NotificationManager notif_;
+    SessionResumer resumer_;
+    SyncCounter syncs_;
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<ResumeResult> results_;
+    int pushes_ = 0;
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 8. LocalServerReplaysMissedPushes
+//    The server replays the pushes after last_seq, then confirms: no sync,
+//    and the client's sequence follows the replay.
+// ---------------------------------------------------------------------------
+TEST(SessionResumerServerTest, LocalServerReplaysMissedPushes) {
+    LocalWsEchoServer server(false);
+    server.setResponder([](const std::string& msg) -> std::vector<std::string> {
+        if (msg != R"({"type":"resume","payload":{"last_seq":2}})")
+            return {};
+        return { notificationPush(3), notificationPush(4), R"({"type":"resume.ok","payload":{"last_seq":4}})" };
+    });
+    auto timers = std::make_shared<anychat::util::TimerScheduler>();
+    ResumeSession session(server.url(), timers);
+    session.resumer_.onSequence(2); // seen on the previous connection
+
+    session.ws_.connect();
+    ASSERT_TRUE(session.waitResult());
+
+    EXPECT_EQ(server.received(), std::vector<std::string>{ R"({"type":"resume","payload":{"last_seq":2}})" });
+    EXPECT_EQ(session.pushes(), 2);
+    EXPECT_EQ(session.resumer_.lastSeq(), 4);
+    EXPECT_EQ(session.syncs_.count(), 0);
+    EXPECT_EQ(session.resumer_.stats().resumed, 1u);
+}
+
+// ---------------------------------------------------------------------------
+// 9. LocalServerRejectsLargeGap
+//    The gap has left the server's window: one full sync.
+// ---------------------------------------------------------------------------
+TEST(SessionResumerServerTest, LocalServerRejectsLargeGap) {
+    LocalWsEchoServer server(false);
+    server.setResponder([](const std::string&) -> std::vector<std::string> {
+        return { R"({"type":"resume.rejected","payload":{"last_seq":"5000","reason":"gap_too_large"}})" };
+    });
+    auto timers = std::make_shared<anychat::util::TimerScheduler>();
+    ResumeSession session(server.url(), timers);
+    session.resumer_.onSequence(2);
+
+    session.ws_.connect();
+    ASSERT_TRUE(session.waitResult());
+    ASSERT_TRUE(session.syncs_.waitFor(1));
+
+    EXPECT_EQ(session.pushes(), 0);
+    EXPECT_EQ(session.resumer_.lastSeq(), 5000);
+    EXPECT_EQ(session.resumer_.stats().rejected, 1u);
+}
@@ -0,0 +1,76 @@
+#include "util/sha256.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using anychat::util::Sha256;
+
+namespace {
+
+std::string hashOf(const std::string& data) {
+    Sha256 hasher;
+    hasher.update(data.data(), data.size());
+    return Sha256::toHex(hasher.finish());
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 1. KnownVectors (FIPS 180-4 examples)
+// ---------------------------------------------------------------------------
+TEST(Sha256Test, KnownVectors) {
+    EXPECT_EQ(hashOf(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    EXPECT_EQ(hashOf("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    EXPECT_EQ(
+        hashOf("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"
+    );
+    EXPECT_EQ(
+        hashOf(std::string(1000000, 'a')),
+        "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"
+    );
+}
+
+// ---------------------------------------------------------------------------
+// 2. ChunkingDoesNotChangeDigest
+// ---------------------------------------------------------------------------
+TEST(Sha256Test, ChunkingDoesNotChangeDigest) {
+    std::string data(10000, '\0');
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<char>(i * 31);
+
+    const std::string expected = hashOf(data);
+    for (size_t step : { 1u, 7u, 63u, 64u, 65u, 4096u }) {
+        Sha256 hasher;
+        for (size_t pos = 0; pos < data.size(); pos += step)
+            hasher.update(data.data() + pos, std::min(step, data.size() - pos));
+        EXPECT_EQ(Sha256::toHex(hasher.finish()), expected) << "step " << step;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 3. FileHashMatchesInMemoryHash
+// ---------------------------------------------------------------------------
+TEST(Sha256Test, FileHashMatchesInMemoryHash) {
+    const auto path = std::filesystem::temp_directory_path() / "anychat_sha256_file.bin";
+    std::string data(200 * 1024 + 17, '\0');
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<char>((i * 13) ^ (i >> 8));
+    {
+        std::ofstream ofs(path, std::ios::binary);
+        ofs << data;
+    }
+
+    std::string digest;
+    std::string err;
+    ASSERT_TRUE(anychat::util::sha256File(path.string(), digest, err)) << err;
+    EXPECT_EQ(digest, hashOf(data));
+
+    EXPECT_FALSE(anychat::util::sha256File("/nonexistent/file.bin", digest, err));
+    EXPECT_FALSE(err.empty());
+
+    std::filesystem::remove(path);
+}
@@ -1,3 +1,4 @@
+#include "message_ingestor.h"
 #include "sync_engine.h"
 
 #include "cache/conversation_cache.h"
@@ -24,11 +25,13 @@ protected:
 
         http_ = std::make_shared<anychat::network::HttpClient>("http://localhost:19999");
 
-        engine_ = std::make_unique<anychat::SyncEngine>(db_.get(), conv_cache_.get(), msg_cache_.get(), http_);
+        ingestor_ = std::make_unique<anychat::MessageIngestor>(db_.get(), msg_cache_.get(), conv_cache_.get());
+        engine_ = std::make_unique<anychat::SyncEngine>(db_.get(), conv_cache_.get(), ingestor_.get(), http_);
     }
 
     void TearDown() override {
         engine_.reset();
+        ingestor_.reset();
         http_.reset();
         msg_cache_.reset();
         conv_cache_.reset();
@@ -43,6 +46,7 @@ protected:
     std::unique_ptr<anychat::db::Database> db_;
     std::unique_ptr<anychat::cache::ConversationCache> conv_cache_;
     std::unique_ptr<anychat::cache::MessageCache> msg_cache_;
+    std::unique_ptr<anychat::MessageIngestor> ingestor_;
     std::shared_ptr<anychat::network::HttpClient> http_;
     std::unique_ptr<anychat::SyncEngine> engine_;
 };
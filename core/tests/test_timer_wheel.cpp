@@ -0,0 +1,191 @@
+#include "util/timer_wheel.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using anychat::util::TimerId;
+using anychat::util::TimerScheduler;
+using anychat::util::TimerWheel;
+
+namespace {
+
+// Pops everything expired by |to_tick|; returns "id@tick" per timer.
+std::vector<std::string> drain(TimerWheel& wheel, uint64_t to_tick) {
+    std::vector<std::string> fired;
+    while (auto expired = wheel.popExpired(to_tick)) {
+        expired->fn();
+        fired.push_back(std::to_string(expired->id) + "@" + std::to_string(wheel.now()));
+    }
+    return fired;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 1. TimersFireAtTheirDeadline
+//    Deadlines on every level, including past the top one, come out on the
+//    exact tick and in deadline order.
+// ---------------------------------------------------------------------------
+TEST(TimerWheelTest, TimersFireAtTheirDeadline) {
+    TimerWheel wheel(5);
+    const uint64_t top_span = uint64_t{ 1 } << (TimerWheel::kLevelBits * TimerWheel::kLevels);
+    const std::vector<uint64_t> deadlines = {
+        6, 68, 69, 4100, 4096 * 64 + 7, top_span + 1000, 3 * top_span,
+    };
+    int calls = 0;
+    for (size_t i = 0; i < deadlines.size(); ++i)
+        wheel.add(static_cast<TimerId>(i + 1), deadlines[i], [&calls] {
+            ++calls;
+        });
+    // Reverse insertion order for the same tick still pops by id.
+    wheel.add(9, 69, [] {});
+    wheel.add(8, 69, [] {});
+
+    EXPECT_EQ(drain(wheel, 5), std::vector<std::string>{});
+    EXPECT_EQ(drain(wheel, 70), std::vector<std::string>({ "1@6", "2@68", "3@69", "8@69", "9@69" }));
+    EXPECT_EQ(drain(wheel, 4099), std::vector<std::string>{});
+    EXPECT_EQ(drain(wheel, 4096 * 64 + 7), std::vector<std::string>({ "4@4100", "5@262151" }));
+    EXPECT_EQ(drain(wheel, 3 * top_span), std::vector<std::string>({
+        "6@" + std::to_string(top_span + 1000),
+        "7@" + std::to_string(3 * top_span),
+    }));
+    EXPECT_EQ(calls, 7);
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+// ---------------------------------------------------------------------------
+// 2. CancelledTimersNeverFire
+// ---------------------------------------------------------------------------
+TEST(TimerWheelTest, CancelledTimersNeverFire) {
+    TimerWheel wheel;
+    wheel.add(1, 10, [] {});
+    wheel.add(2, 10, [] {});
+    wheel.add(3, 5000, [] {});
+
+    EXPECT_TRUE(wheel.cancel(3));
+    EXPECT_FALSE(wheel.cancel(3));
+    EXPECT_FALSE(wheel.cancel(42));
+
+    // Timer 2 is due together with 1; it can still be cancelled after 1 pops.
+    auto first = wheel.popExpired(10);
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->id, 1u);
+    EXPECT_TRUE(wheel.cancel(2));
+    EXPECT_FALSE(wheel.popExpired(10000).has_value());
+    EXPECT_EQ(wheel.now(), 10000u);
+}
+
+// ---------------------------------------------------------------------------
+// 3. PastDeadlinesFireOnTheNextTick
+// ---------------------------------------------------------------------------
+TEST(TimerWheelTest, PastDeadlinesFireOnTheNextTick) {
+    TimerWheel wheel(100);
+    wheel.add(1, 3, [] {});
+    wheel.add(2, 100, [] {});
+    EXPECT_EQ(wheel.ticksUntilNext(), std::optional<uint64_t>(1));
+    EXPECT_EQ(drain(wheel, 101), std::vector<std::string>({ "1@101", "2@101" }));
+}
+
+// ---------------------------------------------------------------------------
+// 4. NextWakeUpSkipsEmptySlots
+//    A lone far timer needs one wake-up per cascade, not one per tick.
+// ---------------------------------------------------------------------------
+TEST(TimerWheelTest, NextWakeUpSkipsEmptySlots) {
+    TimerWheel wheel;
+    EXPECT_FALSE(wheel.ticksUntilNext().has_value());
+
+    wheel.add(1, 3000, [] {}); // level 1, slot 46
+    int wakeups = 0;
+    uint64_t fired_at = 0;
+    while (wheel.size() > 0) {
+        const auto next = wheel.ticksUntilNext();
+        ASSERT_TRUE(next.has_value());
+        ++wakeups;
+        if (auto expired = wheel.popExpired(wheel.now() + *next))
+            fired_at = wheel.now();
+    }
+    EXPECT_EQ(fired_at, 3000u);
+    EXPECT_LE(wakeups, 2);
+    EXPECT_FALSE(wheel.ticksUntilNext().has_value());
+}
+
+// ---------------------------------------------------------------------------
+// 5. SchedulerRunsTimersInOrder
+// ---------------------------------------------------------------------------
+TEST(TimerSchedulerTest, SchedulerRunsTimersInOrder) {
+    TimerScheduler scheduler(std::chrono::milliseconds(1));
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<int> order;
+    auto record = [&](int n) {
+        return [&, n] {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(n);
+            cv.notify_all();
+        };
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    scheduler.schedule(std::chrono::milliseconds(60), record(3));
+    scheduler.schedule(std::chrono::milliseconds(20), record(1));
+    const TimerId cancelled = scheduler.schedule(std::chrono::milliseconds(30), record(99));
+    scheduler.schedule(std::chrono::milliseconds(40), record(2));
+    EXPECT_TRUE(scheduler.cancel(cancelled));
+
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&] {
+        return order.size() == 3;
+    }));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(60));
+    EXPECT_EQ(order, std::vector<int>({ 1, 2, 3 }));
+    EXPECT_EQ(scheduler.pending(), 0u);
+}
+
+// ---------------------------------------------------------------------------
+// 6. CallbacksCanRescheduleThemselves
+//    The repeating-timer pattern used by the heartbeat; cancel() from
+//    another thread waits for a running callback.
+// ---------------------------------------------------------------------------
+TEST(TimerSchedulerTest, CallbacksCanRescheduleThemselves) {
+    TimerScheduler scheduler(std::chrono::milliseconds(1));
+    std::mutex mutex;
+    TimerId current = 0;
+    std::atomic<int> ticks{ 0 };
+    std::function<void()> tick = [&] {
+        ++ticks;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        std::lock_guard<std::mutex> lock(mutex);
+        if (current != 0)
+            current = scheduler.schedule(std::chrono::milliseconds(1), tick);
+    };
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = scheduler.schedule(std::chrono::milliseconds(1), tick);
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (ticks < 5 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ASSERT_GE(ticks, 5);
+
+    TimerId id = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = std::exchange(current, 0);
+    }
+    scheduler.cancel(id);
+    const int after_cancel = ticks;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(ticks, after_cancel);
+    EXPECT_EQ(scheduler.pending(), 0u);
+}
@@ -0,0 +1,296 @@
+#include "upload_scheduler.h"
+
+#include "db/database.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using anychat::FileInfo;
+using anychat::UploadJobInfo;
+using anychat::UploadQueueProgress;
+using anychat::UploadScheduler;
+using anychat::UploadSchedulerConfig;
+
+namespace {
+
+// Records started jobs and lets the test finish them by hand. Jobs start on
+// the scheduler's thread, so tests wait for them with waitFor().
+struct FakeRunner {
+    struct Started {
+        UploadJobInfo job;
+        int64_t max_bytes_per_sec = 0;
+        anychat::UploadProgressCallback on_progress;
+        anychat::AnyChatValueCallback<FileInfo> on_done;
+        std::thread::id thread;
+    };
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<Started> started;
+
+    UploadScheduler::Runner runner() {
+        return [this](
+                   const UploadJobInfo& job,
+                   int64_t max_bytes_per_sec,
+                   anychat::UploadProgressCallback on_progress,
+                   anychat::AnyChatValueCallback<FileInfo> on_done
+               ) {
+            std::lock_guard<std::mutex> lock(mutex);
+            started.push_back(Started{
+                job,
+                max_bytes_per_sec,
+                std::move(on_progress),
+                std::move(on_done),
+                std::this_thread::get_id(),
+            });
+            cv.notify_all();
+        };
+    }
+
+    // True once at least |n| jobs have started.
+    bool waitFor(size_t n) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(5), [&] { return started.size() >= n; });
+    }
+
+    size_t count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return started.size();
+    }
+
+    Started at(size_t i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return started.at(i);
+    }
+
+    void succeed(size_t i) {
+        Started s = at(i);
+        s.on_progress(s.job.file_size, s.job.file_size);
+        s.on_done.on_success(FileInfo{ .file_id = "file-" + std::to_string(s.job.job_id) });
+    }
+};
+
+class UploadSchedulerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root_ = std::filesystem::temp_directory_path() / "anychat_upload_scheduler_test";
+        std::filesystem::remove_all(root_);
+        std::filesystem::create_directories(root_);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root_);
+    }
+
+    std::string writeFile(const std::string& name, size_t size) const {
+        const auto path = root_ / name;
+        std::ofstream ofs(path, std::ios::binary);
+        ofs << std::string(size, 'u');
+        return path.string();
+    }
+
+    std::filesystem::path root_;
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 1. ConcurrencyLimitAndBandwidthShare
+// ---------------------------------------------------------------------------
+TEST_F(UploadSchedulerTest, ConcurrencyLimitAndBandwidthShare) {
+    FakeRunner fake;
+    UploadScheduler scheduler(
+        fake.runner(),
+        nullptr,
+        UploadSchedulerConfig{ .max_concurrent = 2, .max_bytes_per_sec = 1000 }
+    );
+
+    for (int i = 0; i < 4; ++i)
+        EXPECT_GT(scheduler.enqueue(writeFile("f" + std::to_string(i), 10), 1, 0, {}), 0);
+
+    ASSERT_TRUE(fake.waitFor(2));
+    EXPECT_EQ(fake.count(), 2u);
+    EXPECT_EQ(fake.at(0).max_bytes_per_sec, 500);
+    EXPECT_EQ(scheduler.progress().queued, 2);
+    EXPECT_EQ(scheduler.progress().running, 2);
+
+    fake.succeed(0);
+    ASSERT_TRUE(fake.waitFor(3));
+
+    scheduler.setConfig(UploadSchedulerConfig{ .max_concurrent = 4 });
+    ASSERT_TRUE(fake.waitFor(4));
+    EXPECT_EQ(fake.at(3).max_bytes_per_sec, 0);
+}
+
+// ---------------------------------------------------------------------------
+// 2. HigherPriorityRunsFirst
+// ---------------------------------------------------------------------------
+TEST_F(UploadSchedulerTest, HigherPriorityRunsFirst) {
+    FakeRunner fake;
+    UploadScheduler scheduler(fake.runner(), nullptr, UploadSchedulerConfig{ .max_concurrent = 1 });
+    scheduler.pause();
+
+    const int64_t low = scheduler.enqueue(writeFile("low", 10), 1, 0, {});
+    const int64_t high = scheduler.enqueue(writeFile("high", 10), 1, 5, {});
+    const int64_t low2 = scheduler.enqueue(writeFile("low2", 10), 1, 0, {});
+    EXPECT_EQ(fake.count(), 0u);
+
+    scheduler.resume();
+    ASSERT_TRUE(fake.waitFor(1));
+    fake.succeed(0);
+    ASSERT_TRUE(fake.waitFor(2));
+    fake.succeed(1);
+    ASSERT_TRUE(fake.waitFor(3));
+    EXPECT_EQ(fake.at(0).job.job_id, high);
+    EXPECT_EQ(fake.at(1).job.job_id, low);
+    EXPECT_EQ(fake.at(2).job.job_id, low2);
+}
+
+// ---------------------------------------------------------------------------
+// 3. CancelQueuedJobAndMissingFile
+// ---------------------------------------------------------------------------
+TEST_F(UploadSchedulerTest, CancelQueuedJobAndMissingFile) {
+    FakeRunner fake;
+    UploadScheduler scheduler(fake.runner(), nullptr, UploadSchedulerConfig{ .max_concurrent = 1 });
+
+    const int64_t running = scheduler.enqueue(writeFile("a", 10), 1, 0, {});
+    std::string cancel_error;
+    const int64_t queued = scheduler.enqueue(
+        writeFile("b", 10),
+        1,
+        0,
+        anychat::AnyChatValueCallback<FileInfo>{
+            .on_error = [&](int, const std::string& error) { cancel_error = error; },
+        }
+    );
+
+    EXPECT_FALSE(scheduler.cancel(running));
+    EXPECT_TRUE(scheduler.cancel(queued));
+    EXPECT_FALSE(cancel_error.empty());
+    EXPECT_EQ(scheduler.progress().queued, 0);
+
+    std::string missing_error;
+    EXPECT_EQ(
+        scheduler.enqueue(
+            (root_ / "missing").string(),
+            1,
+            0,
+            anychat::AnyChatValueCallback<FileInfo>{
+                .on_error = [&](int, const std::string& error) { missing_error = error; },
+            }
+        ),
+        0
+    );
+    EXPECT_FALSE(missing_error.empty());
+}
+
+// ---------------------------------------------------------------------------
+// 4. AggregateProgressCoversBatch
+// ---------------------------------------------------------------------------
+TEST_F(UploadSchedulerTest, AggregateProgressCoversBatch) {
+    FakeRunner fake;
+    UploadScheduler scheduler(fake.runner(), nullptr, UploadSchedulerConfig{ .max_concurrent = 2 });
+
+    std::vector<UploadQueueProgress> reports;
+    scheduler.setQueueProgressListener([&](const UploadQueueProgress& p) { reports.push_back(p); });
+
+    scheduler.enqueue(writeFile("a", 100), 1, 0, {});
+    scheduler.enqueue(writeFile("b", 300), 1, 0, {});
+    ASSERT_TRUE(fake.waitFor(2));
+
+    fake.at(1).on_progress(150, 300);
+    EXPECT_EQ(scheduler.progress().uploaded_bytes, 150);
+    EXPECT_EQ(scheduler.progress().total_bytes, 400);
+
+    fake.succeed(0);
+    const UploadQueueProgress mid = scheduler.progress();
+    EXPECT_EQ(mid.uploaded_bytes, 250);
+    EXPECT_EQ(mid.succeeded, 1);
+    EXPECT_EQ(mid.running, 1);
+
+    fake.at(1).on_done.on_error(-1, "boom");
+    ASSERT_FALSE(reports.empty());
+    EXPECT_EQ(reports.back().uploaded_bytes, 400);
+    EXPECT_EQ(reports.back().failed, 1);
+
+    // The drained queue starts a fresh batch.
+    EXPECT_EQ(scheduler.progress().total_bytes, 0);
+}
+
+// ---------------------------------------------------------------------------
+// 5. QueuedJobsSurviveRestartPaused
+// ---------------------------------------------------------------------------
+TEST_F(UploadSchedulerTest, QueuedJobsSurviveRestartPaused) {
+    const std::string db_path = (root_ / "jobs.db").string();
+    const std::string a = writeFile("a", 10);
+    const std::string b = writeFile("b", 20);
+    {
+        anychat::db::Database db(db_path);
+        ASSERT_TRUE(db.open());
+        FakeRunner fake;
+        UploadScheduler scheduler(fake.runner(), &db, UploadSchedulerConfig{ .max_concurrent = 1 });
+        scheduler.enqueue(a, 1, 0, {});
+        scheduler.enqueue(b, 3, 7, {});
+        ASSERT_TRUE(fake.waitFor(1));
+        fake.succeed(0);
+        db.close();
+    }
+
+    anychat::db::Database db(db_path);
+    ASSERT_TRUE(db.open());
+    FakeRunner fake;
+    UploadScheduler scheduler(fake.runner(), &db);
+    EXPECT_TRUE(scheduler.isPaused());
+    EXPECT_EQ(scheduler.progress().queued, 1);
+    EXPECT_EQ(fake.count(), 0u);
+
+    std::vector<int64_t> finished;
+    scheduler.setJobListener([&](int64_t job_id, int code, const std::string&, const FileInfo&) {
+        if (code == 0)
+            finished.push_back(job_id);
+    });
+    scheduler.resume();
+    ASSERT_TRUE(fake.waitFor(1));
+    EXPECT_EQ(fake.at(0).job.local_path, b);
+    EXPECT_EQ(fake.at(0).job.priority, 7);
+    EXPECT_EQ(fake.at(0).job.file_size, 20);
+
+    fake.succeed(0);
+    ASSERT_EQ(finished.size(), 1u);
+    EXPECT_EQ(finished[0], fake.at(0).job.job_id);
+
+    // New ids continue after the restored ones.
+    EXPECT_GT(scheduler.enqueue(a, 1, 0, {}), fake.at(0).job.job_id);
+    db.close();
+}
+
+// ---------------------------------------------------------------------------
+// 6. JobsStartOffTheCompletingThread
+// ---------------------------------------------------------------------------
+TEST_F(UploadSchedulerTest, JobsStartOffTheCompletingThread) {
+    FakeRunner fake;
+    UploadScheduler scheduler(fake.runner(), nullptr, UploadSchedulerConfig{ .max_concurrent = 1 });
+
+    scheduler.enqueue(writeFile("a", 10), 1, 0, {});
+    scheduler.enqueue(writeFile("b", 10), 1, 0, {});
+    ASSERT_TRUE(fake.waitFor(1));
+    EXPECT_NE(fake.at(0).thread, std::this_thread::get_id());
+
+    // Stands in for the HTTP worker reporting the transfer done.
+    std::thread worker([&] { fake.succeed(0); });
+    const std::thread::id worker_id = worker.get_id();
+    worker.join();
+
+    ASSERT_TRUE(fake.waitFor(2));
+    EXPECT_NE(fake.at(1).thread, worker_id);
+    EXPECT_EQ(fake.at(1).thread, fake.at(0).thread);
+}
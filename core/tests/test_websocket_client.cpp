@@ -0,0 +1,379 @@
+#include "network/websocket_client.h"
+
+#include "local_http_server.h"
+#include "local_ws_echo_server.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using anychat::network::WebSocketClient;
+using anychat::network::WebSocketCompressionOptions;
+using anychat::network::WebSocketStats;
+using anychat::test::LocalWsEchoServer;
+
+namespace {
+
+// Collects echoed messages and connection events from the service thread.
+class Recorder {
+public:
+    explicit Recorder(WebSocketClient& ws) {
+        ws.setOnConnected([this] {
+            std::lock_guard<std::mutex> lock(mutex_);
+            connected_ = true;
+            cv_.notify_all();
+        });
+        ws.setOnMessage([this](std::string_view msg, bool) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            messages_.emplace_back(msg);
+            cv_.notify_all();
+        });
+        ws.setOnError([this](const std::string&) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++errors_;
+            cv_.notify_all();
+        });
+    }
+
+    bool waitConnected() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, std::chrono::seconds(5), [this] {
+            return connected_;
+        });
+    }
+
+    bool waitMessages(size_t n) {
+        return waitMessagesFor(n, std::chrono::seconds(5));
+    }
+
+    bool waitMessagesFor(size_t n, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, timeout, [this, n] {
+            return messages_.size() >= n;
+        });
+    }
+
+    bool waitErrors(int n) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, std::chrono::seconds(5), [this, n] {
+            return errors_ >= n;
+        });
+    }
+
+    std::vector<std::string> messages() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return messages_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool connected_ = false;
+    int errors_ = 0;
+    std::vector<std::string> messages_;
+};
+
+// Chat traffic: repetitive keys, similar values.
+std::string chattyMessage(int seq, size_t min_bytes) {
+    std::string msg = R"({"type":"message.send","payload":{"conversation_id":"conv-42","items":[)";
+    for (int i = 0; msg.size() < min_bytes; ++i) {
+        if (i > 0)
+            msg += ',';
+        msg += R"({"message_id":"msg-)" + std::to_string(seq * 100000 + i)
+               + R"(","sender_id":"user-7","content_type":"text","content":"see you at the standup"})";
+    }
+    msg += "]}}";
+    return msg;
+}
+
+double ratio(uint64_t compressed, uint64_t uncompressed) {
+    return uncompressed == 0 ? 0.0 : static_cast<double>(compressed) / static_cast<double>(uncompressed);
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 1. CompressedEchoRoundTrip
+//    Small and fragmented (> 16 KiB) messages survive deflate in both
+//    directions, and the counters show real compression.
+// ---------------------------------------------------------------------------
+TEST(WebSocketClientTest, CompressedEchoRoundTrip) {
+#if defined(LWS_WITHOUT_EXTENSIONS)
+    GTEST_SKIP() << "libwebsockets built without extensions";
+#endif
+    LocalWsEchoServer server(true);
+    WebSocketClient ws(server.url());
+    ws.setCompression(WebSocketCompressionOptions{ .enabled = true });
+    Recorder recorder(ws);
+
+    ws.connect();
+    ASSERT_TRUE(recorder.waitConnected());
+    const std::vector<std::string> sent = {
+        chattyMessage(1, 200),
+        chattyMessage(2, 64 * 1024),
+        chattyMessage(3, 2000),
+    };
+    for (const auto& msg : sent)
+        ws.send(msg);
+    ASSERT_TRUE(recorder.waitMessages(sent.size()));
+    EXPECT_EQ(recorder.messages(), sent);
+
+    const WebSocketStats stats = ws.stats();
+    ws.disconnect();
+
+    EXPECT_TRUE(stats.compression_active);
+    EXPECT_EQ(stats.messages_sent, sent.size());
+    EXPECT_EQ(stats.messages_received, sent.size());
+    EXPECT_GE(stats.deflate_in_bytes, sent[0].size() + sent[1].size() + sent[2].size());
+    EXPECT_EQ(stats.inflate_out_bytes, stats.payload_bytes_received);
+    EXPECT_GT(stats.deflate_out_bytes, 0u);
+    EXPECT_GT(stats.inflate_in_bytes, 0u);
+    EXPECT_LT(ratio(stats.deflate_out_bytes, stats.deflate_in_bytes), 0.5);
+    EXPECT_LT(ratio(stats.inflate_in_bytes, stats.inflate_out_bytes), 0.5);
+
+    const auto offers = server.extensionOffers();
+    ASSERT_EQ(offers.size(), 1u);
+    EXPECT_EQ(offers[0].find("permessage-deflate"), 0u);
+}
+
+// ---------------------------------------------------------------------------
+// 2. OfferCarriesWindowBitsAndContextTakeover
+// ---------------------------------------------------------------------------
+TEST(WebSocketClientTest, OfferCarriesWindowBitsAndContextTakeover) {
+#if defined(LWS_WITHOUT_EXTENSIONS)
+    GTEST_SKIP() << "libwebsockets built without extensions";
+#endif
+    LocalWsEchoServer server(true);
+    WebSocketClient ws(server.url());
+    ws.setCompression(WebSocketCompressionOptions{
+        .enabled = true,
+        .client_max_window_bits = 10,
+        .server_max_window_bits = 4, // clamped to 9
+        .client_no_context_takeover = true,
+        .server_no_context_takeover = true,
+    });
+    Recorder recorder(ws);
+
+    ws.connect();
+    ASSERT_TRUE(recorder.waitConnected());
+    const std::string msg = chattyMessage(1, 4000);
+    ws.send(msg);
+    ws.send(msg);
+    ASSERT_TRUE(recorder.waitMessages(2));
+    EXPECT_EQ(recorder.messages(), std::vector<std::string>({ msg, msg }));
+    EXPECT_TRUE(ws.stats().compression_active);
+    ws.disconnect();
+
+    const auto offers = server.extensionOffers();
+    ASSERT_EQ(offers.size(), 1u);
+    EXPECT_NE(offers[0].find("client_max_window_bits=10"), std::string::npos);
+    EXPECT_NE(offers[0].find("server_max_window_bits=9"), std::string::npos);
+    EXPECT_NE(offers[0].find("client_no_context_takeover"), std::string::npos);
+    EXPECT_NE(offers[0].find("server_no_context_takeover"), std::string::npos);
+}
+
+// ---------------------------------------------------------------------------
+// 3. ServerWithoutDeflateGetsPlainConnection
+//    The offer is ignored by the server; traffic flows uncompressed.
+// ---------------------------------------------------------------------------
+TEST(WebSocketClientTest, ServerWithoutDeflateGetsPlainConnection) {
+    LocalWsEchoServer server(false);
+    WebSocketClient ws(server.url());
+    ws.setCompression(WebSocketCompressionOptions{ .enabled = true });
+    Recorder recorder(ws);
+
+    ws.connect();
+    ASSERT_TRUE(recorder.waitConnected());
+    const std::string msg = chattyMessage(1, 30 * 1024);
+    ws.send(msg);
+    ASSERT_TRUE(recorder.waitMessages(1));
+    EXPECT_EQ(recorder.messages()[0], msg);
+
+    const WebSocketStats stats = ws.stats();
+    ws.disconnect();
+
+    EXPECT_FALSE(stats.compression_active);
+    EXPECT_EQ(stats.compression_fallbacks, 0u);
+    EXPECT_EQ(stats.payload_bytes_sent, msg.size());
+    EXPECT_EQ(stats.payload_bytes_received, msg.size());
+    EXPECT_EQ(stats.deflate_in_bytes, 0u);
+    EXPECT_EQ(stats.deflate_out_bytes, 0u);
+    EXPECT_EQ(stats.inflate_in_bytes, 0u);
+}
+
+// ---------------------------------------------------------------------------
+// 4. CompressionIsOffByDefault
+// ---------------------------------------------------------------------------
+TEST(WebSocketClientTest, CompressionIsOffByDefault) {
+    LocalWsEchoServer server(true);
+    WebSocketClient ws(server.url());
+    Recorder recorder(ws);
+
+    ws.connect();
+    ASSERT_TRUE(recorder.waitConnected());
+    ws.send(R"({"type":"ping"})");
+    ASSERT_TRUE(recorder.waitMessages(1));
+    EXPECT_FALSE(ws.stats().compression_active);
+    ws.disconnect();
+
+    const auto offers = server.extensionOffers();
+    ASSERT_EQ(offers.size(), 1u);
+    EXPECT_TRUE(offers[0].empty());
+}
+
+// ---------------------------------------------------------------------------
+// 5. RejectedUpgradeRetriesWithoutOffer
+//    An intermediary that answers the offer with an error makes the next
+//    attempt go out without the extension header.
+// ---------------------------------------------------------------------------
+TEST(WebSocketClientTest, RejectedUpgradeRetriesWithoutOffer) {
+#if defined(LWS_WITHOUT_EXTENSIONS)
+    GTEST_SKIP() << "libwebsockets built without extensions";
+#endif
+    std::mutex mutex;
+    std::vector<std::string> offers;
+    anychat::test::LocalHttpServer proxy([&](const anychat::test::LocalHttpRequest& req) {
+        std::lock_guard<std::mutex> lock(mutex);
+        offers.push_back(req.header("sec-websocket-extensions"));
+        return anychat::test::LocalHttpReply{ .status = 400, .body = "bad extension" };
+    });
+
+    const std::string url = "ws://" + proxy.baseUrl().substr(std::string("http://").size()) + "/api/v1/ws";
+    WebSocketClient ws(url);
+    ws.setCompression(WebSocketCompressionOptions{ .enabled = true });
+    Recorder recorder(ws);
+
+    ws.connect();
+    ASSERT_TRUE(recorder.waitErrors(2)); // first retry after ~1 s
+    ws.disconnect();
+
+    EXPECT_EQ(ws.stats().compression_fallbacks, 1u);
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_GE(offers.size(), 2u);
+    EXPECT_FALSE(offers[0].empty());
+    EXPECT_TRUE(offers[1].empty());
+}
+
+// ---------------------------------------------------------------------------
+// 6. CongestedQueueRefusesBulkUntilDrained
+//    Frames queued before the connection count against the watermarks;
+//    writing them out fires the drained handler.
+// ---------------------------------------------------------------------------
+TEST(WebSocketClientTest, CongestedQueueRefusesBulkUntilDrained) {
+    LocalWsEchoServer server(false);
+    WebSocketClient ws(server.url());
+    ws.setSendQueueLimits(anychat::network::WsSendQueueLimits{ .high_watermark_bytes = 64, .low_watermark_bytes = 0 });
+    Recorder recorder(ws);
+    std::atomic<int> drains{ 0 };
+    ws.setOnDrained([&drains] {
+        ++drains;
+    });
+
+    const std::string bulk = chattyMessage(1, 100);
+    EXPECT_TRUE(ws.send(bulk));
+    EXPECT_FALSE(ws.send(bulk));
+    EXPECT_TRUE(ws.send(R"({"type":"ping"})", anychat::network::SendPriority::Control));
+    EXPECT_EQ(ws.stats().bulk_frames_refused, 1u);
+    EXPECT_EQ(ws.stats().send_queue_bytes, bulk.size());
+
+    ws.connect();
+    ASSERT_TRUE(recorder.waitMessages(2));
+    EXPECT_EQ(recorder.messages(), std::vector<std::string>({ R"({"type":"ping"})", bulk }));
+    EXPECT_EQ(drains, 1);
+    EXPECT_TRUE(ws.send(bulk));
+    ASSERT_TRUE(recorder.waitMessages(3));
+    ws.disconnect();
+}
+
+// ---------------------------------------------------------------------------
+// 7. PingControlFrameIsAnsweredWithPong
+//    The pong echoes the payload; control frames stay out of the message and
+//    payload counters.
+// ---------------------------------------------------------------------------
+TEST(WebSocketClientTest, PingControlFrameIsAnsweredWithPong) {
+    LocalWsEchoServer server(false);
+    WebSocketClient ws(server.url());
+    Recorder recorder(ws);
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> pongs;
+    ws.setOnPong([&](std::string_view payload) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pongs.emplace_back(payload);
+        cv.notify_all();
+    });
+
+    EXPECT_FALSE(ws.sendPing("1")) << "not connected yet";
+    ws.connect();
+    ASSERT_TRUE(recorder.waitConnected());
+    EXPECT_FALSE(ws.sendPing(std::string(126, 'x'))) << "control payloads are limited to 125 bytes";
+    EXPECT_TRUE(ws.sendPing("42"));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&] {
+            return !pongs.empty();
+        }));
+        EXPECT_EQ(pongs, std::vector<std::string>({ "42" }));
+    }
+
+    const WebSocketStats stats = ws.stats();
+    ws.disconnect();
+    EXPECT_EQ(stats.pings_sent, 1u);
+    EXPECT_EQ(stats.pongs_received, 1u);
+    EXPECT_EQ(stats.messages_sent, 0u);
+    EXPECT_EQ(stats.payload_bytes_sent, 0u);
+    EXPECT_TRUE(recorder.messages().empty());
+}
+
+// ---------------------------------------------------------------------------
+// 8. MessageCutOffByDisconnectIsResentIntact
+//    The server drops the connection in the middle of a fragmented message;
+//    after the reconnect the whole message goes out again, byte for byte.
+// ---------------------------------------------------------------------------
+TEST(WebSocketClientTest, MessageCutOffByDisconnectIsResentIntact) {
+    LocalWsEchoServer server(false);
+    // Past the first fragment, long before the socket buffers took it all.
+    server.dropOnceAfter(20 * 1024);
+    WebSocketClient ws(server.url());
+    Recorder recorder(ws);
+
+    ws.connect();
+    ASSERT_TRUE(recorder.waitConnected());
+    const std::string big = chattyMessage(1, 16 * 1024 * 1024);
+    ASSERT_TRUE(ws.send(big));
+    ASSERT_TRUE(recorder.waitMessages(1));
+    ws.disconnect();
+
+    EXPECT_EQ(server.received(), std::vector<std::string>({ big }));
+    EXPECT_EQ(recorder.messages(), std::vector<std::string>({ big }));
+}
+
+// ---------------------------------------------------------------------------
+// 9. PausedReceiveHoldsMessagesUntilResumed
+//    While reading is paused the echo waits in the socket; sends and pings
+//    still go out.
+// ---------------------------------------------------------------------------
+TEST(WebSocketClientTest, PausedReceiveHoldsMessagesUntilResumed) {
+    LocalWsEchoServer server(false);
+    WebSocketClient ws(server.url());
+    Recorder recorder(ws);
+
+    ws.connect();
+    ASSERT_TRUE(recorder.waitConnected());
+    ws.setReceivePaused(true);
+    ASSERT_TRUE(ws.send("held"));
+    EXPECT_TRUE(ws.sendPing("1"));
+    EXPECT_FALSE(recorder.waitMessagesFor(1, std::chrono::milliseconds(200)));
+    EXPECT_EQ(server.received(), std::vector<std::string>({ "held" }));
+    EXPECT_EQ(ws.stats().pings_sent, 1u);
+
+    ws.setReceivePaused(false);
+    ASSERT_TRUE(recorder.waitMessages(1));
+    EXPECT_EQ(recorder.messages(), std::vector<std::string>({ "held" }));
+    ws.disconnect();
+}
@@ -0,0 +1,81 @@
+#include "network/ws_frame_assembler.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+using anychat::network::WsFrameAssembler;
+using Result = anychat::network::WsFrameAssembler::Result;
+
+// ---------------------------------------------------------------------------
+// 1. SingleChunkMessage
+// ---------------------------------------------------------------------------
+TEST(WsFrameAssemblerTest, SingleChunkMessage) {
+    WsFrameAssembler assembler;
+    EXPECT_EQ(assembler.append(R"({"type":"pong"})", true), Result::Complete);
+    EXPECT_EQ(assembler.message(), R"({"type":"pong"})");
+    EXPECT_EQ(assembler.message().data()[assembler.message().size()], '\0');
+}
+
+// ---------------------------------------------------------------------------
+// 2. FragmentsAreJoined
+//    A large push split over fragments and rx-buffer-sized chunks arrives as
+//    one message; nothing is delivered before the last chunk.
+// ---------------------------------------------------------------------------
+TEST(WsFrameAssemblerTest, FragmentsAreJoined) {
+    const std::string message = R"({"type":"notification","payload":")" + std::string(20000, 'x') + R"("})";
+    WsFrameAssembler assembler;
+
+    size_t pos = 0;
+    while (pos < message.size()) {
+        const size_t len = std::min<size_t>(4096, message.size() - pos);
+        const bool final = pos + len == message.size();
+        const Result result = assembler.append(std::string_view(message).substr(pos, len), final);
+        EXPECT_EQ(result, final ? Result::Complete : Result::Incomplete);
+        if (!final) {
+            EXPECT_TRUE(assembler.message().empty());
+        }
+        pos += len;
+    }
+    EXPECT_TRUE(assembler.message() == message);
+}
+
+// ---------------------------------------------------------------------------
+// 3. BufferIsReusedAcrossMessages
+// ---------------------------------------------------------------------------
+TEST(WsFrameAssemblerTest, BufferIsReusedAcrossMessages) {
+    WsFrameAssembler assembler;
+    ASSERT_EQ(assembler.append(std::string(1000, 'a'), true), Result::Complete);
+    const size_t capacity = assembler.capacity();
+
+    ASSERT_EQ(assembler.append("hello", false), Result::Incomplete);
+    ASSERT_EQ(assembler.append(" world", true), Result::Complete);
+    EXPECT_EQ(assembler.message(), "hello world");
+    EXPECT_EQ(assembler.capacity(), capacity);
+}
+
+// ---------------------------------------------------------------------------
+// 4. OversizedMessageIsDroppedWhole
+//    The rest of the message is skipped, and the next one is unaffected.
+// ---------------------------------------------------------------------------
+TEST(WsFrameAssemblerTest, OversizedMessageIsDroppedWhole) {
+    WsFrameAssembler assembler(10);
+    EXPECT_EQ(assembler.append("0123456", false), Result::Incomplete);
+    EXPECT_EQ(assembler.append("789abc", false), Result::Incomplete);
+    EXPECT_EQ(assembler.append("def", true), Result::Dropped);
+    EXPECT_TRUE(assembler.message().empty());
+
+    EXPECT_EQ(assembler.append("ok", true), Result::Complete);
+    EXPECT_EQ(assembler.message(), "ok");
+}
+
+// ---------------------------------------------------------------------------
+// 5. ResetDiscardsPartialMessage
+// ---------------------------------------------------------------------------
+TEST(WsFrameAssemblerTest, ResetDiscardsPartialMessage) {
+    WsFrameAssembler assembler;
+    ASSERT_EQ(assembler.append(R"({"type":)", false), Result::Incomplete);
+    assembler.reset();
+    ASSERT_EQ(assembler.append(R"({"type":"pong"})", true), Result::Complete);
+    EXPECT_EQ(assembler.message(), R"({"type":"pong"})");
+}
@@ -0,0 +1,59 @@
+#include "network/ws_frame_pool.h"
+
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using anychat::network::WsFrame;
+using anychat::network::WsFramePool;
+
+// ---------------------------------------------------------------------------
+// 1. FrameCarriesHeadroomAndPayload
+// ---------------------------------------------------------------------------
+TEST(WsFramePoolTest, FrameCarriesHeadroomAndPayload) {
+    WsFramePool pool(16);
+    WsFrame frame = pool.make(R"({"type":"ping"})");
+
+    EXPECT_EQ(frame.headroom, 16u);
+    EXPECT_EQ(frame.buf.size(), 16u + frame.size());
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(frame.payload()), frame.size()), R"({"type":"ping"})");
+}
+
+// ---------------------------------------------------------------------------
+// 2. RecycledBuffersAreReused
+//    Steady traffic allocates once per concurrently queued frame.
+// ---------------------------------------------------------------------------
+TEST(WsFramePoolTest, RecycledBuffersAreReused) {
+    WsFramePool pool(16);
+    for (int i = 0; i < 100; ++i) {
+        WsFrame frame = pool.make(std::string(100 + i, 'x'));
+        ASSERT_EQ(frame.size(), static_cast<size_t>(100 + i));
+        pool.recycle(std::move(frame));
+    }
+    EXPECT_EQ(pool.allocations(), 1u);
+    EXPECT_EQ(pool.pooled(), 1u);
+
+    WsFrame reused = pool.make("short");
+    EXPECT_EQ(reused.size(), 5u);
+    EXPECT_EQ(std::memcmp(reused.payload(), "short", 5), 0);
+}
+
+// ---------------------------------------------------------------------------
+// 3. PoolIsBounded
+//    Oversized buffers are released and the free list has a cap.
+// ---------------------------------------------------------------------------
+TEST(WsFramePoolTest, PoolIsBounded) {
+    WsFramePool pool(16, 2, 1024);
+
+    pool.recycle(pool.make(std::string(4096, 'x')));
+    EXPECT_EQ(pool.pooled(), 0u);
+
+    WsFrame a = pool.make("a");
+    WsFrame b = pool.make("b");
+    WsFrame c = pool.make("c");
+    pool.recycle(std::move(a));
+    pool.recycle(std::move(b));
+    pool.recycle(std::move(c));
+    EXPECT_EQ(pool.pooled(), 2u);
+}
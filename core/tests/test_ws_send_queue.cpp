@@ -0,0 +1,136 @@
+#include "network/ws_send_queue.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using anychat::network::SendPriority;
+using anychat::network::WsFrame;
+using anychat::network::WsFramePool;
+using anychat::network::WsSendQueue;
+using anychat::network::WsSendQueueLimits;
+
+namespace {
+
+std::string text(const WsFrame& frame) {
+    return std::string(reinterpret_cast<const char*>(frame.buf.data() + frame.headroom), frame.size());
+}
+
+// Pops everything; |drains| counts pops that ended a congestion.
+std::vector<std::string> popAll(WsSendQueue& queue, int* drains = nullptr) {
+    std::vector<std::string> out;
+    bool drained = false;
+    while (std::optional<WsFrame> frame = queue.pop(drained)) {
+        out.push_back(text(*frame));
+        if (drained && drains)
+            ++*drains;
+    }
+    return out;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// 1. HigherPrioritiesGoFirst
+//    A bulk backlog does not delay control or transient frames; each lane
+//    keeps its own order.
+// ---------------------------------------------------------------------------
+TEST(WsSendQueueTest, HigherPrioritiesGoFirst) {
+    WsFramePool pool(16);
+    WsSendQueue queue(pool);
+
+    EXPECT_TRUE(queue.push(pool.make("send-1"), SendPriority::Bulk));
+    EXPECT_TRUE(queue.push(pool.make("send-2"), SendPriority::Bulk));
+    EXPECT_TRUE(queue.push(pool.make("typing-1"), SendPriority::Transient));
+    EXPECT_TRUE(queue.push(pool.make("ping"), SendPriority::Control));
+    EXPECT_TRUE(queue.push(pool.make("typing-2"), SendPriority::Transient));
+
+    EXPECT_EQ(popAll(queue), std::vector<std::string>({ "ping", "typing-1", "typing-2", "send-1", "send-2" }));
+    EXPECT_TRUE(queue.empty());
+}
+
+// ---------------------------------------------------------------------------
+// 2. FullTransientLaneDropsOldest
+// ---------------------------------------------------------------------------
+TEST(WsSendQueueTest, FullTransientLaneDropsOldest) {
+    WsFramePool pool(16);
+    WsSendQueue queue(pool, WsSendQueueLimits{ .max_transient_frames = 2 });
+
+    std::vector<WsFrame> typing;
+    for (int i = 1; i <= 4; ++i)
+        typing.push_back(pool.make("typing-" + std::to_string(i)));
+    for (auto& frame : typing)
+        EXPECT_TRUE(queue.push(std::move(frame), SendPriority::Transient));
+    EXPECT_EQ(pool.pooled(), 2u) << "dropped frames go back to the pool";
+
+    for (int i = 1; i <= 4; ++i)
+        EXPECT_TRUE(queue.push(pool.make("ping-" + std::to_string(i)), SendPriority::Control));
+
+    const auto stats = queue.stats();
+    EXPECT_EQ(stats.transient_frames, 2u);
+    EXPECT_EQ(stats.transient_dropped, 2u);
+    EXPECT_EQ(stats.control_frames, 4u);
+
+    EXPECT_EQ(
+        popAll(queue),
+        std::vector<std::string>({ "ping-1", "ping-2", "ping-3", "ping-4", "typing-3", "typing-4" })
+    );
+}
+
+// ---------------------------------------------------------------------------
+// 3. BulkLaneRefusesBetweenWatermarks
+//    Congestion starts at the high watermark and ends, exactly once, when
+//    pops bring the lane down to the low watermark.
+// ---------------------------------------------------------------------------
+TEST(WsSendQueueTest, BulkLaneRefusesBetweenWatermarks) {
+    WsFramePool pool(16);
+    WsSendQueue queue(pool, WsSendQueueLimits{ .high_watermark_bytes = 40, .low_watermark_bytes = 10 });
+    const std::string chunk(10, 'x');
+
+    for (int i = 0; i < 3; ++i)
+        EXPECT_TRUE(queue.push(pool.make(chunk), SendPriority::Bulk));
+    EXPECT_FALSE(queue.stats().congested);
+    EXPECT_TRUE(queue.push(pool.make(chunk), SendPriority::Bulk)); // reaches 40
+    EXPECT_TRUE(queue.stats().congested);
+
+    EXPECT_FALSE(queue.push(pool.make(chunk), SendPriority::Bulk));
+    EXPECT_TRUE(queue.push(pool.make("ping"), SendPriority::Control)) << "only bulk frames are refused";
+    EXPECT_EQ(queue.stats().bulk_refused, 1u);
+    EXPECT_EQ(queue.stats().bulk_bytes, 40u);
+
+    bool drained = false;
+    ASSERT_TRUE(queue.pop(drained)); // ping
+    EXPECT_FALSE(drained);
+    ASSERT_TRUE(queue.pop(drained)); // 30 bytes left
+    EXPECT_FALSE(drained);
+    EXPECT_FALSE(queue.push(pool.make(chunk), SendPriority::Bulk)) << "still congested above the low watermark";
+    ASSERT_TRUE(queue.pop(drained)); // 20
+    EXPECT_FALSE(drained);
+    ASSERT_TRUE(queue.pop(drained)); // 10
+    EXPECT_TRUE(drained);
+
+    EXPECT_TRUE(queue.push(pool.make(chunk), SendPriority::Bulk));
+    int drains = 0;
+    EXPECT_EQ(popAll(queue, &drains).size(), 2u);
+    EXPECT_EQ(drains, 0);
+}
+
+// ---------------------------------------------------------------------------
+// 4. OversizedFrameIsAccepted
+//    One frame larger than the high watermark is still queued, then blocks
+//    further bulk frames until it has been written.
+// ---------------------------------------------------------------------------
+TEST(WsSendQueueTest, OversizedFrameIsAccepted) {
+    WsFramePool pool(16);
+    WsSendQueue queue(pool, WsSendQueueLimits{ .high_watermark_bytes = 8, .low_watermark_bytes = 0 });
+
+    EXPECT_TRUE(queue.push(pool.make(std::string(100, 'x')), SendPriority::Bulk));
+    EXPECT_FALSE(queue.push(pool.make("next"), SendPriority::Bulk));
+
+    bool drained = false;
+    ASSERT_TRUE(queue.pop(drained));
+    EXPECT_TRUE(drained);
+    EXPECT_TRUE(queue.push(pool.make("next"), SendPriority::Bulk));
+}
@@ -776,6 +776,45 @@ final class AnyChatClientConfig_C extends ffi.Struct {
   /// 1 = enabled (default), 0 = disabled
   @ffi.Int()
   external int auto_reconnect;
+
+  /// downloaded media cache directory; NULL or "" disables it
+  external ffi.Pointer<ffi.Char> media_cache_dir;
+
+  /// default: 512 MiB
+  @ffi.Int64()
+  external int media_cache_max_bytes;
+
+  /// 1 = gzip large /sync request bodies, 0 = off (default)
+  @ffi.Int()
+  external int compress_request_bodies;
+
+  /// 1 = offer WebSocket permessage-deflate, 0 = off (default)
+  @ffi.Int()
+  external int ws_permessage_deflate;
+
+  /// 9..15, default: 15
+  @ffi.Int()
+  external int ws_deflate_window_bits;
+
+  /// 1 = reset the deflate dictionary per message, 0 = keep (default)
+  @ffi.Int()
+  external int ws_deflate_no_context_takeover;
+
+  /// 1 = offer binary (BEVE) frames, 0 = JSON only (default)
+  @ffi.Int()
+  external int ws_binary_frames;
+
+  /// callback threads; 0 = default (2), negative = run on the WebSocket thread
+  @ffi.Int()
+  external int dispatch_threads;
+
+  /// events waiting for a callback thread; 0 = default (10000)
+  @ffi.Int()
+  external int dispatch_queue_limit;
+
+  /// > 0: deliver listener events in batches per window, e.g. 16; 0 = off (default)
+  @ffi.Int()
+  external int listener_batch_window_ms;
 }
 
 final class AnyChatConvListCallback_C extends ffi.Struct {